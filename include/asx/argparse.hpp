@@ -11,6 +11,9 @@
 #include <vector>
 #include <cstddef>
 #include <cstdint>
+#include <charconv>
+#include <optional>
+#include <type_traits>
 #include <unordered_map>
 
 namespace asx
@@ -179,7 +182,7 @@ namespace asx
 			template <typename T>
 			const T& get() const
 			{
-				return std::any_cast<T>(this->value_);
+				return std::any_cast<const T&>(this->value_);
 			};
 
 			/**
@@ -203,6 +206,33 @@ namespace asx
 				};
 			};
 
+			/**
+			 * @brief Converts the stored value text to a number.
+			 *
+			 * @tparam T Arithmetic type to convert to.
+			 *
+			 * @return The number, or nullopt if no value was provided or the whole text isn't a
+			 * number representable by `T`.
+			*/
+			template <typename T> requires std::is_arithmetic_v<T>
+			std::optional<T> to_number() const
+			{
+				const auto _text = this->try_get<std::string>();
+				if (!_text)
+				{
+					return std::nullopt;
+				};
+
+				T _number{};
+				const auto _end = _text->data() + _text->size();
+				const auto _result = std::from_chars(_text->data(), _end, _number);
+				if (_result.ec != std::errc{} || _result.ptr != _end)
+				{
+					return std::nullopt;
+				};
+				return _number;
+			};
+
 			/**
 			 * @brief Constructs an empty parsed value.
 			 * 
@@ -619,6 +649,21 @@ namespace asx
 		*/
 		ParseResult parse_args(int _nargs, const char* const* _vargs);
 
+		/**
+		 * @brief Checks a single named option and its values against the argument definitions.
+		 * 
+		 * Lets other sources of options, like a config file, share the definitions used for the
+		 * command line.
+		 * 
+		 * @param _name Name of the option including its leading '-' or '--'.
+		 * @param _count Number of values given for the option.
+		 * @param _outErrorMessage Optional, set to the reason the option was rejected.
+		 * 
+		 * @return Label of the matching argument, or nullptr if no named argument has this name or
+		 * it can't take `_count` values.
+		*/
+		const std::string* check_option(std::string_view _name, size_t _count, std::string* _outErrorMessage = nullptr) const;
+
 
 
 
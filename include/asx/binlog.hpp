@@ -0,0 +1,590 @@
+#pragma once
+
+/**
+ * @file
+ * @brief Compact binary log format.
+ *
+ * A binary log file is a sequence of self-contained segments. Each segment is laid out as
+ *
+ *	segment_header
+ *	string table   (`string_count` entries, each a `string_entry_header` followed by its strings)
+ *	record block   (`record_count` records, each a `record_header` followed by its encoded arguments)
+ *
+ * Records store the id of a format string (or call site) from the string table, the raw
+ * arguments and a timestamp rather than formatted text. Every segment carries the complete
+ * string table so that segments can be decoded independently of one another. All values
+ * are stored in host byte order, readers reject segments written with a different one.
+ *
+ * The record block may be compressed with `asx/lz.hpp` as a single block, which is flagged with
+ * `SEGMENT_FLAG_LZ`. The header and string table are never compressed so segments can still be
+ * skipped and filtered by time without decompressing them.
+ *
+ * Segments flagged with `SEGMENT_FLAG_CRC32C` (version 2 onward) carry a checksum of the whole
+ * segment, so a reader recovering a damaged file can detect a corrupted or torn segment, skip it
+ * and resync on the next `SEGMENT_MAGIC`.
+*/
+
+#include <asx/source.hpp>
+#include <asx/format.hpp>
+#include <asx/lz.hpp>
+#include <asx/log_index.hpp>
+
+#include <span>
+#include <array>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <variant>
+#include <concepts>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+
+namespace asx::binlog
+{
+	/**
+	 * @brief Magic bytes every segment begins with.
+	*/
+	constexpr inline std::array<char, 8> SEGMENT_MAGIC{ 'A', 'S', 'X', 'B', 'L', 'O', 'G', '\0' };
+
+	/**
+	 * @brief Version of the segment format written by this library, every older version can still be read.
+	 *
+	 * Version 2 added record block compression and a checksum of the whole segment, every segment is
+	 * written as version 2 and checksummed.
+	*/
+	constexpr inline uint16_t FORMAT_VERSION = 2;
+
+	/**
+	 * @brief Set in `segment_header::flags` if the record block is compressed, version 2 onward.
+	*/
+	constexpr inline uint16_t SEGMENT_FLAG_LZ = 0x0001;
+
+	/**
+	 * @brief Set in `segment_header::flags` if `segment_header::checksum` is set, version 2 onward.
+	*/
+	constexpr inline uint16_t SEGMENT_FLAG_CRC32C = 0x0002;
+
+	/**
+	 * @brief Value written to `segment_header::byte_order`, reads back byte swapped on a host with the other byte order.
+	*/
+	constexpr inline uint16_t BYTE_ORDER_MARKER = 0x0102;
+
+	/**
+	 * @brief Default size of a segment's record block before it is written out.
+	*/
+	constexpr inline size_t SEGMENT_CAPACITY_DEFAULT = 1024 * 1024;
+
+	/**
+	 * @brief Kinds of string table entries.
+	*/
+	enum class entry_kind : uint8_t
+	{
+		/**
+		 * @brief Holds a format string.
+		*/
+		format = 0,
+
+		/**
+		 * @brief Holds a source location and refers to the format string used there.
+		*/
+		callsite = 1,
+	};
+
+	/**
+	 * @brief Type tags for encoded record arguments.
+	*/
+	enum class arg_type : uint8_t
+	{
+		boolean = 1,	// 1 byte
+		character,		// 1 byte
+		int64,			// 8 bytes
+		uint64,			// 8 bytes
+		float64,		// 8 bytes
+		string,			// uint32 length followed by the bytes
+	};
+
+	struct segment_header
+	{
+		std::array<char, 8> magic;
+
+		uint16_t version;
+
+		/**
+		 * @brief Size of this header in bytes, the string table begins this many bytes into the segment.
+		*/
+		uint16_t header_size;
+
+		uint16_t byte_order;
+		uint16_t flags;
+
+		uint32_t string_count;
+
+		/**
+		 * @brief Size of the string table in bytes.
+		*/
+		uint32_t string_table_size;
+
+		/**
+		 * @brief Size of the record block in bytes as stored in the file.
+		*/
+		uint64_t record_block_size;
+
+		uint64_t record_count;
+
+		/**
+		 * @brief Earliest record timestamp, nanoseconds since the unix epoch.
+		*/
+		uint64_t time_begin;
+
+		/**
+		 * @brief Latest record timestamp, nanoseconds since the unix epoch.
+		*/
+		uint64_t time_end;
+
+		/**
+		 * @brief Size of the record block once decompressed, only set if `SEGMENT_FLAG_LZ` is.
+		*/
+		uint32_t record_block_raw_size;
+
+		/**
+		 * @brief CRC-32C of the whole segment taken with this field as 0, only set if `SEGMENT_FLAG_CRC32C` is.
+		*/
+		uint32_t checksum;
+	};
+	static_assert(sizeof(segment_header) == 64);
+
+	struct string_entry_header
+	{
+		/**
+		 * @brief Id records use to refer to this entry, ids are assigned sequentially starting at 1.
+		*/
+		uint32_t id;
+
+		entry_kind kind;
+
+		/**
+		 * @brief Log level of the call site, only meaningful for `entry_kind::callsite`.
+		*/
+		uint8_t level;
+
+		uint16_t reserved;
+
+		/**
+		 * @brief Source line of the call site, only meaningful for `entry_kind::callsite`.
+		*/
+		uint32_t line;
+
+		/**
+		 * @brief Id of the format string used at the call site, only meaningful for `entry_kind::callsite`.
+		*/
+		uint32_t format_id;
+
+		/**
+		 * @brief Size of the first string (format text, or call site file).
+		*/
+		uint32_t size0;
+
+		/**
+		 * @brief Size of the second string (empty, or call site function).
+		*/
+		uint32_t size1;
+	};
+	static_assert(sizeof(string_entry_header) == 24);
+
+	struct record_header
+	{
+		/**
+		 * @brief Nanoseconds since the unix epoch.
+		*/
+		uint64_t timestamp;
+
+		/**
+		 * @brief Size of the record in bytes, including this header.
+		*/
+		uint32_t size;
+
+		/**
+		 * @brief Id of the string table entry (format string or call site) for this record.
+		*/
+		uint32_t site_id;
+
+		/**
+		 * @brief Log level, uses the values of `asx::LogLevel`.
+		*/
+		uint8_t level;
+
+		uint8_t arg_count;
+		uint16_t reserved0;
+		uint32_t reserved1;
+	};
+	static_assert(sizeof(record_header) == 24);
+
+
+
+	/**
+	 * @brief Gets the display name for a log level value.
+	 * @param _level Log level, uses the values of `asx::LogLevel`.
+	 * @return Level name ("fatal", "error", "warn", "info"), or "unknown".
+	*/
+	std::string_view level_name(uint8_t _level);
+
+	inline void append_bytes(std::string& _out, const auto& _value)
+	{
+		static_assert(std::is_trivially_copyable_v<std::remove_cvref_t<decltype(_value)>>);
+		_out.append(reinterpret_cast<const char*>(&_value), sizeof(_value));
+	};
+
+	/**
+	 * @brief Encodes a single record argument.
+	 *
+	 * Arithmetic and string types are stored raw. Any other formattable type is
+	 * formatted and stored as a string.
+	 *
+	 * @param _out String to append the encoded argument to.
+	 * @param _value Value to encode.
+	*/
+	template <cx_formattable T>
+	inline void encode_arg(std::string& _out, const T& _value)
+	{
+		if constexpr (std::same_as<T, bool>)
+		{
+			_out.push_back(static_cast<char>(arg_type::boolean));
+			_out.push_back(_value ? 1 : 0);
+		}
+		else if constexpr (std::same_as<T, char>)
+		{
+			_out.push_back(static_cast<char>(arg_type::character));
+			_out.push_back(_value);
+		}
+		else if constexpr (std::signed_integral<T>)
+		{
+			_out.push_back(static_cast<char>(arg_type::int64));
+			append_bytes(_out, static_cast<int64_t>(_value));
+		}
+		else if constexpr (std::unsigned_integral<T>)
+		{
+			_out.push_back(static_cast<char>(arg_type::uint64));
+			append_bytes(_out, static_cast<uint64_t>(_value));
+		}
+		else if constexpr (std::floating_point<T>)
+		{
+			_out.push_back(static_cast<char>(arg_type::float64));
+			append_bytes(_out, static_cast<double>(_value));
+		}
+		else if constexpr (std::convertible_to<const T&, std::string_view>)
+		{
+			const auto _str = std::string_view(_value);
+			_out.push_back(static_cast<char>(arg_type::string));
+			append_bytes(_out, static_cast<uint32_t>(_str.size()));
+			_out.append(_str);
+		}
+		else
+		{
+			const auto _str = asx::format("{}", _value);
+			_out.push_back(static_cast<char>(arg_type::string));
+			append_bytes(_out, static_cast<uint32_t>(_str.size()));
+			_out.append(_str);
+		};
+	};
+
+	/**
+	 * @brief Encodes record arguments.
+	 * @param _out String to append the encoded arguments to.
+	 * @param _args... Values to encode.
+	*/
+	inline void encode_args(std::string& _out, const cx_formattable auto&... _args)
+	{
+		(binlog::encode_arg(_out, _args), ...);
+	};
+
+
+
+	/**
+	 * @brief Writes binary log segments to a file.
+	 *
+	 * Records are buffered in memory until the record block reaches the segment capacity
+	 * or `flush()` is called, at which point a complete segment is written out. An index entry
+	 * is written to the side index (see `asx/log_index.hpp`) for every segment.
+	 *
+	 * This is thread safe.
+	*/
+	class writer
+	{
+	public:
+
+		/**
+		 * @brief Opens a file to write segments into, any previous file is flushed and closed.
+		 * @param _path Path to the file, it will be truncated.
+		 * @param _indexed If true, a side index is written next to the file at `log_index_path(_path)`.
+		 * @return True on good open, false otherwise.
+		*/
+		bool open(const char* _path, bool _indexed = true);
+
+		/**
+		 * @brief Flushes buffered records and closes the file, does nothing if none is open.
+		*/
+		void close();
+
+		/**
+		 * @brief Checks if a file is currently open.
+		*/
+		bool is_open() const;
+
+		/**
+		 * @brief Writes all buffered records out as a segment.
+		*/
+		void flush();
+
+		/**
+		 * @brief Sets the record block size at which a segment is written out.
+		 * @param _bytes Size in bytes.
+		*/
+		void set_segment_capacity(size_t _bytes);
+
+		/**
+		 * @brief Sets whether the record blocks of segments are compressed.
+		 *
+		 * Blocks that don't get smaller are stored uncompressed. Off by default.
+		 *
+		 * @param _enabled True to compress.
+		*/
+		void set_compression(bool _enabled);
+
+		/**
+		 * @brief Appends a record.
+		 * @param _level Log level, uses the values of `asx::LogLevel`.
+		 * @param _site Optional source location the record was logged from, may be null.
+		 * @param _fmt The format string for the record.
+		 * @param _encodedArgs Arguments encoded using `encode_args()`.
+		 * @param _argCount Number of encoded arguments.
+		*/
+		void write(uint8_t _level, const SourceLocation* _site, std::string_view _fmt, std::string_view _encodedArgs, size_t _argCount);
+
+		writer() = default;
+		~writer();
+
+	private:
+
+		struct string_hash
+		{
+			using is_transparent = void;
+			size_t operator()(std::string_view _str) const noexcept
+			{
+				return std::hash<std::string_view>{}(_str);
+			};
+		};
+		using string_id_map = std::unordered_map<std::string, uint32_t, string_hash, std::equal_to<>>;
+
+		uint32_t intern_format(std::string_view _fmt);
+		uint32_t intern_callsite(uint8_t _level, const SourceLocation& _site, uint32_t _formatId);
+		uint32_t add_entry(entry_kind _kind, uint8_t _level, uint32_t _line, uint32_t _formatId, std::string_view _str0, std::string_view _str1);
+
+		void flush_segment();
+
+		mutable std::mutex mtx_;
+		std::ofstream file_;
+		log_index_writer index_;
+
+		/**
+		 * @brief Number of bytes written to the file so far.
+		*/
+		uint64_t file_offset_ = 0;
+
+		string_id_map format_ids_;
+		string_id_map callsite_ids_;
+
+		/**
+		 * @brief Serialized string table, written in full with every segment.
+		*/
+		std::string strings_;
+		uint32_t string_count_ = 0;
+
+		/**
+		 * @brief Buffered record block for the next segment.
+		*/
+		std::string records_;
+		uint64_t record_count_ = 0;
+		uint64_t time_begin_ = 0;
+		uint64_t time_end_ = 0;
+
+		size_t segment_capacity_ = SEGMENT_CAPACITY_DEFAULT;
+
+		bool compress_ = false;
+		std::vector<std::byte> compressed_;
+	};
+
+
+
+	/**
+	 * @brief Checks the segment at the start of some bytes without decoding it.
+	 *
+	 * Verifies the header, that the whole segment is present and its checksum if it has one.
+	 *
+	 * @param _bytes Bytes beginning with a segment, may extend past the end of it.
+	 * @param _outSize Optional, set to the size of the segment in bytes on success.
+	 * @return True if a complete, intact segment was found, false otherwise.
+	*/
+	bool check_segment(std::span<const std::byte> _bytes, size_t* _outSize = nullptr);
+
+	/**
+	 * @brief Finds where the next segment may begin, for skipping past corrupted data.
+	 * @param _bytes Bytes to search.
+	 * @param _offset Offset to start searching at.
+	 * @return Offset of the next `SEGMENT_MAGIC` at or after `_offset`, or the size of `_bytes` if there is none.
+	*/
+	size_t find_segment_magic(std::span<const std::byte> _bytes, size_t _offset);
+
+	/**
+	 * @brief Decoded string table entry.
+	*/
+	struct string_entry
+	{
+		entry_kind kind = entry_kind::format;
+		uint8_t level = 0;
+		uint32_t line = 0;
+
+		/**
+		 * @brief Format string, resolved through `format_id` for call site entries.
+		*/
+		std::string_view format;
+
+		/**
+		 * @brief Call site file, empty for format entries.
+		*/
+		std::string_view file;
+
+		/**
+		 * @brief Call site function, empty for format entries.
+		*/
+		std::string_view function;
+	};
+
+	/**
+	 * @brief View of a single record within a segment.
+	*/
+	struct record_view
+	{
+		uint64_t timestamp = 0;
+		uint32_t site_id = 0;
+		uint8_t level = 0;
+		uint8_t arg_count = 0;
+
+		/**
+		 * @brief The encoded arguments.
+		*/
+		std::span<const std::byte> args;
+	};
+
+	/**
+	 * @brief Decoded record argument, strings view into the segment data.
+	*/
+	using arg_value = std::variant<bool, char, int64_t, uint64_t, double, std::string_view>;
+
+	/**
+	 * @brief Non-owning view of a segment.
+	*/
+	class segment_view
+	{
+	public:
+
+		/**
+		 * @brief Parses the segment at the start of some bytes.
+		 *
+		 * Only the header and string table are decoded, records are decoded while iterating. The
+		 * checksum is verified if the segment has one.
+		 *
+		 * @param _bytes Bytes beginning with a segment, may extend past the end of it.
+		 * @param _outSegment Segment view to write to on success.
+		 * @param _buffer Buffer to decompress a compressed record block into, the view refers to it so it
+		 * must outlive the view and not be modified. Compressed segments fail to parse without one.
+		 * @return True if a complete, valid segment was found, false otherwise.
+		*/
+		static bool parse(std::span<const std::byte> _bytes, segment_view& _outSegment, std::vector<std::byte>* _buffer = nullptr);
+
+		/**
+		 * @brief Parses a segment already accepted by `check_segment`, without verifying its checksum again.
+		 *
+		 * The header is still checked, only the checksum is trusted.
+		 *
+		 * @param _bytes Bytes beginning with a segment that passed `check_segment`, may extend past the end of it.
+		 * @param _outSegment Segment view to write to on success.
+		 * @param _buffer Buffer to decompress a compressed record block into, as for `parse`.
+		 * @return True if a complete, valid segment was found, false otherwise.
+		*/
+		static bool parse_checked(std::span<const std::byte> _bytes, segment_view& _outSegment, std::vector<std::byte>* _buffer = nullptr);
+
+		/**
+		 * @brief Gets the segment's header.
+		*/
+		const segment_header& header() const noexcept
+		{
+			return this->header_;
+		};
+
+		/**
+		 * @brief Gets the total size of the segment in bytes.
+		 * @return Size in bytes.
+		*/
+		size_t size_bytes() const noexcept
+		{
+			return this->size_;
+		};
+
+		/**
+		 * @brief Looks up a string table entry by id.
+		 * @param _id Entry id.
+		 * @return Pointer to the entry, or null if no such entry exists.
+		*/
+		const string_entry* find_entry(uint32_t _id) const noexcept
+		{
+			if (_id == 0 || _id > this->entries_.size()) { return nullptr; };
+			return &this->entries_[_id - 1];
+		};
+
+		/**
+		 * @brief Decodes the record at an offset into the record block and advances the offset past it.
+		 *
+		 * Start with an offset of 0. Only the record header is decoded, skipping a record
+		 * does not touch its arguments.
+		 *
+		 * @param _offset Offset into the record block, advanced to the next record on success.
+		 * @param _outRecord Record view to write to on success.
+		 * @return True if a record was decoded, false at the end of the block or on malformed data.
+		*/
+		bool next_record(size_t& _offset, record_view& _outRecord) const;
+
+		segment_view() = default;
+
+	private:
+		segment_header header_{};
+		std::vector<string_entry> entries_;
+		std::span<const std::byte> records_;
+		size_t size_ = 0;
+	};
+
+	/**
+	 * @brief Decodes the arguments of a record.
+	 * @param _record Record to decode.
+	 * @param _outArgs Vector to append the decoded arguments to.
+	 * @return True on success, false on malformed data.
+	*/
+	bool decode_args(const record_view& _record, std::vector<arg_value>& _outArgs);
+
+	/**
+	 * @brief Formats the message for a record using its format string and arguments.
+	 *
+	 * Supports automatic and manual argument indexing and standard format specs, dynamic
+	 * width/precision replacement fields are not supported and are written out verbatim.
+	 *
+	 * @param _segment Segment the record belongs to.
+	 * @param _record Record to format.
+	 * @param _out String to append the formatted message to.
+	 * @return True on success, false if the record was malformed.
+	*/
+	bool format_record(const segment_view& _segment, const record_view& _record, std::string& _out);
+};
@@ -0,0 +1,240 @@
+#pragma once
+
+/**
+ * @file
+ * @brief Static descriptors for logging and profiling call sites, which can be switched on or off at runtime.
+ *
+ * Every `ASX_LOG_*` and `ASX_PROFILE_TIME_START()` expansion owns a `callsite`. A site registers itself
+ * the first time it is reached, after that checking it costs a single relaxed load (plus the log level
+ * check for sites that follow the log level). Sites can be forced on or off by file, function, line or
+ * format with `set_callsite_mode()`, which also applies to sites that register later.
+*/
+
+#include <asx/source.hpp>
+
+#include <atomic>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+namespace asx
+{
+	enum class LogLevel;
+	LogLevel get_logging_level();
+
+	/**
+	 * @brief What a call site does when it is reached.
+	*/
+	enum class callsite_kind : uint8_t
+	{
+		log,
+		profile,
+	};
+
+	/**
+	 * @brief Decides whether a call site runs.
+	*/
+	enum class callsite_mode : uint8_t
+	{
+		/**
+		 * @brief Runs if the current log level includes the site's level, the default.
+		*/
+		level = 1,
+
+		/**
+		 * @brief Always runs, regardless of the log level.
+		*/
+		enabled,
+
+		/**
+		 * @brief Never runs.
+		*/
+		disabled,
+	};
+
+	class callsite;
+
+	namespace impl
+	{
+		class callsite_registry;
+
+		/**
+		 * @brief Registers a site the first time it is reached.
+		 * @param _site Site to register.
+		 * @param _format Format string of the site, copied.
+		 * @return True if the site should run.
+		*/
+		bool register_callsite(callsite& _site, std::string_view _format);
+	};
+
+	/**
+	 * @brief Describes one logging or profiling call site, always a static local.
+	 *
+	 * Use `ASX_CALLSITE()` to declare one.
+	*/
+	class callsite
+	{
+	public:
+
+		/**
+		 * @brief Checks if the site should run, registering it the first time.
+		 * @param _format Format string of the site, only used the first time.
+		*/
+		bool enabled(std::string_view _format)
+		{
+			const auto _state = this->state_.load(std::memory_order_relaxed);
+			if (_state == static_cast<uint8_t>(callsite_mode::enabled))
+			{
+				return true;
+			}
+			else if (_state == static_cast<uint8_t>(callsite_mode::disabled))
+			{
+				return false;
+			}
+			else if (_state == 0)
+			{
+				return impl::register_callsite(*this, _format);
+			}
+			else
+			{
+				return asx::get_logging_level() >= this->level_;
+			};
+		};
+
+		/**
+		 * @brief Gets the site's current mode.
+		*/
+		callsite_mode mode() const noexcept
+		{
+			return static_cast<callsite_mode>(this->state_.load(std::memory_order_relaxed));
+		};
+
+		/**
+		 * @brief Gets the project relative path of the source file the site is in.
+		*/
+		std::string_view file() const noexcept
+		{
+			return this->file_;
+		};
+
+		/**
+		 * @brief Gets the name of the function the site is in.
+		*/
+		std::string_view function() const noexcept
+		{
+			return this->function_;
+		};
+
+		/**
+		 * @brief Gets the format string of the site.
+		 *
+		 * For sites whose format isn't a literal, this is the format used the first time the site was reached.
+		*/
+		std::string_view format() const noexcept
+		{
+			return this->format_;
+		};
+
+		uint32_t line() const noexcept
+		{
+			return this->line_;
+		};
+
+		LogLevel level() const noexcept
+		{
+			return this->level_;
+		};
+
+		callsite_kind kind() const noexcept
+		{
+			return this->kind_;
+		};
+
+		constexpr callsite(callsite_kind _kind, LogLevel _level, std::string_view _file, std::string_view _function, uint32_t _line) noexcept :
+			file_(_file), function_(_function), line_(_line), level_(_level), kind_(_kind)
+		{};
+
+	private:
+		friend class impl::callsite_registry;
+
+		std::string_view file_;
+		std::string_view function_;
+		std::string_view format_{};
+		uint32_t line_;
+		LogLevel level_;
+		callsite_kind kind_;
+
+		/**
+		 * @brief 0 until registered, then a `callsite_mode` value.
+		*/
+		std::atomic<uint8_t> state_{ 0 };
+
+		/**
+		 * @brief Link in the list of registered sites.
+		*/
+		callsite* next_ = nullptr;
+
+		callsite(const callsite&) = delete;
+		callsite& operator=(const callsite&) = delete;
+	};
+
+	/**
+	 * @brief Selects call sites, every field that is set must match.
+	 *
+	 * Patterns are globs where `*` matches any run of characters and `?` matches any one character.
+	 * The file pattern is matched against both the project relative path and the file name alone.
+	*/
+	struct callsite_query
+	{
+		std::string file{};
+		std::string function{};
+		std::string format{};
+
+		/**
+		 * @brief Line to match, 0 matches any line.
+		*/
+		uint32_t line = 0;
+
+		std::optional<callsite_kind> kind{};
+		std::optional<LogLevel> level{};
+	};
+
+	/**
+	 * @brief Checks if a site is selected by a query.
+	*/
+	bool matches(const callsite_query& _query, const callsite& _site);
+
+	/**
+	 * @brief Gets every registered call site.
+	 *
+	 * Sites only register the first time they are reached, so ones that never ran aren't listed.
+	*/
+	std::vector<const callsite*> get_callsites();
+
+	/**
+	 * @brief Sets the mode of every call site selected by a query.
+	 *
+	 * The query is kept as a rule, so sites that register later are given the mode too. Later calls take
+	 * priority over earlier ones.
+	 *
+	 * @param _query Sites to change.
+	 * @param _mode New mode for them.
+	 * @return Number of registered sites that were selected.
+	*/
+	size_t set_callsite_mode(const callsite_query& _query, callsite_mode _mode);
+
+	/**
+	 * @brief Drops every rule added by `set_callsite_mode()` and puts all sites back to following the log level.
+	*/
+	void reset_callsite_modes();
+};
+
+/**
+ * @brief Declares a static `asx::callsite` named `name` for the current source location.
+ * @param name Name of the variable.
+ * @param kind Kind of the site, an `asx::callsite_kind` value.
+ * @param level Level of the site, an `asx::LogLevel` value.
+*/
+#define ASX_CALLSITE(name, kind, level) static constinit ::asx::callsite name(kind, level, ::asx::fix_project_source_file_path(ASX_FILE), ASX_FUNCTION, ASX_LINE)
@@ -0,0 +1,487 @@
+#pragma once
+
+/** @file */
+
+#include <asx/assert.hpp>
+#include <asx/per_thread.hpp>
+
+#include <bit>
+#include <list>
+#include <mutex>
+#include <memory>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <algorithm>
+#include <exception>
+#include <functional>
+#include <shared_mutex>
+#include <unordered_map>
+#include <condition_variable>
+
+namespace asx
+{
+	/**
+	 * @brief Counters of a concurrent cache.
+	*/
+	struct cache_stats
+	{
+		uint64_t hits = 0;
+		uint64_t misses = 0;
+		uint64_t evictions = 0;
+
+		/**
+		 * @brief Number of cached entries.
+		*/
+		size_t entries = 0;
+
+		/**
+		 * @brief Total weight of the cached entries.
+		*/
+		size_t size_bytes = 0;
+	};
+
+	/**
+	 * @brief Thread-safe cache with a byte budget, split into shards that each evict with segmented CLOCK.
+	 *
+	 * New entries start in a probation segment, entries referenced while there are promoted to a protected
+	 * segment when the eviction sweep reaches them, and protected entries that go unreferenced are demoted
+	 * back. Entries only hit once are evicted first, so a scan can't flush the working set.
+	 *
+	 * A hit only takes its shard's lock shared and sets the entry's reference bit if it isn't already set,
+	 * no list is touched. Hit and miss counters are kept per thread.
+	 *
+	 * @tparam K Key type.
+	 * @tparam V Value type, lookups return copies.
+	 * @tparam HashT Hash of keys.
+	*/
+	template <typename K, typename V, typename HashT = std::hash<K>>
+	class concurrent_cache
+	{
+	public:
+
+		using key_type = K;
+		using mapped_type = V;
+		using hasher = HashT;
+		using size_type = size_t;
+
+		/**
+		 * @brief Returns the weight of an entry counted against the byte budget.
+		*/
+		using weigher_type = std::function<size_type(const key_type&, const mapped_type&)>;
+
+	private:
+
+		struct entry
+		{
+			key_type key;
+			mapped_type value;
+			size_type weight;
+
+			/**
+			 * @brief Set by hits, cleared by the eviction sweep.
+			*/
+			std::atomic<bool> referenced{ false };
+
+			bool is_protected = false;
+		};
+
+		using list_type = std::list<entry>;
+
+		/**
+		 * @brief Result of a miss being computed, shared with threads that miss on the same key meanwhile.
+		*/
+		struct pending
+		{
+			std::mutex mtx;
+			std::condition_variable cv;
+			bool done = false;
+			std::optional<mapped_type> value;
+			std::exception_ptr error;
+		};
+
+		struct alignas(64) shard
+		{
+			mutable std::shared_mutex mtx;
+			std::unordered_map<key_type, typename list_type::iterator, hasher> index;
+
+			/**
+			 * @brief Both segments are CLOCK queues, the sweep works from the front and requeues at the back.
+			*/
+			list_type probation;
+			list_type protected_segment;
+
+			size_type size_bytes = 0;
+			size_type protected_bytes = 0;
+
+			std::unordered_map<key_type, std::shared_ptr<pending>, hasher> in_flight;
+		};
+
+		struct counters
+		{
+			std::atomic<uint64_t> hits{ 0 };
+			std::atomic<uint64_t> misses{ 0 };
+			std::atomic<uint64_t> evictions{ 0 };
+		};
+
+		shard& shard_for(const key_type& _key) const
+		{
+			// Mix the hash so weak hashes still spread over the shards
+			auto _hash = static_cast<uint64_t>(std::invoke(this->hash_, _key));
+			_hash ^= _hash >> 33;
+			_hash *= 0xFF51AFD7ED558CCDULL;
+			_hash ^= _hash >> 33;
+			return this->shards_[_hash & (this->shard_count_ - 1)];
+		};
+
+		static void count(std::atomic<uint64_t>& _counter) noexcept
+		{
+			_counter.store(_counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+		};
+
+		/**
+		 * @brief Looks up an entry with the shard lock held, marking it referenced.
+		*/
+		static std::optional<mapped_type> find_locked(const shard& _shard, const key_type& _key)
+		{
+			const auto it = _shard.index.find(_key);
+			if (it == _shard.index.end())
+			{
+				return std::nullopt;
+			};
+
+			// Only write the bit if needed so hot entries don't bounce their cache line between readers
+			auto& _entry = *it->second;
+			if (!_entry.referenced.load(std::memory_order_relaxed))
+			{
+				_entry.referenced.store(true, std::memory_order_relaxed);
+			};
+			return _entry.value;
+		};
+
+		/**
+		 * @brief Removes an entry with the shard lock held exclusively.
+		*/
+		static void remove_locked(shard& _shard, typename list_type::iterator _it)
+		{
+			_shard.size_bytes -= _it->weight;
+			if (_it->is_protected)
+			{
+				_shard.protected_bytes -= _it->weight;
+				_shard.index.erase(_it->key);
+				_shard.protected_segment.erase(_it);
+			}
+			else
+			{
+				_shard.index.erase(_it->key);
+				_shard.probation.erase(_it);
+			};
+		};
+
+		/**
+		 * @brief Demotes unreferenced protected entries until the protected segment fits its share.
+		*/
+		void balance_locked(shard& _shard)
+		{
+			while (_shard.protected_bytes > this->protected_budget_ && !_shard.protected_segment.empty())
+			{
+				const auto it = _shard.protected_segment.begin();
+				if (it->referenced.exchange(false, std::memory_order_relaxed))
+				{
+					_shard.protected_segment.splice(_shard.protected_segment.end(), _shard.protected_segment, it);
+				}
+				else
+				{
+					it->is_protected = false;
+					_shard.protected_bytes -= it->weight;
+					_shard.probation.splice(_shard.probation.end(), _shard.protected_segment, it);
+				};
+			};
+		};
+
+		/**
+		 * @brief Evicts entries until a new entry of some weight fits in the shard budget.
+		*/
+		void make_room_locked(shard& _shard, size_type _weight)
+		{
+			while (_shard.size_bytes + _weight > this->shard_budget_)
+			{
+				if (_shard.probation.empty())
+				{
+					// Everything is protected, demote the front so the sweep can continue
+					const auto it = _shard.protected_segment.begin();
+					it->is_protected = false;
+					_shard.protected_bytes -= it->weight;
+					_shard.probation.splice(_shard.probation.end(), _shard.protected_segment, it);
+					continue;
+				};
+
+				const auto it = _shard.probation.begin();
+				if (it->referenced.exchange(false, std::memory_order_relaxed))
+				{
+					// Hit while on probation, promote
+					it->is_protected = true;
+					_shard.protected_bytes += it->weight;
+					_shard.protected_segment.splice(_shard.protected_segment.end(), _shard.probation, it);
+					this->balance_locked(_shard);
+				}
+				else
+				{
+					remove_locked(_shard, it);
+					count(this->counters_.local().evictions);
+				};
+			};
+		};
+
+		/**
+		 * @brief Inserts or replaces an entry with the shard lock held exclusively.
+		*/
+		void put_locked(shard& _shard, const key_type& _key, const mapped_type& _value)
+		{
+			if (const auto it = _shard.index.find(_key); it != _shard.index.end())
+			{
+				remove_locked(_shard, it->second);
+			};
+
+			const auto _weight = std::invoke(this->weigher_, _key, _value);
+			if (_weight > this->shard_budget_)
+			{
+				return;
+			};
+
+			this->make_room_locked(_shard, _weight);
+			_shard.probation.emplace_back(_key, _value, _weight);
+			_shard.index.emplace(_key, std::prev(_shard.probation.end()));
+			_shard.size_bytes += _weight;
+		};
+
+	public:
+
+		/**
+		 * @brief Gets a copy of the cached value for a key.
+		 * @return The value, or nullopt on a miss.
+		*/
+		std::optional<mapped_type> get(const key_type& _key) const
+		{
+			auto& _shard = this->shard_for(_key);
+			auto _value = [&]()
+			{
+				const auto lck = std::shared_lock(_shard.mtx);
+				return find_locked(_shard, _key);
+			}();
+
+			auto& _counters = this->counters_.local();
+			count((_value) ? _counters.hits : _counters.misses);
+			return _value;
+		};
+
+		/**
+		 * @brief Inserts or replaces a value, evicting others to stay within budget.
+		 *
+		 * Values heavier than a shard's share of the budget are not cached.
+		*/
+		void put(const key_type& _key, const mapped_type& _value)
+		{
+			auto& _shard = this->shard_for(_key);
+			const auto lck = std::unique_lock(_shard.mtx);
+			this->put_locked(_shard, _key, _value);
+		};
+
+		/**
+		 * @brief Gets the cached value for a key, computing and caching it on a miss.
+		 *
+		 * Concurrent misses on the same key compute it once, the other callers wait for that result.
+		 * If the computation throws the exception is rethrown to every waiting caller and nothing is cached.
+		 *
+		 * @param _key Key to look up.
+		 * @param _fn Invoked as `_fn(key)` to compute the value.
+		 * @return The cached or computed value.
+		*/
+		template <typename FnT>
+		mapped_type get_or_compute(const key_type& _key, FnT&& _fn)
+		{
+			auto& _shard = this->shard_for(_key);
+			auto& _counters = this->counters_.local();
+			{
+				const auto lck = std::shared_lock(_shard.mtx);
+				if (auto _value = find_locked(_shard, _key); _value)
+				{
+					count(_counters.hits);
+					return std::move(*_value);
+				};
+			};
+
+			// Either join a computation already running for this key or start one
+			auto _pending = std::shared_ptr<pending>();
+			bool _owner = false;
+			{
+				const auto lck = std::unique_lock(_shard.mtx);
+				if (auto _value = find_locked(_shard, _key); _value)
+				{
+					count(_counters.hits);
+					return std::move(*_value);
+				};
+				count(_counters.misses);
+
+				auto& _slot = _shard.in_flight[_key];
+				if (!_slot)
+				{
+					_slot = std::make_shared<pending>();
+					_owner = true;
+				};
+				_pending = _slot;
+			};
+
+			if (!_owner)
+			{
+				auto lck = std::unique_lock(_pending->mtx);
+				_pending->cv.wait(lck, [&]() { return _pending->done; });
+				if (_pending->error)
+				{
+					std::rethrow_exception(_pending->error);
+				};
+				return *_pending->value;
+			};
+
+			std::optional<mapped_type> _value;
+			std::exception_ptr _error;
+			try
+			{
+				_value.emplace(std::invoke(_fn, _key));
+			}
+			catch (...)
+			{
+				_error = std::current_exception();
+			};
+
+			{
+				const auto lck = std::unique_lock(_shard.mtx);
+				if (_value)
+				{
+					this->put_locked(_shard, _key, *_value);
+				};
+				_shard.in_flight.erase(_key);
+			};
+			{
+				const auto lck = std::unique_lock(_pending->mtx);
+				_pending->value = _value;
+				_pending->error = _error;
+				_pending->done = true;
+			};
+			_pending->cv.notify_all();
+
+			if (_error)
+			{
+				std::rethrow_exception(_error);
+			};
+			return std::move(*_value);
+		};
+
+		/**
+		 * @brief Removes the entry for a key.
+		 * @return True if an entry was removed.
+		*/
+		bool erase(const key_type& _key)
+		{
+			auto& _shard = this->shard_for(_key);
+			const auto lck = std::unique_lock(_shard.mtx);
+			const auto it = _shard.index.find(_key);
+			if (it == _shard.index.end())
+			{
+				return false;
+			};
+			remove_locked(_shard, it->second);
+			return true;
+		};
+
+		/**
+		 * @brief Removes every entry.
+		*/
+		void clear()
+		{
+			for (size_type n = 0; n != this->shard_count_; ++n)
+			{
+				auto& _shard = this->shards_[n];
+				const auto lck = std::unique_lock(_shard.mtx);
+				_shard.index.clear();
+				_shard.probation.clear();
+				_shard.protected_segment.clear();
+				_shard.size_bytes = 0;
+				_shard.protected_bytes = 0;
+			};
+		};
+
+		/**
+		 * @brief Gets the counters and current size, each part is a snapshot taken at a slightly different time.
+		*/
+		cache_stats stats() const
+		{
+			auto _stats = this->counters_.combine(cache_stats{}, [](cache_stats _acc, const counters& v)
+			{
+				_acc.hits += v.hits.load(std::memory_order_relaxed);
+				_acc.misses += v.misses.load(std::memory_order_relaxed);
+				_acc.evictions += v.evictions.load(std::memory_order_relaxed);
+				return _acc;
+			});
+			for (size_type n = 0; n != this->shard_count_; ++n)
+			{
+				auto& _shard = this->shards_[n];
+				const auto lck = std::shared_lock(_shard.mtx);
+				_stats.entries += _shard.index.size();
+				_stats.size_bytes += _shard.size_bytes;
+			};
+			return _stats;
+		};
+
+		/**
+		 * @brief Gets the number of shards.
+		*/
+		size_type shard_count() const noexcept
+		{
+			return this->shard_count_;
+		};
+
+		/**
+		 * @brief Constructs an empty cache.
+		 * @param _capacityBytes Total weight budget, split evenly over the shards.
+		 * @param _shards Number of shards, rounded up to a power of 2.
+		 * @param _weigher Weight of an entry, defaults to `sizeof(K) + sizeof(V)`.
+		*/
+		explicit concurrent_cache(size_type _capacityBytes, size_type _shards = 16, weigher_type _weigher = nullptr) :
+			shard_count_(std::bit_ceil(std::max<size_type>(_shards, 1))),
+			shards_(std::make_unique<shard[]>(shard_count_)),
+			weigher_(std::move(_weigher))
+		{
+			ASX_CHECK(_capacityBytes != 0);
+			if (!this->weigher_)
+			{
+				this->weigher_ = [](const key_type&, const mapped_type&) { return sizeof(key_type) + sizeof(mapped_type); };
+			};
+			this->shard_budget_ = std::max<size_type>(_capacityBytes / this->shard_count_, 1);
+			this->protected_budget_ = this->shard_budget_ - this->shard_budget_ / 5;
+		};
+
+	private:
+		size_type shard_count_;
+		std::unique_ptr<shard[]> shards_;
+
+		size_type shard_budget_ = 0;
+
+		/**
+		 * @brief Weight the protected segment of a shard may hold, the rest is left for probation.
+		*/
+		size_type protected_budget_ = 0;
+
+		weigher_type weigher_;
+		hasher hash_{};
+
+		/**
+		 * @brief Only the owning thread writes its counters, so they are plain loads and stores.
+		*/
+		mutable per_thread<counters> counters_;
+
+		concurrent_cache(const concurrent_cache&) = delete;
+		concurrent_cache& operator=(const concurrent_cache&) = delete;
+	};
+};
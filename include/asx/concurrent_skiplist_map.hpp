@@ -0,0 +1,500 @@
+#pragma once
+
+/** @file */
+
+#include <asx/epoch.hpp>
+
+#include <bit>
+#include <new>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <optional>
+#include <functional>
+#include <type_traits>
+
+namespace asx
+{
+	/**
+	 * @brief Thread-safe ordered map built on a lock-free skip list.
+	 *
+	 * Lookups never write to shared memory. Inserts link a node level by level with CAS, erases mark a
+	 * node's links (logical deletion) and then unlink it, any search that passes a marked node helps
+	 * unlink it. Removed nodes are reclaimed through an epoch domain, every operation pins it.
+	 *
+	 * Values are immutable once inserted. Iteration is weakly consistent: it never sees an element
+	 * twice or out of order, and sees every element present for its whole duration.
+	 *
+	 * @tparam K Key type.
+	 * @tparam V Value type.
+	 * @tparam CompareT Strict weak ordering of keys.
+	*/
+	template <typename K, typename V, typename CompareT = std::less<K>>
+	class concurrent_skiplist_map
+	{
+	public:
+
+		using key_type = K;
+		using mapped_type = V;
+		using key_compare = CompareT;
+		using size_type = size_t;
+
+		/**
+		 * @brief Maximum number of levels a node can be linked into.
+		*/
+		constexpr static size_type max_level = 24;
+
+	private:
+
+		/**
+		 * @brief Links are node pointers with the low bit set once the owning node is deleted at that level.
+		*/
+		using link_type = std::atomic<uintptr_t>;
+
+		constexpr static uintptr_t mark_bit = 0x1;
+
+		struct node
+		{
+			key_type key;
+			mapped_type value;
+			uint32_t height;
+
+			/**
+			 * @brief Inserter and eraser each hold a reference, the last to finish retires the node.
+			*/
+			std::atomic<uint32_t> refs{ 2 };
+
+			/**
+			 * @brief Gets the node's links, allocated right after it.
+			*/
+			link_type* tower() const noexcept
+			{
+				return reinterpret_cast<link_type*>(reinterpret_cast<std::byte*>(const_cast<node*>(this)) + tower_offset());
+			};
+
+			constexpr static size_t tower_offset() noexcept
+			{
+				return (sizeof(node) + alignof(link_type) - 1) & ~(alignof(link_type) - 1);
+			};
+		};
+
+		static node* to_node(uintptr_t _link) noexcept
+		{
+			return reinterpret_cast<node*>(_link & ~mark_bit);
+		};
+		static uintptr_t to_link(node* _node) noexcept
+		{
+			return reinterpret_cast<uintptr_t>(_node);
+		};
+		static bool is_marked(uintptr_t _link) noexcept
+		{
+			return (_link & mark_bit) != 0;
+		};
+
+		static node* create_node(key_type&& _key, mapped_type&& _value, uint32_t _height)
+		{
+			const auto _size = node::tower_offset() + sizeof(link_type) * _height;
+			auto _mem = ::operator new(_size, std::align_val_t(alignof(node)));
+			auto _node = new (_mem) node{ std::move(_key), std::move(_value), _height };
+			for (uint32_t n = 0; n != _height; ++n)
+			{
+				new (_node->tower() + n) link_type(0);
+			};
+			return _node;
+		};
+
+		static void destroy_node(void* _ptr)
+		{
+			auto _node = static_cast<node*>(_ptr);
+			_node->~node();
+			::operator delete(_ptr, std::align_val_t(alignof(node)));
+		};
+
+		/**
+		 * @brief Picks a node height, each level has half the nodes of the one below.
+		*/
+		static uint32_t random_height() noexcept
+		{
+			thread_local uint64_t _state = reinterpret_cast<uintptr_t>(&_state) * 0x9E3779B97F4A7C15ULL | 1;
+			_state ^= _state << 13;
+			_state ^= _state >> 7;
+			_state ^= _state << 17;
+			return static_cast<uint32_t>(std::countr_zero(_state | (uint64_t(1) << (max_level - 1)))) + 1;
+		};
+
+		bool less(const key_type& lhs, const key_type& rhs) const
+		{
+			return std::invoke(this->comp_, lhs, rhs);
+		};
+
+		/**
+		 * @brief Finds the predecessor and successor of a key on every level, unlinking marked nodes on the way.
+		 * @param _preds Set to the link out of the last node before the key on each level.
+		 * @param _succs Set to the first node not before the key on each level.
+		 * @return False if an unlink lost a race and the search must be retried.
+		*/
+		bool try_search(const key_type& _key, link_type** _preds, node** _succs)
+		{
+			auto _pred = this->head_.data();
+			for (size_type l = max_level; l-- != 0;)
+			{
+				auto _curr = to_node(_pred[l].load(std::memory_order_acquire));
+				while (_curr)
+				{
+					const auto _succ = _curr->tower()[l].load(std::memory_order_acquire);
+					if (is_marked(_succ))
+					{
+						auto _expected = to_link(_curr);
+						if (!_pred[l].compare_exchange_strong(_expected, _succ & ~mark_bit, std::memory_order_acq_rel, std::memory_order_acquire))
+						{
+							return false;
+						};
+						_curr = to_node(_succ);
+					}
+					else if (this->less(_curr->key, _key))
+					{
+						_pred = _curr->tower();
+						_curr = to_node(_succ);
+					}
+					else
+					{
+						break;
+					};
+				};
+				_preds[l] = &_pred[l];
+				_succs[l] = _curr;
+			};
+			return true;
+		};
+
+		/**
+		 * @brief Finds the predecessor and successor of a key on every level, unlinking marked nodes on the way.
+		 * @return True if the level 0 successor holds the key.
+		*/
+		bool search(const key_type& _key, link_type** _preds, node** _succs)
+		{
+			while (!this->try_search(_key, _preds, _succs)) {};
+			return _succs[0] && !this->less(_key, _succs[0]->key);
+		};
+
+		/**
+		 * @brief Finds the first live node whose key is not before a key, without writing to anything.
+		*/
+		node* lower_bound_node(const key_type& _key) const
+		{
+			auto _pred = this->head_.data();
+			node* _curr = nullptr;
+			for (size_type l = max_level; l-- != 0;)
+			{
+				_curr = to_node(_pred[l].load(std::memory_order_acquire));
+				while (_curr)
+				{
+					const auto _succ = _curr->tower()[l].load(std::memory_order_acquire);
+					if (is_marked(_succ))
+					{
+						_curr = to_node(_succ);
+					}
+					else if (this->less(_curr->key, _key))
+					{
+						_pred = _curr->tower();
+						_curr = to_node(_succ);
+					}
+					else
+					{
+						break;
+					};
+				};
+			};
+			return _curr;
+		};
+
+		/**
+		 * @brief Drops a reference to a removed node, retiring it once both inserter and eraser are done.
+		*/
+		void release_node(node* _node)
+		{
+			if (_node->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+			{
+				this->domain_->retire(_node, &concurrent_skiplist_map::destroy_node);
+			};
+		};
+
+		/**
+		 * @brief Links an inserted node into its upper levels, stopping early if it gets erased.
+		*/
+		void link_upper_levels(node* _node, link_type** _preds, node** _succs)
+		{
+			const auto _tower = _node->tower();
+			for (uint32_t l = 1; l < _node->height; ++l)
+			{
+				while (true)
+				{
+					// Point the new link at the current successor, fails if an eraser marked it
+					auto _link = _tower[l].load(std::memory_order_acquire);
+					if (is_marked(_link))
+					{
+						return;
+					};
+					if (_link != to_link(_succs[l]) &&
+						!_tower[l].compare_exchange_strong(_link, to_link(_succs[l]), std::memory_order_acq_rel, std::memory_order_acquire))
+					{
+						return;
+					};
+
+					auto _expected = to_link(_succs[l]);
+					if (_preds[l]->compare_exchange_strong(_expected, to_link(_node), std::memory_order_acq_rel, std::memory_order_acquire))
+					{
+						break;
+					};
+
+					// Lost a race with another writer, refresh and stop if the node was erased meanwhile
+					this->search(_node->key, _preds, _succs);
+					if (_succs[0] != _node)
+					{
+						return;
+					};
+				};
+
+				// An eraser may have marked the node between the two CAS above, its search could have missed this level
+				if (is_marked(_tower[l].load(std::memory_order_acquire)))
+				{
+					this->search(_node->key, _preds, _succs);
+					return;
+				};
+			};
+		};
+
+	public:
+
+		/**
+		 * @brief Inserts an element if its key isn't already present.
+		 * @param _key Key to insert.
+		 * @param _value Value to insert.
+		 * @return True if inserted, false if the key was already present.
+		*/
+		bool insert(key_type _key, mapped_type _value)
+		{
+			const auto _guard = this->domain_->pin();
+
+			link_type* _preds[max_level];
+			node* _succs[max_level];
+			node* _node = nullptr;
+			while (true)
+			{
+				// Once the node exists the key has been moved into it
+				if (this->search((_node) ? _node->key : _key, _preds, _succs))
+				{
+					if (_node)
+					{
+						destroy_node(_node);
+					};
+					return false;
+				};
+
+				if (!_node)
+				{
+					_node = create_node(std::move(_key), std::move(_value), random_height());
+				};
+				for (uint32_t l = 0; l != _node->height; ++l)
+				{
+					_node->tower()[l].store(to_link(_succs[l]), std::memory_order_relaxed);
+				};
+
+				// Linking level 0 is what makes the element present
+				auto _expected = to_link(_succs[0]);
+				if (_preds[0]->compare_exchange_strong(_expected, to_link(_node), std::memory_order_release, std::memory_order_relaxed))
+				{
+					break;
+				};
+			};
+
+			this->size_.fetch_add(1, std::memory_order_relaxed);
+			this->link_upper_levels(_node, _preds, _succs);
+			this->release_node(_node);
+			return true;
+		};
+
+		/**
+		 * @brief Erases the element with a key.
+		 * @param _key Key to erase.
+		 * @return True if this call erased it, false if it wasn't present.
+		*/
+		bool erase(const key_type& _key)
+		{
+			const auto _guard = this->domain_->pin();
+
+			link_type* _preds[max_level];
+			node* _succs[max_level];
+			if (!this->search(_key, _preds, _succs))
+			{
+				return false;
+			};
+
+			// Mark from the top down, marking level 0 is what removes the element
+			const auto _node = _succs[0];
+			const auto _tower = _node->tower();
+			for (uint32_t l = _node->height - 1; l != 0; --l)
+			{
+				_tower[l].fetch_or(mark_bit, std::memory_order_acq_rel);
+			};
+
+			auto _link = _tower[0].load(std::memory_order_acquire);
+			do
+			{
+				if (is_marked(_link))
+				{
+					return false;
+				};
+			} while (!_tower[0].compare_exchange_weak(_link, _link | mark_bit, std::memory_order_acq_rel, std::memory_order_acquire));
+
+			this->size_.fetch_sub(1, std::memory_order_relaxed);
+
+			// Searching unlinks the node from every level it was linked into
+			this->search(_key, _preds, _succs);
+			this->release_node(_node);
+			return true;
+		};
+
+		/**
+		 * @brief Gets a copy of the value for a key.
+		 * @return The value, or nullopt if the key isn't present.
+		*/
+		std::optional<mapped_type> find(const key_type& _key) const
+		{
+			const auto _guard = this->domain_->pin();
+			const auto _node = this->lower_bound_node(_key);
+			if (_node && !this->less(_key, _node->key))
+			{
+				return _node->value;
+			};
+			return std::nullopt;
+		};
+
+		/**
+		 * @brief Checks if a key is present.
+		*/
+		bool contains(const key_type& _key) const
+		{
+			const auto _guard = this->domain_->pin();
+			const auto _node = this->lower_bound_node(_key);
+			return _node && !this->less(_key, _node->key);
+		};
+
+		/**
+		 * @brief Visits the elements with keys in `[_first, _last)` in order.
+		 *
+		 * Elements inserted or erased during the scan may or may not be visited. Keep the visitor short,
+		 * reclamation is held back while it runs.
+		 *
+		 * @param _first First key of the range.
+		 * @param _last Key the range ends before.
+		 * @param _fn Invoked as `_fn(key, value)`, if it returns bool then false stops the scan.
+		*/
+		template <typename FnT>
+		void for_each_range(const key_type& _first, const key_type& _last, FnT&& _fn) const
+		{
+			const auto _guard = this->domain_->pin();
+			for (auto _node = this->lower_bound_node(_first); _node && this->less(_node->key, _last);)
+			{
+				const auto _link = _node->tower()[0].load(std::memory_order_acquire);
+				if (!is_marked(_link))
+				{
+					if constexpr (std::is_same_v<std::invoke_result_t<FnT&, const key_type&, const mapped_type&>, bool>)
+					{
+						if (!std::invoke(_fn, std::as_const(_node->key), std::as_const(_node->value)))
+						{
+							return;
+						};
+					}
+					else
+					{
+						std::invoke(_fn, std::as_const(_node->key), std::as_const(_node->value));
+					};
+				};
+				_node = to_node(_link);
+			};
+		};
+
+		/**
+		 * @brief Visits every element in order, see `for_each_range()`.
+		 * @param _fn Invoked as `_fn(key, value)`, if it returns bool then false stops the scan.
+		*/
+		template <typename FnT>
+		void for_each(FnT&& _fn) const
+		{
+			const auto _guard = this->domain_->pin();
+			for (auto _node = to_node(this->head_[0].load(std::memory_order_acquire)); _node;)
+			{
+				const auto _link = _node->tower()[0].load(std::memory_order_acquire);
+				if (!is_marked(_link))
+				{
+					if constexpr (std::is_same_v<std::invoke_result_t<FnT&, const key_type&, const mapped_type&>, bool>)
+					{
+						if (!std::invoke(_fn, std::as_const(_node->key), std::as_const(_node->value)))
+						{
+							return;
+						};
+					}
+					else
+					{
+						std::invoke(_fn, std::as_const(_node->key), std::as_const(_node->value));
+					};
+				};
+				_node = to_node(_link);
+			};
+		};
+
+		/**
+		 * @brief Gets the number of elements, may be stale while writers are active.
+		*/
+		size_type size() const noexcept
+		{
+			return this->size_.load(std::memory_order_relaxed);
+		};
+
+		bool empty() const noexcept
+		{
+			return this->size() == 0;
+		};
+
+		/**
+		 * @brief Constructs an empty map.
+		 * @param _domain Epoch domain erased nodes are reclaimed through, must outlive this.
+		*/
+		explicit concurrent_skiplist_map(epoch_domain& _domain = default_epoch_domain(), key_compare _comp = key_compare{}) :
+			domain_(&_domain),
+			comp_(std::move(_comp))
+		{};
+
+		/**
+		 * @brief Destroys every element, no thread may use this concurrently.
+		*/
+		~concurrent_skiplist_map()
+		{
+			auto _node = to_node(this->head_[0].load(std::memory_order_acquire));
+			while (_node)
+			{
+				const auto _next = to_node(_node->tower()[0].load(std::memory_order_relaxed));
+				destroy_node(_node);
+				_node = _next;
+			};
+		};
+
+	private:
+
+		/**
+		 * @brief Links out of the head on every level.
+		*/
+		std::array<link_type, max_level> head_{};
+
+		alignas(64) std::atomic<size_type> size_{ 0 };
+
+		epoch_domain* domain_;
+		key_compare comp_;
+
+		concurrent_skiplist_map(const concurrent_skiplist_map&) = delete;
+		concurrent_skiplist_map& operator=(const concurrent_skiplist_map&) = delete;
+	};
+};
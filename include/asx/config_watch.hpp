@@ -0,0 +1,243 @@
+#pragma once
+
+/**
+ * @file
+ * @brief Configuration loaded from a file and reloaded whenever it changes.
+*/
+
+#include <asx/epoch.hpp>
+
+#include <mutex>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include <charconv>
+#include <concepts>
+#include <functional>
+#include <string_view>
+#include <unordered_map>
+
+namespace asx
+{
+	class ArgumentParser;
+
+	/**
+	 * @brief Immutable set of values parsed from a configuration file.
+	 *
+	 * The file holds one `key = value...` entry per line, values are split on whitespace unless
+	 * wrapped in double quotes. Blank lines and lines starting with '#' are ignored.
+	*/
+	class config
+	{
+	public:
+
+		/**
+		 * @brief Gets every value given for a key.
+		 * @return Values, or nullptr if the key wasn't given.
+		*/
+		const std::vector<std::string>* find(std::string_view _key) const;
+
+		/**
+		 * @brief Checks if a key was given.
+		*/
+		bool contains(std::string_view _key) const
+		{
+			return this->find(_key) != nullptr;
+		};
+
+		/**
+		 * @brief Gets the first value given for a key.
+		 * @param _key Key to look up.
+		 * @param _default Returned if the key wasn't given or has no value.
+		*/
+		std::string_view get(std::string_view _key, std::string_view _default = std::string_view{}) const
+		{
+			const auto _values = this->find(_key);
+			return (_values && !_values->empty()) ? std::string_view(_values->front()) : _default;
+		};
+
+		/**
+		 * @brief Gets the first value given for a key converted to a number or bool.
+		 *
+		 * Bools accept "true"/"false", "on"/"off", "yes"/"no" and "1"/"0".
+		 *
+		 * @param _key Key to look up.
+		 * @param _default Returned if the key wasn't given or its value can't be converted.
+		*/
+		template <typename T>
+		requires std::integral<T> || std::floating_point<T>
+		T get_as(std::string_view _key, T _default) const
+		{
+			const auto _text = this->get(_key);
+			if constexpr (std::same_as<T, bool>)
+			{
+				if (_text == "true" || _text == "on" || _text == "yes" || _text == "1")
+				{
+					return true;
+				}
+				else if (_text == "false" || _text == "off" || _text == "no" || _text == "0")
+				{
+					return false;
+				};
+				return _default;
+			}
+			else
+			{
+				auto _value = T{};
+				const auto [_end, _errc] = std::from_chars(_text.data(), _text.data() + _text.size(), _value);
+				return (_errc == std::errc{} && _end == _text.data() + _text.size() && !_text.empty()) ? _value : _default;
+			};
+		};
+
+		/**
+		 * @brief Gets the version of the configuration, 0 until a file was loaded then bumped by each reload.
+		*/
+		uint64_t version() const noexcept
+		{
+			return this->version_;
+		};
+
+		/**
+		 * @brief Parses configuration file text.
+		 *
+		 * With a schema, each key must name one of its options (without the dashes) and take as many
+		 * values as the option does. Values are then stored under the option's label, so they are read
+		 * the same way as the parsed command line.
+		 *
+		 * @param _text File contents.
+		 * @param _schema Optional argument parser whose options are the valid keys.
+		 * @param _outErrorMessage Optional, set to the reason the text was rejected.
+		 * @return True on success, false if any line is invalid.
+		*/
+		bool parse(std::string_view _text, const ArgumentParser* _schema = nullptr, std::string* _outErrorMessage = nullptr);
+
+		/**
+		 * @brief Constructs an empty configuration.
+		*/
+		config() = default;
+
+	private:
+		friend class config_watch;
+
+		struct string_hash
+		{
+			using is_transparent = void;
+			size_t operator()(std::string_view _text) const noexcept
+			{
+				return std::hash<std::string_view>{}(_text);
+			};
+		};
+
+		std::unordered_map<std::string, std::vector<std::string>, string_hash, std::equal_to<>> values_;
+		uint64_t version_ = 0;
+	};
+
+	/**
+	 * @brief Watches a configuration file and publishes a new immutable `config` each time it changes.
+	 *
+	 * Readers never lock. `get()` pins the default epoch domain and loads the current configuration,
+	 * which then stays alive until the returned snapshot is destroyed. Reloads parse the file on a
+	 * background thread, swap the new configuration in and retire the old one. A file that fails to
+	 * parse is logged and the current configuration is kept.
+	 *
+	 * On linux the file's directory is watched with inotify, so editors and tools that replace the file
+	 * through a rename are picked up too. Elsewhere a warning is logged and only `reload()` loads the file.
+	*/
+	class config_watch
+	{
+	public:
+
+		/**
+		 * @brief Keeps a configuration alive and readable, hold it only for short reads.
+		*/
+		class snapshot
+		{
+		public:
+			const config& operator*() const noexcept
+			{
+				return *this->config_;
+			};
+			const config* operator->() const noexcept
+			{
+				return this->config_;
+			};
+
+		private:
+			friend class config_watch;
+
+			snapshot(epoch_guard&& _guard, const config* _config) noexcept :
+				guard_(std::move(_guard)), config_(_config)
+			{};
+
+			epoch_guard guard_;
+			const config* config_;
+		};
+
+		/**
+		 * @brief Called on the watching thread after a new configuration was published.
+		*/
+		using reload_handler = std::function<void(const config& _config)>;
+
+		/**
+		 * @brief Gets the current configuration.
+		*/
+		snapshot get() const
+		{
+			auto _guard = default_epoch_domain().pin();
+			return snapshot(std::move(_guard), this->current_.load(std::memory_order_acquire));
+		};
+
+		/**
+		 * @brief Loads the file now, from the calling thread.
+		 * @return True if a new configuration was published.
+		*/
+		bool reload();
+
+		/**
+		 * @brief Loads the file and starts watching it.
+		 *
+		 * A missing or invalid file leaves an empty configuration in place until the file is fixed.
+		 *
+		 * @param _path Path of the configuration file.
+		 * @param _schema Optional argument parser whose options are the valid keys, must outlive this.
+		 * @param _onReload Optional, called each time a new configuration is published.
+		*/
+		explicit config_watch(std::string _path, const ArgumentParser* _schema = nullptr, reload_handler _onReload = {});
+
+		/**
+		 * @brief Stops watching, snapshots taken before this may still be read until destroyed.
+		*/
+		~config_watch();
+
+	private:
+
+		void watch();
+
+		std::string path_;
+		const ArgumentParser* schema_;
+		reload_handler on_reload_;
+
+		std::atomic<const config*> current_;
+		uint64_t next_version_ = 0;
+
+		/**
+		 * @brief Serializes reloads from the watching thread and `reload()`.
+		*/
+		std::mutex reload_mtx_;
+
+		int inotify_fd_ = -1;
+
+		/**
+		 * @brief Write end of the pipe used to wake the watching thread for shutdown.
+		*/
+		int wake_fd_ = -1;
+		int wake_read_fd_ = -1;
+
+		std::thread thread_;
+
+		config_watch(const config_watch&) = delete;
+		config_watch& operator=(const config_watch&) = delete;
+	};
+};
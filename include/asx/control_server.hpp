@@ -0,0 +1,103 @@
+#pragma once
+
+/**
+ * @file
+ * @brief Local control socket for inspecting and tuning a running process.
+*/
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <functional>
+#include <string_view>
+
+namespace asx
+{
+	/**
+	 * @brief Serves text commands on a unix domain socket from a background thread.
+	 *
+	 * Clients send one command per line and get the command's output back, ended by an empty line, so
+	 * a tool like `socat - UNIX-CONNECT:<path>` can be used interactively. The socket is only
+	 * accessible by the owning user.
+	 *
+	 * Built in commands:
+	 *	- `help` lists the commands.
+	 *	- `loglevel [<level> | <file pattern>=<level>]` shows or sets the log level, a pattern sets it
+	 *	  only for the log call sites in matching files (see `asx/callsite.hpp`).
+	 *	- `profile start [<duration>]` enables every profiling call site, for a while if a duration such
+	 *	  as `10s` or `500ms` is given. `profile stop` puts them back to following the log level.
+	 *	- `metrics dump` lists every registered metric (see `asx/metrics.hpp`).
+	 *	- `stacks` dumps the stack of every thread in the process (linux only, uses `SIGRTMIN + 3`).
+	 *	- `locks` lists every profiled mutex by the time spent waiting on it.
+	 *
+	 * Only implemented on linux, elsewhere a warning is logged and nothing is served.
+	*/
+	class control_server
+	{
+	public:
+
+		/**
+		 * @brief Handles a command, gets the text following the command name and returns the output.
+		*/
+		using handler_type = std::function<std::string(std::string_view _args)>;
+
+		/**
+		 * @brief Adds a command, replacing a built in one with the same name.
+		 *
+		 * May be called while serving, handlers are run on the server thread.
+		 *
+		 * @param _name Name of the command, the first word of the line.
+		 * @param _description Shown by `help`.
+		 * @param _handler Handles the command.
+		*/
+		void add_command(std::string _name, std::string _description, handler_type _handler);
+
+		/**
+		 * @brief Runs a command line as if it had been received on the socket.
+		 * @return Output of the command.
+		*/
+		std::string execute(std::string_view _line);
+
+		/**
+		 * @brief Checks if the socket is being served.
+		*/
+		bool is_running() const noexcept
+		{
+			return this->thread_.joinable();
+		};
+
+		/**
+		 * @brief Creates the socket and starts serving it.
+		 *
+		 * A stale socket file left at the path is replaced. On failure an error is logged and nothing
+		 * is served, commands can still be run with `execute()`.
+		 *
+		 * @param _path Path of the socket file.
+		*/
+		explicit control_server(std::string _path);
+
+		/**
+		 * @brief Stops serving and removes the socket file.
+		*/
+		~control_server();
+
+	private:
+		struct state;
+
+		void serve();
+
+		std::string path_;
+		std::unique_ptr<state> state_;
+
+		/**
+		 * @brief Write end of the pipe used to wake the server thread for shutdown.
+		*/
+		int wake_fd_ = -1;
+
+		std::thread thread_;
+
+		control_server(const control_server&) = delete;
+		control_server& operator=(const control_server&) = delete;
+	};
+};
@@ -0,0 +1,48 @@
+#pragma once
+
+/**
+ * @file
+ * @brief CRC-32C (Castagnoli) checksums.
+*/
+
+#include <span>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace asx
+{
+	/**
+	 * @brief Computes or continues a CRC-32C checksum.
+	 *
+	 * Uses the SSE 4.2 `crc32` instruction on x86-64 and the CRC extension on AArch64 when the CPU has
+	 * them (checked once at runtime), otherwise a slicing-by-8 table implementation.
+	 *
+	 * @param _data Bytes to checksum.
+	 * @param _crc Checksum of the preceding bytes to continue from, 0 to start a new checksum.
+	 * @return Checksum of the preceding bytes followed by `_data`.
+	*/
+	uint32_t crc32c(std::span<const std::byte> _data, uint32_t _crc = 0) noexcept;
+
+	/**
+	 * @brief Computes or continues a CRC-32C checksum over text.
+	*/
+	inline uint32_t crc32c(std::string_view _text, uint32_t _crc = 0) noexcept
+	{
+		return asx::crc32c(std::as_bytes(std::span<const char>(_text.data(), _text.size())), _crc);
+	};
+
+	/**
+	 * @brief Combines the checksums of two adjacent pieces of data.
+	 * @param _crc1 Checksum of the first piece.
+	 * @param _crc2 Checksum of the second piece.
+	 * @param _size2 Size of the second piece in bytes.
+	 * @return Checksum of the first piece followed by the second.
+	*/
+	uint32_t crc32c_combine(uint32_t _crc1, uint32_t _crc2, size_t _size2) noexcept;
+
+	/**
+	 * @brief Checks if `crc32c()` uses CPU instructions rather than tables.
+	*/
+	bool crc32c_is_hardware_accelerated() noexcept;
+};
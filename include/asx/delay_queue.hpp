@@ -0,0 +1,443 @@
+#pragma once
+
+/** @file */
+
+#include <jclib/concepts.h>
+
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <vector>
+#include <cstdint>
+#include <utility>
+#include <algorithm>
+#include <optional>
+#include <type_traits>
+#include <condition_variable>
+
+namespace asx
+{
+	/**
+	 * @brief Provides a thread-safe message queue whose elements only become visible once their delivery time is reached.
+	 *
+	 * Elements are delivered in deadline order, elements with the same deadline are delivered in the
+	 * order they were pushed.
+	 *
+	 * WARNING: Any number of threads may push, but only ONE thread may read (try_next, wait_next).
+	 * Pushed elements go to an intake list that the reader moves into a 4-ary heap it owns, so the
+	 * heap itself is never locked.
+	 *
+	 * @tparam T The type the queue will store, the heap moves elements by assignment.
+	 * @tparam ClockT Clock used for delivery times.
+	 * @tparam SingleProducer If true, only ONE thread may push, and pushing becomes lock-free.
+	*/
+	template <jc::cx_move_constructible T, typename ClockT = std::chrono::steady_clock, bool SingleProducer = false>
+	requires std::is_move_assignable_v<T>
+	class delay_queue
+	{
+	public:
+
+		using value_type = T;
+		using pointer = value_type*;
+		using reference = value_type&;
+		using const_pointer = const value_type*;
+		using const_reference = const value_type&;
+
+		using size_type = size_t;
+
+		using clock_type = ClockT;
+		using time_point = typename clock_type::time_point;
+		using duration = typename clock_type::duration;
+
+	private:
+
+		/**
+		 * @brief Node of the lock-free single producer intake list.
+		*/
+		struct intake_node
+		{
+			value_type value;
+			time_point deadline;
+			intake_node* next;
+		};
+
+		/**
+		 * @brief Element of the intake vector used with multiple producers.
+		*/
+		struct intake_entry
+		{
+			value_type value;
+			time_point deadline;
+		};
+
+		struct heap_entry
+		{
+			time_point deadline;
+
+			/**
+			 * @brief Order the element entered the heap in, keeps equal deadlines FIFO.
+			*/
+			uint64_t sequence;
+
+			value_type value;
+
+			bool operator<(const heap_entry& rhs) const noexcept
+			{
+				return (this->deadline < rhs.deadline) ||
+					(this->deadline == rhs.deadline && this->sequence < rhs.sequence);
+			};
+		};
+
+		/**
+		 * @brief Number of children each heap node has.
+		*/
+		constexpr static size_t heap_arity = 4;
+
+		void heap_push(time_point _deadline, value_type&& _value)
+		{
+			auto& _heap = this->heap_;
+			_heap.push_back(heap_entry{ _deadline, this->next_sequence_++, std::move(_value) });
+
+			// Sift up
+			auto _pos = _heap.size() - 1;
+			while (_pos != 0)
+			{
+				const auto _parent = (_pos - 1) / heap_arity;
+				if (!(_heap[_pos] < _heap[_parent]))
+				{
+					break;
+				};
+				std::swap(_heap[_pos], _heap[_parent]);
+				_pos = _parent;
+			};
+		};
+
+		value_type heap_pop()
+		{
+			auto& _heap = this->heap_;
+			auto _value = std::move(_heap.front().value);
+			if (_heap.size() != 1)
+			{
+				_heap.front() = std::move(_heap.back());
+			};
+			_heap.pop_back();
+
+			// Sift down
+			const auto _size = _heap.size();
+			size_t _pos = 0;
+			while (true)
+			{
+				const auto _firstChild = _pos * heap_arity + 1;
+				if (_firstChild >= _size)
+				{
+					break;
+				};
+
+				auto _smallest = _firstChild;
+				const auto _lastChild = std::min(_firstChild + heap_arity, _size);
+				for (auto n = _firstChild + 1; n < _lastChild; ++n)
+				{
+					if (_heap[n] < _heap[_smallest])
+					{
+						_smallest = n;
+					};
+				};
+
+				if (!(_heap[_smallest] < _heap[_pos]))
+				{
+					break;
+				};
+				std::swap(_heap[_pos], _heap[_smallest]);
+				_pos = _smallest;
+			};
+
+			return _value;
+		};
+
+		/**
+		 * @brief Moves everything pushed since the last call into the heap.
+		*/
+		void drain_intake()
+		{
+			if constexpr (SingleProducer)
+			{
+				auto _node = this->intake_head_.exchange(nullptr, std::memory_order_acquire);
+
+				// The list is newest first, reverse it so the heap sees push order
+				intake_node* _reversed = nullptr;
+				while (_node)
+				{
+					auto _next = _node->next;
+					_node->next = _reversed;
+					_reversed = _node;
+					_node = _next;
+				};
+
+				while (_reversed)
+				{
+					auto _next = _reversed->next;
+					this->heap_push(_reversed->deadline, std::move(_reversed->value));
+					delete _reversed;
+					_reversed = _next;
+				};
+			}
+			else
+			{
+				{
+					const auto lck = std::unique_lock(this->mtx_);
+					std::swap(this->intake_, this->drained_intake_);
+				};
+				for (auto& _entry : this->drained_intake_)
+				{
+					this->heap_push(_entry.deadline, std::move(_entry.value));
+				};
+				this->drained_intake_.clear();
+			};
+		};
+
+		/**
+		 * @brief Checks if anything has been pushed since the last drain. Must be called while locked.
+		*/
+		bool has_intake() const noexcept
+		{
+			if constexpr (SingleProducer)
+			{
+				return this->intake_head_.load(std::memory_order_seq_cst) != nullptr;
+			}
+			else
+			{
+				return !this->intake_.empty();
+			};
+		};
+
+		/**
+		 * @brief Wakes the reader if it is sleeping.
+		*/
+		void wake_reader()
+		{
+			if (this->sleeping_.load(std::memory_order_seq_cst))
+			{
+				// Taking the lock ensures the reader is inside its wait and will see the notify
+				const auto lck = std::unique_lock(this->mtx_);
+				this->sleeping_.store(false, std::memory_order_relaxed);
+				this->cvar_.notify_one();
+			};
+		};
+
+	public:
+
+		/**
+		 * @brief Pushes an element to be delivered at a given time.
+		 * @param _value Value to add to the queue.
+		 * @param _deliverAt Time at which the value becomes visible to the reader.
+		*/
+		void push(value_type _value, time_point _deliverAt)
+		{
+			if constexpr (SingleProducer)
+			{
+				auto _node = new intake_node{ std::move(_value), _deliverAt, this->intake_head_.load(std::memory_order_relaxed) };
+
+				// Only the reader can change the head, and only ever to null
+				while (!this->intake_head_.compare_exchange_weak(_node->next, _node, std::memory_order_seq_cst, std::memory_order_relaxed))
+				{};
+				this->wake_reader();
+			}
+			else
+			{
+				const auto lck = std::unique_lock(this->mtx_);
+				this->intake_.push_back(intake_entry{ std::move(_value), _deliverAt });
+				if (this->sleeping_.load(std::memory_order_relaxed))
+				{
+					this->sleeping_.store(false, std::memory_order_relaxed);
+					this->cvar_.notify_one();
+				};
+			};
+		};
+
+		/**
+		 * @brief Pushes an element to be delivered after a delay.
+		 * @param _value Value to add to the queue.
+		 * @param _delay Time from now at which the value becomes visible to the reader.
+		*/
+		void push_after(value_type _value, duration _delay)
+		{
+			this->push(std::move(_value), clock_type::now() + _delay);
+		};
+
+		/**
+		 * @brief Attempts to grab the next due element in the queue. READER ONLY.
+		 * @param _now Current time, elements with a delivery time at or before this are due.
+		 * @return The next due element, or nullopt if none are due.
+		*/
+		std::optional<value_type> try_next(time_point _now = clock_type::now())
+		{
+			this->drain_intake();
+			if (!this->heap_.empty() && this->heap_.front().deadline <= _now)
+			{
+				return this->heap_pop();
+			};
+			return std::nullopt;
+		};
+
+		/**
+		 * @brief Waits for the next element to become due, or until a timeout. READER ONLY.
+		 * @param _timeout Time to stop waiting at.
+		 * @return The next due element, or nullopt if none became due before the timeout.
+		*/
+		std::optional<value_type> wait_next_until(time_point _timeout)
+		{
+			while (true)
+			{
+				const auto _now = clock_type::now();
+				if (auto _value = this->try_next(_now); _value)
+				{
+					return _value;
+				};
+				if (_now >= _timeout)
+				{
+					return std::nullopt;
+				};
+
+				// Sleep until the earliest deadline, or until something is pushed
+				auto _wakeAt = _timeout;
+				if (!this->heap_.empty() && this->heap_.front().deadline < _wakeAt)
+				{
+					_wakeAt = this->heap_.front().deadline;
+				};
+
+				auto lck = std::unique_lock(this->mtx_);
+				this->sleeping_.store(true, std::memory_order_seq_cst);
+				if (!this->has_intake())
+				{
+					const auto _woken = [this]() { return !this->sleeping_.load(std::memory_order_relaxed); };
+					if (_wakeAt == time_point::max())
+					{
+						this->cvar_.wait(lck, _woken);
+					}
+					else
+					{
+						this->cvar_.wait_until(lck, _wakeAt, _woken);
+					};
+				};
+				this->sleeping_.store(false, std::memory_order_relaxed);
+			};
+		};
+
+		/**
+		 * @brief Waits for a duration for the next element to become due. READER ONLY.
+		 * @param _timeout Maximum time to wait for.
+		 * @return The next due element, or nullopt if none became due in time.
+		*/
+		std::optional<value_type> wait_next_for(duration _timeout)
+		{
+			// Saturate rather than overflow, a timeout past the end of the clock waits like wait_next()
+			const auto _now = clock_type::now();
+			if (_timeout >= time_point::max() - _now)
+			{
+				return this->wait_next_until(time_point::max());
+			};
+			return this->wait_next_until(_now + _timeout);
+		};
+
+		/**
+		 * @brief Waits for the next element to become due. READER ONLY.
+		 * @return The next due element.
+		*/
+		value_type wait_next()
+		{
+			return std::move(*this->wait_next_until(time_point::max()));
+		};
+
+		/**
+		 * @brief Gets the delivery time of the next element. READER ONLY.
+		 * @return Delivery time, or nullopt if the queue is empty.
+		*/
+		std::optional<time_point> next_deadline()
+		{
+			this->drain_intake();
+			if (this->heap_.empty())
+			{
+				return std::nullopt;
+			};
+			return this->heap_.front().deadline;
+		};
+
+		/**
+		 * @brief Gets the number of elements held, due or not. READER ONLY.
+		*/
+		size_type size()
+		{
+			this->drain_intake();
+			return this->heap_.size();
+		};
+
+		/**
+		 * @brief Checks if the queue holds NO elements, due or not. READER ONLY.
+		*/
+		bool empty()
+		{
+			return this->size() == 0;
+		};
+
+		/**
+		 * @brief Constructs an empty delay queue.
+		*/
+		delay_queue() = default;
+
+		~delay_queue()
+		{
+			if constexpr (SingleProducer)
+			{
+				auto _node = this->intake_head_.exchange(nullptr, std::memory_order_acquire);
+				while (_node)
+				{
+					auto _next = _node->next;
+					delete _node;
+					_node = _next;
+				};
+			};
+		};
+
+	private:
+
+		/**
+		 * @brief Protects the intake when there are multiple producers, and the reader's sleep.
+		*/
+		mutable std::mutex mtx_;
+
+		/**
+		 * @brief Signalled when something is pushed while the reader is sleeping.
+		*/
+		std::condition_variable cvar_;
+
+		/**
+		 * @brief Set while the reader is (about to be) waiting on `cvar_`.
+		*/
+		std::atomic<bool> sleeping_{ false };
+
+		/**
+		 * @brief Newest first list of elements pushed by the single producer.
+		*/
+		std::atomic<intake_node*> intake_head_{ nullptr };
+
+		/**
+		 * @brief Elements pushed by multiple producers, guarded by `mtx_`.
+		*/
+		std::vector<intake_entry> intake_;
+
+		/**
+		 * @brief Intake storage being drained by the reader, swapped with `intake_` to reuse allocations.
+		*/
+		std::vector<intake_entry> drained_intake_;
+
+		/**
+		 * @brief Min heap of delivery times, owned by the reader.
+		*/
+		std::vector<heap_entry> heap_;
+
+		uint64_t next_sequence_ = 0;
+
+		delay_queue(const delay_queue&) = delete;
+		delay_queue& operator=(const delay_queue&) = delete;
+	};
+};
@@ -0,0 +1,175 @@
+#pragma once
+
+/**
+ * @file
+ * @brief Hex and base64 encoding of binary data, UTF-8 validation and JSON string escaping.
+ *
+ * Bulk data is handled with SSSE3 on x86-64 CPUs that have it (checked once at runtime), the rest
+ * with scalar code. Decoding is strict, anything that isn't exactly the canonical encoding of some
+ * bytes is rejected.
+*/
+
+#include <span>
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace asx
+{
+	/**
+	 * @brief Gets the number of characters hex encoding some bytes takes.
+	*/
+	constexpr size_t hex_encoded_size(size_t _size) noexcept
+	{
+		return _size * 2;
+	};
+
+	/**
+	 * @brief Encodes bytes as lowercase hex.
+	 * @param _bytes Bytes to encode.
+	 * @param _out Buffer to write to, must hold at least `hex_encoded_size(_bytes.size())` characters.
+	*/
+	void hex_encode(std::span<const std::byte> _bytes, std::span<char> _out) noexcept;
+
+	/**
+	 * @brief Encodes bytes as lowercase hex.
+	 * @param _bytes Bytes to encode.
+	 * @return The hex text.
+	*/
+	std::string hex_encode(std::span<const std::byte> _bytes);
+
+	/**
+	 * @brief Decodes hex text, either case is accepted.
+	 * @param _text Text to decode, must be exactly `hex_encoded_size(_out.size())` characters.
+	 * @param _out Buffer to write the bytes to.
+	 * @return True on success, false if the size doesn't match or a character isn't a hex digit.
+	*/
+	bool hex_decode(std::string_view _text, std::span<std::byte> _out) noexcept;
+
+	/**
+	 * @brief Decodes hex text, either case is accepted.
+	 * @param _text Text to decode.
+	 * @param _out Vector to append the bytes to, left unchanged on failure.
+	 * @return True on success, false if the size is odd or a character isn't a hex digit.
+	*/
+	bool hex_decode(std::string_view _text, std::vector<std::byte>& _out);
+
+
+
+	/**
+	 * @brief Alphabets for base64.
+	*/
+	enum class base64_alphabet : uint8_t
+	{
+		/**
+		 * @brief Uses '+' and '/' for the last two digits (RFC 4648 section 4).
+		*/
+		standard,
+
+		/**
+		 * @brief Uses '-' and '_' for the last two digits, safe in URLs and file names (RFC 4648 section 5).
+		*/
+		url,
+	};
+
+	/**
+	 * @brief Gets the number of characters base64 encoding some bytes takes.
+	 * @param _size Number of bytes.
+	 * @param _padded If true, includes the '=' padding up to a multiple of 4 characters.
+	*/
+	constexpr size_t base64_encoded_size(size_t _size, bool _padded = true) noexcept
+	{
+		return _padded ? (_size + 2) / 3 * 4 : (_size * 4 + 2) / 3;
+	};
+
+	/**
+	 * @brief Gets the most bytes some base64 text can decode to.
+	*/
+	constexpr size_t base64_decoded_size_max(size_t _textSize) noexcept
+	{
+		return (_textSize + 3) / 4 * 3;
+	};
+
+	/**
+	 * @brief Encodes bytes as base64.
+	 * @param _bytes Bytes to encode.
+	 * @param _out Buffer to write to, must hold at least `base64_encoded_size(_bytes.size(), _padded)` characters.
+	 * @param _alphabet Digits to use.
+	 * @param _padded If true, '=' padding is written up to a multiple of 4 characters.
+	 * @return Number of characters written.
+	*/
+	size_t base64_encode(std::span<const std::byte> _bytes, std::span<char> _out,
+		base64_alphabet _alphabet = base64_alphabet::standard, bool _padded = true) noexcept;
+
+	/**
+	 * @brief Encodes bytes as base64.
+	 * @param _bytes Bytes to encode.
+	 * @param _alphabet Digits to use.
+	 * @param _padded If true, '=' padding is written up to a multiple of 4 characters.
+	 * @return The base64 text.
+	*/
+	std::string base64_encode(std::span<const std::byte> _bytes,
+		base64_alphabet _alphabet = base64_alphabet::standard, bool _padded = true);
+
+	/**
+	 * @brief Decodes base64 text.
+	 *
+	 * Padding is optional, but if present the text must be a multiple of 4 characters. Whitespace,
+	 * digits from the other alphabet and unused bits that aren't zero are rejected.
+	 *
+	 * @param _text Text to decode.
+	 * @param _out Buffer to write to, must hold at least `base64_decoded_size_max(_text.size())` bytes.
+	 * @param _outSize Set to the number of bytes decoded on success.
+	 * @param _alphabet Digits the text uses.
+	 * @return True on success, false if the text isn't valid base64.
+	*/
+	bool base64_decode(std::string_view _text, std::span<std::byte> _out, size_t& _outSize,
+		base64_alphabet _alphabet = base64_alphabet::standard) noexcept;
+
+	/**
+	 * @brief Decodes base64 text, see the other overload for the rules.
+	 * @param _text Text to decode.
+	 * @param _out Vector to append the bytes to, left unchanged on failure.
+	 * @param _alphabet Digits the text uses.
+	 * @return True on success, false if the text isn't valid base64.
+	*/
+	bool base64_decode(std::string_view _text, std::vector<std::byte>& _out,
+		base64_alphabet _alphabet = base64_alphabet::standard);
+
+
+
+	/**
+	 * @brief Checks if bytes are valid UTF-8.
+	 *
+	 * Overlong forms, surrogates, code points past U+10FFFF and truncated sequences are invalid.
+	 * Runs of ASCII are skipped 16 bytes at a time.
+	 *
+	 * @param _bytes Bytes to check.
+	 * @param _outValidSize Optional, set to the size of the valid prefix, which is all of `_bytes` on success.
+	 * @return True if all of the bytes are valid UTF-8.
+	*/
+	bool utf8_validate(std::span<const std::byte> _bytes, size_t* _outValidSize = nullptr) noexcept;
+
+	/**
+	 * @brief Checks if text is valid UTF-8.
+	*/
+	inline bool utf8_validate(std::string_view _text, size_t* _outValidSize = nullptr) noexcept
+	{
+		return asx::utf8_validate(std::as_bytes(std::span<const char>(_text.data(), _text.size())), _outValidSize);
+	};
+
+	/**
+	 * @brief Appends text escaped for use inside a JSON string, without the surrounding quotes.
+	 *
+	 * Quotes, backslashes and control characters are escaped, and bytes that aren't part of valid
+	 * UTF-8 are replaced with `\ufffd` so the output is always valid JSON. Runs of characters
+	 * that need neither are copied 16 bytes at a time.
+	 *
+	 * @param _out String to append to.
+	 * @param _text Text to escape.
+	 * @return True if the text was valid UTF-8, false if anything was replaced.
+	*/
+	bool json_escape_to(std::string& _out, std::string_view _text);
+};
@@ -0,0 +1,219 @@
+#pragma once
+
+/**
+ * @file
+ * @brief Epoch based reclamation for memory removed from lock-free structures.
+ *
+ * Readers pin the domain's epoch for the duration of a read-side critical section. Retired objects
+ * are deleted once the epoch has advanced twice past their retirement, at which point no reader that
+ * could have seen them is still pinned.
+*/
+
+#include <mutex>
+#include <atomic>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+namespace asx
+{
+	/**
+	 * @brief Per-thread participation record of an epoch domain.
+	*/
+	struct alignas(64) epoch_record
+	{
+		/**
+		 * @brief `(epoch << 1) | 1` while the owning thread is pinned, 0 otherwise.
+		*/
+		std::atomic<uint64_t> state{ 0 };
+
+		/**
+		 * @brief Set while a thread owns this record.
+		*/
+		std::atomic<bool> active{ false };
+
+		/**
+		 * @brief Pin nesting depth, only touched by the owning thread.
+		*/
+		uint32_t nesting = 0;
+
+		epoch_record* next = nullptr;
+	};
+
+	class epoch_guard;
+
+	/**
+	 * @brief Tracks the epoch of readers and the objects retired while they may still see them.
+	 *
+	 * Reading is wait-free: pinning is a load and a store to a thread owned record. Each thread keeps a
+	 * limbo list of its retired objects, every so often a retiring thread tries to advance the epoch and
+	 * deletes the objects from two or more epochs ago. A stalled reader holds back reclamation for the
+	 * whole domain, so keep critical sections short. Limbo lists of exited threads are handed to the domain.
+	 *
+	 * A domain must outlive every thread that used it, prefer `default_epoch_domain()`.
+	*/
+	class epoch_domain
+	{
+	public:
+
+		using deleter_type = void(*)(void*);
+
+		/**
+		 * @brief Pins the calling thread, objects it can see won't be deleted until the guard is destroyed.
+		 * @return Guard that unpins on destruction, pins may be nested.
+		*/
+		[[nodiscard]] epoch_guard pin();
+
+		/**
+		 * @brief Retires an object, deleting it once no pinned reader could still see it.
+		 * @param _ptr Object to retire, must already be unreachable for new readers.
+		 * @param _deleter Function used to delete the object.
+		*/
+		void retire(void* _ptr, deleter_type _deleter);
+
+		/**
+		 * @brief Retires an object allocated with `new`.
+		 * @param _ptr Object to retire, must already be unreachable for new readers.
+		*/
+		template <typename T>
+		void retire(T* _ptr)
+		{
+			this->retire(static_cast<void*>(_ptr), [](void* p) { delete static_cast<T*>(p); });
+		};
+
+		/**
+		 * @brief Tries to advance the epoch and deletes the calling thread's reclaimable objects.
+		*/
+		void reclaim();
+
+		/**
+		 * @brief Blocks until every reader pinned before this call has unpinned, then reclaims.
+		 *
+		 * Must not be called while the calling thread is pinned.
+		*/
+		void synchronize();
+
+		/**
+		 * @brief Gets the current global epoch.
+		*/
+		uint64_t epoch() const noexcept
+		{
+			return this->epoch_.load(std::memory_order_acquire);
+		};
+
+		epoch_domain() = default;
+		~epoch_domain();
+
+	private:
+		friend class epoch_guard;
+		friend struct epoch_thread_state;
+
+		struct retired_object
+		{
+			void* ptr;
+			deleter_type deleter;
+			uint64_t epoch;
+		};
+
+		/**
+		 * @brief Gets the calling thread's record, acquiring one on first use.
+		*/
+		epoch_record& this_thread_record();
+
+		void enter(epoch_record& _record) noexcept
+		{
+			if (_record.nesting++ == 0)
+			{
+				const auto _epoch = this->epoch_.load(std::memory_order_relaxed);
+				_record.state.store((_epoch << 1) | 1, std::memory_order_seq_cst);
+			};
+		};
+
+		void leave(epoch_record& _record) noexcept
+		{
+			if (--_record.nesting == 0)
+			{
+				_record.state.store(0, std::memory_order_release);
+			};
+		};
+
+		/**
+		 * @brief Advances the global epoch if every pinned reader has seen the current one.
+		 * @return True if the epoch was advanced.
+		*/
+		bool try_advance() noexcept;
+
+		/**
+		 * @brief Deletes the objects in a list retired at least two epochs ago.
+		*/
+		void collect(std::vector<retired_object>& _limbo);
+
+		epoch_record* acquire_record();
+
+		alignas(64) std::atomic<uint64_t> epoch_{ 1 };
+
+		/**
+		 * @brief Lock-free list of every record, records are never removed until destruction.
+		*/
+		std::atomic<epoch_record*> records_{ nullptr };
+
+		/**
+		 * @brief Objects left behind by exited threads.
+		*/
+		std::mutex orphans_mtx_;
+		std::vector<retired_object> orphans_;
+		std::atomic<bool> has_orphans_{ false };
+
+		epoch_domain(const epoch_domain&) = delete;
+		epoch_domain& operator=(const epoch_domain&) = delete;
+	};
+
+	/**
+	 * @brief Gets the process wide epoch domain, it is never destroyed.
+	*/
+	epoch_domain& default_epoch_domain();
+
+	/**
+	 * @brief Keeps the calling thread pinned in an epoch domain while alive.
+	*/
+	class epoch_guard
+	{
+	public:
+
+		epoch_guard(epoch_guard&& other) noexcept :
+			domain_(other.domain_),
+			record_(std::exchange(other.record_, nullptr))
+		{};
+
+		~epoch_guard()
+		{
+			if (this->record_)
+			{
+				this->domain_->leave(*this->record_);
+			};
+		};
+
+	private:
+		friend class epoch_domain;
+
+		epoch_guard(epoch_domain& _domain, epoch_record& _record) noexcept :
+			domain_(&_domain),
+			record_(&_record)
+		{
+			this->domain_->enter(*this->record_);
+		};
+
+		epoch_domain* domain_;
+		epoch_record* record_;
+
+		epoch_guard(const epoch_guard&) = delete;
+		epoch_guard& operator=(const epoch_guard&) = delete;
+		epoch_guard& operator=(epoch_guard&&) = delete;
+	};
+
+	inline epoch_guard epoch_domain::pin()
+	{
+		return epoch_guard(*this, this->this_thread_record());
+	};
+};
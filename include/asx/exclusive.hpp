@@ -7,6 +7,11 @@
 #include <asx/type_traits.hpp>
 
 #include <mutex>
+#include <chrono>
+#include <memory>
+#include <utility>
+#include <functional>
+#include <condition_variable>
 
 namespace asx
 {
@@ -31,6 +36,11 @@ namespace asx
 	private:
 		using lock_type = std::unique_lock<mutex_type>;
 
+		/**
+		 * @brief Condition variable of the owning exclusive, created by the first waiter under the lock.
+		*/
+		using condition_slot = std::unique_ptr<std::condition_variable_any>;
+
 	public:
 
 		bool good() const
@@ -44,16 +54,34 @@ namespace asx
 
 		/**
 		 * @brief Unlocks the managed lock (if present) and releases ownership of the locked state.
+		 *
+		 * Wakes threads waiting on the owning exclusive if `notify_on_release()` was called. The wake
+		 * happens before unlocking, as the exclusive (and its condition variable) may be destroyed as
+		 * soon as the lock is given up.
 		*/
 		void unlock()
 		{
 			if (this->lck_)
 			{
 				this->ptr_ = nullptr;
+				if (std::exchange(this->notify_, false) && *this->cv_)
+				{
+					(*this->cv_)->notify_all();
+				};
 				this->lck_.unlock();
 			};
 		};
 
+		/**
+		 * @brief Wakes threads waiting on the owning exclusive once this is unlocked.
+		 *
+		 * Call after mutating the value in a way waiters may care about, readers that don't skip the wake.
+		*/
+		void notify_on_release() noexcept
+		{
+			this->notify_ = (this->cv_ != nullptr);
+		};
+
 		pointer get() const noexcept
 		{
 			return this->ptr_;
@@ -71,16 +99,34 @@ namespace asx
 			return *this->get();
 		};
 
-		explicit locked_ptr(reference _ptr, mutex_type& _mtx) :
-			ptr_(&_ptr), lck_(_mtx)
+		explicit locked_ptr(reference _ptr, mutex_type& _mtx, condition_slot* _cv = nullptr) :
+			ptr_(&_ptr), lck_(_mtx), cv_(_cv)
 		{
 			ASX_CHECK((this->ptr_ != nullptr) == (this->lck_.owns_lock()));
 		};
-		
+
+		/**
+		 * @brief Takes ownership of an already held lock.
+		*/
+		explicit locked_ptr(reference _ptr, lock_type&& _lck, condition_slot* _cv = nullptr) :
+			ptr_(&_ptr), lck_(std::move(_lck)), cv_(_cv)
+		{
+			ASX_CHECK(this->lck_.owns_lock());
+		};
+
+		/**
+		 * @brief Constructs without owning a lock, `good()` returns false.
+		*/
+		locked_ptr() noexcept :
+			ptr_(nullptr), lck_()
+		{};
+
 		locked_ptr(locked_ptr&& other) noexcept
 		requires std::move_constructible<lock_type> :
-			lck_(std::move(other.mtx_)),
-			ptr_(std::exchange(other.ptr_, nullptr))
+			ptr_(std::exchange(other.ptr_, nullptr)),
+			lck_(std::move(other.lck_)),
+			cv_(std::exchange(other.cv_, nullptr)),
+			notify_(std::exchange(other.notify_, false))
 		{};
 
 		locked_ptr& operator=(locked_ptr&& other) noexcept
@@ -89,8 +135,10 @@ namespace asx
 			if (this == &other) { return *this; };
 
 			this->unlock();
-			this->lck_ = std::move(other.mtx_);
 			this->ptr_ = std::exchange(other.ptr_, nullptr);
+			this->lck_ = std::move(other.lck_);
+			this->cv_ = std::exchange(other.cv_, nullptr);
+			this->notify_ = std::exchange(other.notify_, false);
 			return *this;
 		};
 
@@ -102,6 +150,16 @@ namespace asx
 	private:
 		pointer ptr_;
 		std::unique_lock<mutex_type> lck_;
+
+		/**
+		 * @brief Condition variable slot of the owning exclusive, if any, only read while locked.
+		*/
+		condition_slot* cv_ = nullptr;
+
+		/**
+		 * @brief Set by `notify_on_release()`, waiters (if any) are notified on unlock.
+		*/
+		bool notify_ = false;
 	
 		locked_ptr(const locked_ptr&) = delete;
 		locked_ptr& operator=(const locked_ptr&) = delete;
@@ -146,6 +204,20 @@ namespace asx
 			this->mtx_.unlock();
 		};
 
+		/**
+		 * @brief Gets the condition variable waiters sleep on, creating it on first use.
+		 *
+		 * Must be called while locked.
+		*/
+		std::condition_variable_any& condition() const
+		{
+			if (!this->cv_)
+			{
+				this->cv_ = std::make_unique<std::condition_variable_any>();
+			};
+			return *this->cv_;
+		};
+
 	public:
 
 		/**
@@ -157,7 +229,7 @@ namespace asx
 		*/
 		locked_type get()
 		{
-			return locked_type(this->value_, this->mtx_);
+			return locked_type(this->value_, this->mtx_, &this->cv_);
 		};
 
 		/**
@@ -169,7 +241,70 @@ namespace asx
 		*/
 		const_locked_type get() const
 		{
-			return const_locked_type(this->value_, this->mtx_);
+			return const_locked_type(this->value_, this->mtx_, &this->cv_);
+		};
+
+		/**
+		 * @brief Waits until a predicate holds for the managed object, then returns it locked.
+		 *
+		 * The predicate is re-checked whenever a locked pointer that called `notify_on_release()` is released.
+		 *
+		 * @param _pred Predicate invoked as `_pred(value)` while locked.
+		 * @return Locked pointer to the managed object.
+		*/
+		template <typename PredT>
+		locked_type wait_until(PredT&& _pred)
+		{
+			auto _lck = std::unique_lock<mutex_type>(this->mtx_);
+			this->condition().wait(_lck, [&]() { return std::invoke(_pred, std::as_const(this->value_)); });
+			return locked_type(this->value_, std::move(_lck), &this->cv_);
+		};
+
+		/**
+		 * @brief Waits until a predicate holds for the managed object, then returns it locked.
+		 * @param _pred Predicate invoked as `_pred(value)` while locked.
+		 * @return Locked pointer to the managed object.
+		*/
+		template <typename PredT>
+		const_locked_type wait_until(PredT&& _pred) const
+		{
+			auto _lck = std::unique_lock<mutex_type>(this->mtx_);
+			this->condition().wait(_lck, [&]() { return std::invoke(_pred, this->value_); });
+			return const_locked_type(this->value_, std::move(_lck), &this->cv_);
+		};
+
+		/**
+		 * @brief Waits up to a timeout for a predicate to hold for the managed object, then returns it locked.
+		 * @param _timeout Maximum time to wait for.
+		 * @param _pred Predicate invoked as `_pred(value)` while locked.
+		 * @return Locked pointer to the managed object, or an unlocked pointer on timeout.
+		*/
+		template <typename RepT, typename PeriodT, typename PredT>
+		locked_type wait_for(std::chrono::duration<RepT, PeriodT> _timeout, PredT&& _pred)
+		{
+			auto _lck = std::unique_lock<mutex_type>(this->mtx_);
+			if (!this->condition().wait_for(_lck, _timeout, [&]() { return std::invoke(_pred, std::as_const(this->value_)); }))
+			{
+				return locked_type();
+			};
+			return locked_type(this->value_, std::move(_lck), &this->cv_);
+		};
+
+		/**
+		 * @brief Waits up to a timeout for a predicate to hold for the managed object, then returns it locked.
+		 * @param _timeout Maximum time to wait for.
+		 * @param _pred Predicate invoked as `_pred(value)` while locked.
+		 * @return Locked pointer to the managed object, or an unlocked pointer on timeout.
+		*/
+		template <typename RepT, typename PeriodT, typename PredT>
+		const_locked_type wait_for(std::chrono::duration<RepT, PeriodT> _timeout, PredT&& _pred) const
+		{
+			auto _lck = std::unique_lock<mutex_type>(this->mtx_);
+			if (!this->condition().wait_for(_lck, _timeout, [&]() { return std::invoke(_pred, this->value_); }))
+			{
+				return const_locked_type();
+			};
+			return const_locked_type(this->value_, std::move(_lck), &this->cv_);
 		};
 
 		/**
@@ -227,5 +362,13 @@ namespace asx
 	private:
 		mutable mutex_type mtx_;
 		value_type value_;
+
+		/**
+		 * @brief Notified by locked pointers released after `notify_on_release()`.
+		 *
+		 * Only created once something waits, so an exclusive nobody waits on allocates nothing.
+		 * Guarded by `mtx_`.
+		*/
+		mutable std::unique_ptr<std::condition_variable_any> cv_;
 	};
 };
\ No newline at end of file
@@ -0,0 +1,363 @@
+#pragma once
+
+/**
+ * @file
+ * @brief Stackful fibers and a scheduler that runs them on a thread pool.
+ *
+ * A fiber runs a function on its own stack and can suspend itself anywhere, not only at a
+ * `co_await`, so blocking-style code can run on fibers unchanged as long as it blocks through
+ * the fiber aware waits here.
+*/
+
+#include <asx/futex.hpp>
+#include <asx/thread_pool.hpp>
+#include <asx/message_queue.hpp>
+
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+
+namespace asx
+{
+	/**
+	 * @brief Stack memory for a fiber.
+	*/
+	struct fiber_stack
+	{
+		/**
+		 * @brief Lowest usable address, a guard page sits right below it.
+		*/
+		void* base = nullptr;
+
+		/**
+		 * @brief Usable size in bytes.
+		*/
+		size_t size = 0;
+	};
+
+	/**
+	 * @brief Hands out fixed size fiber stacks, keeping released ones for reuse.
+	 *
+	 * Stacks are mapped with an inaccessible guard page below them so an overflow faults instead of
+	 * corrupting other memory. Stack memory is only committed by the OS as it is touched.
+	*/
+	class fiber_stack_pool
+	{
+	public:
+
+		/**
+		 * @brief Gets a stack, reusing a released one if there is one.
+		 * @return The stack, or an empty stack on failure (an error message will be logged).
+		*/
+		fiber_stack acquire();
+
+		/**
+		 * @brief Gives a stack back to the pool.
+		*/
+		void release(fiber_stack _stack);
+
+		/**
+		 * @brief Gets the usable size of the stacks handed out.
+		*/
+		size_t stack_size() const noexcept
+		{
+			return this->stack_size_;
+		};
+
+		/**
+		 * @brief Constructs a pool.
+		 * @param _stackSize Usable size of each stack, rounded up to the page size.
+		 * @param _maxCached Maximum number of released stacks to keep mapped.
+		*/
+		explicit fiber_stack_pool(size_t _stackSize = 256 * 1024, size_t _maxCached = 64);
+		~fiber_stack_pool();
+
+	private:
+		size_t stack_size_;
+		size_t max_cached_;
+
+		std::mutex mtx_;
+		std::vector<fiber_stack> free_;
+
+		fiber_stack_pool(const fiber_stack_pool&) = delete;
+		fiber_stack_pool& operator=(const fiber_stack_pool&) = delete;
+	};
+
+	/**
+	 * @brief Gets the process wide stack pool, it is never destroyed.
+	*/
+	fiber_stack_pool& default_fiber_stack_pool();
+
+	/**
+	 * @brief Function on its own stack that can be suspended and resumed.
+	 *
+	 * Switching is done in user mode with hand written assembly on x86-64 and AArch64, saving only
+	 * the callee saved registers. Windows uses the OS fiber API, which is also user mode.
+	 *
+	 * A fiber may be resumed by a different thread each time, but never by two at once.
+	*/
+	class fiber
+	{
+	public:
+
+		/**
+		 * @brief Runs the fiber until it yields or finishes.
+		 *
+		 * If the fiber's function threw, the exception is rethrown here once it finishes.
+		 *
+		 * @return True if the fiber can be resumed again, false once it has finished.
+		*/
+		bool resume();
+
+		/**
+		 * @brief Checks if the fiber's function has returned.
+		*/
+		bool done() const noexcept
+		{
+			return this->done_;
+		};
+
+		/**
+		 * @brief Gets the fiber running on the calling thread.
+		 * @return The fiber, or null if the caller isn't running on one.
+		*/
+		static fiber* current() noexcept;
+
+		/**
+		 * @brief Suspends the calling fiber, returning to whoever resumed it.
+		*/
+		static void yield();
+
+		/**
+		 * @brief Creates a fiber, it doesn't start running until resumed.
+		 * @param _fn Function to run.
+		 * @param _stacks Pool to take the fiber's stack from.
+		*/
+		explicit fiber(std::function<void()> _fn, fiber_stack_pool& _stacks = default_fiber_stack_pool());
+
+		/**
+		 * @brief Releases the fiber's stack, the fiber must not be suspended part way through.
+		*/
+		~fiber();
+
+	private:
+
+		/**
+		 * @brief First function run on the fiber's stack.
+		*/
+		static void entry(void* _fiber);
+
+		/**
+		 * @brief Saved stack pointer of the fiber while suspended, or its OS fiber handle.
+		*/
+		void* context_ = nullptr;
+
+		/**
+		 * @brief Saved stack pointer of the resumer while the fiber runs, or its OS fiber handle.
+		*/
+		void* caller_context_ = nullptr;
+
+		fiber* previous_ = nullptr;
+
+		std::function<void()> fn_;
+		fiber_stack stack_{};
+		fiber_stack_pool* stacks_;
+
+		bool started_ = false;
+		bool done_ = false;
+		std::exception_ptr error_;
+
+		fiber(const fiber&) = delete;
+		fiber& operator=(const fiber&) = delete;
+	};
+
+	/**
+	 * @brief Runs fibers as tasks on a thread pool.
+	 *
+	 * A fiber that yields is queued again at the back of the pool, a fiber that parks isn't run again
+	 * until something unparks it. Parking and unparking may race, an unpark that comes first makes the
+	 * next park return immediately.
+	*/
+	class fiber_scheduler
+	{
+	public:
+
+		/**
+		 * @brief Fiber run by a scheduler.
+		*/
+		class task;
+
+		/**
+		 * @brief Starts a function on a new fiber.
+		 * @param _fn Function to run, exceptions it throws are logged.
+		*/
+		void spawn(std::function<void()> _fn);
+
+		/**
+		 * @brief Gets the scheduled fiber running on the calling thread.
+		 * @return The task, or null if the caller isn't on a fiber run by a scheduler.
+		*/
+		static task* current() noexcept;
+
+		/**
+		 * @brief Requeues the calling fiber behind the other ready work, or yields the thread if not on a fiber.
+		*/
+		static void yield();
+
+		/**
+		 * @brief Suspends the calling scheduled fiber until `unpark()` is called for it.
+		 *
+		 * May return spuriously, callers should re-check what they wait for.
+		*/
+		static void park();
+
+		/**
+		 * @brief Makes a parked fiber runnable again.
+		*/
+		static void unpark(task& _task);
+
+		/**
+		 * @brief Gets the number of spawned fibers that haven't finished.
+		*/
+		size_t active() const noexcept
+		{
+			return this->active_.load(std::memory_order_acquire);
+		};
+
+		/**
+		 * @brief Blocks until every spawned fiber has finished.
+		*/
+		void wait_idle();
+
+		/**
+		 * @brief Constructs a scheduler.
+		 * @param _pool Pool to run the fibers on, must outlive the scheduler.
+		 * @param _stacks Pool to take fiber stacks from.
+		*/
+		explicit fiber_scheduler(thread_pool& _pool, fiber_stack_pool& _stacks = default_fiber_stack_pool());
+
+		/**
+		 * @brief Waits for every spawned fiber to finish.
+		*/
+		~fiber_scheduler();
+
+	private:
+
+		/**
+		 * @brief Resumes a task on a pool thread, then queues, parks, or destroys it depending on how it stopped.
+		*/
+		void run(task& _task);
+
+		thread_pool* pool_;
+		fiber_stack_pool* stacks_;
+
+		futex_word active_{ 0 };
+
+		fiber_scheduler(const fiber_scheduler&) = delete;
+		fiber_scheduler& operator=(const fiber_scheduler&) = delete;
+	};
+
+	/**
+	 * @brief Mutex that parks a waiting fiber instead of blocking its thread.
+	 *
+	 * Threads that aren't on a scheduled fiber may lock it too, they block on a futex. Ownership is
+	 * handed directly to the longest waiter on unlock.
+	*/
+	class fiber_mutex
+	{
+	public:
+
+		void lock();
+		bool try_lock();
+		void unlock();
+
+		fiber_mutex() = default;
+
+	private:
+
+		/**
+		 * @brief Lives on the waiter's own stack while it waits.
+		*/
+		struct waiter
+		{
+			waiter* next = nullptr;
+			fiber_scheduler::task* task = nullptr;
+			futex_word ready{ 0 };
+		};
+
+		std::mutex mtx_;
+		bool locked_ = false;
+		waiter* head_ = nullptr;
+		waiter* tail_ = nullptr;
+
+		fiber_mutex(const fiber_mutex&) = delete;
+		fiber_mutex& operator=(const fiber_mutex&) = delete;
+	};
+
+	/**
+	 * @brief Waits for the next element of a message queue, parking the fiber while it is empty.
+	 *
+	 * Threads that aren't on a scheduled fiber block on a futex instead. Either way the waiter is
+	 * registered with the queue and woken by the push that makes it non-empty.
+	 *
+	 * @param _queue Queue to read from, the caller must be its only reader.
+	 * @return The next element.
+	*/
+	template <typename T>
+	T fiber_wait_next(message_queue<T>& _queue)
+	{
+		struct waiter
+		{
+			fiber_scheduler::task* task = nullptr;
+			futex_word ready{ 0 };
+		};
+
+		// The push wakes us with the queue locked, so we can't return and free this while it does
+		const auto _wake = [](void* _context)
+		{
+			auto& _waiter = *static_cast<waiter*>(_context);
+			if (_waiter.task)
+			{
+				fiber_scheduler::unpark(*_waiter.task);
+			}
+			else
+			{
+				_waiter.ready.store(1, std::memory_order_release);
+				futex_wake_one(_waiter.ready);
+			};
+		};
+
+		auto _waiter = waiter{ fiber_scheduler::current() };
+		while (true)
+		{
+			if (auto _value = _queue.try_next(); _value)
+			{
+				return std::move(*_value);
+			};
+
+			_waiter.ready.store(0, std::memory_order_relaxed);
+			if (!_queue.set_waiter(_wake, &_waiter))
+			{
+				continue;
+			};
+
+			if (_waiter.task)
+			{
+				// May return spuriously, the queue is checked again either way
+				fiber_scheduler::park();
+			}
+			else
+			{
+				while (_waiter.ready.load(std::memory_order_acquire) == 0)
+				{
+					futex_wait(_waiter.ready, 0);
+				};
+			};
+		};
+	};
+};
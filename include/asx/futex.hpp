@@ -0,0 +1,53 @@
+#pragma once
+
+/**
+ * @file
+ * @brief Wait/wake on the value of a 32-bit atomic word (futex).
+ *
+ * Waits may return spuriously, callers are expected to re-check their condition in a loop.
+*/
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace asx
+{
+	using futex_word = std::atomic<uint32_t>;
+	static_assert(sizeof(futex_word) == sizeof(uint32_t) && futex_word::is_always_lock_free);
+
+	/**
+	 * @brief Blocks the calling thread while a word holds an expected value.
+	 *
+	 * Returns immediately if the word doesn't hold the expected value.
+	 *
+	 * @param _word Word to wait on.
+	 * @param _expected Value to wait while the word holds.
+	 * @param _shared Set if the word is in memory shared between processes.
+	*/
+	void futex_wait(const futex_word& _word, uint32_t _expected, bool _shared = false);
+
+	/**
+	 * @brief Blocks the calling thread while a word holds an expected value, or until a timeout elapses.
+	 * @param _word Word to wait on.
+	 * @param _expected Value to wait while the word holds.
+	 * @param _timeout Maximum time to wait for.
+	 * @param _shared Set if the word is in memory shared between processes.
+	 * @return False if the timeout elapsed, true otherwise.
+	*/
+	bool futex_wait_for(const futex_word& _word, uint32_t _expected, std::chrono::nanoseconds _timeout, bool _shared = false);
+
+	/**
+	 * @brief Wakes up to one thread waiting on a word.
+	 * @param _word Word to wake waiters of.
+	 * @param _shared Set if the word is in memory shared between processes.
+	*/
+	void futex_wake_one(const futex_word& _word, bool _shared = false);
+
+	/**
+	 * @brief Wakes every thread waiting on a word.
+	 * @param _word Word to wake waiters of.
+	 * @param _shared Set if the word is in memory shared between processes.
+	*/
+	void futex_wake_all(const futex_word& _word, bool _shared = false);
+};
@@ -0,0 +1,210 @@
+#pragma once
+
+/**
+ * @file
+ * @brief Hazard pointers for safely reclaiming memory removed from lock-free structures.
+ *
+ * A reader publishes the pointer it is about to dereference in a hazard slot. Writers retire removed
+ * objects instead of deleting them, retired objects are only deleted once no slot holds them.
+*/
+
+#include <mutex>
+#include <atomic>
+#include <vector>
+#include <cstddef>
+
+namespace asx
+{
+	/**
+	 * @brief Number of retired objects a thread collects before scanning, on top of twice the slot count.
+	*/
+	constexpr size_t HAZARD_SCAN_THRESHOLD_MIN = 64;
+
+	/**
+	 * @brief One hazard slot, owned by at most one `hazard_pointer` at a time.
+	*/
+	struct alignas(64) hazard_record
+	{
+		/**
+		 * @brief The protected pointer, or null.
+		*/
+		std::atomic<void*> hazard{ nullptr };
+
+		/**
+		 * @brief Set while a hazard pointer owns this record.
+		*/
+		std::atomic<bool> active{ false };
+
+		hazard_record* next = nullptr;
+	};
+
+	/**
+	 * @brief Owns a set of hazard slots and the objects retired against them.
+	 *
+	 * Each thread keeps its own list of retired objects per domain, which is scanned against every
+	 * slot once it grows past a threshold proportional to the number of slots. Objects still
+	 * protected when a thread exits are handed to the domain and reclaimed by a later scan.
+	 *
+	 * A domain must outlive every thread that used it, prefer `default_hazard_domain()`.
+	*/
+	class hazard_domain
+	{
+	public:
+
+		using deleter_type = void(*)(void*);
+
+		/**
+		 * @brief Retires an object, deleting it once no hazard pointer protects it.
+		 * @param _ptr Object to retire, must already be unreachable for new readers.
+		 * @param _deleter Function used to delete the object.
+		*/
+		void retire(void* _ptr, deleter_type _deleter);
+
+		/**
+		 * @brief Retires an object allocated with `new`.
+		 * @param _ptr Object to retire, must already be unreachable for new readers.
+		*/
+		template <typename T>
+		void retire(T* _ptr)
+		{
+			this->retire(static_cast<void*>(_ptr), [](void* p) { delete static_cast<T*>(p); });
+		};
+
+		/**
+		 * @brief Scans the calling thread's retired objects now, deleting any that are no longer protected.
+		*/
+		void reclaim();
+
+		/**
+		 * @brief Gets the number of hazard slots ever created in this domain.
+		*/
+		size_t slot_count() const noexcept
+		{
+			return this->record_count_.load(std::memory_order_relaxed);
+		};
+
+		hazard_domain() = default;
+		~hazard_domain();
+
+	private:
+		friend class hazard_pointer;
+		friend struct hazard_thread_state;
+
+		struct retired_object
+		{
+			void* ptr;
+			deleter_type deleter;
+		};
+
+		hazard_record* acquire_record();
+		void release_record(hazard_record* _record) noexcept;
+
+		/**
+		 * @brief Deletes the objects in a list that no slot protects, leaving the rest in the list.
+		*/
+		void scan(std::vector<retired_object>& _retired);
+
+		/**
+		 * @brief Lock-free list of every slot record, records are never removed until destruction.
+		*/
+		std::atomic<hazard_record*> records_{ nullptr };
+		std::atomic<size_t> record_count_{ 0 };
+
+		/**
+		 * @brief Objects left behind by exited threads.
+		*/
+		std::mutex orphans_mtx_;
+		std::vector<retired_object> orphans_;
+		std::atomic<bool> has_orphans_{ false };
+
+		hazard_domain(const hazard_domain&) = delete;
+		hazard_domain& operator=(const hazard_domain&) = delete;
+	};
+
+	/**
+	 * @brief Gets the process wide hazard domain, it is never destroyed.
+	*/
+	hazard_domain& default_hazard_domain();
+
+	/**
+	 * @brief Owns one hazard slot, protecting at most one object at a time.
+	 *
+	 * This is NOT thread safe, each thread should use its own hazard pointers.
+	*/
+	class hazard_pointer
+	{
+	public:
+
+		/**
+		 * @brief Loads a pointer and protects the object it points to.
+		 *
+		 * Any previously protected object is no longer protected.
+		 *
+		 * @param _source Atomic pointer to load from.
+		 * @return The loaded pointer, the object it points to (if any) won't be deleted until protection is reset.
+		*/
+		template <typename T>
+		T* protect(const std::atomic<T*>& _source) noexcept
+		{
+			auto _ptr = _source.load(std::memory_order_relaxed);
+			while (true)
+			{
+				this->slot()->store(_ptr, std::memory_order_seq_cst);
+
+				// Re-check the source, if it changed the object may have been retired before we published
+				const auto _check = _source.load(std::memory_order_seq_cst);
+				if (_check == _ptr)
+				{
+					return _ptr;
+				};
+				_ptr = _check;
+			};
+		};
+
+		/**
+		 * @brief Protects a pointer that is known to still be reachable.
+		 *
+		 * Callers must validate the pointer is still reachable after this returns.
+		 *
+		 * @param _ptr Pointer to protect.
+		*/
+		void reset_protection(const void* _ptr) noexcept
+		{
+			this->slot()->store(const_cast<void*>(_ptr), std::memory_order_seq_cst);
+		};
+
+		/**
+		 * @brief Stops protecting any object.
+		*/
+		void reset_protection() noexcept
+		{
+			this->slot()->store(nullptr, std::memory_order_release);
+		};
+
+		/**
+		 * @brief Acquires a slot from a domain.
+		 * @param _domain Domain to acquire the slot from.
+		*/
+		explicit hazard_pointer(hazard_domain& _domain = default_hazard_domain());
+
+		hazard_pointer(hazard_pointer&& other) noexcept;
+		hazard_pointer& operator=(hazard_pointer&& other) noexcept;
+
+		/**
+		 * @brief Releases the slot back to its domain.
+		*/
+		~hazard_pointer();
+
+	private:
+		std::atomic<void*>* slot() const noexcept
+		{
+			return &this->record_->hazard;
+		};
+
+		hazard_domain* domain_;
+		hazard_record* record_;
+
+		hazard_pointer(const hazard_pointer&) = delete;
+		hazard_pointer& operator=(const hazard_pointer&) = delete;
+	};
+};
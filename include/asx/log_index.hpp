@@ -0,0 +1,189 @@
+#pragma once
+
+/**
+ * @file
+ * @brief Sparse timestamp to byte offset side index for log files.
+ *
+ * The index file is a `log_index_header` followed by `log_index_entry` values in
+ * increasing offset order. An entry means "every record before `offset` has a timestamp
+ * no later than `timestamp`", which allows the byte range holding a time window to be
+ * found with a binary search instead of scanning the log.
+*/
+
+#include <asx/mapped_file.hpp>
+
+#include <span>
+#include <array>
+#include <string>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string_view>
+
+namespace asx
+{
+	/**
+	 * @brief Default number of log bytes between index entries.
+	*/
+	constexpr inline size_t LOG_INDEX_INTERVAL_DEFAULT = 64 * 1024;
+
+	/**
+	 * @brief Magic bytes every index file begins with.
+	*/
+	constexpr inline std::array<char, 8> LOG_INDEX_MAGIC{ 'A', 'S', 'X', 'L', 'I', 'D', 'X', '\0' };
+
+	struct log_index_header
+	{
+		std::array<char, 8> magic;
+		uint16_t version;
+		uint16_t byte_order;
+		uint32_t reserved;
+
+		/**
+		 * @brief Number of log bytes between entries when the index was written.
+		*/
+		uint64_t interval;
+
+		uint64_t reserved2;
+	};
+	static_assert(sizeof(log_index_header) == 32);
+
+	struct log_index_entry
+	{
+		/**
+		 * @brief Nanoseconds since the unix epoch.
+		*/
+		uint64_t timestamp;
+
+		/**
+		 * @brief Offset into the log file of the first record written at or after `timestamp`.
+		*/
+		uint64_t offset;
+	};
+	static_assert(sizeof(log_index_entry) == 16);
+
+	/**
+	 * @brief Gets the path of the index file kept alongside a log file.
+	 * @param _logPath Path to the log file.
+	 * @return Index file path (the log path with ".idx" appended).
+	*/
+	std::string log_index_path(std::string_view _logPath);
+
+	/**
+	 * @brief Writes the side index for a log file as records are appended to it.
+	 *
+	 * This is NOT thread safe, it is expected to be driven by the sink writing the log file.
+	*/
+	class log_index_writer
+	{
+	public:
+
+		/**
+		 * @brief Opens (truncating) an index file, closing any previously open one.
+		 * @param _path Path to the index file.
+		 * @param _interval Number of log bytes between index entries.
+		 * @return True on good open, false otherwise.
+		*/
+		bool open(const char* _path, size_t _interval = LOG_INDEX_INTERVAL_DEFAULT);
+
+		/**
+		 * @brief Closes the index file, does nothing if none is open.
+		*/
+		void close();
+
+		bool is_open() const
+		{
+			return this->file_.is_open();
+		};
+
+		/**
+		 * @brief Notifies the index that a record is about to be written to the log.
+		 *
+		 * An entry is written if at least `interval` bytes have been written since the
+		 * last entry, or if `_force` is set.
+		 *
+		 * @param _timestamp Record timestamp, nanoseconds since the unix epoch.
+		 * @param _offset Offset into the log file the record will be written at.
+		 * @param _force Writes an entry regardless of the interval.
+		*/
+		void add(uint64_t _timestamp, uint64_t _offset, bool _force = false);
+
+		log_index_writer() = default;
+
+	private:
+		std::ofstream file_;
+		size_t interval_ = LOG_INDEX_INTERVAL_DEFAULT;
+		uint64_t next_offset_ = 0;
+		uint64_t last_timestamp_ = 0;
+	};
+
+	/**
+	 * @brief Read-only view of a log index file.
+	*/
+	class log_index
+	{
+	public:
+
+		/**
+		 * @brief Range of bytes within a log file, `end` is exclusive.
+		*/
+		struct byte_range
+		{
+			uint64_t begin;
+			uint64_t end;
+		};
+
+		/**
+		 * @brief Maps an index file.
+		 * @param _path Path to the index file.
+		 * @return True if a valid index was opened, false otherwise.
+		*/
+		bool open(const char* _path);
+
+		bool is_open() const noexcept
+		{
+			return this->file_.is_open();
+		};
+
+		/**
+		 * @brief Gets the number of entries in the index.
+		*/
+		size_t size() const noexcept;
+
+		/**
+		 * @brief Gets an entry from the index.
+		 * @param _index Entry index, must be less than `size()`.
+		*/
+		log_index_entry entry(size_t _index) const;
+
+		/**
+		 * @brief Finds the byte range of the log that holds every record within a time window.
+		 *
+		 * This is a binary search over the entries. The range may include records from up to
+		 * one index interval outside of the window on either side.
+		 *
+		 * @param _timeBegin Start of the window, nanoseconds since the unix epoch.
+		 * @param _timeEnd End of the window (inclusive), nanoseconds since the unix epoch.
+		 * @param _logSize Size of the log file in bytes.
+		 * @return Byte range within the log file.
+		*/
+		byte_range find_range(uint64_t _timeBegin, uint64_t _timeEnd, uint64_t _logSize) const;
+
+		log_index() = default;
+
+	private:
+		mapped_file file_;
+	};
+
+	/**
+	 * @brief Maps the part of a log file that holds the records within a time window.
+	 *
+	 * Uses the log's side index to find the range, the whole file is mapped if there is no index.
+	 *
+	 * @param _logPath Path to the log file.
+	 * @param _timeBegin Start of the window, nanoseconds since the unix epoch.
+	 * @param _timeEnd End of the window (inclusive), nanoseconds since the unix epoch.
+	 * @return Mapping of the range, check `is_open()` for success.
+	*/
+	mapped_file map_log_time_range(const char* _logPath, uint64_t _timeBegin, uint64_t _timeEnd);
+};
@@ -3,7 +3,9 @@
 /** @file */
 
 #include <asx/source.hpp>
+#include <asx/binlog.hpp>
 #include <asx/format.hpp>
+#include <asx/callsite.hpp>
 
 #include <string_view>
 
@@ -69,10 +71,22 @@ namespace asx
 	 * If this fails to open the given path, an error message is logged and the original file (if set)
 	 * will remain as the destination file.
 	 * 
+	 * A sparse timestamp index is written alongside the file (see `asx/log_index.hpp`) unless disabled
+	 * with `set_log_index_interval()`.
+	 * 
 	 * @param _path Absolute path to the file to write messages to.
 	*/
 	void set_log_file(const char* _path);
 
+	/**
+	 * @brief Sets how many bytes of log output are written between entries in the side index of log files.
+	 * 
+	 * Takes effect the next time a log file is set.
+	 * 
+	 * @param _bytes Interval in bytes, or 0 to stop writing the side index.
+	*/
+	void set_log_index_interval(size_t _bytes);
+
 	/**
 	 * @brief Closes the file previously set for logging, does nothing if none has been set.
 	*/
@@ -84,6 +98,40 @@ namespace asx
 	bool has_log_file();
 
 
+	/**
+	 * @brief Writes logged messages to the given file as compact binary records, see `asx/binlog.hpp`.
+	 *
+	 * Messages logged using a format string store the format string and raw arguments rather than the
+	 * formatted text. Use the `asx_logcat` tool to turn the file back into text.
+	 *
+	 * If this fails to open the given path, an error message is logged and the original binary file (if set)
+	 * will remain as the destination file.
+	 *
+	 * @param _path Path to the file to write records to, it will be truncated.
+	 * @param _compressed If true, the records of each segment are compressed (see `asx/lz.hpp`).
+	*/
+	void set_binary_log_file(const char* _path, bool _compressed = false);
+
+	/**
+	 * @brief Flushes and closes the file previously set for binary logging, does nothing if none has been set.
+	*/
+	void close_binary_log_file();
+
+	/**
+	 * @brief Checks if a file is currently being used for binary logging.
+	*/
+	bool has_binary_log_file();
+
+	/**
+	 * @brief Writes out any buffered log output.
+	 * 
+	 * Console output is written per message when it is a terminal, otherwise messages are batched
+	 * and written out once enough build up. Errors and fatal errors are always written immediately,
+	 * and anything left over is written on exit. The log file is flushed after every message.
+	*/
+	void flush_log();
+
+
 	/**
 	 * @brief Writes a message to the log.
 	 * @param _message The message to write.
@@ -91,6 +139,124 @@ namespace asx
 	void append_log(std::string_view _message);
 
 
+	namespace impl
+	{
+		/**
+		 * @brief Writes an already encoded record to the binary log file.
+		 * @param _level Level of the message.
+		 * @param _site Call site the message was logged from, may be null.
+		 * @param _fmt The formatting string for the message.
+		 * @param _encodedArgs Arguments encoded with `binlog::encode_args()`.
+		 * @param _argCount Number of encoded arguments.
+		*/
+		void write_binary_log(LogLevel _level, const callsite* _site, std::string_view _fmt, std::string_view _encodedArgs, size_t _argCount);
+
+		/**
+		 * @brief Writes a record to the binary log file.
+		 * @param _level Level of the message.
+		 * @param _site Call site the message was logged from, may be null.
+		 * @param _fmt The formatting string for the message.
+		 * @param _args... Formattable arguments, stored unformatted.
+		*/
+		inline void append_binary_log(LogLevel _level, const callsite* _site, std::string_view _fmt, const cx_formattable auto&... _args)
+		{
+			thread_local std::string _encodedArgs{};
+			_encodedArgs.clear();
+			binlog::encode_args(_encodedArgs, _args...);
+			impl::write_binary_log(_level, _site, _fmt, _encodedArgs, sizeof...(_args));
+		};
+
+		/**
+		 * @brief Writes an already formatted message to the text outputs (console and log file) only.
+		 * @param _level Level of the message.
+		 * @param _message The message to write.
+		*/
+		void append_text_log(LogLevel _level, std::string_view _message);
+
+		/**
+		 * @brief Writes an already formatted message to the text outputs (console and log file) only, including source location.
+		 * @param _level Level of the message.
+		 * @param _trace Stack trace from the source of the message.
+		 * @param _message The message to write.
+		*/
+		void append_text_log(LogLevel _level, const StackTraceView& _trace, std::string_view _message);
+
+		/**
+		 * @brief Writes an unformatted message to the binary log (if set) and the text outputs, ignoring the log level.
+		 * @param _level Level of the message.
+		 * @param _site Call site the message was logged from, may be null.
+		 * @param _message The message to write.
+		*/
+		void log_message(LogLevel _level, const callsite* _site, std::string_view _message);
+
+		/**
+		 * @brief Writes an unformatted message to the binary log (if set) and the text outputs, including source location and ignoring the log level.
+		 * @param _level Level of the message.
+		 * @param _site Call site the message was logged from, may be null.
+		 * @param _trace Stack trace from the source of the message.
+		 * @param _message The message to write.
+		*/
+		void log_message(LogLevel _level, const callsite* _site, const StackTraceView& _trace, std::string_view _message);
+
+		/**
+		 * @brief Writes a message to the binary log (if set) and the text outputs, ignoring the log level.
+		 *
+		 * Without arguments the message is written as is rather than used as a format string.
+		 *
+		 * @param _level Level of the message.
+		 * @param _site Call site the message was logged from, may be null.
+		 * @param _fmt The formatting string for the message.
+		 * @param _args... Formattable arguments.
+		*/
+		inline void log_formatted(LogLevel _level, const callsite* _site, std::string_view _fmt, const cx_formattable auto&... _args)
+		{
+			if constexpr (sizeof...(_args) == 0)
+			{
+				impl::log_message(_level, _site, _fmt);
+			}
+			else
+			{
+				if (asx::has_binary_log_file())
+				{
+					impl::append_binary_log(_level, _site, _fmt, _args...);
+				};
+				const auto s = asx::format(_fmt, _args...);
+				impl::append_text_log(_level, s);
+			};
+		};
+
+		/**
+		 * @brief Writes a message to the binary log (if set) and the text outputs, including source location and ignoring the log level.
+		 *
+		 * Without arguments the message is written as is rather than used as a format string.
+		 *
+		 * @param _level Level of the message.
+		 * @param _site Call site the message was logged from, may be null.
+		 * @param _trace Stack trace from the source of the message.
+		 * @param _fmt The formatting string for the message.
+		 * @param _args... Formattable arguments.
+		*/
+		template <size_t N>
+		inline void log_formatted(LogLevel _level, const callsite* _site, asx::BasicStackTrace<N>&& _trace, std::string_view _fmt, const cx_formattable auto&... _args)
+		{
+			const auto _traceView = asx::StackTraceView(_trace);
+			if constexpr (sizeof...(_args) == 0)
+			{
+				impl::log_message(_level, _site, _traceView, _fmt);
+			}
+			else
+			{
+				if (asx::has_binary_log_file())
+				{
+					impl::append_binary_log(_level, _site, _fmt, _args...);
+				};
+				const auto s = asx::format(_fmt, _args...);
+				impl::append_text_log(_level, _traceView, s);
+			};
+		};
+	};
+
+
 	/**
 	 * @brief Writes a general info message to the log.
 	 * @param _message The message to log.
@@ -106,8 +272,7 @@ namespace asx
 	{
 		if (get_logging_level() >= LogLevel::info)
 		{
-			const auto s = asx::format(_fmt, _args...);
-			log_info(s);
+			impl::log_formatted(LogLevel::info, nullptr, _fmt, _args...);
 		};
 	};
 	
@@ -127,8 +292,7 @@ namespace asx
 	{
 		if (get_logging_level() >= LogLevel::warn)
 		{
-			const auto s = asx::format(_fmt, _args...);
-			asx::log_warn(s);
+			impl::log_formatted(LogLevel::warn, nullptr, _fmt, _args...);
 		};
 	};
 
@@ -170,8 +334,7 @@ namespace asx
 	{
 		if (get_logging_level() >= LogLevel::error)
 		{
-			const auto s = asx::format(_fmt, _args...);
-			asx::log_error(s);
+			impl::log_formatted(LogLevel::error, nullptr, _fmt, _args...);
 		};
 	};
 
@@ -185,8 +348,12 @@ namespace asx
 	{
 		if (get_logging_level() >= LogLevel::error)
 		{
+			if (asx::has_binary_log_file())
+			{
+				impl::append_binary_log(LogLevel::error, nullptr, _fmt, _args...);
+			};
 			const auto s = asx::format(_fmt, _args...);
-			asx::log_error(_trace, s);
+			impl::append_text_log(LogLevel::error, _trace, s);
 		};
 	};
 
@@ -228,8 +395,12 @@ namespace asx
 	{
 		if (get_logging_level() >= LogLevel::fatal)
 		{
+			if (asx::has_binary_log_file())
+			{
+				impl::append_binary_log(LogLevel::fatal, nullptr, _fmt, _args...);
+			};
 			const auto s = asx::format(_fmt, _args...);
-			asx::log_fatal_error(_trace, s);
+			impl::append_text_log(LogLevel::fatal, _trace, s);
 		};
 	};
 
@@ -267,8 +438,33 @@ namespace asx
 
 };
 
-#define ASX_LOG_INFO(fmt, ...) ::asx::log_info(fmt __VA_OPT__(,) __VA_ARGS__)
-#define ASX_LOG_WARN(fmt, ...) ::asx::log_warn(fmt __VA_OPT__(,) __VA_ARGS__)
-#define ASX_LOG_ERROR(fmt, ...) ::asx::log_error(::asx::get_stack_trace(), fmt __VA_OPT__(,) __VA_ARGS__)
-#define ASX_LOG_FATAL(fmt, ...) ::asx::log_fatal_error(::asx::get_stack_trace(), fmt __VA_OPT__(,) __VA_ARGS__)
+/*
+	Each logging macro expansion owns a static `asx::callsite`, see `asx/callsite.hpp`. The format is bound
+	to a reference so it is only evaluated once, the arguments (and stack trace) are only evaluated if the
+	site is enabled.
+*/
+
+#define ASX_LOG_INFO(fmt, ...) do { \
+	ASX_CALLSITE(_asxLogSite, ::asx::callsite_kind::log, ::asx::LogLevel::info); \
+	const auto& _asxLogFmt = fmt; \
+	if (_asxLogSite.enabled(_asxLogFmt)) { ::asx::impl::log_formatted(::asx::LogLevel::info, &_asxLogSite, _asxLogFmt __VA_OPT__(,) __VA_ARGS__); }; \
+} while (false)
+
+#define ASX_LOG_WARN(fmt, ...) do { \
+	ASX_CALLSITE(_asxLogSite, ::asx::callsite_kind::log, ::asx::LogLevel::warn); \
+	const auto& _asxLogFmt = fmt; \
+	if (_asxLogSite.enabled(_asxLogFmt)) { ::asx::impl::log_formatted(::asx::LogLevel::warn, &_asxLogSite, _asxLogFmt __VA_OPT__(,) __VA_ARGS__); }; \
+} while (false)
+
+#define ASX_LOG_ERROR(fmt, ...) do { \
+	ASX_CALLSITE(_asxLogSite, ::asx::callsite_kind::log, ::asx::LogLevel::error); \
+	const auto& _asxLogFmt = fmt; \
+	if (_asxLogSite.enabled(_asxLogFmt)) { ::asx::impl::log_formatted(::asx::LogLevel::error, &_asxLogSite, ::asx::get_stack_trace(), _asxLogFmt __VA_OPT__(,) __VA_ARGS__); }; \
+} while (false)
+
+#define ASX_LOG_FATAL(fmt, ...) do { \
+	ASX_CALLSITE(_asxLogSite, ::asx::callsite_kind::log, ::asx::LogLevel::fatal); \
+	const auto& _asxLogFmt = fmt; \
+	if (_asxLogSite.enabled(_asxLogFmt)) { ::asx::impl::log_formatted(::asx::LogLevel::fatal, &_asxLogSite, ::asx::get_stack_trace(), _asxLogFmt __VA_OPT__(,) __VA_ARGS__); }; \
+} while (false)
 
@@ -0,0 +1,161 @@
+#pragma once
+
+/**
+ * @file
+ * @brief Fast LZ77 compression in the style of LZ4, with a block format and a streaming frame format.
+ *
+ * A compressed block is a sequence of sequences. Each sequence is
+ *
+ *	token          (high 4 bits literal count, low 4 bits match length minus 4, 15 means more follows)
+ *	literal count  (only if 15 or more, bytes of 255 followed by the remainder)
+ *	literals
+ *	match offset   (uint16 little endian, distance back from the current output position)
+ *	match length   (only if 15 or more beyond the minimum, same encoding as the literal count)
+ *
+ * The last sequence only has literals and ends the block. The last 5 bytes of a block are always
+ * literals, and no match starts in the last 12 bytes, which lets the decoder copy in whole words.
+ *
+ * A frame is `FRAME_MAGIC`, the uint32 little endian maximum block size, then blocks each preceded
+ * by their uint32 little endian size, with `FRAME_BLOCK_STORED` set if the block was stored as is.
+ * A size of 0 ends the frame.
+*/
+
+#include <span>
+#include <array>
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+namespace asx::lz
+{
+	/**
+	 * @brief Shortest match that is encoded, shorter repeats are stored as literals.
+	*/
+	constexpr inline size_t MIN_MATCH = 4;
+
+	/**
+	 * @brief Furthest back a match can refer to.
+	*/
+	constexpr inline size_t MAX_OFFSET = 65535;
+
+	/**
+	 * @brief Default number of earlier positions with the same hash checked for each match.
+	*/
+	constexpr inline int EFFORT_DEFAULT = 8;
+
+	/**
+	 * @brief Gets the largest size a block can compress to.
+	 * @param _size Size of the uncompressed data.
+	 * @return Size a destination buffer needs to always fit the compressed data.
+	*/
+	constexpr size_t compress_bound(size_t _size) noexcept
+	{
+		return _size + _size / 255 + 16;
+	};
+
+	/**
+	 * @brief Compresses data as a single block.
+	 *
+	 * Matching is greedy, each position takes the longest match found in its hash chain.
+	 *
+	 * @param _src Data to compress, at most 4 GiB.
+	 * @param _dst Buffer to write the block to, `compress_bound(_src.size())` bytes always fits.
+	 * @param _effort Number of chain entries checked per position, higher compresses better but slower.
+	 * @return Size of the block, or 0 if it didn't fit in `_dst`.
+	*/
+	size_t compress_block(std::span<const std::byte> _src, std::span<std::byte> _dst, int _effort = EFFORT_DEFAULT);
+
+	/**
+	 * @brief Decompresses a single block.
+	 * @param _src The whole compressed block.
+	 * @param _dst Buffer to write the data to, must be large enough for all of it.
+	 * @param _outSize Set to the size of the decompressed data on success.
+	 * @return True on success, false if the block is malformed or doesn't fit in `_dst`.
+	*/
+	bool decompress_block(std::span<const std::byte> _src, std::span<std::byte> _dst, size_t& _outSize);
+
+
+
+	/**
+	 * @brief Magic bytes every frame begins with.
+	*/
+	constexpr inline std::array<char, 4> FRAME_MAGIC{ 'A', 'S', 'X', 'Z' };
+
+	/**
+	 * @brief Set in a frame block's size if the block is stored uncompressed.
+	*/
+	constexpr inline uint32_t FRAME_BLOCK_STORED = 0x8000'0000;
+
+	/**
+	 * @brief Default maximum block size of a frame.
+	*/
+	constexpr inline size_t FRAME_BLOCK_SIZE_DEFAULT = 256 * 1024;
+
+	/**
+	 * @brief Compresses data written in pieces into a frame on an output stream.
+	 *
+	 * Data is buffered until a whole block is collected, so pieces can be any size.
+	*/
+	class frame_writer
+	{
+	public:
+
+		/**
+		 * @brief Adds data to the frame.
+		*/
+		void write(std::span<const std::byte> _data);
+
+		/**
+		 * @brief Writes out the buffered data and ends the frame, further writes are ignored.
+		*/
+		void finish();
+
+		/**
+		 * @brief Starts a frame, writing its header.
+		 * @param _out Stream to write the frame to, must outlive this.
+		 * @param _blockSize Maximum size of each block, less than `FRAME_BLOCK_STORED`.
+		 * @param _effort See `compress_block()`.
+		*/
+		explicit frame_writer(std::ostream& _out, size_t _blockSize = FRAME_BLOCK_SIZE_DEFAULT, int _effort = EFFORT_DEFAULT);
+
+		/**
+		 * @brief Finishes the frame if `finish()` wasn't called.
+		*/
+		~frame_writer();
+
+	private:
+
+		void write_block();
+
+		std::ostream* out_;
+		size_t block_size_;
+		int effort_;
+		bool finished_ = false;
+
+		std::vector<std::byte> buffer_;
+		std::vector<std::byte> compressed_;
+
+		frame_writer(const frame_writer&) = delete;
+		frame_writer& operator=(const frame_writer&) = delete;
+	};
+
+	/**
+	 * @brief Compresses data into a whole frame.
+	 * @param _src Data to compress.
+	 * @param _out String to append the frame to.
+	 * @param _blockSize Maximum size of each block, less than `FRAME_BLOCK_STORED`.
+	 * @param _effort See `compress_block()`.
+	*/
+	void compress_frame(std::span<const std::byte> _src, std::string& _out, size_t _blockSize = FRAME_BLOCK_SIZE_DEFAULT, int _effort = EFFORT_DEFAULT);
+
+	/**
+	 * @brief Decompresses a whole frame.
+	 * @param _src Bytes beginning with a frame, may extend past the end of it.
+	 * @param _out String to append the decompressed data to.
+	 * @param _outFrameSize Optional, set to the size of the frame in bytes on success.
+	 * @return True on success, false if the frame is malformed or truncated.
+	*/
+	bool decompress_frame(std::span<const std::byte> _src, std::string& _out, size_t* _outFrameSize = nullptr);
+};
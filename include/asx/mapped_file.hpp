@@ -0,0 +1,138 @@
+#pragma once
+
+/** @file */
+
+#include <span>
+#include <cstddef>
+#include <cstdint>
+
+namespace asx
+{
+	/**
+	 * @brief Read-only memory mapping of a file, or of a byte range within a file.
+	 *
+	 * The mapping is released when this is closed or destroyed, any spans viewing the
+	 * mapped data are invalidated at that point.
+	*/
+	class mapped_file
+	{
+	public:
+
+		/**
+		 * @brief Special size value meaning "until the end of the file".
+		*/
+		constexpr static size_t npos = static_cast<size_t>(-1);
+
+		/**
+		 * @brief Gets the mapped bytes.
+		 * @return Span viewing the mapped range, empty if nothing is mapped.
+		*/
+		std::span<const std::byte> data() const noexcept
+		{
+			return std::span<const std::byte>(this->data_, this->size_);
+		};
+
+		/**
+		 * @brief Gets the size of the mapped range in bytes.
+		 * @return Size in bytes.
+		*/
+		size_t size() const noexcept
+		{
+			return this->size_;
+		};
+
+		/**
+		 * @brief Gets the offset into the file that the mapped range begins at.
+		 * @return Offset in bytes.
+		*/
+		uint64_t offset() const noexcept
+		{
+			return this->offset_;
+		};
+
+		/**
+		 * @brief Checks if a file is currently mapped.
+		*/
+		bool is_open() const noexcept
+		{
+			return this->map_base_ != nullptr;
+		};
+		explicit operator bool() const noexcept
+		{
+			return this->is_open();
+		};
+
+		/**
+		 * @brief Maps a range of a file into memory, closing any previously mapped file.
+		 *
+		 * The range is clamped to the size of the file. Mapping an empty range will
+		 * succeed but `is_open()` will return false.
+		 *
+		 * @param _path Path to the file to map.
+		 * @param _offset Offset into the file to begin the mapping at, does not need to be page aligned.
+		 * @param _size Number of bytes to map, or `npos` to map until the end of the file.
+		 * @return True on good mapping, false otherwise (an error message will be logged).
+		*/
+		bool open(const char* _path, uint64_t _offset = 0, size_t _size = npos);
+
+		/**
+		 * @brief Unmaps the file, does nothing if no file is mapped.
+		*/
+		void close() noexcept;
+
+		/**
+		 * @brief Gets the size of a file without mapping it.
+		 * @param _path Path to the file.
+		 * @return Size in bytes, or `npos` if the file could not be opened.
+		*/
+		static size_t file_size(const char* _path);
+
+		mapped_file() = default;
+
+		/**
+		 * @brief Maps a range of a file into memory, see `open()`.
+		*/
+		explicit mapped_file(const char* _path, uint64_t _offset = 0, size_t _size = npos)
+		{
+			this->open(_path, _offset, _size);
+		};
+
+		mapped_file(mapped_file&& other) noexcept;
+		mapped_file& operator=(mapped_file&& other) noexcept;
+
+		~mapped_file()
+		{
+			this->close();
+		};
+
+	private:
+
+		/**
+		 * @brief Start of the requested range within the mapping.
+		*/
+		const std::byte* data_ = nullptr;
+
+		/**
+		 * @brief Size of the requested range.
+		*/
+		size_t size_ = 0;
+
+		/**
+		 * @brief File offset of the requested range.
+		*/
+		uint64_t offset_ = 0;
+
+		/**
+		 * @brief Page aligned base address of the mapping.
+		*/
+		void* map_base_ = nullptr;
+
+		/**
+		 * @brief Size of the mapping starting at `map_base_`.
+		*/
+		size_t map_size_ = 0;
+
+		mapped_file(const mapped_file&) = delete;
+		mapped_file& operator=(const mapped_file&) = delete;
+	};
+};
@@ -2,11 +2,20 @@
 
 /** @file */
 
+#include <asx/assert.hpp>
+#include <asx/queue_notifier.hpp>
+
 #include <jclib/concepts.h>
 
 #include <list>
 #include <mutex>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <utility>
 #include <optional>
+#include <functional>
+#include <condition_variable>
 
 namespace asx
 {
@@ -32,6 +41,11 @@ namespace asx
 
 		using size_type = size_t;
 
+		/**
+		 * @brief Callback registered with `set_waiter()`, invoked with its context.
+		*/
+		using waiter_callback = void(*)(void*);
+
 	private:
 
 		/**
@@ -43,6 +57,17 @@ namespace asx
 			return std::unique_lock(this->mtx_);
 		};
 
+		/**
+		 * @brief Invokes and clears the registered waiter, if any. Must be called while locked.
+		*/
+		void wake_waiter()
+		{
+			if (this->waiter_)
+			{
+				std::exchange(this->waiter_, nullptr)(std::exchange(this->waiter_context_, nullptr));
+			};
+		};
+
 	public:
 		
 		/**
@@ -55,6 +80,29 @@ namespace asx
 			return this->data_.empty();
 		};
 
+		/**
+		 * @brief Registers a callback for the reader to be woken by the next push.
+		 * 
+		 * The callback is invoked once, with the queue locked, by the push that makes the queue
+		 * non-empty. Being locked means the reader can't see the element (and stop waiting) until the
+		 * callback returns, but the callback must be short and must not touch the queue.
+		 * 
+		 * @param _callback Function to invoke, replaces any registered callback.
+		 * @param _context Passed to the callback.
+		 * @return True if registered, false if the queue already has data and nothing was registered.
+		*/
+		bool set_waiter(waiter_callback _callback, void* _context)
+		{
+			const auto lck = this->acquire_lock();
+			if (!this->data_.empty())
+			{
+				return false;
+			};
+			this->waiter_ = _callback;
+			this->waiter_context_ = _context;
+			return true;
+		};
+
 		/**
 		 * @brief Clears all data from the queue.
 		*/
@@ -62,6 +110,32 @@ namespace asx
 		{
 			const auto lck = this->acquire_lock();
 			this->data_.clear();
+			if (this->notifier_)
+			{
+				this->notifier_->clear();
+			};
+		};
+
+		/**
+		 * @brief Gets the notifier for this queue, creating it on first use.
+		 * 
+		 * The notifier's handle is readable exactly while the queue has data in it. It is only
+		 * signalled when the queue goes from empty to non-empty, and cleared when it is emptied.
+		 * 
+		 * @return Notifier whose handle can be waited on, see `asx::queue_poller`.
+		*/
+		const queue_notifier& enable_notifier()
+		{
+			const auto lck = this->acquire_lock();
+			if (!this->notifier_)
+			{
+				this->notifier_ = std::make_unique<queue_notifier>();
+				if (!this->data_.empty())
+				{
+					this->notifier_->signal();
+				};
+			};
+			return *this->notifier_;
 		};
 		
 		/**
@@ -78,6 +152,10 @@ namespace asx
 			{
 				auto _data = std::move(this->data_.front());
 				this->data_.pop_front();
+				if (this->data_.empty() && this->notifier_)
+				{
+					this->notifier_->clear();
+				};
 				return _data;
 			}
 			else
@@ -94,6 +172,11 @@ namespace asx
 		{
 			const auto lck = this->acquire_lock();
 			this->data_.push_back(_value);
+			if (this->notifier_ && this->data_.size() == 1)
+			{
+				this->notifier_->signal();
+			};
+			this->wake_waiter();
 		};
 
 		/**
@@ -104,6 +187,11 @@ namespace asx
 		{
 			const auto lck = this->acquire_lock();
 			this->data_.push_back(std::move(_value));
+			if (this->notifier_ && this->data_.size() == 1)
+			{
+				this->notifier_->signal();
+			};
+			this->wake_waiter();
 		};
 
 		/**
@@ -122,5 +210,464 @@ namespace asx
 		 * @brief The underlying queue data structure.
 		*/
 		std::list<value_type> data_;
+
+		/**
+		 * @brief Signalled while the queue has data, null unless enabled.
+		*/
+		std::unique_ptr<queue_notifier> notifier_;
+
+		/**
+		 * @brief Invoked by the next push, null if the reader isn't waiting.
+		*/
+		waiter_callback waiter_ = nullptr;
+		void* waiter_context_ = nullptr;
+	};
+
+	/**
+	 * @brief What a bounded queue does when an element is pushed while it is full.
+	*/
+	enum class overflow_policy
+	{
+		/**
+		 * @brief Blocks the producer until there is room, `try_push()` fails instead.
+		*/
+		block,
+
+		/**
+		 * @brief Fails the push, leaving the queue untouched.
+		*/
+		fail,
+
+		/**
+		 * @brief Removes the oldest element to make room, counted by `dropped()`.
+		*/
+		overwrite_oldest,
+
+		/**
+		 * @brief Discards the pushed element, counted by `dropped()`.
+		*/
+		drop,
+	};
+
+	/**
+	 * @brief Provides a thread-safe fixed capacity message queue (FIFO).
+	 * 
+	 * Unlike `message_queue` this may be used by any number of readers and writers.
+	 * 
+	 * Producers can throttle themselves in advance by reserving credits (slots) with
+	 * `try_reserve()`, each credit guarantees one later `push_reserved()` will succeed. Reserved
+	 * slots count towards the queue's occupancy.
+	 * 
+	 * Watermark callbacks can be set to shed load early. The high callback is invoked when the
+	 * occupancy rises to the high mark, and the low callback when it then falls back to the low
+	 * mark. Callbacks are invoked without the queue locked, on whichever thread caused the change.
+	 * 
+	 * @tparam T The type the message queue will store.
+	*/
+	template <jc::cx_move_constructible T>
+	class bounded_message_queue
+	{
+	public:
+
+		using value_type = T;
+		using pointer = value_type*;
+		using reference = value_type&;
+		using const_pointer = const value_type*;
+		using const_reference = const value_type&;
+
+		using size_type = size_t;
+
+		using watermark_callback = std::function<void()>;
+
+	private:
+
+		/**
+		 * @brief Acquires a unique_lock on the mutex.
+		 * @return Unique lock owning the locked mutex.
+		*/
+		[[nodiscard]] auto acquire_lock() const
+		{
+			return std::unique_lock(this->mtx_);
+		};
+
+		/**
+		 * @brief Gets the number of slots in use, including reserved ones. Must be called while locked.
+		*/
+		size_type occupancy() const noexcept
+		{
+			return this->size_ + this->reserved_;
+		};
+
+		/**
+		 * @brief Watermark crossing found while locked, to be invoked once unlocked.
+		*/
+		enum class watermark_event
+		{
+			none,
+			high,
+			low,
+		};
+
+		/**
+		 * @brief Checks for a watermark crossing after the occupancy changed. Must be called while locked.
+		*/
+		watermark_event check_watermarks() noexcept
+		{
+			if (!this->above_high_)
+			{
+				if (this->high_mark_ != 0 && this->occupancy() >= this->high_mark_)
+				{
+					this->above_high_ = true;
+					return watermark_event::high;
+				};
+			}
+			else if (this->occupancy() <= this->low_mark_)
+			{
+				this->above_high_ = false;
+				return watermark_event::low;
+			};
+			return watermark_event::none;
+		};
+
+		/**
+		 * @brief Unlocks the queue then invokes the callback for a watermark event.
+		*/
+		void notify_watermark(std::unique_lock<std::mutex>& _lock, watermark_event _event)
+		{
+			if (_event == watermark_event::none)
+			{
+				return;
+			};
+
+			// Copy the callback so it may be replaced while being invoked
+			auto _callback = (_event == watermark_event::high) ? this->on_high_ : this->on_low_;
+			_lock.unlock();
+			if (_callback)
+			{
+				_callback();
+			};
+		};
+
+		/**
+		 * @brief Adds an element to the back of the ring. Must be called while locked with room available.
+		*/
+		template <typename U>
+		void emplace_back(U&& _value)
+		{
+			auto _pos = this->head_ + this->size_;
+			if (_pos >= this->data_.size())
+			{
+				_pos -= this->data_.size();
+			};
+			this->data_[_pos].emplace(std::forward<U>(_value));
+			++this->size_;
+		};
+
+		/**
+		 * @brief Removes the element at the front of the ring. Must be called while locked and not empty.
+		*/
+		value_type pop_front()
+		{
+			auto& _slot = this->data_[this->head_];
+			auto _value = std::move(*_slot);
+			_slot.reset();
+
+			if (++this->head_ == this->data_.size())
+			{
+				this->head_ = 0;
+			};
+			--this->size_;
+			return _value;
+		};
+
+		/**
+		 * @brief Pushes an element, applying the overflow policy.
+		 * @param _value Value to add to the queue.
+		 * @param _wait If false, the block policy fails instead of waiting.
+		 * @return True if the value was added to the queue.
+		*/
+		template <typename U>
+		bool push_impl(U&& _value, bool _wait)
+		{
+			auto lck = this->acquire_lock();
+			if (this->occupancy() >= this->data_.size())
+			{
+				switch (this->policy_)
+				{
+				case overflow_policy::block:
+					if (!_wait)
+					{
+						return false;
+					};
+					this->not_full_.wait(lck, [this]() { return this->occupancy() < this->data_.size(); });
+					break;
+				case overflow_policy::fail:
+					return false;
+				case overflow_policy::overwrite_oldest:
+					// Reserved slots are promised to their producers, only queued elements can be overwritten
+					if (this->size_ == 0)
+					{
+						++this->dropped_;
+						return false;
+					};
+					this->pop_front();
+					++this->dropped_;
+					break;
+				case overflow_policy::drop:
+					++this->dropped_;
+					return false;
+				};
+			};
+
+			this->emplace_back(std::forward<U>(_value));
+			const auto _event = this->check_watermarks();
+			this->notify_watermark(lck, _event);
+			return true;
+		};
+
+	public:
+
+		/**
+		 * @brief Gets the maximum number of elements the queue can hold.
+		*/
+		size_type capacity() const noexcept
+		{
+			return this->data_.size();
+		};
+
+		/**
+		 * @brief Gets the policy applied when pushing onto a full queue.
+		*/
+		overflow_policy policy() const noexcept
+		{
+			return this->policy_;
+		};
+
+		/**
+		 * @brief Gets the number of elements currently queued, not including reserved slots.
+		*/
+		size_type size() const
+		{
+			const auto lck = this->acquire_lock();
+			return this->size_;
+		};
+
+		/**
+		 * @brief Checks if the queue has NO data queued up.
+		 * @return True if the next call to try_next() would return null.
+		*/
+		bool empty() const
+		{
+			const auto lck = this->acquire_lock();
+			return this->size_ == 0;
+		};
+
+		/**
+		 * @brief Gets the number of slots that are neither queued nor reserved.
+		*/
+		size_type available() const
+		{
+			const auto lck = this->acquire_lock();
+			return this->data_.size() - this->occupancy();
+		};
+
+		/**
+		 * @brief Gets the number of elements discarded by the drop and overwrite_oldest policies.
+		*/
+		size_t dropped() const noexcept
+		{
+			return this->dropped_.load(std::memory_order_relaxed);
+		};
+
+		/**
+		 * @brief Clears all data from the queue, reserved slots remain reserved.
+		*/
+		void clear()
+		{
+			auto lck = this->acquire_lock();
+			while (this->size_ != 0)
+			{
+				this->pop_front();
+			};
+			const auto _event = this->check_watermarks();
+			this->not_full_.notify_all();
+			this->notify_watermark(lck, _event);
+		};
+
+		/**
+		 * @brief Attempts to grab the next element in the queue.
+		 * 
+		 * This will pop the element from the queue if there is one to grab.
+		 * 
+		 * @return The next element in the queue, or nullopt if the queue is empty.
+		*/
+		std::optional<value_type> try_next()
+		{
+			auto lck = this->acquire_lock();
+			if (this->size_ == 0)
+			{
+				return std::nullopt;
+			};
+
+			auto _value = std::optional<value_type>(this->pop_front());
+			const auto _event = this->check_watermarks();
+			this->not_full_.notify_one();
+			this->notify_watermark(lck, _event);
+			return _value;
+		};
+
+		/**
+		 * @brief Pushes an element onto the queue by copy, applying the overflow policy if full.
+		 * @param _value Value to add to the queue.
+		 * @return True if the value was added to the queue.
+		*/
+		bool push(const_reference _value)
+		{
+			return this->push_impl(_value, true);
+		};
+
+		/**
+		 * @brief Pushes an element onto the queue by move, applying the overflow policy if full.
+		 * @param _value Value to add to the queue.
+		 * @return True if the value was added to the queue.
+		*/
+		bool push(value_type&& _value)
+		{
+			return this->push_impl(std::move(_value), true);
+		};
+
+		/**
+		 * @brief Pushes an element onto the queue by copy without ever blocking.
+		 * @param _value Value to add to the queue.
+		 * @return True if the value was added to the queue.
+		*/
+		bool try_push(const_reference _value)
+		{
+			return this->push_impl(_value, false);
+		};
+
+		/**
+		 * @brief Pushes an element onto the queue by move without ever blocking.
+		 * @param _value Value to add to the queue.
+		 * @return True if the value was added to the queue.
+		*/
+		bool try_push(value_type&& _value)
+		{
+			return this->push_impl(std::move(_value), false);
+		};
+
+		/**
+		 * @brief Reserves slots in the queue for later pushes.
+		 * @param _count Number of slots to reserve.
+		 * @return True if all of the slots were reserved, false if there wasn't room (nothing is reserved).
+		*/
+		bool try_reserve(size_type _count = 1)
+		{
+			auto lck = this->acquire_lock();
+			if (this->data_.size() - this->occupancy() < _count)
+			{
+				return false;
+			};
+			this->reserved_ += _count;
+
+			const auto _event = this->check_watermarks();
+			this->notify_watermark(lck, _event);
+			return true;
+		};
+
+		/**
+		 * @brief Pushes an element into a slot previously reserved with `try_reserve()`, this always succeeds.
+		 * @param _value Value to add to the queue.
+		*/
+		void push_reserved(value_type _value)
+		{
+			const auto lck = this->acquire_lock();
+			ASX_CHECK(this->reserved_ != 0);
+			--this->reserved_;
+			this->emplace_back(std::move(_value));
+		};
+
+		/**
+		 * @brief Returns reserved slots that will not be used.
+		 * @param _count Number of slots to release.
+		*/
+		void release_reserved(size_type _count = 1)
+		{
+			auto lck = this->acquire_lock();
+			ASX_CHECK(this->reserved_ >= _count);
+			this->reserved_ -= _count;
+
+			const auto _event = this->check_watermarks();
+			this->not_full_.notify_all();
+			this->notify_watermark(lck, _event);
+		};
+
+		/**
+		 * @brief Sets the watermark callbacks.
+		 * @param _high Occupancy that invokes `_onHigh`, or 0 to disable the watermarks.
+		 * @param _low Occupancy that invokes `_onLow` after `_onHigh` was invoked, must be less than `_high`.
+		 * @param _onHigh Invoked when the occupancy rises to `_high`.
+		 * @param _onLow Invoked when the occupancy falls back to `_low`.
+		*/
+		void set_watermarks(size_type _high, size_type _low, watermark_callback _onHigh, watermark_callback _onLow)
+		{
+			ASX_CHECK(_high == 0 || _low < _high);
+
+			const auto lck = this->acquire_lock();
+			this->high_mark_ = _high;
+			this->low_mark_ = _low;
+			this->on_high_ = std::move(_onHigh);
+			this->on_low_ = std::move(_onLow);
+			this->above_high_ = false;
+		};
+
+		/**
+		 * @brief Constructs an empty message queue.
+		 * @param _capacity Maximum number of elements the queue can hold, must not be 0.
+		 * @param _policy What to do when pushing onto a full queue.
+		*/
+		explicit bounded_message_queue(size_type _capacity, overflow_policy _policy = overflow_policy::block) :
+			data_(_capacity),
+			policy_(_policy)
+		{
+			ASX_CHECK(_capacity != 0);
+		};
+
+	private:
+
+		/**
+		 * @brief The mutex used to protect the actual queue data structure.
+		*/
+		mutable std::mutex mtx_;
+
+		/**
+		 * @brief Signalled when slots are freed for producers blocked on a full queue.
+		*/
+		std::condition_variable not_full_;
+
+		/**
+		 * @brief Ring of slots, queued elements begin at `head_`.
+		*/
+		std::vector<std::optional<value_type>> data_;
+
+		size_type head_ = 0;
+		size_type size_ = 0;
+
+		/**
+		 * @brief Number of slots reserved for producers.
+		*/
+		size_type reserved_ = 0;
+
+		overflow_policy policy_;
+		std::atomic<size_t> dropped_{ 0 };
+
+		size_type high_mark_ = 0;
+		size_type low_mark_ = 0;
+		bool above_high_ = false;
+		watermark_callback on_high_;
+		watermark_callback on_low_;
+
+		bounded_message_queue(const bounded_message_queue&) = delete;
+		bounded_message_queue& operator=(const bounded_message_queue&) = delete;
 	};
-};
\ No newline at end of file
+};
@@ -0,0 +1,252 @@
+#pragma once
+
+/**
+ * @file
+ * @brief Named process wide metrics and mutexes that track their own contention.
+ *
+ * Metrics and profiled mutexes register themselves by name on construction and unregister on
+ * destruction, so they can be listed at any time, for example by `asx::control_server`.
+*/
+
+#include <asx/per_thread.hpp>
+
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <string_view>
+
+namespace asx
+{
+	/**
+	 * @brief Named value that is registered for listing while it exists.
+	*/
+	class metric
+	{
+	public:
+
+		/**
+		 * @brief Gets the name of the metric.
+		*/
+		const std::string& name() const noexcept
+		{
+			return this->name_;
+		};
+
+		/**
+		 * @brief Gets the current value.
+		*/
+		virtual int64_t value() const = 0;
+
+	protected:
+
+		/**
+		 * @brief Adds the metric to the registry, called by derived classes once they are fully constructed.
+		*/
+		void attach();
+
+		/**
+		 * @brief Removes the metric from the registry, called by derived classes before they are destroyed.
+		*/
+		void detach();
+
+		explicit metric(std::string _name) :
+			name_(std::move(_name))
+		{};
+		~metric() = default;
+
+	private:
+		std::string name_;
+
+		metric(const metric&) = delete;
+		metric& operator=(const metric&) = delete;
+	};
+
+	/**
+	 * @brief Metric that only counts up (or down), each thread adds to its own slot.
+	 *
+	 * Adding never contends with other threads, reading the value sums every thread's slot.
+	*/
+	class metric_counter final : public metric
+	{
+	public:
+
+		void add(int64_t _amount = 1) noexcept
+		{
+			auto& _count = this->counts_.local();
+			_count.store(_count.load(std::memory_order_relaxed) + _amount, std::memory_order_relaxed);
+		};
+
+		int64_t value() const override
+		{
+			return this->counts_.combine(int64_t(0), [](int64_t _sum, const std::atomic<int64_t>& v)
+			{
+				return _sum + v.load(std::memory_order_relaxed);
+			});
+		};
+
+		explicit metric_counter(std::string _name) :
+			metric(std::move(_name))
+		{
+			this->attach();
+		};
+		~metric_counter()
+		{
+			this->detach();
+		};
+
+	private:
+		per_thread<std::atomic<int64_t>> counts_;
+	};
+
+	/**
+	 * @brief Metric holding a single value that is set directly.
+	*/
+	class metric_gauge final : public metric
+	{
+	public:
+
+		void set(int64_t _value) noexcept
+		{
+			this->value_.store(_value, std::memory_order_relaxed);
+		};
+
+		void add(int64_t _amount) noexcept
+		{
+			this->value_.fetch_add(_amount, std::memory_order_relaxed);
+		};
+
+		int64_t value() const override
+		{
+			return this->value_.load(std::memory_order_relaxed);
+		};
+
+		explicit metric_gauge(std::string _name) :
+			metric(std::move(_name))
+		{
+			this->attach();
+		};
+		~metric_gauge()
+		{
+			this->detach();
+		};
+
+	private:
+		std::atomic<int64_t> value_{ 0 };
+	};
+
+	/**
+	 * @brief Name and value of a metric at one point in time.
+	*/
+	struct metric_sample
+	{
+		std::string name;
+		int64_t value;
+	};
+
+	/**
+	 * @brief Reads every registered metric.
+	 * @return Samples sorted by name.
+	*/
+	std::vector<metric_sample> snapshot_metrics();
+
+
+
+	/**
+	 * @brief Contention statistics of a profiled mutex.
+	*/
+	struct lock_stats
+	{
+		std::string name;
+
+		/**
+		 * @brief Number of times the mutex was locked.
+		*/
+		uint64_t acquisitions = 0;
+
+		/**
+		 * @brief Number of those that had to wait for another owner.
+		*/
+		uint64_t contended = 0;
+
+		std::chrono::nanoseconds total_wait{};
+		std::chrono::nanoseconds max_wait{};
+	};
+
+	/**
+	 * @brief Mutex that counts how often and how long lockers wait for it.
+	 *
+	 * An uncontended lock costs one extra try and two relaxed stores over `std::mutex`, only contended
+	 * locks read the clock. The statistics are updated while the lock is held so they need no atomic
+	 * read-modify-write.
+	*/
+	class profiled_mutex
+	{
+	public:
+
+		void lock()
+		{
+			if (!this->mtx_.try_lock())
+			{
+				const auto _start = std::chrono::steady_clock::now();
+				this->mtx_.lock();
+				const auto _wait = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - _start).count();
+
+				this->contended_.store(this->contended_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+				this->total_wait_.store(this->total_wait_.load(std::memory_order_relaxed) + _wait, std::memory_order_relaxed);
+				if (_wait > this->max_wait_.load(std::memory_order_relaxed))
+				{
+					this->max_wait_.store(_wait, std::memory_order_relaxed);
+				};
+			};
+			this->acquisitions_.store(this->acquisitions_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+		};
+
+		bool try_lock()
+		{
+			if (this->mtx_.try_lock())
+			{
+				this->acquisitions_.store(this->acquisitions_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+				return true;
+			};
+			return false;
+		};
+
+		void unlock()
+		{
+			this->mtx_.unlock();
+		};
+
+		/**
+		 * @brief Gets the statistics collected so far.
+		*/
+		lock_stats stats() const;
+
+		/**
+		 * @brief Constructs and registers a mutex.
+		 * @param _name Name shown in contention reports.
+		*/
+		explicit profiled_mutex(std::string _name);
+		~profiled_mutex();
+
+	private:
+		std::mutex mtx_;
+		std::string name_;
+
+		std::atomic<uint64_t> acquisitions_{ 0 };
+		std::atomic<uint64_t> contended_{ 0 };
+		std::atomic<int64_t> total_wait_{ 0 };
+		std::atomic<int64_t> max_wait_{ 0 };
+
+		profiled_mutex(const profiled_mutex&) = delete;
+		profiled_mutex& operator=(const profiled_mutex&) = delete;
+	};
+
+	/**
+	 * @brief Reads the statistics of every registered profiled mutex.
+	 * @return Statistics sorted by total wait time, longest first.
+	*/
+	std::vector<lock_stats> snapshot_lock_stats();
+};
@@ -0,0 +1,251 @@
+#pragma once
+
+/** @file */
+
+#include <atomic>
+#include <cstdint>
+#include <utility>
+#include <optional>
+#include <functional>
+
+namespace asx
+{
+	namespace impl
+	{
+		/**
+		 * @brief Thread local storage key whose value is destroyed when a thread exits.
+		 *
+		 * Every key shares a single thread local table indexed by the key's id, so there is no limit on
+		 * the number of keys like there is for OS keys (1024 on linux). Ids of destroyed keys are reused,
+		 * a per-key generation tells values left behind by a previous owner of the id apart.
+		*/
+		class thread_key
+		{
+		public:
+
+			/**
+			 * @brief Called on thread exit with the exiting thread's non-null value.
+			*/
+			using destructor_type = void(*)(void*);
+
+			/**
+			 * @brief Gets the calling thread's value.
+			 * @return The value, null if it was never set.
+			*/
+			void* get() const noexcept;
+
+			/**
+			 * @brief Sets the calling thread's value.
+			*/
+			void set(void* _value);
+
+			explicit thread_key(destructor_type _destructor);
+			~thread_key();
+
+		private:
+			uint32_t id_;
+			uint64_t generation_;
+			destructor_type destructor_;
+
+			thread_key(const thread_key&) = delete;
+			thread_key& operator=(const thread_key&) = delete;
+		};
+	};
+
+	/**
+	 * @brief Holds one value per thread, so threads can update their own without contention.
+	 *
+	 * Each thread lazily gets its own cache-line-aligned slot on first use of `local()`. Slots are
+	 * registered in a lock-free list that `combine()` and `for_each()` walk. When a thread exits its slot
+	 * is released, keeping its value, and is reused by the next thread that needs one.
+	 *
+	 * Visiting slots while their threads write to them is only safe if `T` is safe for that, such
+	 * as an atomic.
+	 *
+	 * @tparam T Type of the per-thread values.
+	*/
+	template <typename T>
+	class per_thread
+	{
+	public:
+
+		using value_type = T;
+		using reference = value_type&;
+		using const_reference = const value_type&;
+
+	private:
+
+		struct alignas(64) slot
+		{
+			value_type value;
+
+			/**
+			 * @brief Set while a thread is using this slot.
+			*/
+			std::atomic<bool> owned{ true };
+
+			slot* next = nullptr;
+		};
+
+		/**
+		 * @brief Thread exit callback, releases the thread's slot for reuse.
+		*/
+		static void release_slot(void* _slot) noexcept
+		{
+			static_cast<slot*>(_slot)->owned.store(false, std::memory_order_release);
+		};
+
+		/**
+		 * @brief Finds or creates a slot for the calling thread.
+		*/
+		slot* acquire_slot()
+		{
+			// Reuse a slot released by an exited thread if there is one
+			for (auto _slot = this->slots_.load(std::memory_order_acquire); _slot; _slot = _slot->next)
+			{
+				if (!_slot->owned.load(std::memory_order_relaxed) && !_slot->owned.exchange(true, std::memory_order_acquire))
+				{
+					return _slot;
+				};
+			};
+
+			auto _slot = (this->factory_) ? new slot{ this->factory_() } : new slot{};
+			auto _head = this->slots_.load(std::memory_order_relaxed);
+			do
+			{
+				_slot->next = _head;
+			} while (!this->slots_.compare_exchange_weak(_head, _slot, std::memory_order_release, std::memory_order_relaxed));
+			return _slot;
+		};
+
+	public:
+
+		/**
+		 * @brief Gets the calling thread's value, creating it on first use.
+		*/
+		reference local()
+		{
+			auto _slot = static_cast<slot*>(this->key_->get());
+			if (!_slot)
+			{
+				_slot = this->acquire_slot();
+				this->key_->set(_slot);
+			};
+			return _slot->value;
+		};
+
+		/**
+		 * @brief Invokes a function with every thread's value, including those of exited threads.
+		 * @param _fn Function invoked as `_fn(value)`.
+		*/
+		template <typename FnT>
+		void for_each(FnT&& _fn)
+		{
+			for (auto _slot = this->slots_.load(std::memory_order_acquire); _slot; _slot = _slot->next)
+			{
+				std::invoke(_fn, _slot->value);
+			};
+		};
+
+		/**
+		 * @brief Invokes a function with every thread's value, including those of exited threads.
+		 * @param _fn Function invoked as `_fn(value)`.
+		*/
+		template <typename FnT>
+		void for_each(FnT&& _fn) const
+		{
+			for (auto _slot = this->slots_.load(std::memory_order_acquire); _slot; _slot = _slot->next)
+			{
+				std::invoke(_fn, std::as_const(_slot->value));
+			};
+		};
+
+		/**
+		 * @brief Folds every thread's value into an accumulator.
+		 * @param _init Initial accumulator value.
+		 * @param _fn Function invoked as `_acc = _fn(std::move(_acc), value)`.
+		 * @return The final accumulator value.
+		*/
+		template <typename AccT, typename FnT>
+		AccT combine(AccT _init, FnT&& _fn) const
+		{
+			this->for_each([&](const_reference v)
+			{
+				_init = std::invoke(_fn, std::move(_init), v);
+			});
+			return _init;
+		};
+
+		/**
+		 * @brief Combines every thread's value with a binary operation.
+		 * @param _fn Function invoked as `_fn(lhs, rhs)` returning the combined value.
+		 * @return The combined value, a default constructed value if no thread has used this yet.
+		*/
+		template <typename FnT>
+		value_type combine(FnT&& _fn) const
+		{
+			auto _slot = this->slots_.load(std::memory_order_acquire);
+			if (!_slot)
+			{
+				return (this->factory_) ? this->factory_() : value_type{};
+			};
+
+			auto _result = value_type(_slot->value);
+			for (_slot = _slot->next; _slot; _slot = _slot->next)
+			{
+				_result = std::invoke(_fn, std::move(_result), std::as_const(_slot->value));
+			};
+			return _result;
+		};
+
+		/**
+		 * @brief Constructs with each thread's value default constructed.
+		*/
+		per_thread() :
+			key_(std::in_place, &per_thread::release_slot)
+		{};
+
+		/**
+		 * @brief Constructs with each thread's value created by a factory.
+		 * @param _factory Function returning the initial value for a new slot.
+		*/
+		explicit per_thread(std::function<value_type()> _factory) :
+			key_(std::in_place, &per_thread::release_slot),
+			factory_(std::move(_factory))
+		{};
+
+		/**
+		 * @brief Destroys every slot, no thread may use this concurrently.
+		*/
+		~per_thread()
+		{
+			// Unregister the key first so an exiting thread can't release a slot being deleted
+			this->key_.reset();
+
+			auto _slot = this->slots_.load(std::memory_order_acquire);
+			while (_slot)
+			{
+				const auto _next = _slot->next;
+				delete _slot;
+				_slot = _next;
+			};
+		};
+
+	private:
+
+		/**
+		 * @brief Maps the calling thread to its slot, only empty while being destroyed.
+		*/
+		std::optional<impl::thread_key> key_;
+
+		/**
+		 * @brief Lock-free list of every slot, slots are never removed until destruction.
+		*/
+		std::atomic<slot*> slots_{ nullptr };
+
+		std::function<value_type()> factory_;
+
+		per_thread(const per_thread&) = delete;
+		per_thread& operator=(const per_thread&) = delete;
+	};
+};
@@ -0,0 +1,286 @@
+#pragma once
+
+/** @file */
+
+#include <asx/assert.hpp>
+
+#include <jclib/concepts.h>
+
+#include <bit>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <optional>
+
+namespace asx
+{
+	namespace impl
+	{
+		/**
+		 * @brief Lock-free unbounded MULTIPLE WRITER SINGLE READER queue of linked nodes.
+		 * @tparam T The type the queue will store.
+		*/
+		template <jc::cx_move_constructible T>
+		class mpsc_lane
+		{
+		private:
+
+			struct node
+			{
+				std::atomic<node*> next{ nullptr };
+				std::optional<T> value;
+			};
+
+		public:
+
+			void push(T&& _value)
+			{
+				auto _node = new node{};
+				_node->value.emplace(std::move(_value));
+
+				// Between these two steps the lane looks busy to the reader, not empty
+				const auto _prev = this->tail_.exchange(_node, std::memory_order_acq_rel);
+				_prev->next.store(_node, std::memory_order_release);
+			};
+
+			/**
+			 * @brief Pops the front element. READER ONLY.
+			 * @return The front element, or nullopt if the lane is empty or a push is still linking its node.
+			*/
+			std::optional<T> try_pop()
+			{
+				const auto _head = this->head_;
+				const auto _next = _head->next.load(std::memory_order_acquire);
+				if (!_next)
+				{
+					return std::nullopt;
+				};
+
+				// The next node becomes the new stub
+				auto _value = std::move(_next->value);
+				_next->value.reset();
+				this->head_ = _next;
+				delete _head;
+				return _value;
+			};
+
+			/**
+			 * @brief Checks if the lane has nothing in it, including pushes still linking their node. READER ONLY.
+			*/
+			bool empty() const noexcept
+			{
+				return this->head_->next.load(std::memory_order_seq_cst) == nullptr &&
+					this->tail_.load(std::memory_order_seq_cst) == this->head_;
+			};
+
+			mpsc_lane() :
+				head_(new node{}),
+				tail_(head_)
+			{};
+
+			~mpsc_lane()
+			{
+				auto _node = this->head_;
+				while (_node)
+				{
+					const auto _next = _node->next.load(std::memory_order_relaxed);
+					delete _node;
+					_node = _next;
+				};
+			};
+
+		private:
+
+			/**
+			 * @brief Stub node whose successor is the front element, owned by the reader.
+			*/
+			node* head_;
+
+			/**
+			 * @brief Most recently pushed node.
+			*/
+			std::atomic<node*> tail_;
+
+			mpsc_lane(const mpsc_lane&) = delete;
+			mpsc_lane& operator=(const mpsc_lane&) = delete;
+		};
+	};
+
+	/**
+	 * @brief Provides a thread-safe MULTIPLE WRITER SINGLE READER message queue with priority levels.
+	 *
+	 * Each level has its own lock-free FIFO lane, a bitmask of non-empty lanes lets the reader find the
+	 * highest priority element with a single bit scan. Both push and try_next are O(1).
+	 *
+	 * Higher levels are served first. Optional aging serves the lowest non-empty lane every N reads so
+	 * low priority elements can't be starved forever.
+	 *
+	 * @tparam T The type the message queue will store.
+	 * @tparam Levels Number of priority levels, at most 64.
+	*/
+	template <jc::cx_move_constructible T, size_t Levels>
+	requires (Levels >= 1 && Levels <= 64)
+	class priority_queue_mt
+	{
+	public:
+
+		using value_type = T;
+		using pointer = value_type*;
+		using reference = value_type&;
+		using const_pointer = const value_type*;
+		using const_reference = const value_type&;
+
+		using size_type = size_t;
+
+		/**
+		 * @brief Number of priority levels.
+		*/
+		constexpr static size_type levels = Levels;
+
+	private:
+
+		/**
+		 * @brief Pops from a lane whose bit was set, clearing the bit if the lane turns out to be empty.
+		*/
+		std::optional<value_type> try_pop_lane(size_type _level)
+		{
+			auto& _lane = this->lanes_[_level];
+			if (auto _value = _lane.try_pop(); _value)
+			{
+				return _value;
+			};
+
+			// Clear the bit then re-check, a racing push either sees the cleared bit or we see its element
+			const auto _bit = uint64_t(1) << _level;
+			this->mask_.fetch_and(~_bit, std::memory_order_seq_cst);
+			if (!_lane.empty())
+			{
+				this->mask_.fetch_or(_bit, std::memory_order_seq_cst);
+			};
+			return std::nullopt;
+		};
+
+		/**
+		 * @brief Pops from the highest (or lowest) lane in a mask that has an element.
+		 * @param _mask Lanes to try.
+		 * @param _lowest Try the lowest lane first instead of the highest.
+		*/
+		std::optional<value_type> pop_first_lane(uint64_t _mask, bool _lowest)
+		{
+			// Bits may be stale, and lanes may look busy while a push is linking its node
+			while (_mask != 0)
+			{
+				const auto _level = (_lowest) ?
+					static_cast<size_type>(std::countr_zero(_mask)) :
+					static_cast<size_type>(63 - std::countl_zero(_mask));
+				if (auto _value = this->try_pop_lane(_level); _value)
+				{
+					return _value;
+				};
+				_mask &= ~(uint64_t(1) << _level);
+			};
+			return std::nullopt;
+		};
+
+		/**
+		 * @brief Pushes onto a lane and marks it non-empty.
+		*/
+		void push_lane(value_type&& _value, size_type _level)
+		{
+			ASX_CHECK(_level < levels);
+			this->lanes_[_level].push(std::move(_value));
+			this->mask_.fetch_or(uint64_t(1) << _level, std::memory_order_seq_cst);
+		};
+
+	public:
+
+		/**
+		 * @brief Checks if the queue has NO data queued up. READER ONLY.
+		 * @return True if the next call to try_next() would return null.
+		*/
+		bool empty() const noexcept
+		{
+			auto _mask = this->mask_.load(std::memory_order_acquire);
+			while (_mask != 0)
+			{
+				const auto _level = static_cast<size_type>(std::countr_zero(_mask));
+				if (!this->lanes_[_level].empty())
+				{
+					return false;
+				};
+				_mask &= _mask - 1;
+			};
+			return true;
+		};
+
+		/**
+		 * @brief Attempts to grab the next element from the highest priority non-empty lane. READER ONLY.
+		 *
+		 * This will pop the element from the queue if there is one to grab.
+		 *
+		 * @return The next element in the queue, or nullopt if the queue is empty.
+		*/
+		std::optional<value_type> try_next()
+		{
+			const auto _mask = this->mask_.load(std::memory_order_acquire);
+
+			// Every N reads serve the lowest lane instead so it can't starve
+			if (this->aging_interval_ != 0 && _mask != 0 && ++this->reads_since_aging_ >= this->aging_interval_)
+			{
+				this->reads_since_aging_ = 0;
+				return this->pop_first_lane(_mask, true);
+			};
+			return this->pop_first_lane(_mask, false);
+		};
+
+		/**
+		 * @brief Pushes an element onto the queue by copy.
+		 * @param _value Value to add to the queue.
+		 * @param _priority Priority level, less than `levels`. Higher levels are read first.
+		*/
+		void push(const_reference _value, size_type _priority)
+		{
+			this->push_lane(value_type(_value), _priority);
+		};
+
+		/**
+		 * @brief Pushes an element onto the queue by move.
+		 * @param _value Value to add to the queue.
+		 * @param _priority Priority level, less than `levels`. Higher levels are read first.
+		*/
+		void push(value_type&& _value, size_type _priority)
+		{
+			this->push_lane(std::move(_value), _priority);
+		};
+
+		/**
+		 * @brief Enables aging, the lowest non-empty lane is served once every `_interval` reads. READER ONLY.
+		 * @param _interval Number of reads between aged reads, or 0 to disable aging.
+		*/
+		void set_aging_interval(size_type _interval) noexcept
+		{
+			this->aging_interval_ = _interval;
+			this->reads_since_aging_ = 0;
+		};
+
+		/**
+		 * @brief Constructs an empty priority queue.
+		*/
+		priority_queue_mt() = default;
+
+	private:
+
+		/**
+		 * @brief Bit N is set when lane N may be non-empty.
+		*/
+		std::atomic<uint64_t> mask_{ 0 };
+
+		std::array<impl::mpsc_lane<value_type>, Levels> lanes_;
+
+		size_type aging_interval_ = 0;
+		size_type reads_since_aging_ = 0;
+
+		priority_queue_mt(const priority_queue_mt&) = delete;
+		priority_queue_mt& operator=(const priority_queue_mt&) = delete;
+	};
+};
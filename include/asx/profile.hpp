@@ -30,6 +30,11 @@ namespace asx
 		
 		void lap(std::string_view _name)
 		{
+			if (!this->enabled_)
+			{
+				return;
+			};
+
 			const auto _now = Clock::now();
 			const auto _elapsed = std::chrono::duration_cast<Duration>(_now - this->lap_start_time_);
 
@@ -51,10 +56,56 @@ namespace asx
 			this->total_ = std::chrono::duration_cast<Duration>(Clock::now() - this->start_time_);
 		};
 
+		/**
+		 * @brief Logs a set of profile results.
+		*/
+		static void print(const Result& _result)
+		{
+			ASX_LOG_INFO(format_result(_result), _result.total);
+		};
+
 		void print() const
+		{
+			print(this->result());
+		};
+
+		/**
+		 * @brief Finishes and logs the results, does nothing if the profiler is disabled.
+		 *
+		 * The profiler's own call site already decided whether to log, so the log level isn't checked again.
+		*/
+		void finish_and_print()
+		{
+			if (!this->enabled_)
+			{
+				return;
+			};
+			this->finish();
+			impl::log_formatted(LogLevel::info, nullptr, format_result(this->result()), this->total_);
+		};
+
+		ASXSingleTimeProfiler() :
+			ASXSingleTimeProfiler(true)
+		{};
+
+		/**
+		 * @brief Constructs a profiler.
+		 * @param _enabled False makes laps and printing do nothing, used when the profiling call site is disabled.
+		*/
+		explicit ASXSingleTimeProfiler(bool _enabled) :
+			start_time_{ (_enabled) ? Clock::now() : Clock::time_point{} },
+			lap_start_time_{ this->start_time_ },
+			enabled_(_enabled)
+		{};
+	private:
+
+		/**
+		 * @brief Builds the format string for logging a set of results, the total is left as the only argument.
+		*/
+		static std::string format_result(const Result& _result)
 		{
 			std::string _fmt = "Time Profile Results :\n Total = {}\n ";
-			for (auto& v : this->laps_)
+			for (auto& v : _result.laps)
 			{
 				// Defaults to seconds
 				double _value = v.time.count();
@@ -75,29 +126,21 @@ namespace asx
 
 				_fmt.append(asx::format("{} = {} {}\n ", v.name, _value, _unit));
 			};
-			ASX_LOG_INFO(_fmt, this->total_);
+			return _fmt;
 		};
 
-		void finish_and_print()
-		{
-			this->finish();
-			this->print();
-		};
-
-		ASXSingleTimeProfiler() :
-			start_time_{ Clock::now() },
-			lap_start_time_{ this->start_time_ }
-		{};
-	private:
 		Clock::time_point start_time_;
 		Clock::time_point lap_start_time_;
 		Duration total_{};
 		std::vector<Lap> laps_{};
+		bool enabled_;
 	};
 };
 
 #ifndef ASX_PROFILE_TIME_DISABLE
-	#define ASX_PROFILE_TIME_START() ::asx::ASXSingleTimeProfiler _asxProfileTm{}
+	#define ASX_PROFILE_TIME_START() \
+		ASX_CALLSITE(_asxProfileSite, ::asx::callsite_kind::profile, ::asx::LogLevel::info); \
+		::asx::ASXSingleTimeProfiler _asxProfileTm{ _asxProfileSite.enabled("Time Profile Results") }
 	#define ASX_PROFILE_TIME_LAP(lapName) { _asxProfileTm.lap(lapName); }
 	#define ASX_PROFILE_TIME_FINISH() { _asxProfileTm.finish_and_print(); }
 #else
@@ -0,0 +1,63 @@
+#pragma once
+
+/** @file */
+
+#include <cstdint>
+
+namespace asx
+{
+	/**
+	 * @brief Waitable handle that is readable while a queue has data in it.
+	 *
+	 * This is an eventfd on linux (and a manual reset event on windows), so it can be waited on
+	 * alongside sockets and other handles, see `asx::queue_poller`.
+	 *
+	 * This is NOT thread safe, queues drive it under their own lock.
+	*/
+	class queue_notifier
+	{
+	public:
+
+		/**
+		 * @brief Makes the handle readable, does nothing if it already is.
+		*/
+		void signal() noexcept;
+
+		/**
+		 * @brief Makes the handle not readable.
+		*/
+		void clear() noexcept;
+
+		/**
+		 * @brief Gets the native handle (file descriptor on linux) to wait on.
+		 * @return Native handle, or -1 if creating it failed.
+		*/
+		intptr_t native_handle() const noexcept
+		{
+			return this->handle_;
+		};
+
+		bool good() const noexcept
+		{
+			return this->handle_ != -1;
+		};
+		explicit operator bool() const noexcept
+		{
+			return this->good();
+		};
+
+		queue_notifier();
+		~queue_notifier();
+
+	private:
+		intptr_t handle_ = -1;
+
+		/**
+		 * @brief Mirrors whether the handle is signalled, avoids a syscall for redundant signals/clears.
+		*/
+		bool signalled_ = false;
+
+		queue_notifier(const queue_notifier&) = delete;
+		queue_notifier& operator=(const queue_notifier&) = delete;
+	};
+};
@@ -0,0 +1,137 @@
+#pragma once
+
+/** @file */
+
+#include <asx/message_queue.hpp>
+
+#include <span>
+#include <chrono>
+#include <vector>
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+
+namespace asx
+{
+	/**
+	 * @brief Readiness events a poller can wait for.
+	*/
+	enum class poll_event : uint32_t
+	{
+		readable = 0x1,
+		writable = 0x2,
+
+		/**
+		 * @brief The handle hung up or has an error, always reported.
+		*/
+		error = 0x4,
+	};
+
+	/**
+	 * @brief A handle that became ready in `queue_poller::wait()`.
+	*/
+	struct poll_result
+	{
+		/**
+		 * @brief Token given when the handle was added.
+		*/
+		uint64_t token;
+
+		/**
+		 * @brief Events that are ready, a combination of `poll_event` bits.
+		*/
+		uint32_t events;
+	};
+
+	/**
+	 * @brief Lets one thread sleep until any of many queues, file descriptors, or timers is ready.
+	 *
+	 * Built on epoll, queues are waited on through their notifier (see `message_queue::enable_notifier()`).
+	 *
+	 * This is NOT thread safe.
+	*/
+	class queue_poller
+	{
+	public:
+
+		using clock_type = std::chrono::steady_clock;
+
+		/**
+		 * @brief Adds a raw file descriptor.
+		 * @param _fd File descriptor, ownership is NOT taken.
+		 * @param _events Combination of `poll_event` bits to wait for.
+		 * @param _token Value reported when the descriptor is ready.
+		 * @return True on success, false otherwise (an error message will be logged).
+		*/
+		bool add_fd(intptr_t _fd, uint32_t _events, uint64_t _token);
+
+		/**
+		 * @brief Removes a file descriptor, queue, or timer previously added.
+		 * @param _fd File descriptor, queue notifier handle, or timer handle.
+		*/
+		void remove(intptr_t _fd);
+
+		/**
+		 * @brief Adds a queue, reported as readable while it has data in it.
+		 * @param _queue Queue to add, must outlive its time in the poller.
+		 * @param _token Value reported when the queue has data.
+		 * @return Handle to pass to `remove()`, or -1 on failure.
+		*/
+		template <typename T>
+		intptr_t add_queue(message_queue<T>& _queue, uint64_t _token)
+		{
+			const auto _handle = _queue.enable_notifier().native_handle();
+			if (_handle == -1 || !this->add_fd(_handle, static_cast<uint32_t>(poll_event::readable), _token))
+			{
+				return -1;
+			};
+			return _handle;
+		};
+
+		/**
+		 * @brief Adds a timer that is reported as readable when it expires.
+		 *
+		 * Expirations are consumed by `wait()`, so a reported timer doesn't need to be reset.
+		 *
+		 * @param _delay Time from now of the first expiration.
+		 * @param _interval Time between following expirations, or zero for a one-shot timer.
+		 * @param _token Value reported when the timer expires.
+		 * @return Handle to pass to `remove()`, or -1 on failure.
+		*/
+		intptr_t add_timer(std::chrono::nanoseconds _delay, std::chrono::nanoseconds _interval, uint64_t _token);
+
+		/**
+		 * @brief Waits for any of the added handles to be ready.
+		 * @param _results Where to write the ready handles.
+		 * @param _timeout Maximum time to wait for, waits forever if nullopt.
+		 * @return Number of results written, 0 on timeout.
+		*/
+		size_t wait(std::span<poll_result> _results, std::optional<std::chrono::nanoseconds> _timeout = std::nullopt);
+
+		bool good() const noexcept
+		{
+			return this->epoll_ != -1;
+		};
+
+		queue_poller();
+		~queue_poller();
+
+	private:
+
+		struct entry
+		{
+			uint64_t token;
+			bool is_timer;
+		};
+
+		intptr_t epoll_ = -1;
+
+		/**
+		 * @brief Added handles by file descriptor.
+		*/
+		std::unordered_map<intptr_t, entry> entries_;
+
+		queue_poller(const queue_poller&) = delete;
+		queue_poller& operator=(const queue_poller&) = delete;
+	};
+};
@@ -0,0 +1,372 @@
+#pragma once
+
+/**
+ * @file
+ * @brief Single producer single consumer queues living in shared memory, for passing messages between processes.
+ *
+ * The shared region holds a versioned header followed by a ring of records. Only offsets are stored
+ * in the region so each process may map it at a different address. Blocked readers and writers are
+ * woken with futexes on words inside the region.
+ *
+ * Nothing read from the region is trusted, the peer process may be buggy or hostile. The ring size
+ * is fixed when the region is mapped, and positions and record lengths are checked against it
+ * before use. A queue that fails a check is marked corrupt and stops reading or writing records.
+*/
+
+#include <asx/futex.hpp>
+
+#include <bit>
+#include <span>
+#include <array>
+#include <chrono>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <type_traits>
+
+namespace asx
+{
+	/**
+	 * @brief Layout of the start of a shared queue region, private to the implementation.
+	*/
+	struct shm_queue_header;
+
+	/**
+	 * @brief Thread and process safe SINGLE READER SINGLE WRITER queue of variable length byte records in shared memory.
+	 *
+	 * One process creates the queue (named, or anonymous to be passed by file descriptor), the other
+	 * opens it. Closing does not remove a named region, use `unlink()` once both sides have opened it.
+	*/
+	class shm_byte_queue
+	{
+	public:
+
+		/**
+		 * @brief Version of the shared region layout, opening a region with another version fails.
+		*/
+		constexpr static uint32_t LAYOUT_VERSION = 1;
+
+		/**
+		 * @brief Creates a new named queue, replacing any existing region with the same name.
+		 * @param _name Region name, e.g. "/my_queue". If null an anonymous region is created (memfd on linux).
+		 * @param _capacity Minimum number of bytes in the record ring, rounded up to a power of two.
+		 * @return True on success, false otherwise (an error message will be logged).
+		*/
+		bool create(const char* _name, size_t _capacity);
+
+		/**
+		 * @brief Opens an existing named queue.
+		 * @param _name Region name given to `create()`.
+		 * @return True on success, false otherwise (an error message will be logged).
+		*/
+		bool open(const char* _name);
+
+		/**
+		 * @brief Opens a queue from a native handle (file descriptor on linux) to its region.
+		 *
+		 * Used with anonymous queues, whose handle has been inherited or passed over a socket. The
+		 * handle is duplicated, the caller keeps ownership of the one given.
+		 *
+		 * @param _handle Native handle of the region.
+		 * @return True on success, false otherwise (an error message will be logged).
+		*/
+		bool open_native(intptr_t _handle);
+
+		/**
+		 * @brief Gets the native handle (file descriptor on linux) of the region.
+		 * @return Native handle, or -1 if not open.
+		*/
+		intptr_t native_handle() const noexcept
+		{
+			return this->handle_;
+		};
+
+		/**
+		 * @brief Unmaps the region, does nothing if not open.
+		*/
+		void close() noexcept;
+
+		/**
+		 * @brief Removes a named region, existing mappings of it remain valid.
+		 * @param _name Region name given to `create()`.
+		*/
+		static void unlink(const char* _name);
+
+		bool is_open() const noexcept
+		{
+			return this->header_ != nullptr;
+		};
+
+		/**
+		 * @brief Checks if the peer left the queue in an invalid state.
+		 *
+		 * Once corrupt, no more records are pushed or read and waiting for a record returns at once.
+		*/
+		bool is_corrupt() const noexcept
+		{
+			return this->corrupt_;
+		};
+
+		/**
+		 * @brief Gets the number of bytes in the record ring.
+		*/
+		size_t capacity() const noexcept;
+
+		/**
+		 * @brief Gets the largest record that may be pushed.
+		*/
+		size_t max_record_size() const noexcept;
+
+		/**
+		 * @brief Checks if the queue has NO records queued up.
+		*/
+		bool empty() const noexcept;
+
+		/**
+		 * @brief Pushes a record without blocking. WRITER ONLY.
+		 * @param _record Record bytes.
+		 * @return True if the record was pushed, false if the queue is full or the record is too large.
+		*/
+		bool try_push(std::span<const std::byte> _record);
+
+		/**
+		 * @brief Pushes a record, blocking while the queue is full. WRITER ONLY.
+		 * @param _record Record bytes, must be no larger than `max_record_size()`.
+		 * @return True once the record was pushed, false if the queue is corrupt.
+		*/
+		bool push(std::span<const std::byte> _record);
+
+		/**
+		 * @brief Views the next record in place without popping it. READER ONLY.
+		 * @return Span viewing the record, valid until `pop()`. Empty if the queue is empty or corrupt.
+		*/
+		std::optional<std::span<const std::byte>> try_peek();
+
+		/**
+		 * @brief Pops the record previously returned by `try_peek()`. READER ONLY.
+		*/
+		void pop();
+
+		/**
+		 * @brief Attempts to grab the next record in the queue. READER ONLY.
+		 * @return Copy of the next record, or nullopt if the queue is empty.
+		*/
+		std::optional<std::vector<std::byte>> try_next();
+
+		/**
+		 * @brief Blocks until there is a record to read. READER ONLY.
+		 * @param _timeout Maximum time to wait for.
+		 * @return True if a record is ready, false on timeout or if the queue is corrupt.
+		*/
+		bool wait_for_record(std::chrono::nanoseconds _timeout);
+
+		/**
+		 * @brief Blocks until there is a record to read, or the queue is found to be corrupt. READER ONLY.
+		*/
+		void wait_for_record();
+
+		shm_byte_queue() = default;
+
+		shm_byte_queue(shm_byte_queue&& other) noexcept;
+		shm_byte_queue& operator=(shm_byte_queue&& other) noexcept;
+
+		~shm_byte_queue()
+		{
+			this->close();
+		};
+
+	private:
+
+		/**
+		 * @brief Maps the region behind `handle_`, validating or initializing its header.
+		*/
+		bool map_region(size_t _capacity, bool _initialize);
+
+		/**
+		 * @brief Marks the queue corrupt, logging the reason the first time.
+		*/
+		void set_corrupt(const char* _reason) noexcept;
+
+		shm_queue_header* header_ = nullptr;
+		std::byte* ring_ = nullptr;
+		size_t map_size_ = 0;
+		intptr_t handle_ = -1;
+
+		/**
+		 * @brief Size of the record ring, read once from the header when the region is mapped.
+		*/
+		size_t capacity_ = 0;
+
+		/**
+		 * @brief Set once a check on the shared state fails.
+		*/
+		bool corrupt_ = false;
+
+		/**
+		 * @brief Bytes the reader will advance by on `pop()`, zero if nothing has been peeked.
+		*/
+		uint64_t peeked_size_ = 0;
+
+		shm_byte_queue(const shm_byte_queue&) = delete;
+		shm_byte_queue& operator=(const shm_byte_queue&) = delete;
+	};
+
+	/**
+	 * @brief Thread and process safe SINGLE READER SINGLE WRITER message queue (FIFO) in shared memory.
+	 *
+	 * See `shm_byte_queue` for creating and opening the queue.
+	 *
+	 * @tparam T Message type, must be trivially copyable as it is copied between processes byte by byte.
+	*/
+	template <typename T>
+	requires std::is_trivially_copyable_v<T>
+	class shm_message_queue
+	{
+	public:
+
+		using value_type = T;
+		using pointer = value_type*;
+		using reference = value_type&;
+		using const_pointer = const value_type*;
+		using const_reference = const value_type&;
+
+		using size_type = size_t;
+
+		/**
+		 * @brief Creates a new queue, see `shm_byte_queue::create()`.
+		 * @param _name Region name, or null for an anonymous region.
+		 * @param _count Minimum number of messages the queue can hold.
+		 * @return True on success, false otherwise.
+		*/
+		bool create(const char* _name, size_type _count)
+		{
+			// Skipping the end of the ring can waste up to one record
+			return this->queue_.create(_name, (_count + 1) * record_size);
+		};
+
+		/**
+		 * @brief Opens an existing named queue, see `shm_byte_queue::open()`.
+		*/
+		bool open(const char* _name)
+		{
+			return this->queue_.open(_name);
+		};
+
+		/**
+		 * @brief Opens a queue from a native handle, see `shm_byte_queue::open_native()`.
+		*/
+		bool open_native(intptr_t _handle)
+		{
+			return this->queue_.open_native(_handle);
+		};
+
+		intptr_t native_handle() const noexcept
+		{
+			return this->queue_.native_handle();
+		};
+
+		void close() noexcept
+		{
+			this->queue_.close();
+		};
+
+		bool is_open() const noexcept
+		{
+			return this->queue_.is_open();
+		};
+
+		/**
+		 * @brief Checks if the queue has NO data queued up.
+		 * @return True if the next call to try_next() would return null.
+		*/
+		bool empty() const noexcept
+		{
+			return this->queue_.empty();
+		};
+
+		/**
+		 * @brief Attempts to grab the next element in the queue. READER ONLY.
+		 *
+		 * Records that aren't the size of a message, which only a misbehaving peer pushes, are dropped.
+		 *
+		 * @return The next element in the queue, or nullopt if the queue is empty.
+		*/
+		std::optional<value_type> try_next()
+		{
+			const auto _record = this->queue_.try_peek();
+			if (!_record)
+			{
+				return std::nullopt;
+			};
+			if (_record->size() != sizeof(value_type))
+			{
+				this->queue_.pop();
+				return std::nullopt;
+			};
+
+			// Copied out through a byte array so the message type doesn't need a default constructor
+			auto _bytes = std::array<std::byte, sizeof(value_type)>{};
+			std::memcpy(_bytes.data(), _record->data(), sizeof(value_type));
+			this->queue_.pop();
+			return std::bit_cast<value_type>(_bytes);
+		};
+
+		/**
+		 * @brief Checks if the peer left the queue in an invalid state, see `shm_byte_queue::is_corrupt()`.
+		*/
+		bool is_corrupt() const noexcept
+		{
+			return this->queue_.is_corrupt();
+		};
+
+		/**
+		 * @brief Waits for the next element in the queue. READER ONLY.
+		 * @return The next element in the queue, or nullopt if the queue is corrupt.
+		*/
+		std::optional<value_type> wait_next()
+		{
+			while (!this->queue_.is_corrupt())
+			{
+				if (auto _value = this->try_next(); _value)
+				{
+					return _value;
+				};
+				this->queue_.wait_for_record();
+			};
+			return std::nullopt;
+		};
+
+		/**
+		 * @brief Pushes an element onto the queue without blocking. WRITER ONLY.
+		 * @param _value Value to add to the queue.
+		 * @return True if the value was pushed, false if the queue is full.
+		*/
+		bool try_push(const_reference _value)
+		{
+			return this->queue_.try_push(std::as_bytes(std::span<const value_type, 1>(&_value, 1)));
+		};
+
+		/**
+		 * @brief Pushes an element onto the queue, blocking while it is full. WRITER ONLY.
+		 * @param _value Value to add to the queue.
+		 * @return True once the value was pushed, false if the queue is corrupt.
+		*/
+		bool push(const_reference _value)
+		{
+			return this->queue_.push(std::as_bytes(std::span<const value_type, 1>(&_value, 1)));
+		};
+
+		shm_message_queue() = default;
+
+	private:
+
+		/**
+		 * @brief Bytes each message takes in the ring, including its length prefix.
+		*/
+		constexpr static size_type record_size = (sizeof(value_type) + sizeof(uint32_t) + 7) & ~size_type(7);
+
+		shm_byte_queue queue_;
+	};
+};
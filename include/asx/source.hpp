@@ -230,6 +230,29 @@ namespace asx
 	*/
 	size_t get_stack_trace(std::span<SourceLocation> _outBuffer, size_t _skipFrames = 0);
 
+	/**
+	 * @brief Identifies a thread to the OS, the kernel thread id on linux.
+	*/
+	using os_thread_id = uint64_t;
+
+	/**
+	 * @brief Gets the OS id of the calling thread.
+	*/
+	os_thread_id get_os_thread_id();
+
+	/**
+	 * @brief Gets a stack trace of another thread in this process if possible.
+	 *
+	 * On linux the thread is sent `SIGRTMIN + 3` and captures its own stack from the signal handler,
+	 * which stays installed once first used. A thread that blocks the signal, or doesn't respond within
+	 * 200ms, gives no frames.
+	 *
+	 * @param _thread OS id of the thread, may be the calling thread.
+	 * @param _outBuffer Buffer of stack frame objects to write stack frames into.
+	 * @return Number of frames written.
+	*/
+	size_t get_thread_stack_trace(os_thread_id _thread, std::span<SourceLocation> _outBuffer);
+
 	/**
 	 * @brief Holds a number of stack frames composing a stack trace.
 	 * 
@@ -0,0 +1,207 @@
+#pragma once
+
+/**
+ * @file
+ * @brief Latch, barrier, and counting semaphore that spin briefly before sleeping on a futex.
+*/
+
+#include <asx/futex.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+namespace asx
+{
+	/**
+	 * @brief Hints to the CPU that the calling thread is spinning.
+	*/
+	void cpu_relax() noexcept;
+
+	/**
+	 * @brief Number of times waits spin checking their condition before sleeping.
+	*/
+	constexpr inline uint32_t SYNC_SPIN_COUNT_DEFAULT = 128;
+
+	/**
+	 * @brief Single use countdown, threads wait until it reaches zero.
+	*/
+	class latch
+	{
+	public:
+
+		/**
+		 * @brief Decrements the counter, waking waiters if it reaches zero.
+		 * @param _count Amount to decrement by, must not exceed the counter.
+		*/
+		void count_down(uint32_t _count = 1) noexcept;
+
+		/**
+		 * @brief Checks if the counter has reached zero.
+		*/
+		bool try_wait() const noexcept
+		{
+			return this->count_.load(std::memory_order_acquire) == 0;
+		};
+
+		/**
+		 * @brief Waits until the counter reaches zero.
+		*/
+		void wait() const noexcept;
+
+		/**
+		 * @brief Decrements the counter then waits until it reaches zero.
+		 * @param _count Amount to decrement by, must not exceed the counter.
+		*/
+		void arrive_and_wait(uint32_t _count = 1) noexcept
+		{
+			this->count_down(_count);
+			this->wait();
+		};
+
+		explicit latch(uint32_t _count) noexcept :
+			count_(_count)
+		{};
+
+	private:
+		alignas(64) futex_word count_;
+
+		/**
+		 * @brief Number of threads sleeping on the counter, lets the last count down skip the wake syscall.
+		*/
+		mutable std::atomic<uint32_t> sleepers_{ 0 };
+
+		latch(const latch&) = delete;
+		latch& operator=(const latch&) = delete;
+	};
+
+	/**
+	 * @brief Reusable barrier for a fixed number of participants, arrivals are combined up a tree.
+	 *
+	 * Participants are grouped into nodes of `fan_in`, only the last arrival at each node continues up
+	 * to its parent, so no counter is touched by more than `fan_in` threads. The last arrival at the
+	 * root runs the completion function (if any) then releases everyone by bumping the phase.
+	 *
+	 * Each participant must pass its own unique id to `arrive_and_wait()`.
+	*/
+	class barrier
+	{
+	public:
+
+		/**
+		 * @brief Arrives at the barrier and waits for every other participant.
+		 * @param _id Participant id, less than the participant count and unique per participant.
+		*/
+		void arrive_and_wait(size_t _id);
+
+		/**
+		 * @brief Gets the number of participants.
+		*/
+		size_t participants() const noexcept
+		{
+			return this->participants_;
+		};
+
+		/**
+		 * @brief Gets the number of completed phases.
+		*/
+		uint32_t phase() const noexcept
+		{
+			return this->phase_.load(std::memory_order_acquire);
+		};
+
+		/**
+		 * @brief Constructs a barrier.
+		 * @param _participants Number of participants, must not be 0.
+		 * @param _completion Invoked by the last arrival of each phase before anyone is released.
+		 * @param _fanIn Number of arrivals combined at each tree node, at least 2.
+		*/
+		explicit barrier(size_t _participants, std::function<void()> _completion = nullptr, size_t _fanIn = 4);
+
+	private:
+
+		struct alignas(64) node
+		{
+			std::atomic<uint32_t> count{ 0 };
+			uint32_t expected = 0;
+			node* parent = nullptr;
+		};
+
+		alignas(64) futex_word phase_{ 0 };
+
+		/**
+		 * @brief Number of threads sleeping on the phase, lets the last arrival skip the wake syscall.
+		*/
+		std::atomic<uint32_t> sleepers_{ 0 };
+
+		size_t participants_;
+		size_t fan_in_;
+		std::unique_ptr<node[]> nodes_;
+		std::function<void()> completion_;
+
+		barrier(const barrier&) = delete;
+		barrier& operator=(const barrier&) = delete;
+	};
+
+	/**
+	 * @brief Counting semaphore, acquiring blocks while the count is zero.
+	*/
+	class counting_semaphore
+	{
+	public:
+
+		/**
+		 * @brief Increments the count, waking waiters.
+		 * @param _count Amount to increment by.
+		*/
+		void release(uint32_t _count = 1) noexcept;
+
+		/**
+		 * @brief Decrements the count if it isn't zero.
+		 * @return True if the count was decremented.
+		*/
+		bool try_acquire() noexcept
+		{
+			auto _count = this->count_.load(std::memory_order_relaxed);
+			while (_count != 0)
+			{
+				if (this->count_.compare_exchange_weak(_count, _count - 1, std::memory_order_acquire, std::memory_order_relaxed))
+				{
+					return true;
+				};
+			};
+			return false;
+		};
+
+		/**
+		 * @brief Decrements the count, waiting while it is zero.
+		*/
+		void acquire() noexcept;
+
+		/**
+		 * @brief Decrements the count, waiting while it is zero up to a timeout.
+		 * @param _timeout Maximum time to wait for.
+		 * @return True if the count was decremented, false on timeout.
+		*/
+		bool try_acquire_for(std::chrono::nanoseconds _timeout) noexcept;
+
+		explicit counting_semaphore(uint32_t _count = 0) noexcept :
+			count_(_count)
+		{};
+
+	private:
+		alignas(64) futex_word count_;
+
+		/**
+		 * @brief Number of threads sleeping on the count, kept apart from it so releases don't contend with spinners.
+		*/
+		alignas(64) std::atomic<uint32_t> sleepers_{ 0 };
+
+		counting_semaphore(const counting_semaphore&) = delete;
+		counting_semaphore& operator=(const counting_semaphore&) = delete;
+	};
+};
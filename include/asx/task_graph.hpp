@@ -0,0 +1,145 @@
+#pragma once
+
+/** @file */
+
+#include <asx/futex.hpp>
+#include <asx/profile.hpp>
+#include <asx/thread_pool.hpp>
+
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <string_view>
+
+namespace asx
+{
+	/**
+	 * @brief Fixed graph of dependent tasks that can be run many times on a thread pool.
+	 *
+	 * Nodes and edges are declared once. Each run resets an atomic predecessor counter per node and
+	 * dispatches the roots; a finishing node submits every successor whose counter reaches zero, keeping
+	 * one to run itself. Nothing is allocated by a run once the graph has been run once.
+	 *
+	 * Each node's start and end time from the last run is kept, see `profile()` and `critical_path()`.
+	*/
+	class task_graph
+	{
+	public:
+
+		using node_id = size_t;
+		using clock_type = std::chrono::steady_clock;
+
+		/**
+		 * @brief Adds a node.
+		 * @param _name Name shown in profiling results.
+		 * @param _fn Function to run, exceptions are rethrown from `run()`.
+		 * @return Id of the new node.
+		*/
+		node_id add(std::string _name, std::function<void()> _fn);
+
+		/**
+		 * @brief Adds an edge, a node only runs after every node that precedes it has finished.
+		 * @param _before Node that must finish first.
+		 * @param _after Node that depends on it.
+		*/
+		void precede(node_id _before, node_id _after);
+
+		/**
+		 * @brief Runs every node once, respecting the edges, and waits for them to finish.
+		 *
+		 * The calling thread runs pool tasks while it waits. Runs of the same graph must not overlap.
+		 * If any node threw, the rest of the graph still runs and then the first exception is rethrown.
+		 *
+		 * @param _pool Pool to run the nodes on.
+		*/
+		void run(thread_pool& _pool);
+
+		/**
+		 * @brief Gets the number of nodes.
+		*/
+		size_t size() const noexcept
+		{
+			return this->nodes_.size();
+		};
+
+		/**
+		 * @brief Gets how long a node took in the last run.
+		*/
+		clock_type::duration node_time(node_id _node) const;
+
+		/**
+		 * @brief Gets how long the last run took.
+		*/
+		clock_type::duration total_time() const noexcept
+		{
+			return this->end_time_ - this->start_time_;
+		};
+
+		/**
+		 * @brief Gets the chain of nodes that gated the end of the last run.
+		 *
+		 * Starts from the node that finished last and walks back through the predecessor that finished last.
+		 *
+		 * @return Node ids from the first to the last node of the chain, empty if the graph was never run.
+		*/
+		std::vector<node_id> critical_path() const;
+
+		/**
+		 * @brief Gets the time each node took in the last run.
+		 * @return One lap per node in id order, the total is the time the whole run took.
+		*/
+		ASXSingleTimeProfiler::Result profile() const;
+
+		/**
+		 * @brief Logs the nodes on the critical path of the last run with their times.
+		*/
+		void print_critical_path() const;
+
+		task_graph();
+		~task_graph();
+
+	private:
+		struct node;
+
+		/**
+		 * @brief Runs a node and then any successor it made ready, until none is left.
+		*/
+		void execute(node* _node);
+
+		/**
+		 * @brief Finds the roots and checks the graph is acyclic, only done after the graph changes.
+		*/
+		void prepare();
+
+		std::vector<std::unique_ptr<node>> nodes_;
+		std::vector<node*> roots_;
+		bool prepared_ = false;
+
+		thread_pool* pool_ = nullptr;
+
+		/**
+		 * @brief Nodes left to finish in the current run.
+		*/
+		alignas(64) std::atomic<size_t> remaining_{ 0 };
+
+		/**
+		 * @brief 0 while running, 1 while the last node wakes the runner, 2 once done.
+		*/
+		futex_word done_{ 2 };
+
+		std::mutex error_mtx_;
+		std::exception_ptr error_;
+
+		clock_type::time_point start_time_{};
+		clock_type::time_point end_time_{};
+
+		task_graph(const task_graph&) = delete;
+		task_graph& operator=(const task_graph&) = delete;
+	};
+};
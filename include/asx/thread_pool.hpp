@@ -0,0 +1,187 @@
+#pragma once
+
+/** @file */
+
+#include <asx/futex.hpp>
+
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <concepts>
+#include <functional>
+#include <type_traits>
+
+namespace asx
+{
+	class thread_pool;
+
+	/**
+	 * @brief Unit of work run by a thread pool, owned by whoever submits it.
+	 *
+	 * Tasks are linked intrusively so submitting one never allocates.
+	*/
+	class thread_pool_task
+	{
+	public:
+
+		/**
+		 * @brief Runs the task on a pool thread, must not throw.
+		*/
+		virtual void run() = 0;
+
+	protected:
+		~thread_pool_task() = default;
+
+	private:
+		friend class thread_pool;
+
+		/**
+		 * @brief Link in the pool's injection queue.
+		*/
+		thread_pool_task* next_ = nullptr;
+	};
+
+	namespace impl
+	{
+		/**
+		 * @brief Heap allocated task wrapping a function, deletes itself after running.
+		*/
+		template <typename FnT>
+		class function_task final : public thread_pool_task
+		{
+		public:
+			void run() override
+			{
+				const auto _self = std::unique_ptr<function_task>(this);
+				std::invoke(this->fn_);
+			};
+
+			explicit function_task(FnT&& _fn) :
+				fn_(std::move(_fn))
+			{};
+
+		private:
+			FnT fn_;
+		};
+	};
+
+	/**
+	 * @brief Fixed set of worker threads that run submitted tasks, balancing load by work stealing.
+	 *
+	 * Each worker has its own bounded Chase-Lev deque: it pushes and pops at the bottom without contention
+	 * while idle workers steal from the top of others. Tasks submitted from outside the pool, or that
+	 * overflow a deque, go through a shared injection queue. Idle workers spin briefly then sleep on a futex.
+	 *
+	 * Destroying the pool runs every task already submitted before the workers exit.
+	*/
+	class thread_pool
+	{
+	public:
+
+		/**
+		 * @brief Queues a task.
+		 *
+		 * From a worker of this pool the task goes on that worker's own deque.
+		 *
+		 * @param _task Task to run, must stay alive until it has run.
+		*/
+		void submit(thread_pool_task& _task);
+
+		/**
+		 * @brief Queues a function, allocating a task to hold it.
+		 * @param _fn Function to run, must not throw.
+		*/
+		template <typename FnT>
+		requires std::invocable<std::decay_t<FnT>&>
+		void submit(FnT&& _fn)
+		{
+			using task_type = impl::function_task<std::decay_t<FnT>>;
+			this->submit(*new task_type(std::decay_t<FnT>(std::forward<FnT>(_fn))));
+		};
+
+		/**
+		 * @brief Runs one queued task on the calling thread if there is one.
+		 *
+		 * Lets a thread that waits on pool work help instead of blocking.
+		 *
+		 * @return True if a task was run.
+		*/
+		bool try_run_one();
+
+		/**
+		 * @brief Gets the number of worker threads.
+		*/
+		size_t size() const noexcept
+		{
+			return this->worker_count_;
+		};
+
+		/**
+		 * @brief Checks if the calling thread is one of this pool's workers.
+		*/
+		bool is_worker_thread() const noexcept;
+
+		/**
+		 * @brief Starts the worker threads.
+		 * @param _threads Number of workers, 0 uses the hardware concurrency.
+		*/
+		explicit thread_pool(size_t _threads = 0);
+
+		/**
+		 * @brief Runs the remaining queued tasks then joins the workers.
+		*/
+		~thread_pool();
+
+	private:
+		struct worker;
+
+		void worker_main(size_t _index);
+
+		/**
+		 * @brief Finds a task from the calling worker's deque, the injection queue, or another worker.
+		 * @param _self The calling worker, or null if it isn't one.
+		*/
+		thread_pool_task* find_task(worker* _self);
+
+		thread_pool_task* pop_injected();
+		void push_injected(thread_pool_task& _task);
+		thread_pool_task* steal(worker* _self);
+
+		/**
+		 * @brief Checks if any task is queued anywhere.
+		*/
+		bool has_queued() const noexcept;
+
+		/**
+		 * @brief Wakes a sleeping worker if there is one.
+		*/
+		void notify();
+
+		size_t worker_count_;
+		std::unique_ptr<worker[]> workers_;
+		std::vector<std::thread> threads_;
+
+		/**
+		 * @brief Intrusive FIFO of tasks submitted from outside the pool.
+		*/
+		std::mutex inject_mtx_;
+		thread_pool_task* inject_head_ = nullptr;
+		thread_pool_task* inject_tail_ = nullptr;
+		std::atomic<bool> has_injected_{ false };
+
+		/**
+		 * @brief Bumped to wake sleeping workers.
+		*/
+		alignas(64) futex_word wake_epoch_{ 0 };
+		std::atomic<uint32_t> sleepers_{ 0 };
+		std::atomic<bool> stop_{ false };
+
+		thread_pool(const thread_pool&) = delete;
+		thread_pool& operator=(const thread_pool&) = delete;
+	};
+};
@@ -0,0 +1,139 @@
+#pragma once
+
+/** @file */
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <utility>
+
+namespace asx
+{
+	/**
+	 * @brief Hands the latest value from a SINGLE WRITER to a SINGLE READER without either ever waiting.
+	 *
+	 * Three buffers are kept: one the writer fills, one the reader holds, and one in the middle holding
+	 * the latest published value. Publishing and reading swap with the middle buffer through one atomic,
+	 * so the reader always sees a complete value and skips any it didn't get to in time.
+	 *
+	 * Values are assigned into existing buffers, nothing is allocated after construction.
+	 *
+	 * @tparam T The type of the value being handed off.
+	*/
+	template <typename T>
+	class triple_buffer
+	{
+	public:
+
+		using value_type = T;
+		using reference = value_type&;
+		using const_reference = const value_type&;
+
+	private:
+
+		/**
+		 * @brief Set in the middle index when it holds a value the reader hasn't taken yet.
+		*/
+		constexpr static uint8_t dirty_bit = 0x4;
+		constexpr static uint8_t index_mask = 0x3;
+
+		struct alignas(64) slot
+		{
+			value_type value;
+		};
+
+	public:
+
+		/**
+		 * @brief Gets the buffer to fill with the next value. WRITER ONLY.
+		 *
+		 * It holds an old value, callers must overwrite all of it before publishing.
+		*/
+		reference write() noexcept
+		{
+			return this->slots_[this->back_].value;
+		};
+
+		/**
+		 * @brief Publishes the buffer returned by `write()` as the latest value. WRITER ONLY.
+		*/
+		void publish() noexcept
+		{
+			const auto _prev = this->middle_.exchange(this->back_ | dirty_bit, std::memory_order_acq_rel);
+			this->back_ = _prev & index_mask;
+		};
+
+		/**
+		 * @brief Publishes a value by copy. WRITER ONLY.
+		*/
+		void publish(const_reference _value)
+		{
+			this->write() = _value;
+			this->publish();
+		};
+
+		/**
+		 * @brief Publishes a value by move. WRITER ONLY.
+		*/
+		void publish(value_type&& _value)
+		{
+			this->write() = std::move(_value);
+			this->publish();
+		};
+
+		/**
+		 * @brief Checks if a value was published since the last read. READER ONLY.
+		*/
+		bool has_new() const noexcept
+		{
+			return (this->middle_.load(std::memory_order_relaxed) & dirty_bit) != 0;
+		};
+
+		/**
+		 * @brief Takes the latest published value. READER ONLY.
+		 * @return The latest value, stays valid until the next call. Same as the last call if nothing new was published.
+		*/
+		reference read_latest() noexcept
+		{
+			if (this->has_new())
+			{
+				const auto _prev = this->middle_.exchange(this->front_, std::memory_order_acq_rel);
+				this->front_ = _prev & index_mask;
+			};
+			return this->slots_[this->front_].value;
+		};
+
+		/**
+		 * @brief Constructs with every buffer default constructed.
+		*/
+		triple_buffer() = default;
+
+		/**
+		 * @brief Constructs with every buffer holding a copy of an initial value.
+		*/
+		explicit triple_buffer(const_reference _initial) :
+			slots_{ slot{ _initial }, slot{ _initial }, slot{ _initial } }
+		{};
+
+	private:
+		std::array<slot, 3> slots_{};
+
+		/**
+		 * @brief Index of the middle buffer, with `dirty_bit` set if it hasn't been read.
+		*/
+		alignas(64) std::atomic<uint8_t> middle_{ 1 };
+
+		/**
+		 * @brief Index of the writer's buffer, writer owned.
+		*/
+		alignas(64) uint8_t back_ = 0;
+
+		/**
+		 * @brief Index of the reader's buffer, reader owned.
+		*/
+		alignas(64) uint8_t front_ = 2;
+
+		triple_buffer(const triple_buffer&) = delete;
+		triple_buffer& operator=(const triple_buffer&) = delete;
+	};
+};
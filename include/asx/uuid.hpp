@@ -7,7 +7,9 @@
 #include <string>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <compare>
+#include <functional>
 #include <algorithm>
 #include <string_view>
 
@@ -88,4 +90,18 @@ namespace asx
 		storage_type bytes_;
 
 	};
+};
+
+template <>
+struct std::hash<asx::uuid>
+{
+	size_t operator()(const asx::uuid& _value) const noexcept
+	{
+		// Random UUIDs are already uniform, folding the two halves is enough
+		const auto _bytes = _value.to_bytes();
+		uint64_t _low, _high;
+		std::memcpy(&_low, _bytes.data(), sizeof(_low));
+		std::memcpy(&_high, _bytes.data() + sizeof(_low), sizeof(_high));
+		return static_cast<size_t>(_low ^ (_high * 0x9E3779B97F4A7C15ULL));
+	};
 };
\ No newline at end of file
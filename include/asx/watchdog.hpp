@@ -0,0 +1,137 @@
+#pragma once
+
+/**
+ * @file
+ * @brief Detects threads that stop making progress and logs where they are stuck.
+*/
+
+#include <asx/source.hpp>
+#include <asx/metrics.hpp>
+
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include <condition_variable>
+
+namespace asx
+{
+	/**
+	 * @brief Watches registered threads for missed heartbeats.
+	 *
+	 * A registered thread calls `beat()` on its handle whenever it makes progress. A monitor thread
+	 * checks the heartbeats periodically. When a thread misses its deadline, its stack is captured with
+	 * `get_thread_stack_trace()` and logged as an error. The `watchdog.<name>.stalls` metric is also bumped.
+	 * Each stall is reported once, and a log message follows when the thread recovers.
+	 *
+	 * A thread that is about to wait for work for an unbounded time should call `idle()` first. It
+	 * isn't watched again until its next `beat()`.
+	*/
+	class watchdog
+	{
+	private:
+		struct entry;
+		struct event;
+
+	public:
+
+		/**
+		 * @brief Registration of one thread, unregisters it when destroyed.
+		*/
+		class handle
+		{
+		public:
+
+			/**
+			 * @brief Records progress, only call from the registered thread.
+			*/
+			void beat() noexcept
+			{
+				// Bumps the count and clears the idle bit, only this thread writes so no RMW is needed
+				const auto _value = this->heartbeat_->load(std::memory_order_relaxed);
+				this->heartbeat_->store((_value | 1) + 1, std::memory_order_relaxed);
+			};
+
+			/**
+			 * @brief Stops watching the thread until its next `beat()`, only call from the registered thread.
+			*/
+			void idle() noexcept
+			{
+				const auto _value = this->heartbeat_->load(std::memory_order_relaxed);
+				this->heartbeat_->store(_value | 1, std::memory_order_relaxed);
+			};
+
+			handle() = default;
+			handle(handle&& other) noexcept;
+			handle& operator=(handle&& other) noexcept;
+			~handle();
+
+		private:
+			friend class watchdog;
+
+			handle(watchdog* _watchdog, entry* _entry, std::atomic<uint64_t>* _heartbeat) :
+				watchdog_(_watchdog), entry_(_entry), heartbeat_(_heartbeat)
+			{};
+
+			watchdog* watchdog_ = nullptr;
+			entry* entry_ = nullptr;
+
+			/**
+			 * @brief Beat count times two, the low bit is set while idle.
+			*/
+			std::atomic<uint64_t>* heartbeat_ = nullptr;
+		};
+
+		/**
+		 * @brief Starts watching the calling thread.
+		 * @param _name Name of the thread shown in stall reports.
+		 * @param _deadline Longest time allowed between heartbeats.
+		 * @return Handle used to beat, the thread is watched until it is destroyed.
+		*/
+		handle watch(std::string _name, std::chrono::milliseconds _deadline);
+
+		/**
+		 * @brief Gets the number of stalls detected so far.
+		*/
+		int64_t stalls() const
+		{
+			return this->stalls_.value();
+		};
+
+		/**
+		 * @brief Starts the monitor thread.
+		 * @param _name Name of the watchdog, used in its metric's name.
+		 * @param _interval How often heartbeats are checked, also the resolution of deadlines.
+		*/
+		explicit watchdog(const std::string& _name, std::chrono::milliseconds _interval = std::chrono::milliseconds(100));
+
+		/**
+		 * @brief Stops the monitor thread, every handle must have been destroyed first.
+		*/
+		~watchdog();
+
+	private:
+
+		void unwatch(entry* _entry);
+		void monitor();
+		void check(entry& _entry, std::chrono::steady_clock::time_point _now, std::vector<event>& _outEvents);
+		void report(const event& _event);
+
+		std::chrono::milliseconds interval_;
+
+		std::mutex mtx_;
+		std::condition_variable cv_;
+		std::vector<std::unique_ptr<entry>> entries_;
+		bool stop_ = false;
+
+		metric_counter stalls_;
+		std::thread thread_;
+
+		watchdog(const watchdog&) = delete;
+		watchdog& operator=(const watchdog&) = delete;
+	};
+};
@@ -425,7 +425,6 @@ namespace asx
 						// OK, add to finished raw args
 						_finishedRawArguments.push_back(_parsingRawArgument);
 						_parsingRawArgument.clear();
-						++it;
 					}
 					else
 					{
@@ -458,8 +457,8 @@ namespace asx
 					};
 
 					// Find matching definition
-					auto it = _argumentDefinitionNames.find(std::string(_arg));
-					if (it == _argumentDefinitionNames.end())
+					const auto _found = _argumentDefinitionNames.find(std::string(_arg));
+					if (_found == _argumentDefinitionNames.end())
 					{
 						// Option not defined
 						auto _errorText = asx::format("Found unrecognized option \"{}\"", _arg);
@@ -467,11 +466,15 @@ namespace asx
 					};
 
 					// Definition currently being parsed
-					auto _definition = it->second;
+					auto _definition = _found->second;
 
 					// We have an option name, set it to the current definition being parsed
 					_parsingDefinition = _definition;
 					_parsingRawArgument.name = _arg;
+
+					// Values (if any) follow the option name
+					++it;
+					continue;
 				}
 				else
 				{
@@ -479,8 +482,8 @@ namespace asx
 					if (_numParsedPositionalArgs >= _positionArgumentDefinitions.size())
 					{
 						// Too many positional arguments
-						auto _errorText = asx::format("Got too many positional arguments \"{}\", expected at least {}",
-							_arg, _numPositionArgumentsRequired);
+						auto _errorText = asx::format("Got too many positional arguments \"{}\", expected at most {}",
+							_arg, _positionArgumentDefinitions.size());
 						return ParseResult(true, true, std::move(_errorText));
 					};
 
@@ -556,9 +559,50 @@ namespace asx
 			};
 		};
 
+		// Check every required positional argument was given
+		if (_numParsedPositionalArgs < _numPositionArgumentsRequired)
+		{
+			auto _errorText = asx::format("Expected at least {} positional arguments but only {} were provided",
+				_numPositionArgumentsRequired, _numParsedPositionalArgs);
+			return ParseResult(true, true, std::move(_errorText));
+		};
+
+		// Storage for converting the values of one argument at a time
+		std::vector<ParsedValue> _values{};
 
+		// Collects the values given for an argument, the last occurence wins if a named argument was repeated
+		const auto _collectValues = [&](const ArgumentDefinition* _definition) -> std::span<const ParsedValue>
+		{
+			_values.clear();
+			for (auto it = _finishedRawArguments.rbegin(); it != _finishedRawArguments.rend(); ++it)
+			{
+				if (it->definition == _definition)
+				{
+					for (auto& _value : it->values)
+					{
+						_values.push_back(ParsedValue(std::string(_value)));
+					};
+					break;
+				};
+			};
+			return _values;
+		};
 
-		return ParseResult(false, false);
+		// Set every defined argument so that looking up an argument that wasn't given doesn't throw,
+		// positional arguments must be set first
+		auto _result = ParseResult(false, false);
+		for (auto& _definition : _positionArgumentDefinitions)
+		{
+			_result.set_positional_argument(_collectValues(_definition), _definition->label);
+		};
+		for (auto& _definition : _argumentDefinitions)
+		{
+			if (!_definition.is_positional)
+			{
+				_result.set_named_argument(_collectValues(&_definition), _definition.label);
+			};
+		};
+		return _result;
 	};
 	ArgumentParser::ParseResult ArgumentParser::parse_args(std::span<const std::string_view> _args)
 	{
@@ -602,6 +646,50 @@ namespace asx
 		return this->parse_args(_vargStrings);
 	};
 
+	const std::string* ArgumentParser::check_option(std::string_view _name, size_t _count, std::string* _outErrorMessage) const
+	{
+		using MultiValueMode = ArgumentDefinition::MultiValueMode;
+
+		for (auto& _definition : this->argument_definitions_)
+		{
+			if (_definition.is_positional || !jc::contains(_definition.names, _name))
+			{
+				continue;
+			};
+
+			// Check the value count fits the argument
+			bool _fits = false;
+			switch (_definition.multi_value_mode)
+			{
+			case MultiValueMode::fixed:
+				_fits = _count == _definition.nvals;
+				break;
+			case MultiValueMode::variable:
+				_fits = _count <= _definition.nvals;
+				break;
+			case MultiValueMode::one_or_more:
+				_fits = _count >= 1 && _count <= _definition.nvals;
+				break;
+			};
+
+			if (!_fits)
+			{
+				if (_outErrorMessage)
+				{
+					*_outErrorMessage = asx::format("Argument \"{}\" can't take {} values", _name, _count);
+				};
+				return nullptr;
+			};
+			return &_definition.label;
+		};
+
+		if (_outErrorMessage)
+		{
+			*_outErrorMessage = asx::format("Found unrecognized option \"{}\"", _name);
+		};
+		return nullptr;
+	};
+
 
 	ArgumentParser::ArgumentDefinitionHandle ArgumentParser::add_argument(std::string_view _label, std::string_view _description)
 	{
@@ -705,23 +793,52 @@ namespace asx
 		// critical so I think its a non-issue.
 		std::ostringstream _sstr{};
 
+		// Writes the metalabel followed by a placeholder for the values of named arguments
+		const auto _writeArgumentText = [&](const ArgumentDefinition& _definition)
+		{
+			_sstr << _definition.metalabel;
+			if (!_definition.is_positional && (_definition.nvals != 0 ||
+				_definition.multi_value_mode != ArgumentDefinition::MultiValueMode::fixed))
+			{
+				_sstr << " <" << _definition.label << '>';
+			};
+			if (_definition.is_positional && _definition.multi_value_mode != ArgumentDefinition::MultiValueMode::fixed)
+			{
+				_sstr << "...";
+			};
+		};
+
 		// Write usage text
-		_sstr << "Usage:\n\t" << this->name_ << ' ';
+		_sstr << "Usage:\n\t" << this->name_;
 		
 		// Add argument metalabel text
 		for (auto& _definition : _argumentDefinitions)
 		{
-			if (_definition.is_optional)
-			{
-				_sstr << '[' << _definition.metalabel << ']';
-			}
-			else
+			_sstr << ' ' << (_definition.is_optional ? '[' : '<');
+			_writeArgumentText(_definition);
+			_sstr << (_definition.is_optional ? ']' : '>');
+		};
+		_sstr << '\n';
+
+		// Add the program's description
+		if (!this->description_.empty())
+		{
+			_sstr << '\n' << this->description_ << '\n';
+		};
+
+		// Add each argument's description
+		_sstr << "\nArguments:\n";
+		for (auto& _definition : _argumentDefinitions)
+		{
+			_sstr << '\t';
+			_writeArgumentText(_definition);
+			_sstr << '\n';
+			if (!_definition.description.empty())
 			{
-				_sstr << '<' << _definition.metalabel << '>';
+				_sstr << "\t\t" << _definition.description << '\n';
 			};
 		};
 
-
 		return _sstr.str();
 	};
 };
@@ -0,0 +1,648 @@
+#include <asx/binlog.hpp>
+
+#include <asx/crc32c.hpp>
+#include <asx/logging.hpp>
+
+#include <chrono>
+#include <limits>
+#include <charconv>
+#include <algorithm>
+
+namespace asx::binlog
+{
+	std::string_view level_name(uint8_t _level)
+	{
+		switch (static_cast<LogLevel>(_level))
+		{
+		case LogLevel::fatal:
+			return "fatal";
+		case LogLevel::error:
+			return "error";
+		case LogLevel::warn:
+			return "warn";
+		case LogLevel::info:
+			return "info";
+		default:
+			return "unknown";
+		};
+	};
+};
+
+namespace asx::binlog
+{
+	bool writer::open(const char* _path, bool _indexed)
+	{
+		auto _stream = std::ofstream(_path, std::ios::binary | std::ios::trunc);
+		if (!_stream.is_open())
+		{
+			return false;
+		};
+
+		const auto lck = std::unique_lock(this->mtx_);
+		if (this->file_.is_open())
+		{
+			this->flush_segment();
+		};
+		this->file_ = std::move(_stream);
+		this->file_offset_ = 0;
+
+		this->index_.close();
+		if (_indexed)
+		{
+			this->index_.open(log_index_path(_path).c_str(), this->segment_capacity_);
+		};
+		return true;
+	};
+
+	void writer::close()
+	{
+		const auto lck = std::unique_lock(this->mtx_);
+		if (this->file_.is_open())
+		{
+			this->flush_segment();
+			this->file_.close();
+			this->index_.close();
+		};
+	};
+
+	bool writer::is_open() const
+	{
+		const auto lck = std::unique_lock(this->mtx_);
+		return this->file_.is_open();
+	};
+
+	void writer::flush()
+	{
+		const auto lck = std::unique_lock(this->mtx_);
+		if (this->file_.is_open())
+		{
+			this->flush_segment();
+		};
+	};
+
+	void writer::set_segment_capacity(size_t _bytes)
+	{
+		const auto lck = std::unique_lock(this->mtx_);
+		this->segment_capacity_ = _bytes;
+	};
+
+	void writer::set_compression(bool _enabled)
+	{
+		const auto lck = std::unique_lock(this->mtx_);
+		this->compress_ = _enabled;
+	};
+
+	uint32_t writer::add_entry(entry_kind _kind, uint8_t _level, uint32_t _line, uint32_t _formatId, std::string_view _str0, std::string_view _str1)
+	{
+		const auto _id = ++this->string_count_;
+		const auto _entry = string_entry_header
+		{
+			.id = _id,
+			.kind = _kind,
+			.level = _level,
+			.reserved = 0,
+			.line = _line,
+			.format_id = _formatId,
+			.size0 = static_cast<uint32_t>(_str0.size()),
+			.size1 = static_cast<uint32_t>(_str1.size())
+		};
+		append_bytes(this->strings_, _entry);
+		this->strings_.append(_str0);
+		this->strings_.append(_str1);
+		return _id;
+	};
+
+	uint32_t writer::intern_format(std::string_view _fmt)
+	{
+		if (const auto it = this->format_ids_.find(_fmt); it != this->format_ids_.end())
+		{
+			return it->second;
+		};
+
+		const auto _id = this->add_entry(entry_kind::format, 0, 0, 0, _fmt, std::string_view());
+		this->format_ids_.emplace(std::string(_fmt), _id);
+		return _id;
+	};
+
+	uint32_t writer::intern_callsite(uint8_t _level, const SourceLocation& _site, uint32_t _formatId)
+	{
+		// Key on everything that makes the entry unique
+		auto _key = std::string();
+		_key.append(_site.file());
+		_key.push_back('\0');
+		_key.append(_site.function());
+		_key.push_back('\0');
+		append_bytes(_key, _site.line());
+		append_bytes(_key, _formatId);
+		_key.push_back(static_cast<char>(_level));
+
+		if (const auto it = this->callsite_ids_.find(_key); it != this->callsite_ids_.end())
+		{
+			return it->second;
+		};
+
+		const auto _id = this->add_entry(entry_kind::callsite, _level, _site.line(), _formatId, _site.file(), _site.function());
+		this->callsite_ids_.emplace(std::move(_key), _id);
+		return _id;
+	};
+
+	void writer::write(uint8_t _level, const SourceLocation* _site, std::string_view _fmt, std::string_view _encodedArgs, size_t _argCount)
+	{
+		namespace ch = std::chrono;
+
+		const auto lck = std::unique_lock(this->mtx_);
+		if (!this->file_.is_open())
+		{
+			return;
+		};
+
+		// Taken under the lock so record timestamps are in file order, which keeps the side index exact
+		const auto _timestamp = static_cast<uint64_t>(
+			ch::duration_cast<ch::nanoseconds>(ch::system_clock::now().time_since_epoch()).count()
+		);
+
+		auto _siteId = this->intern_format(_fmt);
+		if (_site)
+		{
+			_siteId = this->intern_callsite(_level, *_site, _siteId);
+		};
+
+		const auto _record = record_header
+		{
+			.timestamp = _timestamp,
+			.size = static_cast<uint32_t>(sizeof(record_header) + _encodedArgs.size()),
+			.site_id = _siteId,
+			.level = _level,
+			.arg_count = static_cast<uint8_t>(_argCount),
+			.reserved0 = 0,
+			.reserved1 = 0
+		};
+		append_bytes(this->records_, _record);
+		this->records_.append(_encodedArgs);
+
+		if (this->record_count_ == 0)
+		{
+			this->time_begin_ = _timestamp;
+		};
+		this->time_begin_ = std::min(this->time_begin_, _timestamp);
+		this->time_end_ = std::max(this->time_end_, _timestamp);
+		++this->record_count_;
+
+		if (this->records_.size() >= this->segment_capacity_)
+		{
+			this->flush_segment();
+		};
+	};
+
+	void writer::flush_segment()
+	{
+		if (this->record_count_ == 0)
+		{
+			return;
+		};
+
+		// Keep the record block as is unless compressing makes it smaller
+		auto _block = std::as_bytes(std::span<const char>(this->records_.data(), this->records_.size()));
+		bool _compressed = false;
+		if (this->compress_)
+		{
+			this->compressed_.resize(lz::compress_bound(_block.size()));
+			const auto _size = lz::compress_block(_block, this->compressed_);
+			if (_size != 0 && _size < _block.size())
+			{
+				_block = std::span<const std::byte>(this->compressed_.data(), _size);
+				_compressed = true;
+			};
+		};
+
+		auto _header = segment_header
+		{
+			.magic = SEGMENT_MAGIC,
+			.version = FORMAT_VERSION,
+			.header_size = static_cast<uint16_t>(sizeof(segment_header)),
+			.byte_order = BYTE_ORDER_MARKER,
+			.flags = static_cast<uint16_t>(SEGMENT_FLAG_CRC32C | (_compressed ? SEGMENT_FLAG_LZ : 0)),
+			.string_count = this->string_count_,
+			.string_table_size = static_cast<uint32_t>(this->strings_.size()),
+			.record_block_size = _block.size(),
+			.record_count = this->record_count_,
+			.time_begin = this->time_begin_,
+			.time_end = this->time_end_,
+			.record_block_raw_size = static_cast<uint32_t>(_compressed ? this->records_.size() : 0),
+			.checksum = 0
+		};
+		auto _checksum = crc32c(std::as_bytes(std::span<const segment_header>(&_header, 1)));
+		_checksum = crc32c(this->strings_, _checksum);
+		_header.checksum = crc32c(_block, _checksum);
+
+		this->index_.add(this->time_begin_, this->file_offset_, true);
+
+		this->file_.write(reinterpret_cast<const char*>(&_header), sizeof(_header));
+		this->file_.write(this->strings_.data(), static_cast<std::streamsize>(this->strings_.size()));
+		this->file_.write(reinterpret_cast<const char*>(_block.data()), static_cast<std::streamsize>(_block.size()));
+		this->file_.flush();
+		this->file_offset_ += sizeof(_header) + this->strings_.size() + _block.size();
+
+		this->records_.clear();
+		this->record_count_ = 0;
+		this->time_begin_ = 0;
+		this->time_end_ = 0;
+	};
+
+	writer::~writer()
+	{
+		this->close();
+	};
+};
+
+namespace asx::binlog
+{
+	template <typename T>
+	inline bool read_bytes(std::span<const std::byte> _bytes, size_t _offset, T& _out)
+	{
+		if (_offset > _bytes.size() || _bytes.size() - _offset < sizeof(T))
+		{
+			return false;
+		};
+		std::memcpy(&_out, _bytes.data() + _offset, sizeof(T));
+		return true;
+	};
+
+	inline std::string_view view_string(std::span<const std::byte> _bytes, size_t _offset, size_t _size)
+	{
+		return std::string_view(reinterpret_cast<const char*>(_bytes.data() + _offset), _size);
+	};
+
+	/**
+	 * @brief Gets the flags a segment of a format version may have.
+	*/
+	constexpr uint16_t segment_flags_for_version(uint16_t _version) noexcept
+	{
+		return (_version == 1) ? 0 : (SEGMENT_FLAG_LZ | SEGMENT_FLAG_CRC32C);
+	};
+
+	/**
+	 * @brief Checks the header of the segment at the start of some bytes and that the whole segment is present.
+	 * @return True if the header is valid, false otherwise.
+	*/
+	bool check_segment_header(std::span<const std::byte> _bytes, segment_header& _outHeader, size_t& _outSize)
+	{
+		if (!read_bytes(_bytes, 0, _outHeader))
+		{
+			return false;
+		};
+
+		if (_outHeader.magic != SEGMENT_MAGIC ||
+			_outHeader.byte_order != BYTE_ORDER_MARKER ||
+			_outHeader.version == 0 ||
+			_outHeader.version > FORMAT_VERSION ||
+			_outHeader.header_size < sizeof(segment_header) ||
+			(_outHeader.flags & ~segment_flags_for_version(_outHeader.version)) != 0)
+		{
+			return false;
+		};
+
+		// Check that the whole segment is present
+		const auto _size = static_cast<uint64_t>(_outHeader.header_size) + _outHeader.string_table_size + _outHeader.record_block_size;
+		if (_size > _bytes.size())
+		{
+			return false;
+		};
+		_outSize = static_cast<size_t>(_size);
+		return true;
+	};
+
+	bool check_segment(std::span<const std::byte> _bytes, size_t* _outSize)
+	{
+		auto _header = segment_header{};
+		size_t _size = 0;
+		if (!check_segment_header(_bytes, _header, _size))
+		{
+			return false;
+		};
+
+		if (_header.flags & SEGMENT_FLAG_CRC32C)
+		{
+			const auto _expected = _header.checksum;
+			_header.checksum = 0;
+			auto _checksum = crc32c(std::as_bytes(std::span<const segment_header>(&_header, 1)));
+			_checksum = crc32c(_bytes.subspan(sizeof(segment_header), _size - sizeof(segment_header)), _checksum);
+			if (_checksum != _expected)
+			{
+				return false;
+			};
+		};
+
+		if (_outSize)
+		{
+			*_outSize = _size;
+		};
+		return true;
+	};
+
+	size_t find_segment_magic(std::span<const std::byte> _bytes, size_t _offset)
+	{
+		const auto _text = std::string_view(reinterpret_cast<const char*>(_bytes.data()), _bytes.size());
+		const auto _magic = std::string_view(SEGMENT_MAGIC.data(), SEGMENT_MAGIC.size());
+		const auto _found = _text.find(_magic, std::min(_offset, _text.size()));
+		return (_found != std::string_view::npos) ? _found : _bytes.size();
+	};
+
+	bool segment_view::parse(std::span<const std::byte> _bytes, segment_view& _outSegment, std::vector<std::byte>* _buffer)
+	{
+		return check_segment(_bytes) && parse_checked(_bytes, _outSegment, _buffer);
+	};
+
+	bool segment_view::parse_checked(std::span<const std::byte> _bytes, segment_view& _outSegment, std::vector<std::byte>* _buffer)
+	{
+		// The checksum was verified by check_segment, the header is cheap enough to check again
+		auto _header = segment_header{};
+		size_t _size = 0;
+		if (!check_segment_header(_bytes, _header, _size))
+		{
+			return false;
+		};
+
+		const auto _strings = _bytes.subspan(_header.header_size, _header.string_table_size);
+
+		auto _entries = std::vector<string_entry>();
+		auto _formatIds = std::vector<uint32_t>();
+		_entries.reserve(_header.string_count);
+		_formatIds.reserve(_header.string_count);
+
+		size_t _offset = 0;
+		for (uint32_t n = 0; n != _header.string_count; ++n)
+		{
+			auto _entryHeader = string_entry_header{};
+			if (!read_bytes(_strings, _offset, _entryHeader) || _entryHeader.id != n + 1)
+			{
+				return false;
+			};
+			_offset += sizeof(string_entry_header);
+
+			const auto _stringsSize = static_cast<size_t>(_entryHeader.size0) + _entryHeader.size1;
+			if (_strings.size() - _offset < _stringsSize)
+			{
+				return false;
+			};
+
+			auto& _entry = _entries.emplace_back();
+			_entry.kind = _entryHeader.kind;
+			_entry.level = _entryHeader.level;
+			_entry.line = _entryHeader.line;
+			if (_entryHeader.kind == entry_kind::callsite)
+			{
+				_entry.file = view_string(_strings, _offset, _entryHeader.size0);
+				_entry.function = view_string(_strings, _offset + _entryHeader.size0, _entryHeader.size1);
+			}
+			else
+			{
+				_entry.format = view_string(_strings, _offset, _entryHeader.size0);
+			};
+			_formatIds.push_back(_entryHeader.format_id);
+			_offset += _stringsSize;
+		};
+
+		// Resolve call site format strings now that every entry is known
+		for (size_t n = 0; n != _entries.size(); ++n)
+		{
+			auto& _entry = _entries[n];
+			if (_entry.kind == entry_kind::callsite)
+			{
+				const auto _formatId = _formatIds[n];
+				if (_formatId == 0 || _formatId > _entries.size())
+				{
+					return false;
+				};
+				_entry.format = _entries[_formatId - 1].format;
+			};
+		};
+
+		auto _records = _bytes.subspan(_header.header_size + _header.string_table_size, _header.record_block_size);
+		if (_header.flags & SEGMENT_FLAG_LZ)
+		{
+			size_t _rawSize = 0;
+			// A block can't expand by more than 255 times, which also bounds the allocation for bad sizes
+			if (!_buffer || _header.record_block_raw_size > _header.record_block_size * 255 + 16)
+			{
+				return false;
+			};
+			_buffer->resize(static_cast<size_t>(_header.record_block_raw_size));
+			if (!lz::decompress_block(_records, *_buffer, _rawSize) || _rawSize != _buffer->size())
+			{
+				return false;
+			};
+			_records = *_buffer;
+		};
+
+		_outSegment.header_ = _header;
+		_outSegment.entries_ = std::move(_entries);
+		_outSegment.records_ = _records;
+		_outSegment.size_ = _size;
+		return true;
+	};
+
+	bool segment_view::next_record(size_t& _offset, record_view& _outRecord) const
+	{
+		auto _header = record_header{};
+		if (!read_bytes(this->records_, _offset, _header))
+		{
+			return false;
+		};
+		if (_header.size < sizeof(record_header) || this->records_.size() - _offset < _header.size)
+		{
+			return false;
+		};
+
+		_outRecord.timestamp = _header.timestamp;
+		_outRecord.site_id = _header.site_id;
+		_outRecord.level = _header.level;
+		_outRecord.arg_count = _header.arg_count;
+		_outRecord.args = this->records_.subspan(_offset + sizeof(record_header), _header.size - sizeof(record_header));
+		_offset += _header.size;
+		return true;
+	};
+
+	bool decode_args(const record_view& _record, std::vector<arg_value>& _outArgs)
+	{
+		const auto _bytes = _record.args;
+
+		size_t _offset = 0;
+		for (uint8_t n = 0; n != _record.arg_count; ++n)
+		{
+			auto _type = arg_type{};
+			if (!read_bytes(_bytes, _offset, _type))
+			{
+				return false;
+			};
+			++_offset;
+
+			bool _good = true;
+			switch (_type)
+			{
+			case arg_type::boolean:
+			{
+				uint8_t v{};
+				_good = read_bytes(_bytes, _offset, v);
+				_outArgs.push_back(v != 0);
+				_offset += sizeof(v);
+				break;
+			}
+			case arg_type::character:
+			{
+				char v{};
+				_good = read_bytes(_bytes, _offset, v);
+				_outArgs.push_back(v);
+				_offset += sizeof(v);
+				break;
+			}
+			case arg_type::int64:
+			{
+				int64_t v{};
+				_good = read_bytes(_bytes, _offset, v);
+				_outArgs.push_back(v);
+				_offset += sizeof(v);
+				break;
+			}
+			case arg_type::uint64:
+			{
+				uint64_t v{};
+				_good = read_bytes(_bytes, _offset, v);
+				_outArgs.push_back(v);
+				_offset += sizeof(v);
+				break;
+			}
+			case arg_type::float64:
+			{
+				double v{};
+				_good = read_bytes(_bytes, _offset, v);
+				_outArgs.push_back(v);
+				_offset += sizeof(v);
+				break;
+			}
+			case arg_type::string:
+			{
+				uint32_t _size{};
+				_good = read_bytes(_bytes, _offset, _size);
+				_offset += sizeof(_size);
+				_good = _good && (_bytes.size() - _offset >= _size);
+				if (_good)
+				{
+					_outArgs.push_back(view_string(_bytes, _offset, _size));
+					_offset += _size;
+				};
+				break;
+			}
+			default:
+				_good = false;
+				break;
+			};
+
+			if (!_good)
+			{
+				return false;
+			};
+		};
+		return true;
+	};
+
+	/**
+	 * @brief Formats a single argument using the spec text from a replacement field.
+	 * @param _spec The replacement field's format spec, without the leading ':'.
+	*/
+	inline void format_arg(std::string& _out, const arg_value& _arg, std::string_view _spec)
+	{
+		auto _fmt = std::string("{:");
+		_fmt.append(_spec);
+		_fmt.push_back('}');
+
+		std::visit([&](const auto& v)
+		{
+			try
+			{
+				_out.append(std::vformat(_fmt, std::make_format_args(v)));
+			}
+			catch (const std::format_error&)
+			{
+				// Spec doesn't apply to the stored type, fall back to the default formatting
+				_out.append(asx::format("{}", v));
+			};
+		}, _arg);
+	};
+
+	bool format_record(const segment_view& _segment, const record_view& _record, std::string& _out)
+	{
+		const auto _entry = _segment.find_entry(_record.site_id);
+		if (!_entry)
+		{
+			return false;
+		};
+
+		thread_local std::vector<arg_value> _args{};
+		_args.clear();
+		if (!decode_args(_record, _args))
+		{
+			return false;
+		};
+
+		const auto _fmt = _entry->format;
+		size_t _nextArg = 0;
+		for (size_t n = 0; n < _fmt.size(); ++n)
+		{
+			const auto c = _fmt[n];
+			if (c == '}')
+			{
+				// Collapse "}}"
+				if (n + 1 < _fmt.size() && _fmt[n + 1] == '}') { ++n; };
+				_out.push_back('}');
+				continue;
+			}
+			else if (c != '{')
+			{
+				_out.push_back(c);
+				continue;
+			};
+
+			// Collapse "{{"
+			if (n + 1 < _fmt.size() && _fmt[n + 1] == '{')
+			{
+				_out.push_back('{');
+				++n;
+				continue;
+			};
+
+			const auto _fieldEnd = _fmt.find('}', n);
+			const auto _nestedField = _fmt.find('{', n + 1);
+			if (_fieldEnd == _fmt.npos || _nestedField < _fieldEnd)
+			{
+				// Unterminated or dynamic field, write out the rest verbatim
+				_out.append(_fmt.substr(n));
+				break;
+			};
+
+			// Field text between the braces
+			const auto _field = _fmt.substr(n + 1, _fieldEnd - n - 1);
+			const auto _colon = _field.find(':');
+			const auto _indexText = _field.substr(0, _colon);
+			const auto _spec = (_colon == _field.npos) ? std::string_view() : _field.substr(_colon + 1);
+
+			size_t _argIndex = _nextArg++;
+			if (!_indexText.empty())
+			{
+				std::from_chars(_indexText.data(), _indexText.data() + _indexText.size(), _argIndex);
+			};
+
+			if (_argIndex < _args.size())
+			{
+				format_arg(_out, _args[_argIndex], _spec);
+			}
+			else
+			{
+				_out.append(_fmt.substr(n, _fieldEnd - n + 1));
+			};
+			n = _fieldEnd;
+		};
+
+		return true;
+	};
+};
@@ -0,0 +1,218 @@
+#include <asx/callsite.hpp>
+
+#include <asx/logging.hpp>
+
+#include <mutex>
+#include <deque>
+
+namespace asx
+{
+	namespace
+	{
+		/**
+		 * @brief Matches a glob pattern against a whole string.
+		*/
+		bool glob_match(std::string_view _pattern, std::string_view _text)
+		{
+			// Iterative matching, backtracking only to the last star seen
+			size_t p = 0;
+			size_t t = 0;
+			size_t _starP = std::string_view::npos;
+			size_t _starT = 0;
+			while (t < _text.size())
+			{
+				if (p < _pattern.size() && (_pattern[p] == '?' || _pattern[p] == _text[t]))
+				{
+					++p;
+					++t;
+				}
+				else if (p < _pattern.size() && _pattern[p] == '*')
+				{
+					_starP = p++;
+					_starT = t;
+				}
+				else if (_starP != std::string_view::npos)
+				{
+					p = _starP + 1;
+					t = ++_starT;
+				}
+				else
+				{
+					return false;
+				};
+			};
+			while (p < _pattern.size() && _pattern[p] == '*')
+			{
+				++p;
+			};
+			return p == _pattern.size();
+		};
+	};
+
+	namespace impl
+	{
+		/**
+		 * @brief Owns the list of registered sites and the rules that set their modes.
+		*/
+		class callsite_registry
+		{
+		public:
+
+			bool register_site(callsite& _site, std::string_view _format)
+			{
+				{
+					const auto lck = std::unique_lock(this->mtx_);
+
+					// Another thread may have registered it first
+					if (_site.state_.load(std::memory_order_relaxed) == 0)
+					{
+						_site.format_ = this->formats_.emplace_back(_format);
+						_site.next_ = this->head_;
+						this->head_ = &_site;
+						_site.state_.store(static_cast<uint8_t>(this->rule_mode(_site)), std::memory_order_relaxed);
+					};
+				};
+				return _site.enabled(_format);
+			};
+
+			std::vector<const callsite*> sites()
+			{
+				auto _sites = std::vector<const callsite*>();
+
+				const auto lck = std::unique_lock(this->mtx_);
+				for (auto _site = this->head_; _site; _site = _site->next_)
+				{
+					_sites.push_back(_site);
+				};
+				return _sites;
+			};
+
+			size_t set_mode(const callsite_query& _query, callsite_mode _mode)
+			{
+				size_t _count = 0;
+
+				const auto lck = std::unique_lock(this->mtx_);
+				this->rules_.push_back({ _query, _mode });
+				for (auto _site = this->head_; _site; _site = _site->next_)
+				{
+					if (asx::matches(_query, *_site))
+					{
+						_site->state_.store(static_cast<uint8_t>(_mode), std::memory_order_relaxed);
+						++_count;
+					};
+				};
+				return _count;
+			};
+
+			void reset()
+			{
+				const auto lck = std::unique_lock(this->mtx_);
+				this->rules_.clear();
+				for (auto _site = this->head_; _site; _site = _site->next_)
+				{
+					_site->state_.store(static_cast<uint8_t>(callsite_mode::level), std::memory_order_relaxed);
+				};
+			};
+
+		private:
+			struct rule
+			{
+				callsite_query query;
+				callsite_mode mode;
+			};
+
+			/**
+			 * @brief Gets the mode the rules give a site, the last matching rule wins.
+			*/
+			callsite_mode rule_mode(const callsite& _site) const
+			{
+				for (auto it = this->rules_.rbegin(); it != this->rules_.rend(); ++it)
+				{
+					if (asx::matches(it->query, _site))
+					{
+						return it->mode;
+					};
+				};
+				return callsite_mode::level;
+			};
+
+			std::mutex mtx_;
+
+			/**
+			 * @brief Intrusive list of registered sites, newest first.
+			*/
+			callsite* head_ = nullptr;
+
+			/**
+			 * @brief Copies of site format strings, a deque so the copies never move.
+			*/
+			std::deque<std::string> formats_;
+
+			std::vector<rule> rules_;
+		};
+
+		/**
+		 * @brief Gets the registry, it is never destroyed so sites can still be reached during exit.
+		*/
+		callsite_registry& get_callsite_registry()
+		{
+			static auto* _registry = new callsite_registry();
+			return *_registry;
+		};
+
+		bool register_callsite(callsite& _site, std::string_view _format)
+		{
+			return impl::get_callsite_registry().register_site(_site, _format);
+		};
+	};
+
+	bool matches(const callsite_query& _query, const callsite& _site)
+	{
+		if (_query.kind && *_query.kind != _site.kind())
+		{
+			return false;
+		};
+		if (_query.level && *_query.level != _site.level())
+		{
+			return false;
+		};
+		if (_query.line != 0 && _query.line != _site.line())
+		{
+			return false;
+		};
+		if (!_query.file.empty())
+		{
+			const auto _path = _site.file();
+			const auto _nameStart = _path.find_last_of("/\\");
+			const auto _name = (_nameStart == std::string_view::npos) ? _path : _path.substr(_nameStart + 1);
+			if (!glob_match(_query.file, _path) && !glob_match(_query.file, _name))
+			{
+				return false;
+			};
+		};
+		if (!_query.function.empty() && !glob_match(_query.function, _site.function()))
+		{
+			return false;
+		};
+		if (!_query.format.empty() && !glob_match(_query.format, _site.format()))
+		{
+			return false;
+		};
+		return true;
+	};
+
+	std::vector<const callsite*> get_callsites()
+	{
+		return impl::get_callsite_registry().sites();
+	};
+
+	size_t set_callsite_mode(const callsite_query& _query, callsite_mode _mode)
+	{
+		return impl::get_callsite_registry().set_mode(_query, _mode);
+	};
+
+	void reset_callsite_modes()
+	{
+		impl::get_callsite_registry().reset();
+	};
+};
@@ -0,0 +1,313 @@
+#include <asx/config_watch.hpp>
+
+#include "os.hpp"
+#include <asx/argparse.hpp>
+#include <asx/format.hpp>
+#include <asx/logging.hpp>
+
+#include <memory>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <filesystem>
+
+#ifdef ASX_OS_LINUX
+	#include <poll.h>
+	#include <fcntl.h>
+	#include <unistd.h>
+	#include <sys/inotify.h>
+#endif
+
+namespace asx
+{
+	namespace
+	{
+		std::string_view trim(std::string_view _text)
+		{
+			const auto _begin = _text.find_first_not_of(" \t\r");
+			if (_begin == std::string_view::npos)
+			{
+				return std::string_view{};
+			};
+			const auto _end = _text.find_last_not_of(" \t\r");
+			return _text.substr(_begin, _end - _begin + 1);
+		};
+
+		/**
+		 * @brief Splits the values of an entry on whitespace, keeping double quoted text together.
+		 * @return False if a quote isn't closed.
+		*/
+		bool split_values(std::string_view _text, std::vector<std::string>& _values)
+		{
+			size_t n = 0;
+			while (true)
+			{
+				n = _text.find_first_not_of(" \t\r", n);
+				if (n == std::string_view::npos)
+				{
+					return true;
+				};
+
+				if (_text[n] == '"')
+				{
+					const auto _close = _text.find('"', n + 1);
+					if (_close == std::string_view::npos)
+					{
+						return false;
+					};
+					_values.push_back(std::string(_text.substr(n + 1, _close - n - 1)));
+					n = _close + 1;
+				}
+				else
+				{
+					const auto _end = std::min(_text.find_first_of(" \t\r", n), _text.size());
+					_values.push_back(std::string(_text.substr(n, _end - n)));
+					n = _end;
+				};
+			};
+		};
+	};
+
+	const std::vector<std::string>* config::find(std::string_view _key) const
+	{
+		const auto it = this->values_.find(_key);
+		return (it != this->values_.end()) ? &it->second : nullptr;
+	};
+
+	bool config::parse(std::string_view _text, const ArgumentParser* _schema, std::string* _outErrorMessage)
+	{
+		const auto _fail = [_outErrorMessage](size_t _lineNumber, std::string_view _reason)
+		{
+			if (_outErrorMessage)
+			{
+				*_outErrorMessage = asx::format("line {} : {}", _lineNumber, _reason);
+			};
+			return false;
+		};
+
+		size_t _lineNumber = 0;
+		while (!_text.empty())
+		{
+			++_lineNumber;
+			const auto _lineEnd = std::min(_text.find('\n'), _text.size());
+			const auto _line = trim(_text.substr(0, _lineEnd));
+			_text.remove_prefix(std::min(_lineEnd + 1, _text.size()));
+
+			if (_line.empty() || _line.front() == '#')
+			{
+				continue;
+			};
+
+			const auto _equals = _line.find('=');
+			if (_equals == std::string_view::npos)
+			{
+				return _fail(_lineNumber, "expected \"key = value\"");
+			};
+
+			const auto _key = trim(_line.substr(0, _equals));
+			if (_key.empty())
+			{
+				return _fail(_lineNumber, "missing key");
+			};
+
+			auto _values = std::vector<std::string>();
+			if (!split_values(_line.substr(_equals + 1), _values))
+			{
+				return _fail(_lineNumber, "unterminated quote");
+			};
+
+			auto _label = std::string(_key);
+			if (_schema)
+			{
+				// Keys are option names without their dashes, single letters may be short options
+				std::string _errorText{};
+				auto _found = _schema->check_option("--" + _label, _values.size(), &_errorText);
+				if (!_found && _key.size() == 1)
+				{
+					_found = _schema->check_option("-" + _label, _values.size(), &_errorText);
+				};
+				if (!_found)
+				{
+					return _fail(_lineNumber, _errorText);
+				};
+				_label = *_found;
+			};
+
+			this->values_.insert_or_assign(std::move(_label), std::move(_values));
+		};
+		return true;
+	};
+
+	bool config_watch::reload()
+	{
+		const auto lck = std::unique_lock(this->reload_mtx_);
+
+		auto _file = std::ifstream(this->path_, std::ios::binary);
+		if (!_file)
+		{
+			ASX_LOG_WARN("Failed to open config file \"{}\"", this->path_);
+			return false;
+		};
+		auto _text = std::stringstream();
+		_text << _file.rdbuf();
+
+		auto _config = std::make_unique<config>();
+		std::string _errorText{};
+		if (!_config->parse(_text.view(), this->schema_, &_errorText))
+		{
+			ASX_LOG_ERROR("Config file \"{}\" is invalid and was not loaded, {}", this->path_, _errorText);
+			return false;
+		};
+		_config->version_ = ++this->next_version_;
+
+		// Readers still pinned on the old config keep it alive until they unpin
+		const auto _old = this->current_.exchange(_config.release(), std::memory_order_acq_rel);
+		default_epoch_domain().retire(const_cast<config*>(_old));
+
+		if (this->on_reload_)
+		{
+			// Only reloads retire the current config, so it can't go away while the lock is held
+			this->on_reload_(*this->current_.load(std::memory_order_relaxed));
+		};
+		return true;
+	};
+};
+
+#ifdef ASX_OS_LINUX
+
+namespace asx
+{
+	void config_watch::watch()
+	{
+		const auto _name = std::filesystem::path(this->path_).filename().string();
+
+		alignas(inotify_event) char _buffer[4096];
+		pollfd _fds[2]
+		{
+			{ this->wake_read_fd_, POLLIN, 0 },
+			{ this->inotify_fd_, POLLIN, 0 },
+		};
+		while (true)
+		{
+			const auto _ready = poll(_fds, 2, -1);
+			if (_ready < 0)
+			{
+				if (errno == EINTR)
+				{
+					continue;
+				};
+				ASX_LOG_ERROR("poll() failed while watching config file \"{}\", errno {}", this->path_, errno);
+				break;
+			};
+
+			// The wake pipe is only ever closed, to stop
+			if (_fds[0].revents != 0)
+			{
+				break;
+			};
+
+			const auto _size = read(this->inotify_fd_, _buffer, sizeof(_buffer));
+			if (_size <= 0)
+			{
+				continue;
+			};
+
+			// Reload once for every batch of events that touched the file
+			bool _changed = false;
+			for (ssize_t n = 0; n < _size;)
+			{
+				const auto _event = reinterpret_cast<const inotify_event*>(_buffer + n);
+				if (_event->len != 0 && _name == _event->name)
+				{
+					_changed = true;
+				};
+				n += static_cast<ssize_t>(sizeof(inotify_event) + _event->len);
+			};
+			if (_changed)
+			{
+				this->reload();
+			};
+		};
+	};
+};
+
+#endif
+
+namespace asx
+{
+	config_watch::config_watch(std::string _path, const ArgumentParser* _schema, reload_handler _onReload) :
+		path_(std::move(_path)),
+		schema_(_schema),
+		on_reload_(std::move(_onReload)),
+		current_(new config())
+	{
+#ifdef ASX_OS_LINUX
+		// Watch the directory rather than the file, a file replaced through a rename is a new inode
+		auto _directory = std::filesystem::path(this->path_).parent_path();
+		if (_directory.empty())
+		{
+			_directory = ".";
+		};
+
+		this->inotify_fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+		if (this->inotify_fd_ < 0)
+		{
+			ASX_LOG_ERROR("inotify_init1() failed for config file \"{}\", errno {}", this->path_, errno);
+		}
+		else if (inotify_add_watch(this->inotify_fd_, _directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0)
+		{
+			ASX_LOG_ERROR("Failed to watch directory \"{}\" of config file \"{}\", errno {}", _directory.string(), this->path_, errno);
+			close(this->inotify_fd_);
+			this->inotify_fd_ = -1;
+		}
+		else
+		{
+			int _pipe[2]{ -1, -1 };
+			if (pipe2(_pipe, O_CLOEXEC) != 0)
+			{
+				ASX_LOG_ERROR("pipe2() failed for config file \"{}\", errno {}", this->path_, errno);
+				close(this->inotify_fd_);
+				this->inotify_fd_ = -1;
+			}
+			else
+			{
+				this->wake_read_fd_ = _pipe[0];
+				this->wake_fd_ = _pipe[1];
+			};
+		};
+#else
+		ASX_LOG_WARN("config_watch was created but no implementation exists for the current platform");
+#endif
+
+		// The directory is already watched, so changes made while loading are not missed
+		this->reload();
+
+#ifdef ASX_OS_LINUX
+		if (this->wake_fd_ >= 0)
+		{
+			this->thread_ = std::thread([this]()
+			{
+				this->watch();
+			});
+		};
+#endif
+	};
+
+	config_watch::~config_watch()
+	{
+#ifdef ASX_OS_LINUX
+		if (this->thread_.joinable())
+		{
+			// Closing the write end wakes the watching thread with a hangup
+			close(this->wake_fd_);
+			this->thread_.join();
+			close(this->wake_read_fd_);
+		};
+		if (this->inotify_fd_ >= 0)
+		{
+			close(this->inotify_fd_);
+		};
+#endif
+		default_epoch_domain().retire(const_cast<config*>(this->current_.load(std::memory_order_relaxed)));
+	};
+};
@@ -0,0 +1,620 @@
+#include <asx/control_server.hpp>
+
+#include "os.hpp"
+#include <asx/format.hpp>
+#include <asx/logging.hpp>
+#include <asx/metrics.hpp>
+#include <asx/callsite.hpp>
+
+#include <map>
+#include <mutex>
+#include <chrono>
+#include <vector>
+#include <cerrno>
+#include <cstring>
+#include <charconv>
+#include <optional>
+
+#ifdef ASX_OS_LINUX
+	#include <poll.h>
+	#include <fcntl.h>
+	#include <dirent.h>
+	#include <unistd.h>
+	#include <sys/stat.h>
+	#include <sys/un.h>
+	#include <sys/socket.h>
+#endif
+
+namespace asx
+{
+	namespace
+	{
+		/**
+		 * @brief Splits the first word off a command line.
+		 * @return The word and the rest of the line with leading spaces removed.
+		*/
+		std::pair<std::string_view, std::string_view> split_word(std::string_view _line)
+		{
+			const auto _begin = _line.find_first_not_of(" \t\r");
+			if (_begin == std::string_view::npos)
+			{
+				return {};
+			};
+			_line.remove_prefix(_begin);
+
+			const auto _end = std::min(_line.find_first_of(" \t\r"), _line.size());
+			auto _rest = _line.substr(_end);
+			const auto _restBegin = _rest.find_first_not_of(" \t\r");
+			_rest = (_restBegin == std::string_view::npos) ? std::string_view() : _rest.substr(_restBegin);
+			while (!_rest.empty() && (_rest.back() == ' ' || _rest.back() == '\t' || _rest.back() == '\r'))
+			{
+				_rest.remove_suffix(1);
+			};
+			return { _line.substr(0, _end), _rest };
+		};
+
+		std::optional<LogLevel> parse_log_level(std::string_view _name)
+		{
+			if (_name == "none") { return LogLevel::none; };
+			if (_name == "fatal") { return LogLevel::fatal; };
+			if (_name == "error") { return LogLevel::error; };
+			if (_name == "warn") { return LogLevel::warn; };
+			if (_name == "info") { return LogLevel::info; };
+			if (_name == "all") { return LogLevel::all; };
+			return std::nullopt;
+		};
+
+		const char* log_level_name(LogLevel _level)
+		{
+			switch (_level)
+			{
+			case LogLevel::none:
+				return "none";
+			case LogLevel::fatal:
+				return "fatal";
+			case LogLevel::error:
+				return "error";
+			case LogLevel::warn:
+				return "warn";
+			case LogLevel::info:
+				return "info";
+			default:
+				return "all";
+			};
+		};
+
+		/**
+		 * @brief Parses a duration such as "10s", "500ms" or "2m", plain numbers are seconds.
+		*/
+		std::optional<std::chrono::milliseconds> parse_duration(std::string_view _text)
+		{
+			uint64_t _count = 0;
+			const auto [_end, _error] = std::from_chars(_text.data(), _text.data() + _text.size(), _count);
+			if (_error != std::errc() || _end == _text.data())
+			{
+				return std::nullopt;
+			};
+
+			const auto _unit = std::string_view(_end, _text.data() + _text.size());
+			if (_unit.empty() || _unit == "s")
+			{
+				return std::chrono::seconds(_count);
+			}
+			else if (_unit == "ms")
+			{
+				return std::chrono::milliseconds(_count);
+			}
+			else if (_unit == "m")
+			{
+				return std::chrono::minutes(_count);
+			};
+			return std::nullopt;
+		};
+
+		/**
+		 * @brief Enables or disables the profiling call sites.
+		 * @return Number of registered profiling sites.
+		*/
+		size_t set_profiling(bool _enabled)
+		{
+			auto _query = callsite_query{};
+			_query.kind = callsite_kind::profile;
+			return asx::set_callsite_mode(_query, (_enabled) ? callsite_mode::enabled : callsite_mode::level);
+		};
+
+		std::string dump_metrics()
+		{
+			auto _out = std::string();
+			for (auto& v : asx::snapshot_metrics())
+			{
+				_out.append(asx::format("{} {}\n", v.name, v.value));
+			};
+			return _out;
+		};
+
+		std::string dump_locks()
+		{
+			namespace ch = std::chrono;
+
+			auto _out = std::string("name acquisitions contended total_wait_us max_wait_us\n");
+			for (auto& v : asx::snapshot_lock_stats())
+			{
+				_out.append(asx::format("{} {} {} {} {}\n",
+					v.name, v.acquisitions, v.contended,
+					ch::duration_cast<ch::microseconds>(v.total_wait).count(),
+					ch::duration_cast<ch::microseconds>(v.max_wait).count()
+				));
+			};
+			return _out;
+		};
+	};
+};
+
+#ifdef ASX_OS_LINUX
+
+namespace asx
+{
+	namespace
+	{
+		std::string thread_name(pid_t _tid)
+		{
+			auto _name = std::string();
+			const auto _path = asx::format("/proc/self/task/{}/comm", _tid);
+			const auto _fd = open(_path.c_str(), O_RDONLY | O_CLOEXEC);
+			if (_fd >= 0)
+			{
+				char _buffer[64]{};
+				const auto _read = read(_fd, _buffer, sizeof(_buffer));
+				if (_read > 0)
+				{
+					_name.assign(_buffer, static_cast<size_t>(_read));
+					while (!_name.empty() && _name.back() == '\n')
+					{
+						_name.pop_back();
+					};
+				};
+				close(_fd);
+			};
+			return _name;
+		};
+
+		/**
+		 * @brief Gets the stack of every thread in the process, see `get_thread_stack_trace()`.
+		*/
+		std::string dump_stacks()
+		{
+			auto _out = std::string();
+			auto _trace = StackTrace(STACK_TRACE_MAX_FRAMES_DEFAULT);
+
+			const auto _dir = opendir("/proc/self/task");
+			for (auto _entry = (_dir) ? readdir(_dir) : nullptr; _entry; _entry = readdir(_dir))
+			{
+				if (_entry->d_name[0] == '.')
+				{
+					continue;
+				};
+				const auto _tid = static_cast<pid_t>(std::atoi(_entry->d_name));
+				_out.append(asx::format("thread {} \"{}\"\n", _tid, thread_name(_tid)));
+
+				_trace.resize(asx::get_thread_stack_trace(static_cast<os_thread_id>(_tid), std::span<SourceLocation>(_trace.begin(), _trace.max_size())));
+				if (_trace.size() == 0)
+				{
+					_out.append("\t(no stack)\n");
+				};
+				for (auto& v : _trace)
+				{
+					_out.append(asx::format("\t{}() in {}\n", v.function(), v.file()));
+				};
+			};
+			if (_dir)
+			{
+				closedir(_dir);
+			};
+			return _out;
+		};
+	};
+};
+
+#else
+
+namespace asx
+{
+	namespace
+	{
+		std::string dump_stacks()
+		{
+			return "stack dumps are not supported on this platform\n";
+		};
+	};
+};
+
+#endif
+
+namespace asx
+{
+	struct control_server::state
+	{
+		struct command
+		{
+			std::string description;
+			handler_type handler;
+		};
+
+		std::mutex mtx;
+		std::map<std::string, command, std::less<>> commands;
+
+		/**
+		 * @brief When a timed `profile start` ends, if one is running.
+		*/
+		std::optional<std::chrono::steady_clock::time_point> profile_deadline;
+
+		int listen_fd = -1;
+		int wake_read_fd = -1;
+	};
+
+	void control_server::add_command(std::string _name, std::string _description, handler_type _handler)
+	{
+		const auto lck = std::unique_lock(this->state_->mtx);
+		this->state_->commands[std::move(_name)] = state::command{ std::move(_description), std::move(_handler) };
+	};
+
+	std::string control_server::execute(std::string_view _line)
+	{
+		const auto [_name, _args] = split_word(_line);
+		if (_name.empty())
+		{
+			return std::string();
+		};
+
+		auto _handler = handler_type();
+		{
+			const auto lck = std::unique_lock(this->state_->mtx);
+			const auto it = this->state_->commands.find(_name);
+			if (it == this->state_->commands.end())
+			{
+				return asx::format("unknown command \"{}\", try \"help\"\n", _name);
+			};
+			_handler = it->second.handler;
+		};
+
+		try
+		{
+			return _handler(_args);
+		}
+		catch (const std::exception& _exception)
+		{
+			return asx::format("command \"{}\" failed : {}\n", _name, _exception.what());
+		};
+	};
+};
+
+#ifdef ASX_OS_LINUX
+
+namespace asx
+{
+	void control_server::serve()
+	{
+		struct client
+		{
+			int fd;
+			std::string input;
+		};
+
+		// Longest command line accepted before a client is dropped
+		constexpr size_t MAX_LINE_SIZE = 64 * 1024;
+
+		auto& _state = *this->state_;
+		auto _clients = std::vector<client>();
+		auto _fds = std::vector<pollfd>();
+		while (true)
+		{
+			_fds.clear();
+			_fds.push_back({ _state.wake_read_fd, POLLIN, 0 });
+			_fds.push_back({ _state.listen_fd, POLLIN, 0 });
+			for (auto& v : _clients)
+			{
+				_fds.push_back({ v.fd, POLLIN, 0 });
+			};
+
+			int _timeout = -1;
+			{
+				const auto lck = std::unique_lock(_state.mtx);
+				if (_state.profile_deadline)
+				{
+					const auto _left = std::chrono::ceil<std::chrono::milliseconds>(*_state.profile_deadline - std::chrono::steady_clock::now());
+					_timeout = static_cast<int>(std::max<int64_t>(_left.count(), 0));
+				};
+			};
+
+			const auto _ready = poll(_fds.data(), static_cast<nfds_t>(_fds.size()), _timeout);
+			if (_ready < 0 && errno != EINTR)
+			{
+				ASX_LOG_ERROR("poll() failed on the control socket, errno {}", errno);
+				break;
+			};
+
+			// End a timed profile capture
+			{
+				const auto lck = std::unique_lock(_state.mtx);
+				if (_state.profile_deadline && std::chrono::steady_clock::now() >= *_state.profile_deadline)
+				{
+					_state.profile_deadline.reset();
+					set_profiling(false);
+				};
+			};
+			if (_ready <= 0)
+			{
+				continue;
+			};
+
+			// Bytes on the wake pipe ask for the deadline to be rechecked, a hangup asks to stop
+			if (_fds[0].revents != 0)
+			{
+				char _drain[64];
+				if (read(_state.wake_read_fd, _drain, sizeof(_drain)) <= 0)
+				{
+					break;
+				};
+			};
+
+			// Clients are handled before accepting so the indices still line up with _fds
+			for (size_t n = _clients.size(); n != 0; --n)
+			{
+				auto& _client = _clients[n - 1];
+				if (_fds[n + 1].revents == 0)
+				{
+					continue;
+				};
+
+				char _buffer[4096];
+				const auto _read = recv(_client.fd, _buffer, sizeof(_buffer), 0);
+				bool _keep = (_read > 0);
+				if (_keep)
+				{
+					_client.input.append(_buffer, static_cast<size_t>(_read));
+					size_t _lineEnd = 0;
+					while ((_lineEnd = _client.input.find('\n')) != std::string::npos)
+					{
+						auto _output = this->execute(std::string_view(_client.input).substr(0, _lineEnd));
+						_client.input.erase(0, _lineEnd + 1);
+						if (!_output.empty() && _output.back() != '\n')
+						{
+							_output.push_back('\n');
+						};
+						_output.push_back('\n');
+						if (send(_client.fd, _output.data(), _output.size(), MSG_NOSIGNAL) != static_cast<ssize_t>(_output.size()))
+						{
+							_keep = false;
+							break;
+						};
+					};
+					_keep = _keep && _client.input.size() <= MAX_LINE_SIZE;
+				};
+
+				if (!_keep)
+				{
+					close(_client.fd);
+					_client = std::move(_clients.back());
+					_clients.pop_back();
+				};
+			};
+
+			if (_fds[1].revents & POLLIN)
+			{
+				const auto _fd = accept4(_state.listen_fd, nullptr, nullptr, SOCK_CLOEXEC);
+				if (_fd >= 0)
+				{
+					// Don't let a client that stops reading stall the server forever
+					const auto _timeout = timeval{ 1, 0 };
+					setsockopt(_fd, SOL_SOCKET, SO_SNDTIMEO, &_timeout, sizeof(_timeout));
+					_clients.push_back({ _fd, std::string() });
+				};
+			};
+		};
+
+		for (auto& v : _clients)
+		{
+			close(v.fd);
+		};
+	};
+};
+
+#endif
+
+namespace asx
+{
+	control_server::control_server(std::string _path) :
+		path_(std::move(_path)),
+		state_(std::make_unique<state>())
+	{
+		this->add_command("help", "lists the commands", [this](std::string_view)
+		{
+			auto _out = std::string();
+			const auto lck = std::unique_lock(this->state_->mtx);
+			for (auto& [_name, _command] : this->state_->commands)
+			{
+				_out.append(asx::format("{} - {}\n", _name, _command.description));
+			};
+			return _out;
+		});
+
+		this->add_command("loglevel", "[<level> | <file pattern>=<level>] shows or sets the log level, levels are none, fatal, error, warn, info and all", [](std::string_view _args)
+		{
+			if (_args.empty())
+			{
+				return asx::format("{}\n", log_level_name(asx::get_logging_level()));
+			};
+
+			const auto _equals = _args.find('=');
+			const auto _level = parse_log_level((_equals == std::string_view::npos) ? _args : _args.substr(_equals + 1));
+			if (!_level)
+			{
+				return std::string("unknown log level\n");
+			};
+			if (_equals == std::string_view::npos)
+			{
+				asx::set_logging_level(*_level);
+				return std::string("ok\n");
+			};
+
+			// Plain names match any file containing them
+			auto _pattern = std::string(_args.substr(0, _equals));
+			if (_pattern.find_first_of("*?") == std::string::npos)
+			{
+				_pattern = "*" + _pattern + "*";
+			};
+
+			size_t _count = 0;
+			for (auto _siteLevel : { LogLevel::fatal, LogLevel::error, LogLevel::warn, LogLevel::info })
+			{
+				auto _query = callsite_query{};
+				_query.file = _pattern;
+				_query.kind = callsite_kind::log;
+				_query.level = _siteLevel;
+				_count += asx::set_callsite_mode(_query, (_siteLevel <= *_level) ? callsite_mode::enabled : callsite_mode::disabled);
+			};
+			return asx::format("ok, {} call sites matched so far\n", _count);
+		});
+
+		this->add_command("profile", "start [<duration>] | stop, enables the profiling call sites", [this](std::string_view _args)
+		{
+			const auto [_action, _rest] = split_word(_args);
+			if (_action == "start")
+			{
+				auto _duration = std::optional<std::chrono::milliseconds>();
+				if (!_rest.empty())
+				{
+					_duration = parse_duration(_rest);
+					if (!_duration)
+					{
+						return std::string("invalid duration, expected a number followed by ms, s or m\n");
+					};
+				};
+
+				{
+					const auto lck = std::unique_lock(this->state_->mtx);
+					if (_duration)
+					{
+						this->state_->profile_deadline = std::chrono::steady_clock::now() + *_duration;
+					}
+					else
+					{
+						this->state_->profile_deadline.reset();
+					};
+				};
+
+				// Wake the server so it picks up the new deadline
+				if (this->wake_fd_ >= 0)
+				{
+					const char _byte = 0;
+					[[maybe_unused]] const auto _written = write(this->wake_fd_, &_byte, 1);
+				};
+				return asx::format("profiling enabled, {} call sites so far\n", set_profiling(true));
+			}
+			else if (_action == "stop")
+			{
+				{
+					const auto lck = std::unique_lock(this->state_->mtx);
+					this->state_->profile_deadline.reset();
+				};
+				set_profiling(false);
+				return std::string("profiling stopped\n");
+			};
+			return std::string("expected \"profile start [<duration>]\" or \"profile stop\"\n");
+		});
+
+		this->add_command("metrics", "dump, lists every registered metric", [](std::string_view _args)
+		{
+			if (_args != "dump")
+			{
+				return std::string("expected \"metrics dump\"\n");
+			};
+			return dump_metrics();
+		});
+
+		this->add_command("stacks", "dumps the stack of every thread", [](std::string_view)
+		{
+			return dump_stacks();
+		});
+
+		this->add_command("locks", "lists profiled mutexes by time spent waiting", [](std::string_view)
+		{
+			return dump_locks();
+		});
+
+#ifdef ASX_OS_LINUX
+		auto _address = sockaddr_un{};
+		_address.sun_family = AF_UNIX;
+		if (this->path_.empty() || this->path_.size() >= sizeof(_address.sun_path))
+		{
+			ASX_LOG_ERROR("Control socket path \"{}\" is empty or too long", this->path_);
+			return;
+		};
+		std::memcpy(_address.sun_path, this->path_.data(), this->path_.size());
+
+		// Only replace a stale socket, never some other file
+		struct stat _stat {};
+		if (lstat(this->path_.c_str(), &_stat) == 0 && S_ISSOCK(_stat.st_mode))
+		{
+			unlink(this->path_.c_str());
+		};
+
+		const auto _fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+		if (_fd < 0)
+		{
+			ASX_LOG_ERROR("socket() failed for the control socket, errno {}", errno);
+			return;
+		};
+		if (bind(_fd, reinterpret_cast<const sockaddr*>(&_address), sizeof(_address)) != 0)
+		{
+			ASX_LOG_ERROR("Failed to bind the control socket at path \"{}\", errno {}", this->path_, errno);
+			close(_fd);
+			return;
+		};
+
+		// Nobody can connect before listen(), so restricting access here leaves no window
+		if (chmod(this->path_.c_str(), S_IRUSR | S_IWUSR) != 0 || listen(_fd, 8) != 0)
+		{
+			ASX_LOG_ERROR("Failed to set up the control socket at path \"{}\", errno {}", this->path_, errno);
+			close(_fd);
+			unlink(this->path_.c_str());
+			return;
+		};
+
+		int _pipe[2]{ -1, -1 };
+		if (pipe2(_pipe, O_CLOEXEC) != 0)
+		{
+			ASX_LOG_ERROR("pipe2() failed for the control socket, errno {}", errno);
+			close(_fd);
+			unlink(this->path_.c_str());
+			return;
+		};
+
+		this->state_->listen_fd = _fd;
+		this->state_->wake_read_fd = _pipe[0];
+		this->wake_fd_ = _pipe[1];
+		this->thread_ = std::thread([this]()
+		{
+			this->serve();
+		});
+#else
+		ASX_LOG_WARN("control_server was created but no implementation exists for the current platform");
+#endif
+	};
+
+	control_server::~control_server()
+	{
+#ifdef ASX_OS_LINUX
+		if (this->thread_.joinable())
+		{
+			// Closing the write end wakes the server with a hangup
+			close(this->wake_fd_);
+			this->thread_.join();
+
+			close(this->state_->wake_read_fd);
+			close(this->state_->listen_fd);
+			unlink(this->path_.c_str());
+		};
+#endif
+	};
+};
@@ -0,0 +1,303 @@
+#include <asx/crc32c.hpp>
+
+#include "os.hpp"
+
+#include <bit>
+#include <array>
+#include <cstring>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+	#include <immintrin.h>
+	#define ASX_CRC32C_HARDWARE
+	#define ASX_CRC32C_TARGET __attribute__((target("sse4.2")))
+#elif defined(_M_X64)
+	#include <intrin.h>
+	#define ASX_CRC32C_HARDWARE
+	#define ASX_CRC32C_TARGET
+#elif defined(__aarch64__) && defined(ASX_OS_LINUX) && (defined(__GNUC__) || defined(__clang__))
+	#include <arm_acle.h>
+	#include <sys/auxv.h>
+	#include <asm/hwcap.h>
+	#define ASX_CRC32C_HARDWARE
+	#define ASX_CRC32C_TARGET __attribute__((target("+crc")))
+#endif
+
+namespace asx
+{
+	namespace
+	{
+		/**
+		 * @brief The Castagnoli polynomial, bit reversed.
+		*/
+		constexpr uint32_t CRC32C_POLY = 0x82F63B78;
+
+		/**
+		 * @brief Multiplies two polynomials modulo the CRC polynomial, bit 31 holds the x^0 term.
+		*/
+		constexpr uint32_t multiply_mod_poly(uint32_t _lhs, uint32_t _rhs) noexcept
+		{
+			uint32_t _product = 0;
+			for (uint32_t _bit = uint32_t(1) << 31; _bit != 0; _bit >>= 1)
+			{
+				if (_lhs & _bit)
+				{
+					_product ^= _rhs;
+				};
+				_rhs = (_rhs & 1) ? (_rhs >> 1) ^ CRC32C_POLY : _rhs >> 1;
+			};
+			return _product;
+		};
+
+		/**
+		 * @brief Holds x^(2^n) modulo the CRC polynomial at index n.
+		*/
+		constexpr auto X2N_TABLE = []()
+		{
+			auto _table = std::array<uint32_t, 32>{};
+			_table[0] = uint32_t(1) << 30;
+			for (size_t n = 1; n != _table.size(); ++n)
+			{
+				_table[n] = multiply_mod_poly(_table[n - 1], _table[n - 1]);
+			};
+			return _table;
+		}();
+
+		/**
+		 * @brief Gets x^(8 * _bytes) modulo the CRC polynomial, which shifts a checksum past that many zero bytes.
+		*/
+		constexpr uint32_t shift_operator(size_t _bytes) noexcept
+		{
+			uint32_t _result = uint32_t(1) << 31;
+			for (size_t k = 3; _bytes != 0; _bytes >>= 1, ++k)
+			{
+				if (_bytes & 1)
+				{
+					_result = multiply_mod_poly(X2N_TABLE[k & 31], _result);
+				};
+			};
+			return _result;
+		};
+
+		/**
+		 * @brief Tables for slicing-by-8, table n advances a byte through n further zero bytes.
+		*/
+		constexpr auto SLICING_TABLES = []()
+		{
+			auto _tables = std::array<std::array<uint32_t, 256>, 8>{};
+			for (uint32_t n = 0; n != 256; ++n)
+			{
+				auto _crc = n;
+				for (int k = 0; k != 8; ++k)
+				{
+					_crc = (_crc & 1) ? (_crc >> 1) ^ CRC32C_POLY : _crc >> 1;
+				};
+				_tables[0][n] = _crc;
+			};
+			for (size_t t = 1; t != _tables.size(); ++t)
+			{
+				for (size_t n = 0; n != 256; ++n)
+				{
+					const auto _prev = _tables[t - 1][n];
+					_tables[t][n] = (_prev >> 8) ^ _tables[0][_prev & 0xFF];
+				};
+			};
+			return _tables;
+		}();
+
+		inline uint64_t read64(const uint8_t* p) noexcept
+		{
+			uint64_t v;
+			std::memcpy(&v, p, sizeof(v));
+			return v;
+		};
+
+		uint32_t crc32c_software(uint32_t _crc, const uint8_t* p, size_t _size) noexcept
+		{
+			const auto& t = SLICING_TABLES;
+			if constexpr (std::endian::native == std::endian::little)
+			{
+				for (; _size >= 8; p += 8, _size -= 8)
+				{
+					const auto v = read64(p) ^ _crc;
+					_crc = t[7][v & 0xFF] ^ t[6][(v >> 8) & 0xFF] ^ t[5][(v >> 16) & 0xFF] ^ t[4][(v >> 24) & 0xFF] ^
+						t[3][(v >> 32) & 0xFF] ^ t[2][(v >> 40) & 0xFF] ^ t[1][(v >> 48) & 0xFF] ^ t[0][v >> 56];
+				};
+			};
+			for (; _size != 0; ++p, --_size)
+			{
+				_crc = (_crc >> 8) ^ t[0][(_crc ^ *p) & 0xFF];
+			};
+			return _crc;
+		};
+
+#ifdef ASX_CRC32C_HARDWARE
+
+	#if defined(__x86_64__)
+		ASX_CRC32C_TARGET inline uint32_t crc32c_u64(uint32_t _crc, uint64_t _value) noexcept
+		{
+			return static_cast<uint32_t>(_mm_crc32_u64(_crc, _value));
+		};
+		ASX_CRC32C_TARGET inline uint32_t crc32c_u8(uint32_t _crc, uint8_t _value) noexcept
+		{
+			return _mm_crc32_u8(_crc, _value);
+		};
+		bool has_crc32c_instructions() noexcept
+		{
+			return __builtin_cpu_supports("sse4.2");
+		};
+	#elif defined(_M_X64)
+		inline uint32_t crc32c_u64(uint32_t _crc, uint64_t _value) noexcept
+		{
+			return static_cast<uint32_t>(_mm_crc32_u64(_crc, _value));
+		};
+		inline uint32_t crc32c_u8(uint32_t _crc, uint8_t _value) noexcept
+		{
+			return _mm_crc32_u8(_crc, _value);
+		};
+		bool has_crc32c_instructions() noexcept
+		{
+			int _info[4]{};
+			__cpuid(_info, 1);
+			return (_info[2] & (1 << 20)) != 0;
+		};
+	#elif defined(__aarch64__)
+		ASX_CRC32C_TARGET inline uint32_t crc32c_u64(uint32_t _crc, uint64_t _value) noexcept
+		{
+			return __crc32cd(_crc, _value);
+		};
+		ASX_CRC32C_TARGET inline uint32_t crc32c_u8(uint32_t _crc, uint8_t _value) noexcept
+		{
+			return __crc32cb(_crc, _value);
+		};
+		bool has_crc32c_instructions() noexcept
+		{
+			return (getauxval(AT_HWCAP) & HWCAP_CRC32) != 0;
+		};
+	#endif
+
+		/**
+		 * @brief Size of each of the three streams in the interleaved loops.
+		*/
+		constexpr size_t LONG_STREAM = 8192;
+		constexpr size_t SHORT_STREAM = 256;
+
+		/**
+		 * @brief Shifts a checksum past a fixed number of zero bytes with one lookup per byte of the checksum.
+		*/
+		struct shift_table
+		{
+			std::array<std::array<uint32_t, 256>, 4> bytes;
+
+			constexpr explicit shift_table(size_t _size) :
+				bytes()
+			{
+				const auto _operator = shift_operator(_size);
+				for (uint32_t k = 0; k != 4; ++k)
+				{
+					for (uint32_t n = 0; n != 256; ++n)
+					{
+						this->bytes[k][n] = multiply_mod_poly(_operator, n << (8 * k));
+					};
+				};
+			};
+
+			uint32_t operator()(uint32_t _crc) const noexcept
+			{
+				return this->bytes[0][_crc & 0xFF] ^ this->bytes[1][(_crc >> 8) & 0xFF] ^
+					this->bytes[2][(_crc >> 16) & 0xFF] ^ this->bytes[3][_crc >> 24];
+			};
+		};
+
+		constexpr shift_table SHIFT_LONG{ LONG_STREAM };
+		constexpr shift_table SHIFT_LONG2{ 2 * LONG_STREAM };
+		constexpr shift_table SHIFT_SHORT{ SHORT_STREAM };
+		constexpr shift_table SHIFT_SHORT2{ 2 * SHORT_STREAM };
+
+		/**
+		 * @brief Checksums three adjacent streams at once to hide the latency of the crc instruction.
+		 *
+		 * The second and third streams start from 0, the first stream's checksum is then shifted past
+		 * the other two and the second's past the third, which gives the checksum of all of them in order.
+		*/
+		ASX_CRC32C_TARGET inline uint32_t crc32c_interleaved(uint32_t _crc, const uint8_t*& p, size_t& _size,
+			size_t _stream, const shift_table& _shift, const shift_table& _shift2) noexcept
+		{
+			while (_size >= 3 * _stream)
+			{
+				uint32_t _crc1 = 0;
+				uint32_t _crc2 = 0;
+				const auto _end = p + _stream;
+				do
+				{
+					_crc = crc32c_u64(_crc, read64(p));
+					_crc1 = crc32c_u64(_crc1, read64(p + _stream));
+					_crc2 = crc32c_u64(_crc2, read64(p + 2 * _stream));
+					p += 8;
+				} while (p != _end);
+
+				_crc = _shift2(_crc) ^ _shift(_crc1) ^ _crc2;
+				p += 2 * _stream;
+				_size -= 3 * _stream;
+			};
+			return _crc;
+		};
+
+		ASX_CRC32C_TARGET uint32_t crc32c_hardware(uint32_t _crc, const uint8_t* p, size_t _size) noexcept
+		{
+			for (; _size != 0 && (reinterpret_cast<uintptr_t>(p) & 7) != 0; ++p, --_size)
+			{
+				_crc = crc32c_u8(_crc, *p);
+			};
+
+			_crc = crc32c_interleaved(_crc, p, _size, LONG_STREAM, SHIFT_LONG, SHIFT_LONG2);
+			_crc = crc32c_interleaved(_crc, p, _size, SHORT_STREAM, SHIFT_SHORT, SHIFT_SHORT2);
+
+			for (; _size >= 8; p += 8, _size -= 8)
+			{
+				_crc = crc32c_u64(_crc, read64(p));
+			};
+			for (; _size != 0; ++p, --_size)
+			{
+				_crc = crc32c_u8(_crc, *p);
+			};
+			return _crc;
+		};
+
+#endif
+
+		using crc32c_function = uint32_t(*)(uint32_t, const uint8_t*, size_t) noexcept;
+
+		crc32c_function select_crc32c() noexcept
+		{
+#ifdef ASX_CRC32C_HARDWARE
+			if (has_crc32c_instructions())
+			{
+				return &crc32c_hardware;
+			};
+#endif
+			return &crc32c_software;
+		};
+
+		inline crc32c_function get_crc32c() noexcept
+		{
+			static const auto _function = select_crc32c();
+			return _function;
+		};
+	};
+
+	uint32_t crc32c(std::span<const std::byte> _data, uint32_t _crc) noexcept
+	{
+		const auto _function = get_crc32c();
+		return ~_function(~_crc, reinterpret_cast<const uint8_t*>(_data.data()), _data.size());
+	};
+
+	uint32_t crc32c_combine(uint32_t _crc1, uint32_t _crc2, size_t _size2) noexcept
+	{
+		return multiply_mod_poly(shift_operator(_size2), _crc1) ^ _crc2;
+	};
+
+	bool crc32c_is_hardware_accelerated() noexcept
+	{
+		return get_crc32c() != &crc32c_software;
+	};
+};
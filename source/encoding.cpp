@@ -0,0 +1,833 @@
+#include <asx/encoding.hpp>
+
+#include <bit>
+#include <array>
+#include <cstring>
+#include <string_view>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+	#include <immintrin.h>
+	#define ASX_ENCODING_SSSE3
+	#define ASX_ENCODING_TARGET __attribute__((target("ssse3")))
+#elif defined(_M_X64)
+	#include <intrin.h>
+	#define ASX_ENCODING_SSSE3
+	#define ASX_ENCODING_TARGET
+#endif
+
+namespace asx
+{
+	namespace
+	{
+		/**
+		 * @brief Marks a character that isn't a digit in the value tables.
+		*/
+		constexpr uint8_t INVALID_DIGIT = 0xFF;
+
+		constexpr std::string_view HEX_DIGITS = "0123456789abcdef";
+
+		constexpr auto HEX_VALUES = []()
+		{
+			auto _table = std::array<uint8_t, 256>{};
+			_table.fill(INVALID_DIGIT);
+			for (uint8_t n = 0; n != 10; ++n)
+			{
+				_table['0' + n] = n;
+			};
+			for (uint8_t n = 0; n != 6; ++n)
+			{
+				_table['a' + n] = 10 + n;
+				_table['A' + n] = 10 + n;
+			};
+			return _table;
+		}();
+
+		constexpr std::string_view BASE64_DIGITS = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+		constexpr std::string_view BASE64URL_DIGITS = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+
+		constexpr auto make_base64_values(std::string_view _digits)
+		{
+			auto _table = std::array<uint8_t, 256>{};
+			_table.fill(INVALID_DIGIT);
+			for (uint8_t n = 0; n != 64; ++n)
+			{
+				_table[static_cast<uint8_t>(_digits[n])] = n;
+			};
+			return _table;
+		};
+
+		constexpr auto BASE64_VALUES = make_base64_values(BASE64_DIGITS);
+		constexpr auto BASE64URL_VALUES = make_base64_values(BASE64URL_DIGITS);
+
+		constexpr std::string_view base64_digits(base64_alphabet _alphabet) noexcept
+		{
+			return (_alphabet == base64_alphabet::url) ? BASE64URL_DIGITS : BASE64_DIGITS;
+		};
+		constexpr const std::array<uint8_t, 256>& base64_values(base64_alphabet _alphabet) noexcept
+		{
+			return (_alphabet == base64_alphabet::url) ? BASE64URL_VALUES : BASE64_VALUES;
+		};
+
+
+
+		/*
+			Scalar versions, these handle whatever the vector versions leave over. Decoding stops at
+			the first invalid character and returns how far it got.
+		*/
+
+		void hex_encode_scalar(const uint8_t* _src, size_t _size, char* _dst) noexcept
+		{
+			for (size_t n = 0; n != _size; ++n)
+			{
+				*_dst++ = HEX_DIGITS[_src[n] >> 4];
+				*_dst++ = HEX_DIGITS[_src[n] & 0x0F];
+			};
+		};
+
+		size_t hex_decode_scalar(const char* _src, size_t _size, uint8_t* _dst) noexcept
+		{
+			for (size_t n = 0; n != _size; ++n)
+			{
+				const auto _hi = HEX_VALUES[static_cast<uint8_t>(_src[2 * n])];
+				const auto _lo = HEX_VALUES[static_cast<uint8_t>(_src[2 * n + 1])];
+				if ((_hi | _lo) == INVALID_DIGIT)
+				{
+					return n;
+				};
+				_dst[n] = static_cast<uint8_t>((_hi << 4) | _lo);
+			};
+			return _size;
+		};
+
+		/**
+		 * @brief Encodes whole groups of 3 bytes, returns the number of bytes encoded.
+		*/
+		size_t base64_encode_scalar(const uint8_t* _src, size_t _size, char* _dst, base64_alphabet _alphabet) noexcept
+		{
+			const auto _digits = base64_digits(_alphabet);
+			size_t n = 0;
+			for (; n + 3 <= _size; n += 3)
+			{
+				const auto _bits = (uint32_t(_src[n]) << 16) | (uint32_t(_src[n + 1]) << 8) | _src[n + 2];
+				*_dst++ = _digits[_bits >> 18];
+				*_dst++ = _digits[(_bits >> 12) & 0x3F];
+				*_dst++ = _digits[(_bits >> 6) & 0x3F];
+				*_dst++ = _digits[_bits & 0x3F];
+			};
+			return n;
+		};
+
+		/**
+		 * @brief Decodes whole groups of 4 characters, returns the number of characters decoded.
+		*/
+		size_t base64_decode_scalar(const char* _src, size_t _size, uint8_t* _dst, base64_alphabet _alphabet) noexcept
+		{
+			const auto& _values = base64_values(_alphabet);
+			size_t n = 0;
+			for (; n + 4 <= _size; n += 4)
+			{
+				const auto a = _values[static_cast<uint8_t>(_src[n])];
+				const auto b = _values[static_cast<uint8_t>(_src[n + 1])];
+				const auto c = _values[static_cast<uint8_t>(_src[n + 2])];
+				const auto d = _values[static_cast<uint8_t>(_src[n + 3])];
+				if ((a | b | c | d) == INVALID_DIGIT)
+				{
+					break;
+				};
+				const auto _bits = (uint32_t(a) << 18) | (uint32_t(b) << 12) | (uint32_t(c) << 6) | d;
+				*_dst++ = static_cast<uint8_t>(_bits >> 16);
+				*_dst++ = static_cast<uint8_t>(_bits >> 8);
+				*_dst++ = static_cast<uint8_t>(_bits);
+			};
+			return n;
+		};
+
+		/**
+		 * @brief Gets the size of the UTF-8 sequence starting at `p`, 0 if it isn't valid.
+		*/
+		inline size_t utf8_sequence_size(const uint8_t* p, size_t _size) noexcept
+		{
+			const auto _isContinuation = [](uint8_t c) { return (c & 0xC0) == 0x80; };
+
+			const auto c = p[0];
+			if (c < 0x80)
+			{
+				return 1;
+			}
+			else if (c < 0xC2)
+			{
+				// Stray continuation byte or overlong 2 byte form
+				return 0;
+			}
+			else if (c < 0xE0)
+			{
+				return (_size >= 2 && _isContinuation(p[1])) ? 2 : 0;
+			}
+			else if (c < 0xF0)
+			{
+				if (_size < 3 || !_isContinuation(p[1]) || !_isContinuation(p[2]) ||
+					(c == 0xE0 && p[1] < 0xA0) ||	// overlong
+					(c == 0xED && p[1] >= 0xA0))	// surrogate
+				{
+					return 0;
+				};
+				return 3;
+			}
+			else if (c < 0xF5)
+			{
+				if (_size < 4 || !_isContinuation(p[1]) || !_isContinuation(p[2]) || !_isContinuation(p[3]) ||
+					(c == 0xF0 && p[1] < 0x90) ||	// overlong
+					(c == 0xF4 && p[1] >= 0x90))	// past U+10FFFF
+				{
+					return 0;
+				};
+				return 4;
+			}
+			else
+			{
+				return 0;
+			};
+		};
+
+		/**
+		 * @brief Gets the size of the valid UTF-8 prefix.
+		*/
+		size_t utf8_validate_scalar(const uint8_t* p, size_t _size) noexcept
+		{
+			size_t n = 0;
+			while (n != _size)
+			{
+				// Skip ASCII a word at a time
+				uint64_t _word;
+				if (_size - n >= 8 && (std::memcpy(&_word, p + n, 8), (_word & 0x8080'8080'8080'8080) == 0))
+				{
+					n += 8;
+					continue;
+				};
+
+				const auto _sequenceSize = utf8_sequence_size(p + n, _size - n);
+				if (_sequenceSize == 0)
+				{
+					break;
+				};
+				n += _sequenceSize;
+			};
+			return n;
+		};
+
+		size_t hex_encode_none(const uint8_t*, size_t, char*) noexcept { return 0; };
+		size_t hex_decode_none(const char*, size_t, uint8_t*) noexcept { return 0; };
+		size_t base64_encode_none(const uint8_t*, size_t, char*, base64_alphabet) noexcept { return 0; };
+		size_t base64_decode_none(const char*, size_t, uint8_t*, base64_alphabet) noexcept { return 0; };
+		size_t utf8_validate_none(const uint8_t*, size_t) noexcept { return 0; };
+
+
+
+#ifdef ASX_ENCODING_SSSE3
+
+	#if defined(__x86_64__)
+		bool has_ssse3() noexcept
+		{
+			return __builtin_cpu_supports("ssse3");
+		};
+	#elif defined(_M_X64)
+		bool has_ssse3() noexcept
+		{
+			int _info[4]{};
+			__cpuid(_info, 1);
+			return (_info[2] & (1 << 9)) != 0;
+		};
+	#endif
+
+		/*
+			The vector versions process whole 16 byte registers and return how much they did, leaving
+			the rest for the scalar versions. Decoding stops before the first register holding an
+			invalid character so the scalar version finds it.
+		*/
+
+		ASX_ENCODING_TARGET size_t hex_encode_ssse3(const uint8_t* _src, size_t _size, char* _dst) noexcept
+		{
+			const auto _digits = _mm_loadu_si128(reinterpret_cast<const __m128i*>(HEX_DIGITS.data()));
+			const auto _mask = _mm_set1_epi8(0x0F);
+
+			size_t n = 0;
+			for (; n + 16 <= _size; n += 16)
+			{
+				const auto _in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(_src + n));
+				const auto _hi = _mm_shuffle_epi8(_digits, _mm_and_si128(_mm_srli_epi16(_in, 4), _mask));
+				const auto _lo = _mm_shuffle_epi8(_digits, _mm_and_si128(_in, _mask));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(_dst + 2 * n), _mm_unpacklo_epi8(_hi, _lo));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(_dst + 2 * n + 16), _mm_unpackhi_epi8(_hi, _lo));
+			};
+			return n;
+		};
+
+		/**
+		 * @brief Converts hex digits to their values, clearing lanes of `_valid` that aren't hex digits.
+		*/
+		ASX_ENCODING_TARGET inline __m128i hex_values_ssse3(__m128i _in, __m128i& _valid) noexcept
+		{
+			// Unsigned x <= n is min(x, n) == x, anything below '0' or 'a' wraps around to large.
+			const auto _digit = _mm_sub_epi8(_in, _mm_set1_epi8('0'));
+			const auto _isDigit = _mm_cmpeq_epi8(_mm_min_epu8(_digit, _mm_set1_epi8(9)), _digit);
+			const auto _letter = _mm_sub_epi8(_mm_or_si128(_in, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+			const auto _isLetter = _mm_cmpeq_epi8(_mm_min_epu8(_letter, _mm_set1_epi8(5)), _letter);
+
+			_valid = _mm_and_si128(_valid, _mm_or_si128(_isDigit, _isLetter));
+			return _mm_or_si128(_mm_and_si128(_isDigit, _digit),
+				_mm_and_si128(_isLetter, _mm_add_epi8(_letter, _mm_set1_epi8(10))));
+		};
+
+		ASX_ENCODING_TARGET size_t hex_decode_ssse3(const char* _src, size_t _size, uint8_t* _dst) noexcept
+		{
+			// Multiplies each high digit by 16 and adds the low digit next to it.
+			const auto _merge = _mm_set1_epi16(0x0110);
+
+			size_t n = 0;
+			for (; n + 16 <= _size; n += 16)
+			{
+				auto _valid = _mm_set1_epi8(-1);
+				const auto _v0 = hex_values_ssse3(_mm_loadu_si128(reinterpret_cast<const __m128i*>(_src + 2 * n)), _valid);
+				const auto _v1 = hex_values_ssse3(_mm_loadu_si128(reinterpret_cast<const __m128i*>(_src + 2 * n + 16)), _valid);
+				if (_mm_movemask_epi8(_valid) != 0xFFFF)
+				{
+					break;
+				};
+				const auto _out = _mm_packus_epi16(_mm_maddubs_epi16(_v0, _merge), _mm_maddubs_epi16(_v1, _merge));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(_dst + n), _out);
+			};
+			return n;
+		};
+
+		/**
+		 * @brief Encodes 12 bytes into 16 characters.
+		 *
+		 * Spreads the 6 bit values out into their own bytes, then turns each into a character by adding
+		 * the offset for the range of digits it falls in.
+		*/
+		ASX_ENCODING_TARGET size_t base64_encode_ssse3(const uint8_t* _src, size_t _size, char* _dst, base64_alphabet _alphabet) noexcept
+		{
+			const auto _digit62 = base64_digits(_alphabet)[62];
+			const auto _digit63 = base64_digits(_alphabet)[63];
+			const auto _offsets = _mm_setr_epi8(
+				'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+				'0' - 52, '0' - 52, '0' - 52, char(_digit62 - 62), char(_digit63 - 63), 'A', 0, 0);
+			const auto _spread = _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1);
+
+			size_t n = 0;
+			size_t _written = 0;
+
+			// Reads 16 bytes to use 12 of them.
+			for (; n + 16 <= _size; n += 12, _written += 16)
+			{
+				auto _in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(_src + n));
+				_in = _mm_shuffle_epi8(_in, _spread);
+
+				const auto _ac = _mm_mulhi_epu16(_mm_and_si128(_in, _mm_set1_epi32(0x0FC0FC00)), _mm_set1_epi32(0x04000040));
+				const auto _bd = _mm_mullo_epi16(_mm_and_si128(_in, _mm_set1_epi32(0x003F03F0)), _mm_set1_epi32(0x01000010));
+				const auto _values = _mm_or_si128(_ac, _bd);
+
+				// 0 for 26-51, 1-10 for the numbers, 11 and 12 for the last two, 13 for 0-25.
+				auto _range = _mm_subs_epu8(_values, _mm_set1_epi8(51));
+				const auto _upper = _mm_cmpgt_epi8(_mm_set1_epi8(26), _values);
+				_range = _mm_or_si128(_range, _mm_and_si128(_upper, _mm_set1_epi8(13)));
+
+				const auto _out = _mm_add_epi8(_mm_shuffle_epi8(_offsets, _range), _values);
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(_dst + _written), _out);
+			};
+			return n;
+		};
+
+		/**
+		 * @brief Decodes 16 characters into 12 bytes.
+		 *
+		 * Characters are classified by their high and low nibbles, a character is valid only if the
+		 * two lookups share no bits. The high nibble then picks the offset back to its 6 bit value,
+		 * except '/' which shares a high nibble with '+' and is singled out.
+		*/
+		ASX_ENCODING_TARGET size_t base64_decode_ssse3(const char* _src, size_t _size, uint8_t* _dst, base64_alphabet _alphabet) noexcept
+		{
+			const auto _lowClass = _mm_setr_epi8(
+				0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+			const auto _highClass = _mm_setr_epi8(
+				0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+			const auto _offsets = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+			const auto _mask2F = _mm_set1_epi8(0x2F);
+			const auto _pack = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+			const auto _isUrl = _alphabet == base64_alphabet::url;
+
+			size_t n = 0;
+			size_t _written = 0;
+
+			// Writes 16 bytes to keep 12, so stop while the output still has room for the extra 4.
+			for (; n + 24 <= _size; n += 16, _written += 12)
+			{
+				auto _in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(_src + n));
+				auto _invalid = _mm_setzero_si128();
+
+				if (_isUrl)
+				{
+					// Swap '-' and '_' for '+' and '/', after rejecting any '+' and '/' already there.
+					_invalid = _mm_or_si128(_mm_cmpeq_epi8(_in, _mm_set1_epi8('+')), _mm_cmpeq_epi8(_in, _mm_set1_epi8('/')));
+					const auto _minus = _mm_and_si128(_mm_cmpeq_epi8(_in, _mm_set1_epi8('-')), _mm_set1_epi8('-' - '+'));
+					const auto _underscore = _mm_and_si128(_mm_cmpeq_epi8(_in, _mm_set1_epi8('_')), _mm_set1_epi8('_' - '/'));
+					_in = _mm_sub_epi8(_in, _mm_or_si128(_minus, _underscore));
+				};
+
+				// Masking with 0x2F keeps the nibble and clears bit 7, bit 5 is ignored by the shuffle.
+				const auto _hiNibbles = _mm_and_si128(_mm_srli_epi32(_in, 4), _mask2F);
+				const auto _loNibbles = _mm_and_si128(_in, _mask2F);
+				const auto _lo = _mm_shuffle_epi8(_lowClass, _loNibbles);
+				const auto _hi = _mm_shuffle_epi8(_highClass, _hiNibbles);
+				_invalid = _mm_or_si128(_invalid, _mm_and_si128(_lo, _hi));
+				if (_mm_movemask_epi8(_mm_cmpeq_epi8(_invalid, _mm_setzero_si128())) != 0xFFFF)
+				{
+					break;
+				};
+
+				const auto _isSlash = _mm_cmpeq_epi8(_in, _mask2F);
+				const auto _values = _mm_add_epi8(_in, _mm_shuffle_epi8(_offsets, _mm_add_epi8(_isSlash, _hiNibbles)));
+
+				// Joins pairs of 6 bit values into 12, then pairs of those into 24, then puts the bytes in order.
+				const auto _pairs = _mm_maddubs_epi16(_values, _mm_set1_epi32(0x01400140));
+				const auto _triples = _mm_madd_epi16(_pairs, _mm_set1_epi32(0x00011000));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(_dst + _written), _mm_shuffle_epi8(_triples, _pack));
+			};
+			return n;
+		};
+
+		/*
+			Error bits for UTF-8 validation. Each byte is checked against the byte before it with
+			three lookups, on the previous byte's high and low nibble and on its own high nibble,
+			which only share a bit if the pair is an error. 3rd and 4th bytes of a sequence are
+			continuations the lookups also flag as errors, so those are found separately and cancel.
+		*/
+
+		constexpr uint8_t UTF8_TOO_SHORT = 1 << 0;			// lead byte not followed by a continuation
+		constexpr uint8_t UTF8_TOO_LONG = 1 << 1;			// continuation after ASCII
+		constexpr uint8_t UTF8_OVERLONG_3 = 1 << 2;			// 3 byte form of a code point below U+0800
+		constexpr uint8_t UTF8_TOO_LARGE = 1 << 3;			// past U+10FFFF
+		constexpr uint8_t UTF8_SURROGATE = 1 << 4;			// U+D800 to U+DFFF
+		constexpr uint8_t UTF8_OVERLONG_2 = 1 << 5;			// 2 byte form of a code point below U+0080
+		constexpr uint8_t UTF8_TOO_LARGE_1000 = 1 << 6;		// past U+10FFFF with 1000 in the second byte's high nibble
+		constexpr uint8_t UTF8_OVERLONG_4 = 1 << 6;			// 4 byte form of a code point below U+10000
+		constexpr uint8_t UTF8_TWO_CONTINUATIONS = 1 << 7;	// continuation after a continuation
+		constexpr uint8_t UTF8_CARRY = UTF8_TOO_SHORT | UTF8_TOO_LONG | UTF8_TWO_CONTINUATIONS;
+
+		ASX_ENCODING_TARGET inline __m128i utf8_lookup(
+			uint8_t _0, uint8_t _1, uint8_t _2, uint8_t _3, uint8_t _4, uint8_t _5, uint8_t _6, uint8_t _7,
+			uint8_t _8, uint8_t _9, uint8_t _10, uint8_t _11, uint8_t _12, uint8_t _13, uint8_t _14, uint8_t _15) noexcept
+		{
+			return _mm_setr_epi8(char(_0), char(_1), char(_2), char(_3), char(_4), char(_5), char(_6), char(_7),
+				char(_8), char(_9), char(_10), char(_11), char(_12), char(_13), char(_14), char(_15));
+		};
+
+		/**
+		 * @brief Validates 16 bytes at a time, returns how far it got.
+		 *
+		 * Stops before the first register with an error and backs up to the start of any sequence
+		 * that may continue past where it stopped, so the scalar version can pick up from there.
+		*/
+		ASX_ENCODING_TARGET size_t utf8_validate_ssse3(const uint8_t* _src, size_t _size) noexcept
+		{
+			constexpr auto _tooLarge = UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000;
+			constexpr auto _continuation = UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTINUATIONS;
+
+			const auto _byte1High = utf8_lookup(
+				UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG,
+				UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG,
+				UTF8_TWO_CONTINUATIONS, UTF8_TWO_CONTINUATIONS, UTF8_TWO_CONTINUATIONS, UTF8_TWO_CONTINUATIONS,
+				UTF8_TOO_SHORT | UTF8_OVERLONG_2,
+				UTF8_TOO_SHORT,
+				UTF8_TOO_SHORT | UTF8_OVERLONG_3 | UTF8_SURROGATE,
+				UTF8_TOO_SHORT | _tooLarge | UTF8_OVERLONG_4);
+			const auto _byte1Low = utf8_lookup(
+				UTF8_CARRY | UTF8_OVERLONG_3 | UTF8_OVERLONG_2 | UTF8_OVERLONG_4,
+				UTF8_CARRY | UTF8_OVERLONG_2,
+				UTF8_CARRY,
+				UTF8_CARRY,
+				UTF8_CARRY | UTF8_TOO_LARGE,
+				UTF8_CARRY | _tooLarge, UTF8_CARRY | _tooLarge, UTF8_CARRY | _tooLarge,
+				UTF8_CARRY | _tooLarge, UTF8_CARRY | _tooLarge, UTF8_CARRY | _tooLarge, UTF8_CARRY | _tooLarge,
+				UTF8_CARRY | _tooLarge,
+				UTF8_CARRY | _tooLarge | UTF8_SURROGATE,
+				UTF8_CARRY | _tooLarge,
+				UTF8_CARRY | _tooLarge);
+			const auto _byte2High = utf8_lookup(
+				UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT,
+				UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT,
+				_continuation | UTF8_OVERLONG_3 | UTF8_TOO_LARGE_1000 | UTF8_OVERLONG_4,
+				_continuation | UTF8_OVERLONG_3 | UTF8_TOO_LARGE,
+				_continuation | UTF8_SURROGATE | UTF8_TOO_LARGE,
+				_continuation | UTF8_SURROGATE | UTF8_TOO_LARGE,
+				UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT);
+
+			// Bytes above these at the end of a register start a sequence that continues into the next one.
+			const auto _incompleteMax = utf8_lookup(
+				0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+				0xF0 - 1, 0xE0 - 1, 0xC0 - 1);
+			const auto _nibbleMask = _mm_set1_epi8(0x0F);
+			const auto _zero = _mm_setzero_si128();
+
+			auto _prev = _zero;
+			auto _prevIncomplete = _zero;
+
+			size_t n = 0;
+			for (; n + 16 <= _size; n += 16)
+			{
+				const auto _in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(_src + n));
+
+				auto _error = _prevIncomplete;
+				if (_mm_movemask_epi8(_in) == 0)
+				{
+					_prevIncomplete = _zero;
+				}
+				else
+				{
+					const auto _prev1 = _mm_alignr_epi8(_in, _prev, 15);
+					const auto _b1High = _mm_shuffle_epi8(_byte1High, _mm_and_si128(_mm_srli_epi16(_prev1, 4), _nibbleMask));
+					const auto _b1Low = _mm_shuffle_epi8(_byte1Low, _mm_and_si128(_prev1, _nibbleMask));
+					const auto _b2High = _mm_shuffle_epi8(_byte2High, _mm_and_si128(_mm_srli_epi16(_in, 4), _nibbleMask));
+					const auto _special = _mm_and_si128(_mm_and_si128(_b1High, _b1Low), _b2High);
+
+					// Continuations 2 after a 3 or 4 byte lead, or 3 after a 4 byte lead, have bit 7 set here.
+					const auto _third = _mm_subs_epu8(_mm_alignr_epi8(_in, _prev, 14), _mm_set1_epi8(char(0xE0 - 0x80)));
+					const auto _fourth = _mm_subs_epu8(_mm_alignr_epi8(_in, _prev, 13), _mm_set1_epi8(char(0xF0 - 0x80)));
+					const auto _must23 = _mm_and_si128(_mm_or_si128(_third, _fourth), _mm_set1_epi8(char(0x80)));
+
+					_error = _mm_xor_si128(_must23, _special);
+					_prevIncomplete = _mm_subs_epu8(_in, _incompleteMax);
+				};
+
+				if (_mm_movemask_epi8(_mm_cmpeq_epi8(_error, _zero)) != 0xFFFF)
+				{
+					break;
+				};
+				_prev = _in;
+			};
+
+			for (size_t k = 1; k <= 3 && k <= n; ++k)
+			{
+				if (_src[n - k] >= 0xC0)
+				{
+					return n - k;
+				};
+			};
+			return n;
+		};
+
+#endif
+
+		/**
+		 * @brief Gets the number of bytes at the start of some text that need no JSON escaping.
+		*/
+		inline size_t json_clean_size(const uint8_t* p, size_t _size) noexcept
+		{
+			size_t n = 0;
+
+#if defined(__x86_64__) || defined(_M_X64)
+			// SSE2 is always there on x86-64. The signed compare catches both control characters and non-ASCII.
+			const auto _space = _mm_set1_epi8(0x20);
+			const auto _quote = _mm_set1_epi8('"');
+			const auto _backslash = _mm_set1_epi8('\\');
+			for (; n + 16 <= _size; n += 16)
+			{
+				const auto _in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + n));
+				const auto _special = _mm_or_si128(_mm_cmplt_epi8(_in, _space),
+					_mm_or_si128(_mm_cmpeq_epi8(_in, _quote), _mm_cmpeq_epi8(_in, _backslash)));
+				const auto _mask = static_cast<uint32_t>(_mm_movemask_epi8(_special));
+				if (_mask != 0)
+				{
+					return n + std::countr_zero(_mask);
+				};
+			};
+#endif
+
+			for (; n != _size; ++n)
+			{
+				const auto c = p[n];
+				if (c < 0x20 || c >= 0x80 || c == '"' || c == '\\')
+				{
+					break;
+				};
+			};
+			return n;
+		};
+
+		/**
+		 * @brief Bulk versions picked for the CPU, each returns how much of the input it handled.
+		*/
+		struct encoding_kernels
+		{
+			size_t(*hex_encode)(const uint8_t* _src, size_t _size, char* _dst) noexcept;
+			size_t(*hex_decode)(const char* _src, size_t _size, uint8_t* _dst) noexcept;
+			size_t(*base64_encode)(const uint8_t* _src, size_t _size, char* _dst, base64_alphabet _alphabet) noexcept;
+			size_t(*base64_decode)(const char* _src, size_t _size, uint8_t* _dst, base64_alphabet _alphabet) noexcept;
+			size_t(*utf8_validate)(const uint8_t* _src, size_t _size) noexcept;
+		};
+
+		encoding_kernels select_kernels() noexcept
+		{
+#ifdef ASX_ENCODING_SSSE3
+			if (has_ssse3())
+			{
+				return { &hex_encode_ssse3, &hex_decode_ssse3, &base64_encode_ssse3, &base64_decode_ssse3, &utf8_validate_ssse3 };
+			};
+#endif
+			return { &hex_encode_none, &hex_decode_none, &base64_encode_none, &base64_decode_none, &utf8_validate_none };
+		};
+
+		inline const encoding_kernels& get_kernels() noexcept
+		{
+			static const auto _kernels = select_kernels();
+			return _kernels;
+		};
+
+		inline const uint8_t* as_uint8(const std::byte* p) noexcept
+		{
+			return reinterpret_cast<const uint8_t*>(p);
+		};
+		inline uint8_t* as_uint8(std::byte* p) noexcept
+		{
+			return reinterpret_cast<uint8_t*>(p);
+		};
+	};
+
+
+
+	void hex_encode(std::span<const std::byte> _bytes, std::span<char> _out) noexcept
+	{
+		const auto _src = as_uint8(_bytes.data());
+		const auto _done = get_kernels().hex_encode(_src, _bytes.size(), _out.data());
+		hex_encode_scalar(_src + _done, _bytes.size() - _done, _out.data() + 2 * _done);
+	};
+
+	std::string hex_encode(std::span<const std::byte> _bytes)
+	{
+		auto _str = std::string(hex_encoded_size(_bytes.size()), '\0');
+		hex_encode(_bytes, _str);
+		return _str;
+	};
+
+	bool hex_decode(std::string_view _text, std::span<std::byte> _out) noexcept
+	{
+		if (_text.size() != hex_encoded_size(_out.size()))
+		{
+			return false;
+		};
+
+		const auto _dst = as_uint8(_out.data());
+		const auto _done = get_kernels().hex_decode(_text.data(), _out.size(), _dst);
+		const auto _rest = _out.size() - _done;
+		return hex_decode_scalar(_text.data() + 2 * _done, _rest, _dst + _done) == _rest;
+	};
+
+	bool hex_decode(std::string_view _text, std::vector<std::byte>& _out)
+	{
+		if (_text.size() % 2 != 0)
+		{
+			return false;
+		};
+
+		const auto _prevSize = _out.size();
+		_out.resize(_prevSize + _text.size() / 2);
+		if (!hex_decode(_text, std::span(_out).subspan(_prevSize)))
+		{
+			_out.resize(_prevSize);
+			return false;
+		};
+		return true;
+	};
+
+
+
+	size_t base64_encode(std::span<const std::byte> _bytes, std::span<char> _out,
+		base64_alphabet _alphabet, bool _padded) noexcept
+	{
+		const auto _src = as_uint8(_bytes.data());
+		const auto _size = _bytes.size();
+		auto _dst = _out.data();
+
+		auto _done = get_kernels().base64_encode(_src, _size, _dst, _alphabet);
+		_done += base64_encode_scalar(_src + _done, _size - _done, _dst + _done / 3 * 4, _alphabet);
+		_dst += _done / 3 * 4;
+
+		// Last 1 or 2 bytes, the unused bits of the last digit are zero.
+		const auto _digits = base64_digits(_alphabet);
+		const auto _left = _size - _done;
+		if (_left != 0)
+		{
+			const auto _bits = (uint32_t(_src[_done]) << 16) | ((_left == 2) ? (uint32_t(_src[_done + 1]) << 8) : 0);
+			*_dst++ = _digits[_bits >> 18];
+			*_dst++ = _digits[(_bits >> 12) & 0x3F];
+			if (_left == 2)
+			{
+				*_dst++ = _digits[(_bits >> 6) & 0x3F];
+			};
+			if (_padded)
+			{
+				*_dst++ = '=';
+				if (_left == 1)
+				{
+					*_dst++ = '=';
+				};
+			};
+		};
+		return static_cast<size_t>(_dst - _out.data());
+	};
+
+	std::string base64_encode(std::span<const std::byte> _bytes, base64_alphabet _alphabet, bool _padded)
+	{
+		auto _str = std::string(base64_encoded_size(_bytes.size(), _padded), '\0');
+		base64_encode(_bytes, _str, _alphabet, _padded);
+		return _str;
+	};
+
+	bool base64_decode(std::string_view _text, std::span<std::byte> _out, size_t& _outSize,
+		base64_alphabet _alphabet) noexcept
+	{
+		// Padding is only allowed to fill out the last group of 4.
+		auto _size = _text.size();
+		if (_size % 4 == 0 && _size != 0 && _text[_size - 1] == '=')
+		{
+			_size -= (_text[_size - 2] == '=') ? 2 : 1;
+		};
+
+		const auto _left = _size % 4;
+		if (_left == 1)
+		{
+			return false;
+		};
+
+		const auto _decodedSize = _size / 4 * 3 + (_left == 0 ? 0 : _left - 1);
+		if (_out.size() < _decodedSize)
+		{
+			return false;
+		};
+
+		const auto _src = _text.data();
+		const auto _dst = as_uint8(_out.data());
+
+		auto _done = get_kernels().base64_decode(_src, _size, _dst, _alphabet);
+		_done += base64_decode_scalar(_src + _done, _size - _done, _dst + _done / 4 * 3, _alphabet);
+		if (_done != _size - _left)
+		{
+			return false;
+		};
+
+		// Last 2 or 3 characters, the bits past the last whole byte must be zero.
+		if (_left != 0)
+		{
+			const auto& _values = base64_values(_alphabet);
+			const auto a = _values[static_cast<uint8_t>(_src[_done])];
+			const auto b = _values[static_cast<uint8_t>(_src[_done + 1])];
+			const auto c = (_left == 3) ? _values[static_cast<uint8_t>(_src[_done + 2])] : uint8_t(0);
+			if ((a | b | c) == INVALID_DIGIT)
+			{
+				return false;
+			};
+
+			const auto _bits = (uint32_t(a) << 18) | (uint32_t(b) << 12) | (uint32_t(c) << 6);
+			const auto _unused = (_left == 3) ? (_bits & 0xFF) : (_bits & 0xFFFF);
+			if (_unused != 0)
+			{
+				return false;
+			};
+
+			auto _tail = _dst + _done / 4 * 3;
+			*_tail++ = static_cast<uint8_t>(_bits >> 16);
+			if (_left == 3)
+			{
+				*_tail++ = static_cast<uint8_t>(_bits >> 8);
+			};
+		};
+
+		_outSize = _decodedSize;
+		return true;
+	};
+
+	bool base64_decode(std::string_view _text, std::vector<std::byte>& _out, base64_alphabet _alphabet)
+	{
+		const auto _prevSize = _out.size();
+		_out.resize(_prevSize + base64_decoded_size_max(_text.size()));
+
+		size_t _decodedSize = 0;
+		if (!base64_decode(_text, std::span(_out).subspan(_prevSize), _decodedSize, _alphabet))
+		{
+			_out.resize(_prevSize);
+			return false;
+		};
+		_out.resize(_prevSize + _decodedSize);
+		return true;
+	};
+
+
+
+	bool utf8_validate(std::span<const std::byte> _bytes, size_t* _outValidSize) noexcept
+	{
+		const auto _src = as_uint8(_bytes.data());
+		const auto _done = get_kernels().utf8_validate(_src, _bytes.size());
+		const auto _validSize = _done + utf8_validate_scalar(_src + _done, _bytes.size() - _done);
+		if (_outValidSize)
+		{
+			*_outValidSize = _validSize;
+		};
+		return _validSize == _bytes.size();
+	};
+
+	bool json_escape_to(std::string& _out, std::string_view _text)
+	{
+		const auto p = reinterpret_cast<const uint8_t*>(_text.data());
+		const auto _size = _text.size();
+
+		bool _valid = true;
+		size_t _copyFrom = 0;
+		size_t n = 0;
+		while (true)
+		{
+			n += json_clean_size(p + n, _size - n);
+			if (n == _size)
+			{
+				break;
+			};
+
+			const auto c = p[n];
+			if (c >= 0x80)
+			{
+				const auto _sequenceSize = utf8_sequence_size(p + n, _size - n);
+				if (_sequenceSize != 0)
+				{
+					n += _sequenceSize;
+					continue;
+				};
+			};
+
+			_out.append(_text.substr(_copyFrom, n - _copyFrom));
+			switch (c)
+			{
+			case '"': _out.append("\\\""); break;
+			case '\\': _out.append("\\\\"); break;
+			case '\b': _out.append("\\b"); break;
+			case '\f': _out.append("\\f"); break;
+			case '\n': _out.append("\\n"); break;
+			case '\r': _out.append("\\r"); break;
+			case '\t': _out.append("\\t"); break;
+			default:
+				if (c >= 0x80)
+				{
+					_out.append("\\ufffd");
+					_valid = false;
+				}
+				else
+				{
+					const char _escape[6]{ '\\', 'u', '0', '0', HEX_DIGITS[c >> 4], HEX_DIGITS[c & 0x0F] };
+					_out.append(_escape, sizeof(_escape));
+				};
+				break;
+			};
+			_copyFrom = ++n;
+		};
+		_out.append(_text.substr(_copyFrom));
+		return _valid;
+	};
+};
@@ -0,0 +1,207 @@
+#include <asx/epoch.hpp>
+
+#include <thread>
+#include <algorithm>
+
+namespace asx
+{
+	/**
+	 * @brief Number of retirements between attempts to advance the epoch and collect.
+	*/
+	constexpr size_t EPOCH_COLLECT_INTERVAL = 64;
+
+	/**
+	 * @brief Records and limbo lists of the calling thread, one per domain used.
+	*/
+	struct epoch_thread_state
+	{
+		struct domain_state
+		{
+			epoch_domain* domain;
+			epoch_record* record;
+			std::vector<epoch_domain::retired_object> limbo;
+			size_t retired_since_collect = 0;
+		};
+
+		std::vector<domain_state> domains;
+
+		domain_state& state_for(epoch_domain& _domain)
+		{
+			for (auto& _state : this->domains)
+			{
+				if (_state.domain == &_domain)
+				{
+					return _state;
+				};
+			};
+			return this->domains.emplace_back(domain_state{ &_domain, _domain.acquire_record(), {} });
+		};
+
+		/**
+		 * @brief Forgets a domain that is being destroyed.
+		*/
+		void forget(epoch_domain& _domain) noexcept
+		{
+			std::erase_if(this->domains, [&](const domain_state& v) { return v.domain == &_domain; });
+		};
+
+		~epoch_thread_state()
+		{
+			for (auto& _state : this->domains)
+			{
+				auto& _domain = *_state.domain;
+				_state.record->state.store(0, std::memory_order_release);
+				_state.record->nesting = 0;
+				_state.record->active.store(false, std::memory_order_release);
+
+				// Collect what we can, hand the rest to the domain
+				_domain.try_advance();
+				_domain.collect(_state.limbo);
+				if (!_state.limbo.empty())
+				{
+					const auto lck = std::unique_lock(_domain.orphans_mtx_);
+					_domain.orphans_.insert(_domain.orphans_.end(), _state.limbo.begin(), _state.limbo.end());
+					_domain.has_orphans_.store(true, std::memory_order_release);
+				};
+			};
+		};
+	};
+
+	inline epoch_thread_state& this_thread_epoch_state()
+	{
+		thread_local epoch_thread_state _state{};
+		return _state;
+	};
+
+
+
+	epoch_record* epoch_domain::acquire_record()
+	{
+		// Reuse a record released by an exited thread if there is one
+		for (auto _record = this->records_.load(std::memory_order_acquire); _record; _record = _record->next)
+		{
+			if (!_record->active.load(std::memory_order_relaxed) && !_record->active.exchange(true, std::memory_order_acquire))
+			{
+				return _record;
+			};
+		};
+
+		auto _record = new epoch_record{};
+		_record->active.store(true, std::memory_order_relaxed);
+
+		auto _head = this->records_.load(std::memory_order_relaxed);
+		do
+		{
+			_record->next = _head;
+		} while (!this->records_.compare_exchange_weak(_head, _record, std::memory_order_release, std::memory_order_relaxed));
+		return _record;
+	};
+
+	epoch_record& epoch_domain::this_thread_record()
+	{
+		return *this_thread_epoch_state().state_for(*this).record;
+	};
+
+	bool epoch_domain::try_advance() noexcept
+	{
+		auto _epoch = this->epoch_.load(std::memory_order_seq_cst);
+		for (auto _record = this->records_.load(std::memory_order_acquire); _record; _record = _record->next)
+		{
+			const auto _state = _record->state.load(std::memory_order_seq_cst);
+			if ((_state & 1) && (_state >> 1) != _epoch)
+			{
+				// Someone is still pinned in an older epoch
+				return false;
+			};
+		};
+		return this->epoch_.compare_exchange_strong(_epoch, _epoch + 1, std::memory_order_seq_cst);
+	};
+
+	void epoch_domain::collect(std::vector<retired_object>& _limbo)
+	{
+		// Adopt anything left behind by exited threads
+		if (this->has_orphans_.load(std::memory_order_acquire))
+		{
+			const auto lck = std::unique_lock(this->orphans_mtx_);
+			_limbo.insert(_limbo.end(), this->orphans_.begin(), this->orphans_.end());
+			this->orphans_.clear();
+			this->has_orphans_.store(false, std::memory_order_relaxed);
+		};
+
+		// Readers pinned when an object was retired have all unpinned two epochs later
+		const auto _epoch = this->epoch_.load(std::memory_order_seq_cst);
+		const auto _expired = std::partition(_limbo.begin(), _limbo.end(), [&](const retired_object& v)
+		{
+			return v.epoch + 2 > _epoch;
+		});
+
+		// Copy out first, deleters may retire more objects into this same list
+		auto _reclaimable = std::vector<retired_object>(_expired, _limbo.end());
+		_limbo.erase(_expired, _limbo.end());
+		for (auto& v : _reclaimable)
+		{
+			v.deleter(v.ptr);
+		};
+	};
+
+	void epoch_domain::retire(void* _ptr, deleter_type _deleter)
+	{
+		auto& _state = this_thread_epoch_state().state_for(*this);
+		_state.limbo.push_back(retired_object{ _ptr, _deleter, this->epoch_.load(std::memory_order_seq_cst) });
+
+		if (++_state.retired_since_collect >= EPOCH_COLLECT_INTERVAL)
+		{
+			_state.retired_since_collect = 0;
+			this->try_advance();
+			this->collect(_state.limbo);
+		};
+	};
+
+	void epoch_domain::reclaim()
+	{
+		auto& _state = this_thread_epoch_state().state_for(*this);
+		this->try_advance();
+		this->collect(_state.limbo);
+	};
+
+	void epoch_domain::synchronize()
+	{
+		const auto _target = this->epoch_.load(std::memory_order_seq_cst) + 2;
+		while (this->epoch_.load(std::memory_order_seq_cst) < _target)
+		{
+			if (!this->try_advance())
+			{
+				std::this_thread::yield();
+			};
+		};
+		this->reclaim();
+	};
+
+	epoch_domain::~epoch_domain()
+	{
+		// Nothing can be pinned anymore, delete everything
+		auto& _threadState = this_thread_epoch_state();
+		auto& _limbo = _threadState.state_for(*this).limbo;
+		_limbo.insert(_limbo.end(), this->orphans_.begin(), this->orphans_.end());
+		for (auto& v : _limbo)
+		{
+			v.deleter(v.ptr);
+		};
+		_threadState.forget(*this);
+
+		auto _record = this->records_.load(std::memory_order_relaxed);
+		while (_record)
+		{
+			const auto _next = _record->next;
+			delete _record;
+			_record = _next;
+		};
+	};
+
+	epoch_domain& default_epoch_domain()
+	{
+		// Leaked so it outlives every thread_local that may still retire into it
+		static auto _domain = new epoch_domain();
+		return *_domain;
+	};
+};
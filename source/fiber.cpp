@@ -0,0 +1,664 @@
+#include <asx/fiber.hpp>
+
+#include "os.hpp"
+#include <asx/sync.hpp>
+#include <asx/assert.hpp>
+#include <asx/logging.hpp>
+
+#include <cerrno>
+#include <algorithm>
+
+#ifdef ASX_OS_LINUX
+	#include <unistd.h>
+	#include <sys/mman.h>
+#endif
+
+#if defined(ASX_OS_LINUX) && (defined(__x86_64__) || defined(__aarch64__))
+	#define ASX_FIBER_ASM
+#endif
+
+#ifdef _MSC_VER
+	#define ASX_FIBER_NOINLINE __declspec(noinline)
+#else
+	#define ASX_FIBER_NOINLINE __attribute__((noinline))
+#endif
+
+#ifdef ASX_FIBER_ASM
+
+/**
+ * @brief Saves the callee saved registers on the current stack, stores the stack pointer in `_save`,
+ * then switches to the stack `_to` and restores the registers saved there.
+*/
+extern "C" void asx_fiber_switch(void** _save, void* _to);
+
+/**
+ * @brief First return address of a new fiber, calls the entry function with its argument.
+*/
+extern "C" void asx_fiber_trampoline();
+
+#if defined(__x86_64__)
+// Frame : fpu control word, mxcsr, r15, r14, r13, r12, rbx, rbp, return address
+__asm__(R"(
+	.text
+	.globl asx_fiber_switch
+	.hidden asx_fiber_switch
+	.type asx_fiber_switch, @function
+	.p2align 4
+asx_fiber_switch:
+	pushq %rbp
+	pushq %rbx
+	pushq %r12
+	pushq %r13
+	pushq %r14
+	pushq %r15
+	subq $16, %rsp
+	stmxcsr 8(%rsp)
+	fnstcw (%rsp)
+	movq %rsp, (%rdi)
+	movq %rsi, %rsp
+	fldcw (%rsp)
+	ldmxcsr 8(%rsp)
+	addq $16, %rsp
+	popq %r15
+	popq %r14
+	popq %r13
+	popq %r12
+	popq %rbx
+	popq %rbp
+	ret
+	.size asx_fiber_switch, .-asx_fiber_switch
+
+	.globl asx_fiber_trampoline
+	.hidden asx_fiber_trampoline
+	.type asx_fiber_trampoline, @function
+	.p2align 4
+asx_fiber_trampoline:
+	movq %r13, %rdi
+	andq $-16, %rsp
+	callq *%r12
+	ud2
+	.size asx_fiber_trampoline, .-asx_fiber_trampoline
+)");
+#elif defined(__aarch64__)
+// Frame : x19 - x28, x29 (frame pointer), x30 (link register), d8 - d15
+__asm__(R"(
+	.text
+	.globl asx_fiber_switch
+	.hidden asx_fiber_switch
+	.type asx_fiber_switch, %function
+	.p2align 4
+asx_fiber_switch:
+	sub sp, sp, #160
+	stp x19, x20, [sp, #0]
+	stp x21, x22, [sp, #16]
+	stp x23, x24, [sp, #32]
+	stp x25, x26, [sp, #48]
+	stp x27, x28, [sp, #64]
+	stp x29, x30, [sp, #80]
+	stp d8, d9, [sp, #96]
+	stp d10, d11, [sp, #112]
+	stp d12, d13, [sp, #128]
+	stp d14, d15, [sp, #144]
+	mov x9, sp
+	str x9, [x0]
+	mov sp, x1
+	ldp x19, x20, [sp, #0]
+	ldp x21, x22, [sp, #16]
+	ldp x23, x24, [sp, #32]
+	ldp x25, x26, [sp, #48]
+	ldp x27, x28, [sp, #64]
+	ldp x29, x30, [sp, #80]
+	ldp d8, d9, [sp, #96]
+	ldp d10, d11, [sp, #112]
+	ldp d12, d13, [sp, #128]
+	ldp d14, d15, [sp, #144]
+	add sp, sp, #160
+	ret
+	.size asx_fiber_switch, .-asx_fiber_switch
+
+	.globl asx_fiber_trampoline
+	.hidden asx_fiber_trampoline
+	.type asx_fiber_trampoline, %function
+	.p2align 4
+asx_fiber_trampoline:
+	mov x0, x20
+	blr x19
+	brk #0
+	.size asx_fiber_trampoline, .-asx_fiber_trampoline
+)");
+#endif
+
+namespace asx
+{
+	/**
+	 * @brief Builds the initial frame of a new fiber so that switching to it calls `_fn(_arg)`.
+	 * @return The fiber's initial stack pointer.
+	*/
+	inline void* make_fiber_frame(const fiber_stack& _stack, void(*_fn)(void*), void* _arg)
+	{
+		const auto _top = (reinterpret_cast<uintptr_t>(_stack.base) + _stack.size) & ~uintptr_t(15);
+		auto _sp = reinterpret_cast<uintptr_t*>(_top);
+#if defined(__x86_64__)
+		*--_sp = 0;
+		*--_sp = reinterpret_cast<uintptr_t>(&asx_fiber_trampoline);
+		*--_sp = 0; // rbp
+		*--_sp = 0; // rbx
+		*--_sp = reinterpret_cast<uintptr_t>(_fn); // r12
+		*--_sp = reinterpret_cast<uintptr_t>(_arg); // r13
+		*--_sp = 0; // r14
+		*--_sp = 0; // r15
+		*--_sp = 0x1F80; // mxcsr default
+		*--_sp = 0x037F; // fpu control word default
+#elif defined(__aarch64__)
+		_sp -= 20;
+		for (size_t n = 0; n != 20; ++n)
+		{
+			_sp[n] = 0;
+		};
+		_sp[0] = reinterpret_cast<uintptr_t>(_fn); // x19
+		_sp[1] = reinterpret_cast<uintptr_t>(_arg); // x20
+		_sp[11] = reinterpret_cast<uintptr_t>(&asx_fiber_trampoline); // x30
+#endif
+		return _sp;
+	};
+};
+#endif
+
+namespace asx
+{
+	namespace
+	{
+		thread_local fiber* this_thread_fiber = nullptr;
+		thread_local fiber_scheduler::task* this_thread_task = nullptr;
+
+		// Fibers may move between threads, so thread locals are only reached through calls the
+		// compiler can't inline and cache the address of across a switch
+		ASX_FIBER_NOINLINE fiber* get_this_thread_fiber() noexcept
+		{
+			return this_thread_fiber;
+		};
+		ASX_FIBER_NOINLINE void set_this_thread_fiber(fiber* _fiber) noexcept
+		{
+			this_thread_fiber = _fiber;
+		};
+		ASX_FIBER_NOINLINE fiber_scheduler::task* get_this_thread_task() noexcept
+		{
+			return this_thread_task;
+		};
+		ASX_FIBER_NOINLINE void set_this_thread_task(fiber_scheduler::task* _task) noexcept
+		{
+			this_thread_task = _task;
+		};
+	};
+};
+
+namespace asx
+{
+#ifdef ASX_OS_WINDOWS
+	inline size_t fiber_page_size()
+	{
+		SYSTEM_INFO _info{};
+		GetSystemInfo(&_info);
+		return static_cast<size_t>(_info.dwPageSize);
+	};
+#else
+	inline size_t fiber_page_size()
+	{
+		return static_cast<size_t>(sysconf(_SC_PAGESIZE));
+	};
+#endif
+
+	inline void unmap_fiber_stack(const fiber_stack& _stack)
+	{
+		const auto _page = fiber_page_size();
+#ifdef ASX_OS_WINDOWS
+		VirtualFree(static_cast<std::byte*>(_stack.base) - _page, 0, MEM_RELEASE);
+#else
+		munmap(static_cast<std::byte*>(_stack.base) - _page, _stack.size + _page);
+#endif
+	};
+
+	fiber_stack fiber_stack_pool::acquire()
+	{
+		{
+			const auto lck = std::unique_lock(this->mtx_);
+			if (!this->free_.empty())
+			{
+				const auto _stack = this->free_.back();
+				this->free_.pop_back();
+				return _stack;
+			};
+		};
+
+		// Map the guard page together with the stack, then take its access away
+		const auto _page = fiber_page_size();
+		const auto _total = this->stack_size_ + _page;
+#ifdef ASX_OS_WINDOWS
+		const auto _memory = VirtualAlloc(nullptr, _total, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+		if (!_memory)
+		{
+			ASX_LOG_ERROR("VirtualAlloc() failed to allocate a fiber stack of {} bytes", _total);
+			return fiber_stack{};
+		};
+		DWORD _oldProtect = 0;
+		VirtualProtect(_memory, _page, PAGE_NOACCESS, &_oldProtect);
+#else
+		const auto _memory = mmap(nullptr, _total, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK, -1, 0);
+		if (_memory == MAP_FAILED)
+		{
+			ASX_LOG_ERROR("mmap() failed to allocate a fiber stack of {} bytes (errno {})", _total, errno);
+			return fiber_stack{};
+		};
+		mprotect(_memory, _page, PROT_NONE);
+#endif
+		return fiber_stack{ static_cast<std::byte*>(_memory) + _page, this->stack_size_ };
+	};
+
+	void fiber_stack_pool::release(fiber_stack _stack)
+	{
+		if (!_stack.base)
+		{
+			return;
+		};
+
+		{
+			const auto lck = std::unique_lock(this->mtx_);
+			if (this->free_.size() < this->max_cached_)
+			{
+				this->free_.push_back(_stack);
+				return;
+			};
+		};
+		unmap_fiber_stack(_stack);
+	};
+
+	fiber_stack_pool::fiber_stack_pool(size_t _stackSize, size_t _maxCached) :
+		stack_size_(0),
+		max_cached_(_maxCached)
+	{
+		const auto _page = fiber_page_size();
+		this->stack_size_ = (std::max<size_t>(_stackSize, _page) + _page - 1) / _page * _page;
+	};
+
+	fiber_stack_pool::~fiber_stack_pool()
+	{
+		for (auto& _stack : this->free_)
+		{
+			unmap_fiber_stack(_stack);
+		};
+	};
+
+	fiber_stack_pool& default_fiber_stack_pool()
+	{
+		static auto* _pool = new fiber_stack_pool();
+		return *_pool;
+	};
+};
+
+namespace asx
+{
+	void fiber::entry(void* _fiber)
+	{
+		const auto _self = static_cast<fiber*>(_fiber);
+		try
+		{
+			_self->fn_();
+		}
+		catch (...)
+		{
+			_self->error_ = std::current_exception();
+		};
+		_self->done_ = true;
+
+		// Never resumed again
+#if defined(ASX_FIBER_ASM)
+		asx_fiber_switch(&_self->context_, _self->caller_context_);
+#elif defined(ASX_OS_WINDOWS)
+		SwitchToFiber(_self->caller_context_);
+#endif
+	};
+
+	bool fiber::resume()
+	{
+		ASX_CHECK(!this->done_);
+
+#if defined(ASX_FIBER_ASM)
+		if (!this->started_)
+		{
+			this->stack_ = this->stacks_->acquire();
+			if (!this->stack_.base)
+			{
+				this->done_ = true;
+				return false;
+			};
+			this->context_ = make_fiber_frame(this->stack_, &fiber::entry, this);
+			this->started_ = true;
+		};
+
+		this->previous_ = get_this_thread_fiber();
+		set_this_thread_fiber(this);
+		asx_fiber_switch(&this->caller_context_, this->context_);
+		set_this_thread_fiber(this->previous_);
+#elif defined(ASX_OS_WINDOWS)
+		if (!this->started_)
+		{
+			// Return from the start routine would exit the thread, entry() switches back instead
+			this->context_ = CreateFiberEx(0, this->stacks_->stack_size(), FIBER_FLAG_FLOAT_SWITCH,
+				[](void* _fiber) { fiber::entry(_fiber); }, this);
+			if (!this->context_)
+			{
+				ASX_LOG_ERROR("CreateFiberEx() failed (error {})", GetLastError());
+				this->done_ = true;
+				return false;
+			};
+			this->started_ = true;
+		};
+		if (!IsThreadAFiber())
+		{
+			ConvertThreadToFiberEx(nullptr, FIBER_FLAG_FLOAT_SWITCH);
+		};
+
+		this->previous_ = get_this_thread_fiber();
+		set_this_thread_fiber(this);
+		this->caller_context_ = GetCurrentFiber();
+		SwitchToFiber(this->context_);
+		set_this_thread_fiber(this->previous_);
+#else
+		ASX_LOG_WARN("fiber::resume was called but no implementation exists for the current platform");
+		this->done_ = true;
+		return false;
+#endif
+
+		if (this->done_ && this->error_)
+		{
+			std::rethrow_exception(std::exchange(this->error_, nullptr));
+		};
+		return !this->done_;
+	};
+
+	fiber* fiber::current() noexcept
+	{
+		return get_this_thread_fiber();
+	};
+
+	void fiber::yield()
+	{
+		const auto _self = get_this_thread_fiber();
+		ASX_CHECK(_self);
+
+#if defined(ASX_FIBER_ASM)
+		asx_fiber_switch(&_self->context_, _self->caller_context_);
+#elif defined(ASX_OS_WINDOWS)
+		SwitchToFiber(_self->caller_context_);
+#endif
+	};
+
+	fiber::fiber(std::function<void()> _fn, fiber_stack_pool& _stacks) :
+		fn_(std::move(_fn)),
+		stacks_(&_stacks)
+	{};
+
+	fiber::~fiber()
+	{
+		ASX_CHECK(!this->started_ || this->done_);
+#if defined(ASX_FIBER_ASM)
+		this->stacks_->release(this->stack_);
+#elif defined(ASX_OS_WINDOWS)
+		if (this->context_)
+		{
+			DeleteFiber(this->context_);
+		};
+#endif
+	};
+};
+
+namespace asx
+{
+	class fiber_scheduler::task final : public thread_pool_task
+	{
+	public:
+		constexpr static uint32_t running = 0;
+		constexpr static uint32_t notified = 1;
+		constexpr static uint32_t parked = 2;
+
+		void run() override
+		{
+			this->scheduler->run(*this);
+		};
+
+		task(fiber_scheduler* _scheduler, std::function<void()> _fn, fiber_stack_pool& _stacks) :
+			scheduler(_scheduler),
+			fib(std::move(_fn), _stacks)
+		{};
+
+		fiber_scheduler* scheduler;
+		fiber fib;
+
+		/**
+		 * @brief Park state, see `fiber_scheduler::park()`.
+		*/
+		std::atomic<uint32_t> state{ running };
+
+		/**
+		 * @brief Set by the fiber before it switches out to park instead of yield.
+		*/
+		bool parking = false;
+	};
+
+	void fiber_scheduler::run(task& _task)
+	{
+		const auto _previous = get_this_thread_task();
+		set_this_thread_task(&_task);
+		try
+		{
+			_task.fib.resume();
+		}
+		catch (const std::exception& _error)
+		{
+			ASX_LOG_ERROR("Fiber exited with an exception : {}", _error.what());
+		}
+		catch (...)
+		{
+			ASX_LOG_ERROR("Fiber exited with an unknown exception");
+		};
+		set_this_thread_task(_previous);
+
+		if (_task.fib.done())
+		{
+			delete &_task;
+			if (this->active_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+			{
+				futex_wake_all(this->active_);
+			};
+			return;
+		};
+
+		if (_task.parking)
+		{
+			// Stays parked unless an unpark already came in while it was switching out
+			_task.parking = false;
+			auto _state = task::running;
+			if (_task.state.compare_exchange_strong(_state, task::parked, std::memory_order_acq_rel, std::memory_order_acquire))
+			{
+				return;
+			};
+			_task.state.store(task::running, std::memory_order_relaxed);
+		};
+		this->pool_->submit(_task);
+	};
+
+	void fiber_scheduler::spawn(std::function<void()> _fn)
+	{
+		this->active_.fetch_add(1, std::memory_order_relaxed);
+		this->pool_->submit(*new task(this, std::move(_fn), *this->stacks_));
+	};
+
+	fiber_scheduler::task* fiber_scheduler::current() noexcept
+	{
+		return get_this_thread_task();
+	};
+
+	void fiber_scheduler::yield()
+	{
+		if (get_this_thread_task())
+		{
+			fiber::yield();
+		}
+		else
+		{
+			std::this_thread::yield();
+		};
+	};
+
+	void fiber_scheduler::park()
+	{
+		const auto _task = get_this_thread_task();
+		if (!_task)
+		{
+			std::this_thread::yield();
+			return;
+		};
+		_task->parking = true;
+		fiber::yield();
+	};
+
+	void fiber_scheduler::unpark(task& _task)
+	{
+		auto _state = _task.state.load(std::memory_order_acquire);
+		while (true)
+		{
+			if (_state == task::notified)
+			{
+				return;
+			}
+			else if (_state == task::parked)
+			{
+				if (_task.state.compare_exchange_weak(_state, task::running, std::memory_order_acq_rel, std::memory_order_acquire))
+				{
+					_task.scheduler->pool_->submit(_task);
+					return;
+				};
+			}
+			else if (_task.state.compare_exchange_weak(_state, task::notified, std::memory_order_acq_rel, std::memory_order_acquire))
+			{
+				return;
+			};
+		};
+	};
+
+	void fiber_scheduler::wait_idle()
+	{
+		while (true)
+		{
+			const auto _active = this->active_.load(std::memory_order_acquire);
+			if (_active == 0)
+			{
+				break;
+			};
+			futex_wait(this->active_, _active);
+		};
+	};
+
+	fiber_scheduler::fiber_scheduler(thread_pool& _pool, fiber_stack_pool& _stacks) :
+		pool_(&_pool),
+		stacks_(&_stacks)
+	{};
+
+	fiber_scheduler::~fiber_scheduler()
+	{
+		this->wait_idle();
+	};
+};
+
+namespace asx
+{
+	void fiber_mutex::lock()
+	{
+		auto _waiter = waiter{};
+		{
+			const auto lck = std::unique_lock(this->mtx_);
+			if (!this->locked_)
+			{
+				this->locked_ = true;
+				return;
+			};
+
+			_waiter.task = fiber_scheduler::current();
+			if (this->tail_)
+			{
+				this->tail_->next = &_waiter;
+			}
+			else
+			{
+				this->head_ = &_waiter;
+			};
+			this->tail_ = &_waiter;
+		};
+
+		// 1 means the unlocker is still touching the waiter, 2 that ownership was handed over
+		while (true)
+		{
+			const auto _ready = _waiter.ready.load(std::memory_order_acquire);
+			if (_ready == 2)
+			{
+				break;
+			}
+			else if (_ready == 1)
+			{
+				// The unlocker may have been preempted, spinning could hold up the core it needs
+				fiber_scheduler::yield();
+			}
+			else if (_waiter.task)
+			{
+				fiber_scheduler::park();
+			}
+			else
+			{
+				futex_wait(_waiter.ready, 0);
+			};
+		};
+	};
+
+	bool fiber_mutex::try_lock()
+	{
+		const auto lck = std::unique_lock(this->mtx_);
+		if (this->locked_)
+		{
+			return false;
+		};
+		this->locked_ = true;
+		return true;
+	};
+
+	void fiber_mutex::unlock()
+	{
+		waiter* _waiter = nullptr;
+		{
+			const auto lck = std::unique_lock(this->mtx_);
+			ASX_CHECK(this->locked_);
+			_waiter = this->head_;
+			if (!_waiter)
+			{
+				this->locked_ = false;
+				return;
+			};
+			this->head_ = _waiter->next;
+			if (!this->head_)
+			{
+				this->tail_ = nullptr;
+			};
+		};
+
+		// Ownership passes straight to the waiter, so the mutex stays locked
+		_waiter->ready.store(1, std::memory_order_release);
+		if (_waiter->task)
+		{
+			fiber_scheduler::unpark(*_waiter->task);
+		}
+		else
+		{
+			futex_wake_one(_waiter->ready);
+		};
+		_waiter->ready.store(2, std::memory_order_release);
+	};
+};
@@ -0,0 +1,108 @@
+#include <asx/futex.hpp>
+
+#include "os.hpp"
+
+#include <cerrno>
+#include <climits>
+#include <algorithm>
+
+#ifdef ASX_OS_WINDOWS
+	#pragma comment(lib, "Synchronization")
+#elif defined(ASX_OS_LINUX)
+	#include <ctime>
+	#include <unistd.h>
+	#include <linux/futex.h>
+	#include <sys/syscall.h>
+#endif
+
+namespace asx
+{
+#ifdef ASX_OS_LINUX
+	inline long futex_call(const futex_word& _word, int _op, uint32_t _value, const timespec* _timeout, bool _shared)
+	{
+		if (!_shared)
+		{
+			_op |= FUTEX_PRIVATE_FLAG;
+		};
+		return ::syscall(SYS_futex, reinterpret_cast<const uint32_t*>(&_word), _op, _value, _timeout, nullptr, 0);
+	};
+#endif
+
+	void futex_wait(const futex_word& _word, uint32_t _expected, bool _shared)
+	{
+#ifdef ASX_OS_WINDOWS
+		if (_shared)
+		{
+			// WaitOnAddress can't see wakes from other processes, poll instead
+			if (_word.load(std::memory_order_relaxed) == _expected)
+			{
+				Sleep(1);
+			};
+			return;
+		};
+		WaitOnAddress(const_cast<futex_word*>(&_word), &_expected, sizeof(_expected), INFINITE);
+#else
+		futex_call(_word, FUTEX_WAIT, _expected, nullptr, _shared);
+#endif
+	};
+
+	bool futex_wait_for(const futex_word& _word, uint32_t _expected, std::chrono::nanoseconds _timeout, bool _shared)
+	{
+		if (_timeout.count() <= 0)
+		{
+			return _word.load(std::memory_order_relaxed) != _expected;
+		};
+
+#ifdef ASX_OS_WINDOWS
+		const auto _ms = std::chrono::ceil<std::chrono::milliseconds>(_timeout).count();
+		const auto _waitMs = static_cast<DWORD>(std::min<long long>(_ms, INFINITE - 1));
+		if (_shared)
+		{
+			// WaitOnAddress can't see wakes from other processes, poll instead
+			if (_word.load(std::memory_order_relaxed) == _expected)
+			{
+				Sleep(std::min<DWORD>(_waitMs, 1));
+			};
+			return _waitMs > 1 || _word.load(std::memory_order_relaxed) != _expected;
+		};
+		if (!WaitOnAddress(const_cast<futex_word*>(&_word), &_expected, sizeof(_expected), _waitMs))
+		{
+			return GetLastError() != ERROR_TIMEOUT;
+		};
+		return true;
+#else
+		const auto _seconds = std::chrono::duration_cast<std::chrono::seconds>(_timeout);
+		const auto _time = timespec
+		{
+			.tv_sec = static_cast<time_t>(_seconds.count()),
+			.tv_nsec = static_cast<long>((_timeout - _seconds).count())
+		};
+		const auto _result = futex_call(_word, FUTEX_WAIT, _expected, &_time, _shared);
+		return !(_result == -1 && errno == ETIMEDOUT);
+#endif
+	};
+
+	void futex_wake_one(const futex_word& _word, bool _shared)
+	{
+#ifdef ASX_OS_WINDOWS
+		if (!_shared)
+		{
+			WakeByAddressSingle(const_cast<futex_word*>(&_word));
+		};
+#else
+		futex_call(_word, FUTEX_WAKE, 1, nullptr, _shared);
+#endif
+	};
+
+	void futex_wake_all(const futex_word& _word, bool _shared)
+	{
+#ifdef ASX_OS_WINDOWS
+		if (!_shared)
+		{
+			WakeByAddressAll(const_cast<futex_word*>(&_word));
+		};
+#else
+		futex_call(_word, FUTEX_WAKE, INT_MAX, nullptr, _shared);
+#endif
+	};
+};
@@ -0,0 +1,211 @@
+#include <asx/hazard_pointer.hpp>
+
+#include <utility>
+#include <algorithm>
+
+namespace asx
+{
+	/**
+	 * @brief Retired object lists of the calling thread, one per domain used.
+	*/
+	struct hazard_thread_state
+	{
+		struct domain_list
+		{
+			hazard_domain* domain;
+			std::vector<hazard_domain::retired_object> retired;
+		};
+
+		std::vector<domain_list> lists;
+
+		std::vector<hazard_domain::retired_object>& list_for(hazard_domain& _domain)
+		{
+			for (auto& _list : this->lists)
+			{
+				if (_list.domain == &_domain)
+				{
+					return _list.retired;
+				};
+			};
+			return this->lists.emplace_back(domain_list{ &_domain, {} }).retired;
+		};
+
+		/**
+		 * @brief Forgets a domain that is being destroyed.
+		*/
+		void forget(hazard_domain& _domain) noexcept
+		{
+			std::erase_if(this->lists, [&](const domain_list& v) { return v.domain == &_domain; });
+		};
+
+		~hazard_thread_state()
+		{
+			// Reclaim what we can, hand the rest to the domain
+			for (auto& _list : this->lists)
+			{
+				_list.domain->scan(_list.retired);
+				if (!_list.retired.empty())
+				{
+					auto& _domain = *_list.domain;
+					const auto lck = std::unique_lock(_domain.orphans_mtx_);
+					_domain.orphans_.insert(_domain.orphans_.end(), _list.retired.begin(), _list.retired.end());
+					_domain.has_orphans_.store(true, std::memory_order_release);
+				};
+			};
+		};
+	};
+
+	inline hazard_thread_state& this_thread_hazard_state()
+	{
+		thread_local hazard_thread_state _state{};
+		return _state;
+	};
+
+
+
+	hazard_record* hazard_domain::acquire_record()
+	{
+		// Reuse a released record if there is one
+		for (auto _record = this->records_.load(std::memory_order_acquire); _record; _record = _record->next)
+		{
+			if (!_record->active.load(std::memory_order_relaxed) && !_record->active.exchange(true, std::memory_order_acquire))
+			{
+				return _record;
+			};
+		};
+
+		auto _record = new hazard_record{};
+		_record->active.store(true, std::memory_order_relaxed);
+
+		auto _head = this->records_.load(std::memory_order_relaxed);
+		do
+		{
+			_record->next = _head;
+		} while (!this->records_.compare_exchange_weak(_head, _record, std::memory_order_release, std::memory_order_relaxed));
+
+		this->record_count_.fetch_add(1, std::memory_order_relaxed);
+		return _record;
+	};
+
+	void hazard_domain::release_record(hazard_record* _record) noexcept
+	{
+		_record->hazard.store(nullptr, std::memory_order_release);
+		_record->active.store(false, std::memory_order_release);
+	};
+
+	void hazard_domain::scan(std::vector<retired_object>& _retired)
+	{
+		// Adopt anything left behind by exited threads
+		if (this->has_orphans_.load(std::memory_order_acquire))
+		{
+			const auto lck = std::unique_lock(this->orphans_mtx_);
+			_retired.insert(_retired.end(), this->orphans_.begin(), this->orphans_.end());
+			this->orphans_.clear();
+			this->has_orphans_.store(false, std::memory_order_relaxed);
+		};
+
+		// Snapshot every published hazard, sorted for binary searching
+		auto _hazards = std::vector<void*>();
+		_hazards.reserve(this->slot_count());
+		for (auto _record = this->records_.load(std::memory_order_acquire); _record; _record = _record->next)
+		{
+			if (const auto _ptr = _record->hazard.load(std::memory_order_seq_cst); _ptr)
+			{
+				_hazards.push_back(_ptr);
+			};
+		};
+		std::sort(_hazards.begin(), _hazards.end());
+
+		const auto _protected = std::partition(_retired.begin(), _retired.end(), [&](const retired_object& v)
+		{
+			return std::binary_search(_hazards.begin(), _hazards.end(), v.ptr);
+		});
+
+		// Copy out first, deleters may retire more objects into this same list
+		auto _reclaimable = std::vector<retired_object>(_protected, _retired.end());
+		_retired.erase(_protected, _retired.end());
+		for (auto& v : _reclaimable)
+		{
+			v.deleter(v.ptr);
+		};
+	};
+
+	void hazard_domain::retire(void* _ptr, deleter_type _deleter)
+	{
+		auto& _retired = this_thread_hazard_state().list_for(*this);
+		_retired.push_back(retired_object{ _ptr, _deleter });
+
+		// Scanning costs O(slots), only do it once that is amortized over enough retirements
+		const auto _threshold = HAZARD_SCAN_THRESHOLD_MIN + 2 * this->slot_count();
+		if (_retired.size() >= _threshold)
+		{
+			this->scan(_retired);
+		};
+	};
+
+	void hazard_domain::reclaim()
+	{
+		this->scan(this_thread_hazard_state().list_for(*this));
+	};
+
+	hazard_domain::~hazard_domain()
+	{
+		// Nothing can be protected anymore, delete everything
+		auto& _state = this_thread_hazard_state();
+		auto& _retired = _state.list_for(*this);
+		_retired.insert(_retired.end(), this->orphans_.begin(), this->orphans_.end());
+		for (auto& v : _retired)
+		{
+			v.deleter(v.ptr);
+		};
+		_state.forget(*this);
+
+		auto _record = this->records_.load(std::memory_order_relaxed);
+		while (_record)
+		{
+			const auto _next = _record->next;
+			delete _record;
+			_record = _next;
+		};
+	};
+
+	hazard_domain& default_hazard_domain()
+	{
+		// Leaked so it outlives every thread_local that may still retire into it
+		static auto _domain = new hazard_domain();
+		return *_domain;
+	};
+
+
+
+	hazard_pointer::hazard_pointer(hazard_domain& _domain) :
+		domain_(&_domain),
+		record_(_domain.acquire_record())
+	{};
+
+	hazard_pointer::hazard_pointer(hazard_pointer&& other) noexcept :
+		domain_(other.domain_),
+		record_(std::exchange(other.record_, nullptr))
+	{};
+
+	hazard_pointer& hazard_pointer::operator=(hazard_pointer&& other) noexcept
+	{
+		if (this == &other) { return *this; };
+
+		if (this->record_)
+		{
+			this->domain_->release_record(this->record_);
+		};
+		this->domain_ = other.domain_;
+		this->record_ = std::exchange(other.record_, nullptr);
+		return *this;
+	};
+
+	hazard_pointer::~hazard_pointer()
+	{
+		if (this->record_)
+		{
+			this->domain_->release_record(this->record_);
+		};
+	};
+};
@@ -0,0 +1,189 @@
+#include <asx/log_index.hpp>
+
+#include <asx/binlog.hpp>
+
+#include <cstring>
+#include <algorithm>
+
+namespace asx
+{
+	std::string log_index_path(std::string_view _logPath)
+	{
+		auto _path = std::string(_logPath);
+		_path.append(".idx");
+		return _path;
+	};
+};
+
+namespace asx
+{
+	bool log_index_writer::open(const char* _path, size_t _interval)
+	{
+		this->close();
+
+		auto _stream = std::ofstream(_path, std::ios::binary | std::ios::trunc);
+		if (!_stream.is_open())
+		{
+			return false;
+		};
+
+		const auto _header = log_index_header
+		{
+			.magic = LOG_INDEX_MAGIC,
+			.version = 1,
+			.byte_order = binlog::BYTE_ORDER_MARKER,
+			.reserved = 0,
+			.interval = _interval,
+			.reserved2 = 0
+		};
+		_stream.write(reinterpret_cast<const char*>(&_header), sizeof(_header));
+		_stream.flush();
+
+		this->file_ = std::move(_stream);
+		this->interval_ = std::max<size_t>(_interval, 1);
+		this->next_offset_ = 0;
+		this->last_timestamp_ = 0;
+		return true;
+	};
+
+	void log_index_writer::close()
+	{
+		if (this->file_.is_open())
+		{
+			this->file_.close();
+		};
+	};
+
+	void log_index_writer::add(uint64_t _timestamp, uint64_t _offset, bool _force)
+	{
+		if (!this->file_.is_open() || (!_force && _offset < this->next_offset_))
+		{
+			return;
+		};
+
+		// Keep timestamps monotonic so the index stays searchable if the clock steps back
+		this->last_timestamp_ = std::max(this->last_timestamp_, _timestamp);
+
+		const auto _entry = log_index_entry
+		{
+			.timestamp = this->last_timestamp_,
+			.offset = _offset
+		};
+		this->file_.write(reinterpret_cast<const char*>(&_entry), sizeof(_entry));
+		this->file_.flush();
+		this->next_offset_ = _offset + this->interval_;
+	};
+};
+
+namespace asx
+{
+	bool log_index::open(const char* _path)
+	{
+		// A missing index isn't an error, don't let mapped_file report it
+		if (mapped_file::file_size(_path) == mapped_file::npos)
+		{
+			return false;
+		};
+
+		if (!this->file_.open(_path) || !this->file_.is_open())
+		{
+			return false;
+		};
+
+		auto _header = log_index_header{};
+		const auto _data = this->file_.data();
+		if (_data.size() < sizeof(_header))
+		{
+			this->file_.close();
+			return false;
+		};
+		std::memcpy(&_header, _data.data(), sizeof(_header));
+
+		if (_header.magic != LOG_INDEX_MAGIC || _header.byte_order != binlog::BYTE_ORDER_MARKER)
+		{
+			this->file_.close();
+			return false;
+		};
+		return true;
+	};
+
+	size_t log_index::size() const noexcept
+	{
+		if (!this->file_.is_open())
+		{
+			return 0;
+		};
+
+		// A partially written trailing entry is ignored
+		return (this->file_.size() - sizeof(log_index_header)) / sizeof(log_index_entry);
+	};
+
+	log_index_entry log_index::entry(size_t _index) const
+	{
+		auto _entry = log_index_entry{};
+		const auto _offset = sizeof(log_index_header) + _index * sizeof(log_index_entry);
+		std::memcpy(&_entry, this->file_.data().data() + _offset, sizeof(_entry));
+		return _entry;
+	};
+
+	log_index::byte_range log_index::find_range(uint64_t _timeBegin, uint64_t _timeEnd, uint64_t _logSize) const
+	{
+		const auto _count = this->size();
+
+		// Index of the first entry satisfying a predicate that is false then true across the entries
+		const auto _partitionPoint = [&](auto&& _pred)
+		{
+			size_t _low = 0;
+			size_t _high = _count;
+			while (_low < _high)
+			{
+				const auto _mid = _low + (_high - _low) / 2;
+				if (_pred(this->entry(_mid)))
+				{
+					_high = _mid;
+				}
+				else
+				{
+					_low = _mid + 1;
+				};
+			};
+			return _low;
+		};
+
+		auto _range = byte_range{ 0, _logSize };
+
+		// Begin at the last entry before the window, everything before it is older than the window
+		const auto _firstInWindow = _partitionPoint([&](const log_index_entry& e) { return e.timestamp >= _timeBegin; });
+		if (_firstInWindow != 0)
+		{
+			_range.begin = std::min(this->entry(_firstInWindow - 1).offset, _logSize);
+		};
+
+		// End at the first entry after the window, everything after it is newer than the window
+		const auto _firstAfterWindow = _partitionPoint([&](const log_index_entry& e) { return e.timestamp > _timeEnd; });
+		if (_firstAfterWindow != _count)
+		{
+			_range.end = std::clamp(this->entry(_firstAfterWindow).offset, _range.begin, _logSize);
+		};
+
+		return _range;
+	};
+
+	mapped_file map_log_time_range(const char* _logPath, uint64_t _timeBegin, uint64_t _timeEnd)
+	{
+		const auto _logSize = mapped_file::file_size(_logPath);
+		if (_logSize == mapped_file::npos)
+		{
+			return mapped_file(_logPath);
+		};
+
+		auto _index = log_index{};
+		if (!_index.open(log_index_path(_logPath).c_str()))
+		{
+			return mapped_file(_logPath);
+		};
+
+		const auto _range = _index.find_range(_timeBegin, _timeEnd, _logSize);
+		return mapped_file(_logPath, _range.begin, static_cast<size_t>(_range.end - _range.begin));
+	};
+};
@@ -1,15 +1,25 @@
 #include <asx/logging.hpp>
 
-#include <asx/exclusive.hpp>
+#include "os.hpp"
+#include <asx/encoding.hpp>
+#include <asx/log_index.hpp>
 
 #include <span>
 #include <mutex>
+#include <atomic>
+#include <chrono>
+#include <concepts>
 #include <string>
 #include <fstream>
 #include <ostream>
 #include <sstream>
-#include <iostream>
 #include <optional>
+#include <cstdio>
+#include <cerrno>
+
+#ifdef ASX_OS_LINUX
+	#include <unistd.h>
+#endif
 
 namespace asx
 {
@@ -56,53 +66,142 @@ namespace asx
 	};
 
 
-	struct osyncstream
+	/**
+	 * @brief Writes complete records straight to the standard output handle, bypassing iostreams.
+	 *
+	 * Terminals get one write per record so output shows up immediately. Other outputs
+	 * (pipes, files) collect records into batches which are written once they grow past
+	 * `BATCH_SIZE_REDIRECTED`, on `flush()`, or on destruction.
+	 *
+	 * This is NOT thread safe, it is driven under the logging system's mutex.
+	*/
+	class console_sink
 	{
 	public:
-		using stream_type = std::ostream;
-		using mutex_type = std::mutex;
 
-		template <typename T>
-		requires requires(stream_type& s, const T& v)
-		{
-			{ s << v } -> std::same_as<std::ostream&>;
-		}
-		friend inline osyncstream& operator<<(osyncstream& _ostr, const T& v)
+		/**
+		 * @brief Number of buffered bytes that triggers a write when the output isn't a terminal.
+		*/
+		constexpr static size_t BATCH_SIZE_REDIRECTED = 64 * 1024;
+
+		/**
+		 * @brief Checks if the output is a terminal.
+		*/
+		bool is_terminal() const noexcept
 		{
-			auto p = _ostr.stream_.get();
-			**p << v;
-			return _ostr;
+			return this->is_terminal_;
 		};
-	
-		std::streambuf* rdbuf(std::streambuf* _buf) const
+
+		/**
+		 * @brief Writes or batches a complete record.
+		 * @param _record Record bytes, including any color codes and the trailing newline.
+		 * @param _flush Writes the record (and anything batched) out immediately.
+		*/
+		void write(std::string_view _record, bool _flush)
 		{
-			return this->stream_->get()->rdbuf(_buf);
+			if (this->batch_.empty() && (this->is_terminal_ || _flush))
+			{
+				this->write_out(_record);
+				return;
+			};
+
+			this->batch_.append(_record);
+			if (_flush || this->is_terminal_ || this->batch_.size() >= BATCH_SIZE_REDIRECTED)
+			{
+				this->flush();
+			};
 		};
 
-		auto stream()
+		/**
+		 * @brief Writes out any batched records.
+		*/
+		void flush()
 		{
-			return this->stream_.get();
+			if (!this->batch_.empty())
+			{
+				this->write_out(this->batch_);
+				this->batch_.clear();
+			};
 		};
 
-		explicit osyncstream(std::streambuf* _buf) :
-			stream_(std::make_unique<stream_type>(_buf))
-		{};
+		console_sink()
+		{
+#ifdef ASX_OS_WINDOWS
+			this->handle_ = GetStdHandle(STD_OUTPUT_HANDLE);
+			DWORD _mode{};
+			this->is_terminal_ = GetConsoleMode(this->handle_, &_mode) != 0;
+#else
+			this->is_terminal_ = ::isatty(STDOUT_FILENO) != 0;
+#endif
+			if (!this->is_terminal_)
+			{
+				this->batch_.reserve(BATCH_SIZE_REDIRECTED * 2);
+			};
+		};
+		~console_sink()
+		{
+			this->flush();
+		};
 
 	private:
-		asx::exclusive<std::unique_ptr<stream_type>, mutex_type> stream_;
+
+		void write_out(std::string_view _bytes)
+		{
+			// Anything written through stdio/iostreams must come out before our bytes
+			std::fflush(stdout);
+
+#ifdef ASX_OS_WINDOWS
+			while (!_bytes.empty())
+			{
+				DWORD _written{};
+				if (!WriteFile(this->handle_, _bytes.data(), static_cast<DWORD>(_bytes.size()), &_written, NULL) || _written == 0)
+				{
+					return;
+				};
+				_bytes.remove_prefix(_written);
+			};
+#else
+			while (!_bytes.empty())
+			{
+				const auto _written = ::write(STDOUT_FILENO, _bytes.data(), _bytes.size());
+				if (_written < 0)
+				{
+					if (errno == EINTR)
+					{
+						continue;
+					};
+					return;
+				};
+				_bytes.remove_prefix(static_cast<size_t>(_written));
+			};
+#endif
+		};
+
+		/**
+		 * @brief Records waiting to be written, always empty for terminals.
+		*/
+		std::string batch_;
+
+#ifdef ASX_OS_WINDOWS
+		HANDLE handle_ = INVALID_HANDLE_VALUE;
+#endif
+		bool is_terminal_ = false;
 	};
 
 	struct LoggingSystem
 	{
 		std::mutex mtx_{};
 		std::ofstream file_stream_;
-		osyncstream stream_;
+		log_index_writer file_index_;
+		uint64_t file_offset_ = 0;
+		size_t file_index_interval_ = LOG_INDEX_INTERVAL_DEFAULT;
+		binlog::writer binary_log_;
+		std::atomic<bool> has_binary_log_{ false };
+		console_sink console_;
 		LogLevel logging_level_ = LogLevel::all;
 		bool ansi_colors_ = false;
 
-		LoggingSystem() :
-			stream_(std::cout.rdbuf())
-		{};
+		LoggingSystem() = default;
 	};
 
 	inline LoggingSystem& logging_system()
@@ -141,7 +240,8 @@ namespace asx
 
 	void set_log_file(const char* _path)
 	{
-		auto _stream = std::ofstream(_path);
+		// Binary so newlines aren't translated on Windows, index offsets count the bytes actually written
+		auto _stream = std::ofstream(_path, std::ios::binary | std::ios::trunc);
 		if (!_stream.is_open())
 		{
 			ASX_LOG_ERROR("Failed to create/open logging file at path \"{}\"", _path);
@@ -152,16 +252,48 @@ namespace asx
 		{
 			const auto lck = std::unique_lock(_system.mtx_);
 			_system.file_stream_ = std::move(_stream);
+			_system.file_offset_ = 0;
+
+			_system.file_index_.close();
+			if (_system.file_index_interval_ != 0)
+			{
+				_system.file_index_.open(log_index_path(_path).c_str(), _system.file_index_interval_);
+			};
 		};
 		ASX_LOG_INFO("Set logging file path to \"{}\"", _path);
 	};
 
+	void set_log_index_interval(size_t _bytes)
+	{
+		auto& _system = logging_system();
+		const auto lck = std::unique_lock(_system.mtx_);
+		_system.file_index_interval_ = _bytes;
+	};
+
+	void flush_log()
+	{
+		auto& _system = logging_system();
+		{
+			const auto lck = std::unique_lock(_system.mtx_);
+			_system.console_.flush();
+			if (_system.file_stream_.is_open())
+			{
+				_system.file_stream_.flush();
+			};
+		};
+		if (has_binary_log_file())
+		{
+			_system.binary_log_.flush();
+		};
+	};
+
 	void close_log_file()
 	{
 		auto& _system = logging_system();
 		{
 			const auto lck = std::unique_lock(_system.mtx_);
 			_system.file_stream_.close();
+			_system.file_index_.close();
 		};
 	};
 
@@ -172,11 +304,61 @@ namespace asx
 		return _system.file_stream_.is_open();
 	};
 
-	template <typename OT, typename T>
-	inline OT& write(OT& _ostream, const T& _value)
+	void set_binary_log_file(const char* _path, bool _compressed)
+	{
+		auto& _system = logging_system();
+		if (!_system.binary_log_.open(_path))
+		{
+			ASX_LOG_ERROR("Failed to create/open binary logging file at path \"{}\"", _path);
+			return;
+		};
+		_system.binary_log_.set_compression(_compressed);
+		_system.has_binary_log_.store(true, std::memory_order_release);
+		ASX_LOG_INFO("Set binary logging file path to \"{}\"", _path);
+	};
+
+	void close_binary_log_file()
 	{
-		_ostream << _value;
-		return _ostream;
+		auto& _system = logging_system();
+		_system.has_binary_log_.store(false, std::memory_order_release);
+		_system.binary_log_.close();
+	};
+
+	bool has_binary_log_file()
+	{
+		auto& _system = logging_system();
+		return _system.has_binary_log_.load(std::memory_order_relaxed);
+	};
+
+	/**
+	 * @brief UTF-8 encoding of U+FFFD, written in place of bytes that aren't valid UTF-8.
+	*/
+	constexpr std::string_view UTF8_REPLACEMENT_CHARACTER = "\xEF\xBF\xBD";
+
+	/**
+	 * @brief Appends a message part to a record buffer.
+	 *
+	 * Bytes that aren't valid UTF-8 are replaced so the console and log file always get valid text.
+	*/
+	template <typename T>
+	inline void append_part(std::string& _buffer, const T& _part)
+	{
+		if constexpr (std::same_as<T, char>)
+		{
+			_buffer.push_back(_part);
+		}
+		else
+		{
+			auto _text = std::string_view(_part);
+			size_t _validSize = 0;
+			while (!asx::utf8_validate(_text, &_validSize))
+			{
+				_buffer.append(_text.substr(0, _validSize));
+				_buffer.append(UTF8_REPLACEMENT_CHARACTER);
+				_text.remove_prefix(_validSize + 1);
+			};
+			_buffer.append(_text);
+		};
 	};
 
 
@@ -209,38 +391,145 @@ namespace asx
 
 
 
-	inline void append_parts_log(const LogMessageParams& _params, const auto&... _parts)
+	/**
+	 * @brief Writes a record to the console and log file.
+	 *
+	 * The record is assembled (color, text, reset) in a per-thread buffer before the lock is
+	 * taken, so the console gets a single write and the log file gets the uncolored text.
+	 *
+	 * @param _params Message params.
+	 * @param _flush Writes out batched console output, used for messages that may be the last ones logged.
+	 * @param _parts Pieces of the message text.
+	*/
+	inline void append_parts_log(const LogMessageParams& _params, bool _flush, const auto&... _parts)
 	{
 		auto& _system = logging_system();
-		auto _lockedStream = _system.stream_.stream();
-		auto& _stream = *_lockedStream.get()->get();
-
-		auto& _fstream = _system.file_stream_;
-		const auto lck = std::unique_lock(_system.mtx_);
-		ASX_ASSERT(_system.file_stream_);
-
 		const auto _useAnsiColors = _system.ansi_colors_;
+
+		thread_local auto _buffer = std::string();
+		_buffer.clear();
+		if (_useAnsiColors)
+		{
+			_buffer.append(_params.ansi_color);
+		};
+		const auto _textBegin = _buffer.size();
+		(asx::append_part(_buffer, _parts), ...);
+		const auto _textSize = _buffer.size() - _textBegin;
 		if (_useAnsiColors)
 		{
-			asx::write(_stream, _params.ansi_color);
+			_buffer.append(RESET_COLOR_ANSI);
 		};
+		const auto _text = std::string_view(_buffer).substr(_textBegin, _textSize);
+
+		const auto lck = std::unique_lock(_system.mtx_);
+		_system.console_.write(_buffer, _flush);
 
-		(asx::write(_stream, _parts), ...);
+		auto& _fstream = _system.file_stream_;
 		if (_fstream.is_open())
 		{
-			(asx::write(_fstream, _parts), ...);
+			namespace ch = std::chrono;
+			const auto _timestamp = static_cast<uint64_t>(
+				ch::duration_cast<ch::nanoseconds>(ch::system_clock::now().time_since_epoch()).count()
+			);
+			_system.file_index_.add(_timestamp, _system.file_offset_);
+
+			// Flushed per record whatever the console is, so a crash doesn't lose buffered lines
+			_fstream.write(_text.data(), static_cast<std::streamsize>(_text.size()));
 			_fstream.flush();
+			_system.file_offset_ += _text.size();
 		};
+	};
 
-		if (_useAnsiColors)
+	void append_log(const LogMessageParams& _params, std::string_view _message)
+	{
+		append_parts_log(_params, false, _message, '\n');
+	};
+
+
+
+	inline const LogMessageParams& log_message_params(LogLevel _level)
+	{
+		switch (_level)
 		{
-			asx::write(_stream, RESET_COLOR_ANSI);
+		case LogLevel::fatal:
+			return FATAL_ERROR_MESSAGE_PARAMS;
+		case LogLevel::error:
+			return ERROR_MESSAGE_PARAMS;
+		case LogLevel::warn:
+			return WARNING_MESSAGE_PARAMS;
+		default:
+			return INFO_MESSAGE_PARAMS;
 		};
 	};
 
-	void append_log(const LogMessageParams& _params, std::string_view _message)
+	inline const char* log_message_prefix(LogLevel _level)
+	{
+		switch (_level)
+		{
+		case LogLevel::fatal:
+			return "[FATAL] ";
+		case LogLevel::error:
+			return "[Error] ";
+		case LogLevel::warn:
+			return "[Warning] ";
+		default:
+			return "[Info] ";
+		};
+	};
+
+	namespace impl
 	{
-		append_parts_log(_params, _message, '\n');
+		void write_binary_log(LogLevel _level, const callsite* _site, std::string_view _fmt, std::string_view _encodedArgs, size_t _argCount)
+		{
+			auto& _system = logging_system();
+			if (_site)
+			{
+				// Records from logging macros reference a call site entry rather than just their format
+				const auto _location = SourceLocation(_site->file(), _site->function(), _site->line());
+				_system.binary_log_.write(static_cast<uint8_t>(_level), &_location, _fmt, _encodedArgs, _argCount);
+			}
+			else
+			{
+				_system.binary_log_.write(static_cast<uint8_t>(_level), nullptr, _fmt, _encodedArgs, _argCount);
+			};
+
+			// Fatal errors are likely the last thing logged, don't leave them buffered
+			if (_level == LogLevel::fatal)
+			{
+				_system.binary_log_.flush();
+			};
+		};
+
+		void append_text_log(LogLevel _level, std::string_view _message)
+		{
+			append_parts_log(log_message_params(_level), _level <= LogLevel::error, log_message_prefix(_level), _message, '\n');
+		};
+
+		void append_text_log(LogLevel _level, const StackTraceView& _trace, std::string_view _message)
+		{
+			append_parts_log(log_message_params(_level), _level <= LogLevel::error, log_message_prefix(_level), _message, '\n', stringify_stack_trace(_trace), '\n');
+		};
+	};
+
+	namespace impl
+	{
+		void log_message(LogLevel _level, const callsite* _site, std::string_view _message)
+		{
+			if (has_binary_log_file())
+			{
+				impl::append_binary_log(_level, _site, "{}", _message);
+			};
+			impl::append_text_log(_level, _message);
+		};
+
+		void log_message(LogLevel _level, const callsite* _site, const StackTraceView& _trace, std::string_view _message)
+		{
+			if (has_binary_log_file())
+			{
+				impl::append_binary_log(_level, _site, "{}", _message);
+			};
+			impl::append_text_log(_level, _trace, _message);
+		};
 	};
 
 
@@ -249,7 +538,7 @@ namespace asx
 	{
 		if (get_logging_level() >= LogLevel::info)
 		{
-			append_parts_log(INFO_MESSAGE_PARAMS, "[Info] ", _message, '\n');
+			impl::log_message(LogLevel::info, nullptr, _message);
 		};
 	};
 
@@ -257,7 +546,7 @@ namespace asx
 	{
 		if (get_logging_level() >= LogLevel::warn)
 		{
-			append_parts_log(WARNING_MESSAGE_PARAMS, "[Warning] ", _message, '\n');
+			impl::log_message(LogLevel::warn, nullptr, _message);
 		};
 	};
 
@@ -265,14 +554,14 @@ namespace asx
 	{
 		if (get_logging_level() >= LogLevel::error)
 		{
-			append_parts_log(ERROR_MESSAGE_PARAMS, "[Error] ", _message, '\n');
+			impl::log_message(LogLevel::error, nullptr, _message);
 		};
 	};
 	void log_error(const StackTraceView& _trace, std::string_view _message)
 	{
 		if (get_logging_level() >= LogLevel::error)
 		{
-			append_parts_log(ERROR_MESSAGE_PARAMS, "[Error] ", _message, '\n', stringify_stack_trace(_trace), '\n');
+			impl::log_message(LogLevel::error, nullptr, _trace, _message);
 		};
 	};
 
@@ -280,7 +569,7 @@ namespace asx
 	{
 		if (get_logging_level() >= LogLevel::fatal)
 		{
-			append_parts_log(FATAL_ERROR_MESSAGE_PARAMS, "[FATAL] ", _message, '\n', stringify_stack_trace(_trace), '\n');
+			impl::log_message(LogLevel::fatal, nullptr, _trace, _message);
 		};
 	};
 };
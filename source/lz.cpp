@@ -0,0 +1,585 @@
+#include <asx/lz.hpp>
+
+#include <asx/assert.hpp>
+
+#include <bit>
+#include <limits>
+#include <cstring>
+#include <algorithm>
+
+namespace asx::lz
+{
+	namespace
+	{
+		/**
+		 * @brief Number of bytes at the end of a block that are always literals.
+		*/
+		constexpr size_t LAST_LITERALS = 5;
+
+		/**
+		 * @brief No match may start within this many bytes of the end of a block.
+		*/
+		constexpr size_t MATCH_START_LIMIT = 12;
+
+		constexpr size_t HASH_BITS_MAX = 16;
+		constexpr size_t CHAIN_SIZE = MAX_OFFSET + 1;
+
+		/**
+		 * @brief Literal runs longer than `1 << SKIP_SHIFT` start skipping positions, so data that
+		 * doesn't compress is passed over quickly.
+		*/
+		constexpr size_t SKIP_SHIFT = 6;
+
+		inline uint32_t read32(const uint8_t* p) noexcept
+		{
+			uint32_t v;
+			std::memcpy(&v, p, sizeof(v));
+			return v;
+		};
+
+		inline uint64_t read64(const uint8_t* p) noexcept
+		{
+			uint64_t v;
+			std::memcpy(&v, p, sizeof(v));
+			return v;
+		};
+
+		inline void put_le32(uint8_t* p, uint32_t _value) noexcept
+		{
+			p[0] = static_cast<uint8_t>(_value);
+			p[1] = static_cast<uint8_t>(_value >> 8);
+			p[2] = static_cast<uint8_t>(_value >> 16);
+			p[3] = static_cast<uint8_t>(_value >> 24);
+		};
+
+		inline uint32_t get_le32(const uint8_t* p) noexcept
+		{
+			return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+				(static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+		};
+
+		/**
+		 * @brief Counts the bytes two positions have in common, without reading at or past `_end`.
+		*/
+		inline size_t count_common(const uint8_t* _lhs, const uint8_t* _rhs, const uint8_t* _end) noexcept
+		{
+			const auto _begin = _rhs;
+			while (_end - _rhs >= 8)
+			{
+				const auto _diff = read64(_lhs) ^ read64(_rhs);
+				if (_diff != 0)
+				{
+					const auto _bits = (std::endian::native == std::endian::little) ? std::countr_zero(_diff) : std::countl_zero(_diff);
+					return static_cast<size_t>(_rhs - _begin) + static_cast<size_t>(_bits / 8);
+				};
+				_lhs += 8;
+				_rhs += 8;
+			};
+			while (_rhs < _end && *_lhs == *_rhs)
+			{
+				++_lhs;
+				++_rhs;
+			};
+			return static_cast<size_t>(_rhs - _begin);
+		};
+
+		/**
+		 * @brief Writes the continuation of a length that didn't fit in its token nibble.
+		*/
+		inline uint8_t* write_length(uint8_t* _op, size_t _length) noexcept
+		{
+			while (_length >= 255)
+			{
+				*_op++ = 255;
+				_length -= 255;
+			};
+			*_op++ = static_cast<uint8_t>(_length);
+			return _op;
+		};
+
+		/**
+		 * @brief Reads the continuation of a length, adding it to `_length`.
+		*/
+		inline bool read_length(const uint8_t*& _ip, const uint8_t* _iend, size_t& _length) noexcept
+		{
+			uint8_t _byte;
+			do
+			{
+				if (_ip == _iend)
+				{
+					return false;
+				};
+				_byte = *_ip++;
+				_length += _byte;
+			} while (_byte == 255);
+			return true;
+		};
+
+		/**
+		 * @brief Hash heads and chain links, kept per thread so compressing doesn't allocate.
+		 *
+		 * Heads hold positions plus one (0 is empty), links hold the distance to the previous
+		 * position with the same hash (0 ends the chain).
+		*/
+		struct match_tables
+		{
+			std::vector<uint32_t> heads = std::vector<uint32_t>(size_t(1) << HASH_BITS_MAX);
+			std::vector<uint16_t> links = std::vector<uint16_t>(CHAIN_SIZE);
+		};
+
+		inline match_tables& this_thread_match_tables()
+		{
+			thread_local match_tables _tables{};
+			return _tables;
+		};
+
+		/**
+		 * @brief Writes a sequence, returns null if it doesn't fit.
+		*/
+		inline uint8_t* write_sequence(uint8_t* _op, uint8_t* _oend, const uint8_t* _literals, size_t _literalCount, size_t _offset, size_t _matchLength) noexcept
+		{
+			const auto _needed = 1 + (_literalCount / 255 + 1) + _literalCount + 2 + (_matchLength / 255 + 1);
+			if (static_cast<size_t>(_oend - _op) < _needed)
+			{
+				return nullptr;
+			};
+
+			const auto _matchCode = _matchLength - MIN_MATCH;
+			auto& _token = *_op++;
+			_token = static_cast<uint8_t>((std::min<size_t>(_literalCount, 15) << 4) | std::min<size_t>(_matchCode, 15));
+			if (_literalCount >= 15)
+			{
+				_op = write_length(_op, _literalCount - 15);
+			};
+			std::memcpy(_op, _literals, _literalCount);
+			_op += _literalCount;
+
+			*_op++ = static_cast<uint8_t>(_offset);
+			*_op++ = static_cast<uint8_t>(_offset >> 8);
+			if (_matchCode >= 15)
+			{
+				_op = write_length(_op, _matchCode - 15);
+			};
+			return _op;
+		};
+
+		/**
+		 * @brief Writes the final literal only sequence, returns null if it doesn't fit.
+		*/
+		inline uint8_t* write_last_literals(uint8_t* _op, uint8_t* _oend, const uint8_t* _literals, size_t _literalCount) noexcept
+		{
+			const auto _needed = 1 + (_literalCount / 255 + 1) + _literalCount;
+			if (static_cast<size_t>(_oend - _op) < _needed)
+			{
+				return nullptr;
+			};
+
+			*_op++ = static_cast<uint8_t>(std::min<size_t>(_literalCount, 15) << 4);
+			if (_literalCount >= 15)
+			{
+				_op = write_length(_op, _literalCount - 15);
+			};
+			if (_literalCount != 0)
+			{
+				// Skipped when empty, the input may be a null span
+				std::memcpy(_op, _literals, _literalCount);
+			};
+			return _op + _literalCount;
+		};
+	};
+
+	size_t compress_block(std::span<const std::byte> _src, std::span<std::byte> _dst, int _effort)
+	{
+		const auto _begin = reinterpret_cast<const uint8_t*>(_src.data());
+		const auto _size = _src.size();
+		const auto _obegin = reinterpret_cast<uint8_t*>(_dst.data());
+		const auto _oend = _obegin + _dst.size();
+		if (_size >= std::numeric_limits<uint32_t>::max())
+		{
+			return 0;
+		};
+
+		auto _op = _obegin;
+		size_t _anchor = 0;
+		if (_size > MATCH_START_LIMIT)
+		{
+			// Small inputs use fewer hash bits so there is less table to clear
+			const auto _hashBits = std::clamp<size_t>(std::bit_width(_size), 10, HASH_BITS_MAX);
+			const auto _hashShift = 32 - _hashBits;
+			const auto _hash = [_begin, _hashShift](size_t _pos) noexcept
+			{
+				return (read32(_begin + _pos) * 2654435761u) >> _hashShift;
+			};
+
+			auto& _tables = this_thread_match_tables();
+			const auto _heads = _tables.heads.data();
+			const auto _links = _tables.links.data();
+			std::fill_n(_heads, size_t(1) << _hashBits, 0);
+
+			const auto _insert = [&](size_t _pos) noexcept
+			{
+				auto& _head = _heads[_hash(_pos)];
+				const auto _distance = (_head != 0) ? _pos - (_head - 1) : 0;
+				_links[_pos & MAX_OFFSET] = static_cast<uint16_t>((_distance <= MAX_OFFSET) ? _distance : 0);
+				_head = static_cast<uint32_t>(_pos + 1);
+			};
+
+			const auto _matchEnd = _begin + _size - LAST_LITERALS;
+			const auto _searchEnd = _size - MATCH_START_LIMIT;
+			const auto _maxAttempts = std::max(_effort, 1);
+
+			size_t _nextInsert = 0;
+			size_t _pos = 0;
+			while (_pos < _searchEnd)
+			{
+				while (_nextInsert < _pos)
+				{
+					_insert(_nextInsert++);
+				};
+
+				// Walk the chain for the longest match
+				size_t _bestLength = 0;
+				size_t _bestPos = 0;
+				const auto _current = _begin + _pos;
+				const auto _head = _heads[_hash(_pos)];
+				if (_head != 0 && _pos - (_head - 1) <= MAX_OFFSET)
+				{
+					auto _candidate = static_cast<size_t>(_head - 1);
+					for (int _attempts = _maxAttempts; _attempts != 0; --_attempts)
+					{
+						const auto _match = _begin + _candidate;
+						if (read32(_match) == read32(_current) &&
+							(_bestLength == 0 || _current + _bestLength >= _matchEnd || _match[_bestLength] == _current[_bestLength]))
+						{
+							const auto _length = count_common(_match, _current, _matchEnd);
+							if (_length > _bestLength)
+							{
+								_bestLength = _length;
+								_bestPos = _candidate;
+							};
+						};
+
+						const auto _link = _links[_candidate & MAX_OFFSET];
+						if (_link == 0 || _pos - (_candidate - _link) > MAX_OFFSET)
+						{
+							break;
+						};
+						_candidate -= _link;
+					};
+				};
+				_insert(_pos);
+				_nextInsert = _pos + 1;
+
+				if (_bestLength < MIN_MATCH)
+				{
+					_pos += 1 + ((_pos - _anchor) >> SKIP_SHIFT);
+					continue;
+				};
+
+				// Extend the match back into the pending literals
+				while (_pos > _anchor && _bestPos > 0 && _begin[_pos - 1] == _begin[_bestPos - 1])
+				{
+					--_pos;
+					--_bestPos;
+					++_bestLength;
+				};
+
+				_op = write_sequence(_op, _oend, _begin + _anchor, _pos - _anchor, _pos - _bestPos, _bestLength);
+				if (!_op)
+				{
+					return 0;
+				};
+				_pos += _bestLength;
+				_anchor = _pos;
+
+				// Only the tail of a match is added to the chains, indexing all of it costs about half
+				// the speed for a few percent of ratio
+				_nextInsert = std::max(_nextInsert, _pos - 2);
+			};
+		};
+
+		_op = write_last_literals(_op, _oend, _begin + _anchor, _size - _anchor);
+		return _op ? static_cast<size_t>(_op - _obegin) : 0;
+	};
+
+	bool decompress_block(std::span<const std::byte> _src, std::span<std::byte> _dst, size_t& _outSize)
+	{
+		auto _ip = reinterpret_cast<const uint8_t*>(_src.data());
+		const auto _iend = _ip + _src.size();
+		const auto _obegin = reinterpret_cast<uint8_t*>(_dst.data());
+		const auto _oend = _obegin + _dst.size();
+		auto _op = _obegin;
+
+		while (true)
+		{
+			if (_ip == _iend)
+			{
+				return false;
+			};
+			const auto _token = *_ip++;
+
+			// Literals, short runs are copied as one 16 byte word when there is room to spare
+			size_t _literalCount = _token >> 4;
+			if (_literalCount == 15 && !read_length(_ip, _iend, _literalCount))
+			{
+				return false;
+			};
+			const auto _inputLeft = static_cast<size_t>(_iend - _ip);
+			const auto _outputLeft = static_cast<size_t>(_oend - _op);
+			if (_inputLeft < _literalCount || _outputLeft < _literalCount)
+			{
+				return false;
+			};
+			if (_literalCount <= 16 && _inputLeft >= 16 && _outputLeft >= 16)
+			{
+				std::memcpy(_op, _ip, 16);
+			}
+			else if (_literalCount != 0)
+			{
+				// Skipped when empty, the output may be a null span
+				std::memcpy(_op, _ip, _literalCount);
+			};
+			_op += _literalCount;
+			_ip += _literalCount;
+
+			// The last sequence has no match
+			if (_ip == _iend)
+			{
+				break;
+			};
+
+			if (_iend - _ip < 2)
+			{
+				return false;
+			};
+			const auto _offset = static_cast<size_t>(_ip[0]) | (static_cast<size_t>(_ip[1]) << 8);
+			_ip += 2;
+			if (_offset == 0 || _offset > static_cast<size_t>(_op - _obegin))
+			{
+				return false;
+			};
+
+			size_t _matchLength = _token & 15;
+			if (_matchLength == 15 && !read_length(_ip, _iend, _matchLength))
+			{
+				return false;
+			};
+			_matchLength += MIN_MATCH;
+
+			const auto _matchOutputLeft = static_cast<size_t>(_oend - _op);
+			if (_matchOutputLeft < _matchLength)
+			{
+				return false;
+			};
+
+			// Word copies may overrun the match, so they need a word of slack
+			const auto _match = _op - _offset;
+			if (_matchOutputLeft >= _matchLength + 16 && _offset >= 16)
+			{
+				for (size_t n = 0; n < _matchLength; n += 16)
+				{
+					std::memcpy(_op + n, _match + n, 16);
+				};
+			}
+			else if (_matchOutputLeft >= _matchLength + 8 && _offset >= 8)
+			{
+				for (size_t n = 0; n < _matchLength; n += 8)
+				{
+					std::memcpy(_op + n, _match + n, 8);
+				};
+			}
+			else if (_matchOutputLeft >= _matchLength + 8 && _matchLength > 16)
+			{
+				// A short offset repeats a pattern. Once 16 bytes are out, copying from a whole number
+				// of periods back (at least 8 bytes) gives the same bytes and allows word copies.
+				for (size_t n = 0; n != 16; ++n)
+				{
+					_op[n] = _match[n];
+				};
+				const auto _period = _offset * ((8 + _offset - 1) / _offset);
+				for (size_t n = 16; n < _matchLength; n += 8)
+				{
+					std::memcpy(_op + n, _op + n - _period, 8);
+				};
+			}
+			else
+			{
+				for (size_t n = 0; n != _matchLength; ++n)
+				{
+					_op[n] = _match[n];
+				};
+			};
+			_op += _matchLength;
+		};
+
+		_outSize = static_cast<size_t>(_op - _obegin);
+		return true;
+	};
+};
+
+namespace asx::lz
+{
+	namespace
+	{
+		/**
+		 * @brief Appends one frame block, compressed unless that wouldn't make it smaller.
+		*/
+		void append_frame_block(std::span<const std::byte> _data, std::vector<std::byte>& _compressed, int _effort, std::string& _out)
+		{
+			_compressed.resize(compress_bound(_data.size()));
+			const auto _size = compress_block(_data, _compressed, _effort);
+
+			uint8_t _header[4];
+			const auto _stored = _size == 0 || _size >= _data.size();
+			const auto _block = _stored ? _data : std::span<const std::byte>(_compressed.data(), _size);
+			put_le32(_header, static_cast<uint32_t>(_block.size()) | (_stored ? FRAME_BLOCK_STORED : 0));
+			_out.append(reinterpret_cast<const char*>(_header), sizeof(_header));
+			_out.append(reinterpret_cast<const char*>(_block.data()), _block.size());
+		};
+
+		void append_frame_header(size_t _blockSize, std::string& _out)
+		{
+			uint8_t _size[4];
+			put_le32(_size, static_cast<uint32_t>(_blockSize));
+			_out.append(FRAME_MAGIC.data(), FRAME_MAGIC.size());
+			_out.append(reinterpret_cast<const char*>(_size), sizeof(_size));
+		};
+	};
+
+	void frame_writer::write_block()
+	{
+		auto _out = std::string();
+		append_frame_block(this->buffer_, this->compressed_, this->effort_, _out);
+		this->out_->write(_out.data(), static_cast<std::streamsize>(_out.size()));
+		this->buffer_.clear();
+	};
+
+	void frame_writer::write(std::span<const std::byte> _data)
+	{
+		if (this->finished_)
+		{
+			return;
+		};
+
+		while (!_data.empty())
+		{
+			const auto _count = std::min(_data.size(), this->block_size_ - this->buffer_.size());
+			this->buffer_.insert(this->buffer_.end(), _data.begin(), _data.begin() + _count);
+			_data = _data.subspan(_count);
+			if (this->buffer_.size() == this->block_size_)
+			{
+				this->write_block();
+			};
+		};
+	};
+
+	void frame_writer::finish()
+	{
+		if (this->finished_)
+		{
+			return;
+		};
+		if (!this->buffer_.empty())
+		{
+			this->write_block();
+		};
+
+		const char _end[4]{};
+		this->out_->write(_end, sizeof(_end));
+		this->finished_ = true;
+	};
+
+	frame_writer::frame_writer(std::ostream& _out, size_t _blockSize, int _effort) :
+		out_(&_out),
+		block_size_(_blockSize),
+		effort_(_effort)
+	{
+		ASX_CHECK(_blockSize != 0 && _blockSize < FRAME_BLOCK_STORED);
+		this->buffer_.reserve(_blockSize);
+
+		auto _header = std::string();
+		append_frame_header(_blockSize, _header);
+		this->out_->write(_header.data(), static_cast<std::streamsize>(_header.size()));
+	};
+
+	frame_writer::~frame_writer()
+	{
+		this->finish();
+	};
+
+	void compress_frame(std::span<const std::byte> _src, std::string& _out, size_t _blockSize, int _effort)
+	{
+		ASX_CHECK(_blockSize != 0 && _blockSize < FRAME_BLOCK_STORED);
+
+		append_frame_header(_blockSize, _out);
+		auto _compressed = std::vector<std::byte>();
+		while (!_src.empty())
+		{
+			const auto _count = std::min(_src.size(), _blockSize);
+			append_frame_block(_src.first(_count), _compressed, _effort, _out);
+			_src = _src.subspan(_count);
+		};
+		_out.append(4, '\0');
+	};
+
+	bool decompress_frame(std::span<const std::byte> _src, std::string& _out, size_t* _outFrameSize)
+	{
+		const auto _bytes = reinterpret_cast<const uint8_t*>(_src.data());
+		if (_src.size() < 8 || std::memcmp(_bytes, FRAME_MAGIC.data(), FRAME_MAGIC.size()) != 0)
+		{
+			return false;
+		};
+		const auto _blockSize = static_cast<size_t>(get_le32(_bytes + 4));
+		if (_blockSize == 0 || _blockSize >= FRAME_BLOCK_STORED)
+		{
+			return false;
+		};
+
+		size_t _offset = 8;
+		while (true)
+		{
+			if (_src.size() - _offset < 4)
+			{
+				return false;
+			};
+			const auto _header = get_le32(_bytes + _offset);
+			_offset += 4;
+			if (_header == 0)
+			{
+				break;
+			};
+
+			const auto _size = static_cast<size_t>(_header & ~FRAME_BLOCK_STORED);
+			if (_src.size() - _offset < _size)
+			{
+				return false;
+			};
+			const auto _block = _src.subspan(_offset, _size);
+			_offset += _size;
+
+			if (_header & FRAME_BLOCK_STORED)
+			{
+				_out.append(reinterpret_cast<const char*>(_block.data()), _block.size());
+				continue;
+			};
+
+			// Decompress straight into the output string, a block can't expand by more than 255 times
+			const auto _capacity = std::min(_blockSize, _size * 255 + 16);
+			const auto _outOffset = _out.size();
+			_out.resize(_outOffset + _capacity);
+			size_t _decompressed = 0;
+			if (!decompress_block(_block, std::as_writable_bytes(std::span<char>(_out.data() + _outOffset, _capacity)), _decompressed))
+			{
+				_out.resize(_outOffset);
+				return false;
+			};
+			_out.resize(_outOffset + _decompressed);
+		};
+
+		if (_outFrameSize)
+		{
+			*_outFrameSize = _offset;
+		};
+		return true;
+	};
+};
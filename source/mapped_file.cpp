@@ -0,0 +1,173 @@
+#include <asx/mapped_file.hpp>
+
+#include "os.hpp"
+#include <asx/logging.hpp>
+
+#include <utility>
+#include <algorithm>
+
+#ifdef ASX_OS_LINUX
+	#include <fcntl.h>
+	#include <unistd.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+#endif
+
+namespace asx
+{
+#ifdef ASX_OS_WINDOWS
+	inline uint64_t mapping_granularity()
+	{
+		SYSTEM_INFO _info{};
+		GetSystemInfo(&_info);
+		return static_cast<uint64_t>(_info.dwAllocationGranularity);
+	};
+#else
+	inline uint64_t mapping_granularity()
+	{
+		return static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+	};
+#endif
+
+	size_t mapped_file::file_size(const char* _path)
+	{
+#ifdef ASX_OS_WINDOWS
+		WIN32_FILE_ATTRIBUTE_DATA _attributes{};
+		if (!GetFileAttributesExA(_path, GetFileExInfoStandard, &_attributes))
+		{
+			return npos;
+		};
+		return static_cast<size_t>((static_cast<uint64_t>(_attributes.nFileSizeHigh) << 32) | _attributes.nFileSizeLow);
+#else
+		struct stat _stat{};
+		if (::stat(_path, &_stat) != 0)
+		{
+			return npos;
+		};
+		return static_cast<size_t>(_stat.st_size);
+#endif
+	};
+
+	bool mapped_file::open(const char* _path, uint64_t _offset, size_t _size)
+	{
+		this->close();
+
+		const auto _fileSize = mapped_file::file_size(_path);
+		if (_fileSize == npos)
+		{
+			ASX_LOG_ERROR("Failed to open file for mapping at path \"{}\"", _path);
+			return false;
+		};
+
+		// Clamp the requested range to the file
+		if (_offset >= _fileSize)
+		{
+			return true;
+		};
+		_size = std::min<size_t>(_size, _fileSize - static_cast<size_t>(_offset));
+		if (_size == 0)
+		{
+			return true;
+		};
+
+		// Mappings must begin on a granularity boundary, map from the boundary below the offset
+		const auto _mapOffset = _offset - (_offset % mapping_granularity());
+		const auto _mapSize = static_cast<size_t>(_offset - _mapOffset) + _size;
+
+#ifdef ASX_OS_WINDOWS
+		HANDLE _file = CreateFileA(_path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+		if (_file == INVALID_HANDLE_VALUE)
+		{
+			ASX_LOG_ERROR("CreateFileA() failed with error {}", GetLastError());
+			return false;
+		};
+
+		HANDLE _mapping = CreateFileMappingA(_file, NULL, PAGE_READONLY, 0, 0, NULL);
+		CloseHandle(_file);
+		if (_mapping == NULL)
+		{
+			ASX_LOG_ERROR("CreateFileMappingA() failed with error {}", GetLastError());
+			return false;
+		};
+
+		void* _base = MapViewOfFile(_mapping, FILE_MAP_READ,
+			static_cast<DWORD>(_mapOffset >> 32), static_cast<DWORD>(_mapOffset & 0xFFFFFFFF), _mapSize);
+
+		// The view keeps the mapping object alive
+		CloseHandle(_mapping);
+		if (_base == NULL)
+		{
+			ASX_LOG_ERROR("MapViewOfFile() failed with error {}", GetLastError());
+			return false;
+		};
+#else
+		const int _fd = ::open(_path, O_RDONLY | O_CLOEXEC);
+		if (_fd < 0)
+		{
+			ASX_LOG_ERROR("Failed to open file for mapping at path \"{}\"", _path);
+			return false;
+		};
+
+		void* _base = ::mmap(nullptr, _mapSize, PROT_READ, MAP_SHARED, _fd, static_cast<off_t>(_mapOffset));
+
+		// The mapping keeps the file alive
+		::close(_fd);
+		if (_base == MAP_FAILED)
+		{
+			ASX_LOG_ERROR("mmap() failed for file at path \"{}\"", _path);
+			return false;
+		};
+
+		// Mapped files are almost always read front to back
+		::madvise(_base, _mapSize, MADV_SEQUENTIAL);
+#endif
+
+		this->map_base_ = _base;
+		this->map_size_ = _mapSize;
+		this->data_ = static_cast<const std::byte*>(_base) + (_offset - _mapOffset);
+		this->size_ = _size;
+		this->offset_ = _offset;
+		return true;
+	};
+
+	void mapped_file::close() noexcept
+	{
+		if (!this->map_base_)
+		{
+			return;
+		};
+
+#ifdef ASX_OS_WINDOWS
+		UnmapViewOfFile(this->map_base_);
+#else
+		::munmap(this->map_base_, this->map_size_);
+#endif
+
+		this->map_base_ = nullptr;
+		this->map_size_ = 0;
+		this->data_ = nullptr;
+		this->size_ = 0;
+		this->offset_ = 0;
+	};
+
+	mapped_file::mapped_file(mapped_file&& other) noexcept :
+		data_(std::exchange(other.data_, nullptr)),
+		size_(std::exchange(other.size_, 0)),
+		offset_(std::exchange(other.offset_, 0)),
+		map_base_(std::exchange(other.map_base_, nullptr)),
+		map_size_(std::exchange(other.map_size_, 0))
+	{};
+
+	mapped_file& mapped_file::operator=(mapped_file&& other) noexcept
+	{
+		if (this == &other) { return *this; };
+
+		this->close();
+		this->data_ = std::exchange(other.data_, nullptr);
+		this->size_ = std::exchange(other.size_, 0);
+		this->offset_ = std::exchange(other.offset_, 0);
+		this->map_base_ = std::exchange(other.map_base_, nullptr);
+		this->map_size_ = std::exchange(other.map_size_, 0);
+		return *this;
+	};
+};
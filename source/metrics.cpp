@@ -0,0 +1,114 @@
+#include <asx/metrics.hpp>
+
+#include <algorithm>
+
+namespace asx
+{
+	namespace
+	{
+		/**
+		 * @brief Registered metrics and mutexes, never destroyed so statics may unregister during exit.
+		*/
+		struct metrics_registry
+		{
+			std::mutex mtx;
+			std::vector<const metric*> metrics;
+			std::vector<const profiled_mutex*> mutexes;
+		};
+
+		metrics_registry& get_metrics_registry()
+		{
+			static auto* _registry = new metrics_registry();
+			return *_registry;
+		};
+
+		template <typename T>
+		void erase_registered(std::vector<const T*>& _list, const T* _value)
+		{
+			const auto it = std::find(_list.begin(), _list.end(), _value);
+			if (it != _list.end())
+			{
+				*it = _list.back();
+				_list.pop_back();
+			};
+		};
+	};
+
+	void metric::attach()
+	{
+		auto& _registry = get_metrics_registry();
+		const auto lck = std::unique_lock(_registry.mtx);
+		_registry.metrics.push_back(this);
+	};
+
+	void metric::detach()
+	{
+		auto& _registry = get_metrics_registry();
+		const auto lck = std::unique_lock(_registry.mtx);
+		erase_registered(_registry.metrics, this);
+	};
+
+	std::vector<metric_sample> snapshot_metrics()
+	{
+		auto _samples = std::vector<metric_sample>();
+		{
+			auto& _registry = get_metrics_registry();
+			const auto lck = std::unique_lock(_registry.mtx);
+			_samples.reserve(_registry.metrics.size());
+			for (auto& v : _registry.metrics)
+			{
+				_samples.push_back({ v->name(), v->value() });
+			};
+		};
+		std::sort(_samples.begin(), _samples.end(), [](const metric_sample& lhs, const metric_sample& rhs)
+		{
+			return lhs.name < rhs.name;
+		});
+		return _samples;
+	};
+
+	lock_stats profiled_mutex::stats() const
+	{
+		auto _stats = lock_stats{};
+		_stats.name = this->name_;
+		_stats.acquisitions = this->acquisitions_.load(std::memory_order_relaxed);
+		_stats.contended = this->contended_.load(std::memory_order_relaxed);
+		_stats.total_wait = std::chrono::nanoseconds(this->total_wait_.load(std::memory_order_relaxed));
+		_stats.max_wait = std::chrono::nanoseconds(this->max_wait_.load(std::memory_order_relaxed));
+		return _stats;
+	};
+
+	profiled_mutex::profiled_mutex(std::string _name) :
+		name_(std::move(_name))
+	{
+		auto& _registry = get_metrics_registry();
+		const auto lck = std::unique_lock(_registry.mtx);
+		_registry.mutexes.push_back(this);
+	};
+
+	profiled_mutex::~profiled_mutex()
+	{
+		auto& _registry = get_metrics_registry();
+		const auto lck = std::unique_lock(_registry.mtx);
+		erase_registered(_registry.mutexes, this);
+	};
+
+	std::vector<lock_stats> snapshot_lock_stats()
+	{
+		auto _stats = std::vector<lock_stats>();
+		{
+			auto& _registry = get_metrics_registry();
+			const auto lck = std::unique_lock(_registry.mtx);
+			_stats.reserve(_registry.mutexes.size());
+			for (auto& v : _registry.mutexes)
+			{
+				_stats.push_back(v->stats());
+			};
+		};
+		std::sort(_stats.begin(), _stats.end(), [](const lock_stats& lhs, const lock_stats& rhs)
+		{
+			return lhs.total_wait > rhs.total_wait;
+		});
+		return _stats;
+	};
+};
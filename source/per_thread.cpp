@@ -0,0 +1,116 @@
+#include <asx/per_thread.hpp>
+
+#include <mutex>
+#include <vector>
+
+namespace asx::impl
+{
+	namespace
+	{
+		/**
+		 * @brief Hands out key ids and tracks which generation of key currently owns each one.
+		*/
+		struct thread_key_registry
+		{
+			std::mutex mtx;
+
+			/**
+			 * @brief Generation of the key owning each id, 0 if the id is free.
+			*/
+			std::vector<uint64_t> generations;
+			std::vector<uint32_t> free_ids;
+			uint64_t next_generation = 1;
+		};
+
+		thread_key_registry& key_registry()
+		{
+			// Leaked so it outlives every thread_local that may still be destroyed
+			static auto _registry = new thread_key_registry();
+			return *_registry;
+		};
+
+		/**
+		 * @brief Values of every key for the calling thread, indexed by key id.
+		*/
+		struct thread_key_values
+		{
+			struct entry
+			{
+				void* value = nullptr;
+				uint64_t generation = 0;
+				thread_key::destructor_type destructor = nullptr;
+			};
+
+			std::vector<entry> entries;
+
+			~thread_key_values()
+			{
+				// Locked so a key can't be destroyed while its destructor runs
+				auto& _registry = key_registry();
+				const auto lck = std::unique_lock(_registry.mtx);
+				for (size_t n = 0; n != this->entries.size(); ++n)
+				{
+					const auto& _entry = this->entries[n];
+					if (_entry.value && _registry.generations[n] == _entry.generation)
+					{
+						_entry.destructor(_entry.value);
+					};
+				};
+			};
+		};
+
+		thread_key_values& this_thread_key_values()
+		{
+			thread_local thread_key_values _values{};
+			return _values;
+		};
+	};
+
+	thread_key::thread_key(destructor_type _destructor) :
+		destructor_(_destructor)
+	{
+		auto& _registry = key_registry();
+		const auto lck = std::unique_lock(_registry.mtx);
+
+		this->generation_ = _registry.next_generation++;
+		if (_registry.free_ids.empty())
+		{
+			this->id_ = static_cast<uint32_t>(_registry.generations.size());
+			_registry.generations.push_back(this->generation_);
+		}
+		else
+		{
+			this->id_ = _registry.free_ids.back();
+			_registry.free_ids.pop_back();
+			_registry.generations[this->id_] = this->generation_;
+		};
+	};
+
+	thread_key::~thread_key()
+	{
+		auto& _registry = key_registry();
+		const auto lck = std::unique_lock(_registry.mtx);
+		_registry.generations[this->id_] = 0;
+		_registry.free_ids.push_back(this->id_);
+	};
+
+	void* thread_key::get() const noexcept
+	{
+		const auto& _entries = this_thread_key_values().entries;
+		if (this->id_ < _entries.size() && _entries[this->id_].generation == this->generation_)
+		{
+			return _entries[this->id_].value;
+		};
+		return nullptr;
+	};
+
+	void thread_key::set(void* _value)
+	{
+		auto& _entries = this_thread_key_values().entries;
+		if (this->id_ >= _entries.size())
+		{
+			_entries.resize(this->id_ + 1);
+		};
+		_entries[this->id_] = { _value, this->generation_, this->destructor_ };
+	};
+};
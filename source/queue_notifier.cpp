@@ -0,0 +1,79 @@
+#include <asx/queue_notifier.hpp>
+
+#include "os.hpp"
+#include <asx/logging.hpp>
+
+#ifdef ASX_OS_LINUX
+	#include <unistd.h>
+	#include <sys/eventfd.h>
+#endif
+
+namespace asx
+{
+	void queue_notifier::signal() noexcept
+	{
+		if (this->signalled_ || !this->good())
+		{
+			return;
+		};
+		this->signalled_ = true;
+
+#ifdef ASX_OS_WINDOWS
+		SetEvent(reinterpret_cast<HANDLE>(this->handle_));
+#else
+		const uint64_t _value = 1;
+		[[maybe_unused]] const auto _result = ::write(static_cast<int>(this->handle_), &_value, sizeof(_value));
+#endif
+	};
+
+	void queue_notifier::clear() noexcept
+	{
+		if (!this->signalled_)
+		{
+			return;
+		};
+		this->signalled_ = false;
+
+#ifdef ASX_OS_WINDOWS
+		ResetEvent(reinterpret_cast<HANDLE>(this->handle_));
+#else
+		uint64_t _value{};
+		[[maybe_unused]] const auto _result = ::read(static_cast<int>(this->handle_), &_value, sizeof(_value));
+#endif
+	};
+
+	queue_notifier::queue_notifier()
+	{
+#ifdef ASX_OS_WINDOWS
+		HANDLE _event = CreateEventA(NULL, TRUE, FALSE, NULL);
+		if (_event == NULL)
+		{
+			ASX_LOG_ERROR("CreateEventA() failed with error {}", GetLastError());
+			return;
+		};
+		this->handle_ = reinterpret_cast<intptr_t>(_event);
+#else
+		const int _fd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+		if (_fd < 0)
+		{
+			ASX_LOG_ERROR("Failed to create an eventfd for a queue notifier");
+			return;
+		};
+		this->handle_ = _fd;
+#endif
+	};
+
+	queue_notifier::~queue_notifier()
+	{
+		if (!this->good())
+		{
+			return;
+		};
+
+#ifdef ASX_OS_WINDOWS
+		CloseHandle(reinterpret_cast<HANDLE>(this->handle_));
+#else
+		::close(static_cast<int>(this->handle_));
+#endif
+	};
+};
@@ -0,0 +1,202 @@
+#include <asx/queue_poller.hpp>
+
+#include "os.hpp"
+#include <asx/logging.hpp>
+
+#include <array>
+#include <cerrno>
+#include <climits>
+#include <algorithm>
+
+#ifdef ASX_OS_LINUX
+	#include <unistd.h>
+	#include <sys/epoll.h>
+	#include <sys/timerfd.h>
+#endif
+
+namespace asx
+{
+#ifdef ASX_OS_LINUX
+	inline uint32_t to_epoll_events(uint32_t _events)
+	{
+		uint32_t _out = 0;
+		if (_events & static_cast<uint32_t>(poll_event::readable)) { _out |= EPOLLIN; };
+		if (_events & static_cast<uint32_t>(poll_event::writable)) { _out |= EPOLLOUT; };
+		return _out;
+	};
+
+	inline uint32_t from_epoll_events(uint32_t _events)
+	{
+		uint32_t _out = 0;
+		if (_events & EPOLLIN) { _out |= static_cast<uint32_t>(poll_event::readable); };
+		if (_events & EPOLLOUT) { _out |= static_cast<uint32_t>(poll_event::writable); };
+		if (_events & (EPOLLERR | EPOLLHUP)) { _out |= static_cast<uint32_t>(poll_event::error); };
+		return _out;
+	};
+
+	inline timespec to_timespec(std::chrono::nanoseconds _time)
+	{
+		const auto _seconds = std::chrono::duration_cast<std::chrono::seconds>(_time);
+		return timespec
+		{
+			.tv_sec = static_cast<time_t>(_seconds.count()),
+			.tv_nsec = static_cast<long>((_time - _seconds).count())
+		};
+	};
+#endif
+
+	bool queue_poller::add_fd(intptr_t _fd, uint32_t _events, uint64_t _token)
+	{
+#ifdef ASX_OS_LINUX
+		epoll_event _event{};
+		_event.events = to_epoll_events(_events);
+		_event.data.fd = static_cast<int>(_fd);
+		if (::epoll_ctl(static_cast<int>(this->epoll_), EPOLL_CTL_ADD, static_cast<int>(_fd), &_event) != 0)
+		{
+			ASX_LOG_ERROR("epoll_ctl() failed to add file descriptor {} (errno {})", _fd, errno);
+			return false;
+		};
+		this->entries_.insert_or_assign(_fd, entry{ _token, false });
+		return true;
+#else
+		ASX_LOG_WARN("queue_poller::add_fd was called but no implementation exists for the current platform");
+		return false;
+#endif
+	};
+
+	void queue_poller::remove(intptr_t _fd)
+	{
+		const auto it = this->entries_.find(_fd);
+		if (it == this->entries_.end())
+		{
+			return;
+		};
+
+#ifdef ASX_OS_LINUX
+		::epoll_ctl(static_cast<int>(this->epoll_), EPOLL_CTL_DEL, static_cast<int>(_fd), nullptr);
+		if (it->second.is_timer)
+		{
+			// Timers are owned by the poller
+			::close(static_cast<int>(_fd));
+		};
+#endif
+		this->entries_.erase(it);
+	};
+
+	intptr_t queue_poller::add_timer(std::chrono::nanoseconds _delay, std::chrono::nanoseconds _interval, uint64_t _token)
+	{
+#ifdef ASX_OS_LINUX
+		const int _fd = ::timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+		if (_fd < 0)
+		{
+			ASX_LOG_ERROR("timerfd_create() failed (errno {})", errno);
+			return -1;
+		};
+
+		// A zero initial expiration would disarm the timer
+		itimerspec _spec{};
+		_spec.it_value = to_timespec(std::max(_delay, std::chrono::nanoseconds(1)));
+		_spec.it_interval = to_timespec(_interval);
+		if (::timerfd_settime(_fd, 0, &_spec, nullptr) != 0 ||
+			!this->add_fd(_fd, static_cast<uint32_t>(poll_event::readable), _token))
+		{
+			::close(_fd);
+			return -1;
+		};
+		this->entries_.at(_fd).is_timer = true;
+		return _fd;
+#else
+		ASX_LOG_WARN("queue_poller::add_timer was called but no implementation exists for the current platform");
+		return -1;
+#endif
+	};
+
+	size_t queue_poller::wait(std::span<poll_result> _results, std::optional<std::chrono::nanoseconds> _timeout)
+	{
+#ifdef ASX_OS_LINUX
+		if (_results.empty())
+		{
+			return 0;
+		};
+
+		int _timeoutMs = -1;
+		if (_timeout)
+		{
+			// Round up so a short timeout doesn't turn into a busy poll
+			const auto _ms = std::chrono::ceil<std::chrono::milliseconds>(std::max(*_timeout, std::chrono::nanoseconds(0))).count();
+			_timeoutMs = static_cast<int>(std::min<long long>(_ms, INT_MAX));
+		};
+
+		auto _events = std::array<epoll_event, 64>{};
+		const auto _maxEvents = static_cast<int>(std::min(_results.size(), _events.size()));
+
+		int _count = -1;
+		do
+		{
+			_count = ::epoll_wait(static_cast<int>(this->epoll_), _events.data(), _maxEvents, _timeoutMs);
+		} while (_count < 0 && errno == EINTR);
+
+		if (_count < 0)
+		{
+			ASX_LOG_ERROR("epoll_wait() failed (errno {})", errno);
+			return 0;
+		};
+
+		size_t _written = 0;
+		for (int n = 0; n != _count; ++n)
+		{
+			const auto _fd = static_cast<intptr_t>(_events[n].data.fd);
+			const auto it = this->entries_.find(_fd);
+			if (it == this->entries_.end())
+			{
+				continue;
+			};
+
+			if (it->second.is_timer)
+			{
+				// Consume the expirations so the timer stops being readable
+				uint64_t _expirations{};
+				[[maybe_unused]] const auto _result = ::read(static_cast<int>(_fd), &_expirations, sizeof(_expirations));
+			};
+
+			_results[_written++] = poll_result{ it->second.token, from_epoll_events(_events[n].events) };
+		};
+		return _written;
+#else
+		ASX_LOG_WARN("queue_poller::wait was called but no implementation exists for the current platform");
+		return 0;
+#endif
+	};
+
+	queue_poller::queue_poller()
+	{
+#ifdef ASX_OS_LINUX
+		const int _fd = ::epoll_create1(EPOLL_CLOEXEC);
+		if (_fd < 0)
+		{
+			ASX_LOG_ERROR("epoll_create1() failed (errno {})", errno);
+			return;
+		};
+		this->epoll_ = _fd;
+#else
+		ASX_LOG_WARN("queue_poller was created but no implementation exists for the current platform");
+#endif
+	};
+
+	queue_poller::~queue_poller()
+	{
+#ifdef ASX_OS_LINUX
+		for (auto& [_fd, _entry] : this->entries_)
+		{
+			if (_entry.is_timer)
+			{
+				::close(static_cast<int>(_fd));
+			};
+		};
+		if (this->epoll_ != -1)
+		{
+			::close(static_cast<int>(this->epoll_));
+		};
+#endif
+	};
+};
@@ -0,0 +1,583 @@
+#include <asx/shm_queue.hpp>
+
+#include "os.hpp"
+#include <asx/assert.hpp>
+#include <asx/logging.hpp>
+
+#include <bit>
+#include <array>
+#include <atomic>
+#include <string>
+#include <utility>
+#include <algorithm>
+
+#ifdef ASX_OS_LINUX
+	#include <fcntl.h>
+	#include <unistd.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+#endif
+
+namespace asx
+{
+	/**
+	 * @brief Layout of the start of the shared region, the record ring follows at `header_size`.
+	 *
+	 * Positions are free running byte counts, the ring offset of a position is `position & (capacity - 1)`.
+	 * Each record is a 32-bit length followed by the record bytes, padded to 8 bytes. A length of
+	 * `SHM_QUEUE_WRAP_MARKER` means the rest of the ring is unused and the next record is at offset 0.
+	*/
+	struct shm_queue_header
+	{
+		std::array<char, 8> magic;
+		uint32_t version;
+		uint32_t header_size;
+		uint64_t capacity;
+
+		/**
+		 * @brief Position the writer will write the next record at.
+		*/
+		alignas(64) std::atomic<uint64_t> write_pos;
+
+		/**
+		 * @brief Incremented when a record is pushed while the reader is waiting.
+		*/
+		futex_word record_signal;
+
+		/**
+		 * @brief Set while the writer is waiting for space.
+		*/
+		std::atomic<uint32_t> writer_waiting;
+
+		/**
+		 * @brief Position the reader will read the next record at.
+		*/
+		alignas(64) std::atomic<uint64_t> read_pos;
+
+		/**
+		 * @brief Incremented when a record is popped while the writer is waiting.
+		*/
+		futex_word space_signal;
+
+		/**
+		 * @brief Set while the reader is waiting for a record.
+		*/
+		std::atomic<uint32_t> reader_waiting;
+	};
+
+	// Atomics in shared memory must not rely on process local locks
+	static_assert(std::atomic<uint64_t>::is_always_lock_free);
+
+	constexpr std::array<char, 8> SHM_QUEUE_MAGIC{ 'A', 'S', 'X', 'S', 'H', 'M', 'Q', '\0' };
+
+	constexpr uint32_t SHM_QUEUE_WRAP_MARKER = UINT32_MAX;
+
+	constexpr size_t SHM_QUEUE_HEADER_SIZE = (sizeof(shm_queue_header) + 63) & ~size_t(63);
+
+	inline uint64_t shm_record_footprint(size_t _size)
+	{
+		return (static_cast<uint64_t>(_size) + sizeof(uint32_t) + 7) & ~uint64_t(7);
+	};
+};
+
+namespace asx
+{
+	bool shm_byte_queue::create(const char* _name, size_t _capacity)
+	{
+		this->close();
+
+		_capacity = std::bit_ceil(std::max<size_t>(_capacity, 64));
+		const auto _regionSize = SHM_QUEUE_HEADER_SIZE + _capacity;
+
+#ifdef ASX_OS_WINDOWS
+		const auto _mappingName = (_name) ? std::string("Local\\").append(_name) : std::string();
+		HANDLE _handle = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE,
+			static_cast<DWORD>(static_cast<uint64_t>(_regionSize) >> 32), static_cast<DWORD>(_regionSize & 0xFFFFFFFF),
+			(_name) ? _mappingName.c_str() : NULL);
+		if (_handle == NULL)
+		{
+			ASX_LOG_ERROR("CreateFileMappingA() failed with error {}", GetLastError());
+			return false;
+		};
+		this->handle_ = reinterpret_cast<intptr_t>(_handle);
+#else
+		int _fd = -1;
+		if (_name)
+		{
+			_fd = ::shm_open(_name, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+		}
+		else
+		{
+			_fd = ::memfd_create("asx_shm_queue", MFD_CLOEXEC);
+		};
+		if (_fd < 0)
+		{
+			ASX_LOG_ERROR("Failed to create shared memory region \"{}\"", (_name) ? _name : "<anonymous>");
+			return false;
+		};
+		if (::ftruncate(_fd, static_cast<off_t>(_regionSize)) != 0)
+		{
+			ASX_LOG_ERROR("Failed to size shared memory region \"{}\"", (_name) ? _name : "<anonymous>");
+			::close(_fd);
+			return false;
+		};
+		this->handle_ = _fd;
+#endif
+
+		return this->map_region(_capacity, true);
+	};
+
+	bool shm_byte_queue::open(const char* _name)
+	{
+		this->close();
+
+#ifdef ASX_OS_WINDOWS
+		const auto _mappingName = std::string("Local\\").append(_name);
+		HANDLE _handle = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, _mappingName.c_str());
+		if (_handle == NULL)
+		{
+			ASX_LOG_ERROR("OpenFileMappingA() failed with error {}", GetLastError());
+			return false;
+		};
+		this->handle_ = reinterpret_cast<intptr_t>(_handle);
+#else
+		const int _fd = ::shm_open(_name, O_RDWR | O_CLOEXEC, 0600);
+		if (_fd < 0)
+		{
+			ASX_LOG_ERROR("Failed to open shared memory region \"{}\"", _name);
+			return false;
+		};
+		this->handle_ = _fd;
+#endif
+
+		return this->map_region(0, false);
+	};
+
+	bool shm_byte_queue::open_native(intptr_t _handle)
+	{
+		this->close();
+
+#ifdef ASX_OS_WINDOWS
+		HANDLE _duplicate = NULL;
+		if (!DuplicateHandle(GetCurrentProcess(), reinterpret_cast<HANDLE>(_handle), GetCurrentProcess(),
+			&_duplicate, 0, FALSE, DUPLICATE_SAME_ACCESS))
+		{
+			ASX_LOG_ERROR("DuplicateHandle() failed with error {}", GetLastError());
+			return false;
+		};
+		this->handle_ = reinterpret_cast<intptr_t>(_duplicate);
+#else
+		const int _fd = ::fcntl(static_cast<int>(_handle), F_DUPFD_CLOEXEC, 0);
+		if (_fd < 0)
+		{
+			ASX_LOG_ERROR("Failed to duplicate shared memory file descriptor {}", _handle);
+			return false;
+		};
+		this->handle_ = _fd;
+#endif
+
+		return this->map_region(0, false);
+	};
+
+	bool shm_byte_queue::map_region(size_t _capacity, bool _initialize)
+	{
+		size_t _regionSize = SHM_QUEUE_HEADER_SIZE + _capacity;
+
+#ifdef ASX_OS_WINDOWS
+		const auto _handle = reinterpret_cast<HANDLE>(this->handle_);
+		void* _base = MapViewOfFile(_handle, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+		if (_base == NULL)
+		{
+			ASX_LOG_ERROR("MapViewOfFile() failed with error {}", GetLastError());
+			this->close();
+			return false;
+		};
+
+		MEMORY_BASIC_INFORMATION _info{};
+		VirtualQuery(_base, &_info, sizeof(_info));
+		_regionSize = _info.RegionSize;
+#else
+		if (!_initialize)
+		{
+			struct stat _stat{};
+			if (::fstat(static_cast<int>(this->handle_), &_stat) != 0)
+			{
+				ASX_LOG_ERROR("Failed to get the size of a shared memory region");
+				this->close();
+				return false;
+			};
+			_regionSize = static_cast<size_t>(_stat.st_size);
+		};
+
+		void* _base = ::mmap(nullptr, _regionSize, PROT_READ | PROT_WRITE, MAP_SHARED, static_cast<int>(this->handle_), 0);
+		if (_base == MAP_FAILED)
+		{
+			ASX_LOG_ERROR("mmap() failed for a shared memory region");
+			this->close();
+			return false;
+		};
+#endif
+
+		this->header_ = static_cast<shm_queue_header*>(_base);
+		this->map_size_ = _regionSize;
+		auto& _header = *this->header_;
+
+		if (_initialize)
+		{
+			// The region is zero filled, only the non-zero fields need to be set
+			_header.version = LAYOUT_VERSION;
+			_header.header_size = static_cast<uint32_t>(SHM_QUEUE_HEADER_SIZE);
+			_header.capacity = _capacity;
+			std::atomic_thread_fence(std::memory_order_release);
+			_header.magic = SHM_QUEUE_MAGIC;
+		}
+		else
+		{
+			if (_regionSize < sizeof(shm_queue_header) || _header.magic != SHM_QUEUE_MAGIC)
+			{
+				ASX_LOG_ERROR("Shared memory region is not an asx shared memory queue");
+				this->close();
+				return false;
+			};
+			if (_header.version != LAYOUT_VERSION)
+			{
+				ASX_LOG_ERROR("Shared memory queue has layout version {}, expected {}", _header.version, LAYOUT_VERSION);
+				this->close();
+				return false;
+			};
+			if (!std::has_single_bit(_header.capacity) || _header.capacity < 64 ||
+				_header.header_size < SHM_QUEUE_HEADER_SIZE || _header.header_size % 64 != 0 ||
+				_header.header_size + _header.capacity > _regionSize)
+			{
+				ASX_LOG_ERROR("Shared memory queue header is corrupt");
+				this->close();
+				return false;
+			};
+		};
+
+		// Copied out so a peer changing the header later can't move the ring
+		this->ring_ = reinterpret_cast<std::byte*>(_base) + _header.header_size;
+		this->capacity_ = static_cast<size_t>(_header.capacity);
+		this->corrupt_ = false;
+		this->peeked_size_ = 0;
+		return true;
+	};
+
+	void shm_byte_queue::set_corrupt(const char* _reason) noexcept
+	{
+		if (!this->corrupt_)
+		{
+			ASX_LOG_ERROR("Shared memory queue is corrupt ({}), no more records will be read or written", _reason);
+			this->corrupt_ = true;
+		};
+		this->peeked_size_ = 0;
+	};
+
+	void shm_byte_queue::close() noexcept
+	{
+		if (this->header_)
+		{
+#ifdef ASX_OS_WINDOWS
+			UnmapViewOfFile(this->header_);
+#else
+			::munmap(this->header_, this->map_size_);
+#endif
+		};
+		if (this->handle_ != -1)
+		{
+#ifdef ASX_OS_WINDOWS
+			CloseHandle(reinterpret_cast<HANDLE>(this->handle_));
+#else
+			::close(static_cast<int>(this->handle_));
+#endif
+		};
+
+		this->header_ = nullptr;
+		this->ring_ = nullptr;
+		this->map_size_ = 0;
+		this->handle_ = -1;
+		this->capacity_ = 0;
+		this->corrupt_ = false;
+		this->peeked_size_ = 0;
+	};
+
+	void shm_byte_queue::unlink(const char* _name)
+	{
+#ifdef ASX_OS_LINUX
+		::shm_unlink(_name);
+#endif
+		// Windows removes named mappings once every handle is closed
+	};
+
+	size_t shm_byte_queue::capacity() const noexcept
+	{
+		return this->capacity_;
+	};
+
+	size_t shm_byte_queue::max_record_size() const noexcept
+	{
+		// A record may need to skip the end of the ring, so only half of it is guaranteed contiguous
+		const auto _capacity = this->capacity();
+		return (_capacity == 0) ? 0 : _capacity / 2 - sizeof(uint32_t);
+	};
+
+	bool shm_byte_queue::empty() const noexcept
+	{
+		auto& _header = *this->header_;
+		return _header.read_pos.load(std::memory_order_acquire) == _header.write_pos.load(std::memory_order_acquire);
+	};
+
+	bool shm_byte_queue::try_push(std::span<const std::byte> _record)
+	{
+		if (_record.size() > this->max_record_size())
+		{
+			return false;
+		};
+
+		if (this->corrupt_)
+		{
+			return false;
+		};
+
+		auto& _header = *this->header_;
+		const uint64_t _capacity = this->capacity_;
+		const auto _writePos = _header.write_pos.load(std::memory_order_relaxed);
+		const auto _readPos = _header.read_pos.load(std::memory_order_acquire);
+
+		// Positions always move by whole 8 byte units and never more than the ring apart
+		if (_writePos - _readPos > _capacity || (_writePos | _readPos) % 8 != 0)
+		{
+			this->set_corrupt("invalid read or write position");
+			return false;
+		};
+
+		auto _offset = _writePos & (_capacity - 1);
+		const auto _footprint = shm_record_footprint(_record.size());
+
+		// Records never straddle the end of the ring
+		const auto _skip = (_capacity - _offset < _footprint) ? (_capacity - _offset) : 0;
+		if (_capacity - (_writePos - _readPos) < _skip + _footprint)
+		{
+			return false;
+		};
+
+		if (_skip != 0)
+		{
+			std::memcpy(this->ring_ + _offset, &SHM_QUEUE_WRAP_MARKER, sizeof(uint32_t));
+			_offset = 0;
+		};
+		const auto _size = static_cast<uint32_t>(_record.size());
+		std::memcpy(this->ring_ + _offset, &_size, sizeof(_size));
+		std::memcpy(this->ring_ + _offset + sizeof(_size), _record.data(), _record.size());
+
+		// Sequentially consistent so either this sees the reader waiting or the reader sees the record
+		_header.write_pos.store(_writePos + _skip + _footprint, std::memory_order_seq_cst);
+		if (_header.reader_waiting.load(std::memory_order_seq_cst) != 0)
+		{
+			_header.record_signal.fetch_add(1, std::memory_order_release);
+			futex_wake_one(_header.record_signal, true);
+		};
+		return true;
+	};
+
+	bool shm_byte_queue::push(std::span<const std::byte> _record)
+	{
+		ASX_CHECK(_record.size() <= this->max_record_size());
+
+		auto& _header = *this->header_;
+		while (!this->try_push(_record))
+		{
+			// A corrupt queue never frees up space
+			if (this->corrupt_)
+			{
+				return false;
+			};
+
+			const auto _signal = _header.space_signal.load(std::memory_order_acquire);
+			_header.writer_waiting.store(1, std::memory_order_seq_cst);
+
+			// Re-check now that the reader is guaranteed to see us waiting
+			if (this->try_push(_record))
+			{
+				_header.writer_waiting.store(0, std::memory_order_relaxed);
+				return true;
+			};
+			if (this->corrupt_)
+			{
+				_header.writer_waiting.store(0, std::memory_order_relaxed);
+				return false;
+			};
+			futex_wait(_header.space_signal, _signal, true);
+			_header.writer_waiting.store(0, std::memory_order_relaxed);
+		};
+		return true;
+	};
+
+	std::optional<std::span<const std::byte>> shm_byte_queue::try_peek()
+	{
+		if (this->corrupt_)
+		{
+			return std::nullopt;
+		};
+
+		auto& _header = *this->header_;
+		const uint64_t _capacity = this->capacity_;
+		const auto _readPos = _header.read_pos.load(std::memory_order_relaxed);
+		const auto _writePos = _header.write_pos.load(std::memory_order_acquire);
+		if (_readPos == _writePos)
+		{
+			return std::nullopt;
+		};
+
+		// Positions always move by whole 8 byte units and never more than the ring apart
+		const auto _used = _writePos - _readPos;
+		if (_used > _capacity || (_writePos | _readPos) % 8 != 0)
+		{
+			this->set_corrupt("invalid read or write position");
+			return std::nullopt;
+		};
+
+		auto _offset = _readPos & (_capacity - 1);
+		uint64_t _skip = 0;
+
+		uint32_t _size{};
+		std::memcpy(&_size, this->ring_ + _offset, sizeof(_size));
+		if (_size == SHM_QUEUE_WRAP_MARKER)
+		{
+			// The writer only wraps when the largest record might not fit before the end of the ring
+			_skip = _capacity - _offset;
+			if (_offset == 0 || _skip >= shm_record_footprint(this->max_record_size()))
+			{
+				this->set_corrupt("wrap marker where the ring can't wrap");
+				return std::nullopt;
+			};
+			_offset = 0;
+			std::memcpy(&_size, this->ring_, sizeof(_size));
+		};
+
+		const auto _footprint = shm_record_footprint(_size);
+		if (_size > this->max_record_size() || _size > _capacity - _offset - sizeof(uint32_t) ||
+			_skip + _footprint > _used || (_skip != 0 && _footprint <= _skip))
+		{
+			this->set_corrupt("invalid record length");
+			return std::nullopt;
+		};
+
+		this->peeked_size_ = _skip + _footprint;
+		return std::span<const std::byte>(this->ring_ + _offset + sizeof(uint32_t), _size);
+	};
+
+	void shm_byte_queue::pop()
+	{
+		if (this->peeked_size_ == 0 && !this->try_peek())
+		{
+			return;
+		};
+
+		// Sequentially consistent so either this sees the writer waiting or the writer sees the space
+		auto& _header = *this->header_;
+		_header.read_pos.store(_header.read_pos.load(std::memory_order_relaxed) + this->peeked_size_, std::memory_order_seq_cst);
+		this->peeked_size_ = 0;
+
+		if (_header.writer_waiting.load(std::memory_order_seq_cst) != 0)
+		{
+			_header.space_signal.fetch_add(1, std::memory_order_release);
+			futex_wake_one(_header.space_signal, true);
+		};
+	};
+
+	std::optional<std::vector<std::byte>> shm_byte_queue::try_next()
+	{
+		const auto _record = this->try_peek();
+		if (!_record)
+		{
+			return std::nullopt;
+		};
+
+		auto _out = std::vector<std::byte>(_record->begin(), _record->end());
+		this->pop();
+		return _out;
+	};
+
+	bool shm_byte_queue::wait_for_record(std::chrono::nanoseconds _timeout)
+	{
+		if (this->corrupt_)
+		{
+			return false;
+		};
+
+		auto& _header = *this->header_;
+		const auto _deadline = std::chrono::steady_clock::now() + _timeout;
+		while (this->empty())
+		{
+			const auto _signal = _header.record_signal.load(std::memory_order_acquire);
+			_header.reader_waiting.store(1, std::memory_order_seq_cst);
+
+			// Re-check now that the writer is guaranteed to see us waiting
+			if (!this->empty())
+			{
+				_header.reader_waiting.store(0, std::memory_order_relaxed);
+				break;
+			};
+
+			const auto _remaining = _deadline - std::chrono::steady_clock::now();
+			futex_wait_for(_header.record_signal, _signal, _remaining, true);
+			_header.reader_waiting.store(0, std::memory_order_relaxed);
+
+			if (std::chrono::steady_clock::now() >= _deadline)
+			{
+				return !this->empty();
+			};
+		};
+		return true;
+	};
+
+	void shm_byte_queue::wait_for_record()
+	{
+		if (this->corrupt_)
+		{
+			return;
+		};
+
+		auto& _header = *this->header_;
+		while (this->empty())
+		{
+			const auto _signal = _header.record_signal.load(std::memory_order_acquire);
+			_header.reader_waiting.store(1, std::memory_order_seq_cst);
+
+			// Re-check now that the writer is guaranteed to see us waiting
+			if (!this->empty())
+			{
+				_header.reader_waiting.store(0, std::memory_order_relaxed);
+				break;
+			};
+			futex_wait(_header.record_signal, _signal, true);
+			_header.reader_waiting.store(0, std::memory_order_relaxed);
+		};
+	};
+
+	shm_byte_queue::shm_byte_queue(shm_byte_queue&& other) noexcept :
+		header_(std::exchange(other.header_, nullptr)),
+		ring_(std::exchange(other.ring_, nullptr)),
+		map_size_(std::exchange(other.map_size_, 0)),
+		handle_(std::exchange(other.handle_, -1)),
+		capacity_(std::exchange(other.capacity_, 0)),
+		corrupt_(std::exchange(other.corrupt_, false)),
+		peeked_size_(std::exchange(other.peeked_size_, 0))
+	{};
+
+	shm_byte_queue& shm_byte_queue::operator=(shm_byte_queue&& other) noexcept
+	{
+		if (this == &other) { return *this; };
+
+		this->close();
+		this->header_ = std::exchange(other.header_, nullptr);
+		this->ring_ = std::exchange(other.ring_, nullptr);
+		this->map_size_ = std::exchange(other.map_size_, 0);
+		this->handle_ = std::exchange(other.handle_, -1);
+		this->capacity_ = std::exchange(other.capacity_, 0);
+		this->corrupt_ = std::exchange(other.corrupt_, false);
+		this->peeked_size_ = std::exchange(other.peeked_size_, 0);
+		return *this;
+	};
+};
@@ -222,15 +222,170 @@ namespace asx
 
 		return _outIndex;
 	};
+
+	os_thread_id get_os_thread_id()
+	{
+		return static_cast<os_thread_id>(GetCurrentThreadId());
+	};
+
+	size_t get_thread_stack_trace(os_thread_id _thread, std::span<SourceLocation> _outBuffer)
+	{
+		if (_thread == asx::get_os_thread_id())
+		{
+			return asx::get_stack_trace(_outBuffer, 1);
+		};
+		ASX_LOG_WARN("Called get_thread_stack_trace() for another thread but no implementation exists for the current platform.");
+		return 0;
+	};
 };
 
 #elif defined(ASX_OS_LINUX)
 
+#include <asx/futex.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <cxxabi.h>
+#include <signal.h>
+#include <unistd.h>
 #include <execinfo.h>
-#include <stdio.h>
+#include <sys/syscall.h>
 
 namespace asx
 {
+	namespace
+	{
+		/**
+		 * @brief Maximum number of frames captured from another thread.
+		*/
+		constexpr size_t THREAD_STACK_TRACE_MAX_FRAMES = 64;
+
+		/**
+		 * @brief Shared with the signal handler, only one thread is asked for its stack at a time.
+		*/
+		struct thread_stack_request
+		{
+			/**
+			 * @brief Sequence number of the open request, or 0 if there is none or a handler claimed it.
+			 *
+			 * Each signal carries the sequence number of the request that sent it, so a late signal
+			 * from a request that timed out can't write the frames of a later one.
+			*/
+			std::atomic<uint32_t> sequence{ 0 };
+
+			void* frames[THREAD_STACK_TRACE_MAX_FRAMES]{};
+			std::atomic<int> count{ 0 };
+
+			/**
+			 * @brief Set to the request's sequence number once its frames are written.
+			*/
+			futex_word done{ 0 };
+		};
+
+		thread_stack_request thread_stack_state{};
+
+		/**
+		 * @brief Captures the stack of the thread the request targets, only uses async signal safe calls.
+		*/
+		void thread_stack_handler(int, siginfo_t* _info, void*)
+		{
+			const auto _savedErrno = errno;
+			auto& _request = thread_stack_state;
+
+			// Claiming the request keeps the requester from giving up on it while the frames are written
+			auto _sequence = static_cast<uint32_t>(_info->si_value.sival_int);
+			if (_info->si_code == SI_QUEUE && _sequence != 0 &&
+				_request.sequence.compare_exchange_strong(_sequence, 0, std::memory_order_acq_rel))
+			{
+				_request.count.store(backtrace(_request.frames, static_cast<int>(THREAD_STACK_TRACE_MAX_FRAMES)), std::memory_order_relaxed);
+				_request.done.store(_sequence, std::memory_order_release);
+				futex_wake_all(_request.done);
+			};
+			errno = _savedErrno;
+		};
+
+		/**
+		 * @brief Turns return addresses into source locations using the dynamic symbol table.
+		 *
+		 * Lines from `backtrace_symbols()` look like "path(symbol+offset) [address]", the symbol is
+		 * demangled when there is one and the address is used as the function name when there isn't.
+		 * Line numbers aren't available this way.
+		*/
+		size_t symbolize_frames(void* const* _frames, size_t _count, std::span<SourceLocation> _outBuffer)
+		{
+			struct unique_string_array_deleter
+			{
+				void operator()(char** _strings) noexcept
+				{
+					free(_strings);
+				};
+			};
+			using unique_string_array = std::unique_ptr<char*[], unique_string_array_deleter>;
+
+			_count = std::min(_count, _outBuffer.size());
+			const auto _strings = unique_string_array(backtrace_symbols(_frames, static_cast<int>(_count)));
+			if (!_strings)
+			{
+				return 0;
+			};
+
+			for (size_t n = 0; n != _count; ++n)
+			{
+				const auto _line = std::string_view(_strings[n]);
+				const auto _open = _line.find('(');
+				const auto _file = _line.substr(0, std::min(_open, _line.size()));
+
+				auto _symbol = std::string();
+				if (_open != std::string_view::npos)
+				{
+					const auto _end = _line.find_first_of("+)", _open + 1);
+					_symbol = std::string(_line.substr(_open + 1, (_end == std::string_view::npos) ? std::string_view::npos : _end - _open - 1));
+				};
+
+				char _address[32]{};
+				auto _function = std::string_view();
+				int _status = -1;
+				const auto _demangled = (_symbol.empty()) ? nullptr : abi::__cxa_demangle(_symbol.c_str(), nullptr, nullptr, &_status);
+				if (_demangled && _status == 0)
+				{
+					// Drop the parameter list to match the names given on other platforms
+					_function = _demangled;
+					int _depth = 0;
+					for (size_t i = 0; i != _function.size(); ++i)
+					{
+						const auto c = _function[i];
+						if (c == '<')
+						{
+							++_depth;
+						}
+						else if (c == '>')
+						{
+							--_depth;
+						}
+						else if (c == '(' && _depth == 0 && !_function.substr(0, i).ends_with("operator"))
+						{
+							_function = _function.substr(0, i);
+							break;
+						};
+					};
+				}
+				else if (!_symbol.empty())
+				{
+					_function = _symbol;
+				}
+				else
+				{
+					std::snprintf(_address, sizeof(_address), "%p", _frames[n]);
+					_function = _address;
+				};
+
+				_outBuffer[n] = SourceLocation::from_absolute_path(_file, _function, 0);
+				free(_demangled);
+			};
+			return _count;
+		};
+	};
+
 	size_t get_stack_trace(std::span<SourceLocation> _outBuffer, size_t _skipFrames)
 	{
 		// Adding one to this as the get_stack_trace() function has a habit of showing up here
@@ -245,22 +400,103 @@ namespace asx
 			return 0;
 		};
 
-		// Handle symbols		
-		struct unique_string_array_deleter { 
-			void operator()(char** _strings) noexcept
+		return symbolize_frames(_callstack.data() + _skipFrames, static_cast<size_t>(_frameCount) - _skipFrames, _outBuffer);
+	};
+
+	os_thread_id get_os_thread_id()
+	{
+		return static_cast<os_thread_id>(syscall(SYS_gettid));
+	};
+
+	size_t get_thread_stack_trace(os_thread_id _thread, std::span<SourceLocation> _outBuffer)
+	{
+		if (_thread == asx::get_os_thread_id())
+		{
+			return asx::get_stack_trace(_outBuffer, 1);
+		};
+
+		static std::mutex mtx{};
+		const auto lck = std::unique_lock(mtx);
+
+		// The first backtrace() call may load libgcc, don't let that happen in the handler.
+		// The handler is left installed, a signal still pending for a thread that didn't respond in
+		// time would otherwise hit the default action and end the process.
+		const auto _signal = SIGRTMIN + 3;
+		static bool _installed = false;
+		if (!_installed)
+		{
+			void* _frame = nullptr;
+			backtrace(&_frame, 1);
+
+			struct sigaction _action {};
+			_action.sa_sigaction = &thread_stack_handler;
+			_action.sa_flags = SA_RESTART | SA_SIGINFO;
+			sigemptyset(&_action.sa_mask);
+			if (sigaction(_signal, &_action, nullptr) != 0)
 			{
-				free(_strings);
+				ASX_LOG_ERROR("Failed to install the thread stack trace signal handler, errno {}", errno);
+				return 0;
 			};
+			_installed = true;
 		};
-		using unique_string_array = std::unique_ptr<char*[], unique_string_array_deleter>; 
-		auto _stringStorage = unique_string_array(backtrace_symbols(_callstack.data(), _frameCount));
-
-		// Write into the span
-		auto _strings = std::span<char*>(_stringStorage.get(), static_cast<size_t>(_frameCount));
-		for (size_t n = _skipFrames; n != _strings.size(); ++n) {
-			printf("%s\n", _strings[n]);
-		}
-		return 0;
+
+		// Zero is left for "no request"
+		static uint32_t _nextSequence = 0;
+		if (++_nextSequence == 0)
+		{
+			++_nextSequence;
+		};
+		const auto _sequence = _nextSequence;
+
+		auto& _request = thread_stack_state;
+		_request.done.store(0, std::memory_order_relaxed);
+		_request.sequence.store(_sequence, std::memory_order_release);
+
+		// Queued with the sequence number so the handler can tell which request the signal belongs to
+		auto _info = siginfo_t{};
+		_info.si_signo = _signal;
+		_info.si_code = SI_QUEUE;
+		_info.si_pid = getpid();
+		_info.si_uid = getuid();
+		_info.si_value.sival_int = static_cast<int>(_sequence);
+		if (syscall(SYS_rt_tgsigqueueinfo, getpid(), static_cast<pid_t>(_thread), _signal, &_info) == 0)
+		{
+			const auto _deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(200);
+			while (true)
+			{
+				const auto _done = _request.done.load(std::memory_order_acquire);
+				const auto _now = std::chrono::steady_clock::now();
+				if (_done == _sequence || _now >= _deadline)
+				{
+					break;
+				};
+				futex_wait_for(_request.done, _done, _deadline - _now);
+			};
+		};
+
+		// Close the request, if a handler claimed it first it is already writing the frames and won't be long
+		if (_request.sequence.exchange(0, std::memory_order_acq_rel) != 0)
+		{
+			return 0;
+		};
+		while (true)
+		{
+			const auto _done = _request.done.load(std::memory_order_acquire);
+			if (_done == _sequence)
+			{
+				break;
+			};
+			futex_wait(_request.done, _done);
+		};
+
+		// Skip the handler and the signal trampoline
+		constexpr int _handlerFrames = 2;
+		const auto _count = _request.count.load(std::memory_order_relaxed);
+		if (_count <= _handlerFrames)
+		{
+			return 0;
+		};
+		return symbolize_frames(_request.frames + _handlerFrames, static_cast<size_t>(_count - _handlerFrames), _outBuffer);
 	};
 };
 
@@ -273,6 +509,18 @@ namespace asx
 		ASX_LOG_WARN("Called get_stack_trace() but no implementation exists for the current platform.");
 		return 0;
 	};
+
+	os_thread_id get_os_thread_id()
+	{
+		ASX_LOG_WARN("Called get_os_thread_id() but no implementation exists for the current platform.");
+		return 0;
+	};
+
+	size_t get_thread_stack_trace(os_thread_id _thread, std::span<SourceLocation> _outBuffer)
+	{
+		ASX_LOG_WARN("Called get_thread_stack_trace() but no implementation exists for the current platform.");
+		return 0;
+	};
 };
 
 #endif
@@ -0,0 +1,226 @@
+#include <asx/sync.hpp>
+
+#include "os.hpp"
+#include <asx/assert.hpp>
+
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(__i386__)
+	#include <immintrin.h>
+#endif
+
+namespace asx
+{
+	void cpu_relax() noexcept
+	{
+#ifdef ASX_OS_WINDOWS
+		YieldProcessor();
+#elif defined(__x86_64__) || defined(__i386__)
+		_mm_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+		__asm__ __volatile__("yield");
+#endif
+	};
+
+	/**
+	 * @brief Spins until a word no longer holds a value, then sleeps on it.
+	 * @param _word Word to wait on.
+	 * @param _value Value to wait while the word holds.
+	 * @param _sleepers Count of sleepers on the word, held while sleeping so wakers know to make the wake syscall.
+	*/
+	inline void spin_then_wait(const futex_word& _word, uint32_t _value, std::atomic<uint32_t>& _sleepers) noexcept
+	{
+		for (uint32_t n = 0; n != SYNC_SPIN_COUNT_DEFAULT; ++n)
+		{
+			if (_word.load(std::memory_order_acquire) != _value)
+			{
+				return;
+			};
+			cpu_relax();
+		};
+
+		while (_word.load(std::memory_order_acquire) == _value)
+		{
+			// Sequentially consistent so either the waker sees the count or we see the change
+			_sleepers.fetch_add(1, std::memory_order_seq_cst);
+			if (_word.load(std::memory_order_seq_cst) == _value)
+			{
+				futex_wait(_word, _value);
+			};
+			_sleepers.fetch_sub(1, std::memory_order_relaxed);
+		};
+	};
+
+	/**
+	 * @brief Wakes every sleeper on a word if there are any.
+	*/
+	inline void wake_sleepers(const futex_word& _word, const std::atomic<uint32_t>& _sleepers) noexcept
+	{
+		if (_sleepers.load(std::memory_order_seq_cst) != 0)
+		{
+			futex_wake_all(_word);
+		};
+	};
+};
+
+namespace asx
+{
+	void latch::count_down(uint32_t _count) noexcept
+	{
+		const auto _previous = this->count_.fetch_sub(_count, std::memory_order_seq_cst);
+		ASX_CHECK(_previous >= _count);
+		if (_previous == _count)
+		{
+			wake_sleepers(this->count_, this->sleepers_);
+		};
+	};
+
+	void latch::wait() const noexcept
+	{
+		auto _count = this->count_.load(std::memory_order_acquire);
+		while (_count != 0)
+		{
+			spin_then_wait(this->count_, _count, this->sleepers_);
+			_count = this->count_.load(std::memory_order_acquire);
+		};
+	};
+};
+
+namespace asx
+{
+	barrier::barrier(size_t _participants, std::function<void()> _completion, size_t _fanIn) :
+		participants_(_participants),
+		fan_in_(_fanIn),
+		completion_(std::move(_completion))
+	{
+		ASX_CHECK(_participants != 0 && _fanIn >= 2);
+
+		// Count the nodes in each level, leaves first
+		auto _levelSizes = std::vector<size_t>();
+		size_t _width = _participants;
+		do
+		{
+			_width = (_width + _fanIn - 1) / _fanIn;
+			_levelSizes.push_back(_width);
+		} while (_width > 1);
+
+		size_t _total = 0;
+		for (auto& v : _levelSizes)
+		{
+			_total += v;
+		};
+		this->nodes_ = std::make_unique<node[]>(_total);
+
+		// Link each level to the next, the root is the last node
+		size_t _levelBegin = 0;
+		size_t _children = _participants;
+		for (auto& _levelSize : _levelSizes)
+		{
+			const auto _nextBegin = _levelBegin + _levelSize;
+			for (size_t n = 0; n != _levelSize; ++n)
+			{
+				auto& _node = this->nodes_[_levelBegin + n];
+				_node.expected = static_cast<uint32_t>(std::min(_fanIn, _children - n * _fanIn));
+				_node.parent = (_nextBegin < _total) ? &this->nodes_[_nextBegin + n / _fanIn] : nullptr;
+			};
+			_children = _levelSize;
+			_levelBegin = _nextBegin;
+		};
+	};
+
+	void barrier::arrive_and_wait(size_t _id)
+	{
+		ASX_CHECK(_id < this->participants_);
+
+		// Must be read before arriving, the phase may advance as soon as we do
+		const auto _phase = this->phase_.load(std::memory_order_acquire);
+
+		auto _node = &this->nodes_[_id / this->fan_in_];
+		while (_node)
+		{
+			if (_node->count.fetch_add(1, std::memory_order_acq_rel) + 1 != _node->expected)
+			{
+				spin_then_wait(this->phase_, _phase, this->sleepers_);
+				return;
+			};
+
+			// Last arrival here, everyone else at this node is waiting so it can be reset for the next phase
+			_node->count.store(0, std::memory_order_relaxed);
+			_node = _node->parent;
+		};
+
+		// Last arrival overall
+		if (this->completion_)
+		{
+			this->completion_();
+		};
+		this->phase_.fetch_add(1, std::memory_order_seq_cst);
+		wake_sleepers(this->phase_, this->sleepers_);
+	};
+};
+
+namespace asx
+{
+	void counting_semaphore::release(uint32_t _count) noexcept
+	{
+		// Sequentially consistent so either we see the sleeper or the sleeper sees the count
+		this->count_.fetch_add(_count, std::memory_order_seq_cst);
+		if (this->sleepers_.load(std::memory_order_seq_cst) != 0)
+		{
+			if (_count == 1)
+			{
+				futex_wake_one(this->count_);
+			}
+			else
+			{
+				futex_wake_all(this->count_);
+			};
+		};
+	};
+
+	void counting_semaphore::acquire() noexcept
+	{
+		for (uint32_t n = 0; n != SYNC_SPIN_COUNT_DEFAULT; ++n)
+		{
+			if (this->try_acquire())
+			{
+				return;
+			};
+			cpu_relax();
+		};
+
+		while (!this->try_acquire())
+		{
+			this->sleepers_.fetch_add(1, std::memory_order_seq_cst);
+			futex_wait(this->count_, 0);
+			this->sleepers_.fetch_sub(1, std::memory_order_relaxed);
+		};
+	};
+
+	bool counting_semaphore::try_acquire_for(std::chrono::nanoseconds _timeout) noexcept
+	{
+		const auto _deadline = std::chrono::steady_clock::now() + _timeout;
+		for (uint32_t n = 0; n != SYNC_SPIN_COUNT_DEFAULT; ++n)
+		{
+			if (this->try_acquire())
+			{
+				return true;
+			};
+			cpu_relax();
+		};
+
+		while (!this->try_acquire())
+		{
+			const auto _remaining = _deadline - std::chrono::steady_clock::now();
+			if (_remaining <= std::chrono::nanoseconds::zero())
+			{
+				return false;
+			};
+
+			this->sleepers_.fetch_add(1, std::memory_order_seq_cst);
+			futex_wait_for(this->count_, 0, _remaining);
+			this->sleepers_.fetch_sub(1, std::memory_order_relaxed);
+		};
+		return true;
+	};
+};
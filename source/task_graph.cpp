@@ -0,0 +1,272 @@
+#include <asx/task_graph.hpp>
+
+#include <asx/sync.hpp>
+#include <asx/assert.hpp>
+
+namespace asx
+{
+	struct task_graph::node final : public thread_pool_task
+	{
+		task_graph* graph;
+		node_id id;
+		std::string name;
+		std::function<void()> fn;
+
+		std::vector<node*> successors{};
+		std::vector<node*> predecessors{};
+
+		/**
+		 * @brief Predecessors left to finish in the current run.
+		*/
+		std::atomic<uint32_t> pending{ 0 };
+
+		clock_type::time_point start_time{};
+		clock_type::time_point end_time{};
+
+		void run() override
+		{
+			this->graph->execute(this);
+		};
+
+		node(task_graph* _graph, node_id _id, std::string _name, std::function<void()> _fn) :
+			graph(_graph), id(_id), name(std::move(_name)), fn(std::move(_fn))
+		{};
+	};
+};
+
+namespace asx
+{
+	task_graph::node_id task_graph::add(std::string _name, std::function<void()> _fn)
+	{
+		ASX_CHECK(this->done_.load(std::memory_order_acquire) == 2);
+		const auto _id = this->nodes_.size();
+		this->nodes_.push_back(std::make_unique<node>(this, _id, std::move(_name), std::move(_fn)));
+		this->prepared_ = false;
+		return _id;
+	};
+
+	void task_graph::precede(node_id _before, node_id _after)
+	{
+		ASX_CHECK(this->done_.load(std::memory_order_acquire) == 2);
+		ASX_CHECK(_before < this->nodes_.size() && _after < this->nodes_.size() && _before != _after);
+		auto& _from = *this->nodes_[_before];
+		auto& _to = *this->nodes_[_after];
+		_from.successors.push_back(&_to);
+		_to.predecessors.push_back(&_from);
+		this->prepared_ = false;
+	};
+
+	void task_graph::prepare()
+	{
+		this->roots_.clear();
+		for (auto& _node : this->nodes_)
+		{
+			if (_node->predecessors.empty())
+			{
+				this->roots_.push_back(_node.get());
+			};
+		};
+
+		// Kahn's algorithm, every node is reached only if there is no cycle
+		auto _counts = std::vector<size_t>(this->nodes_.size());
+		auto _ready = std::vector<node*>(this->roots_);
+		size_t _visited = 0;
+		for (auto& _node : this->nodes_)
+		{
+			_counts[_node->id] = _node->predecessors.size();
+		};
+		while (!_ready.empty())
+		{
+			const auto _node = _ready.back();
+			_ready.pop_back();
+			++_visited;
+			for (auto& _successor : _node->successors)
+			{
+				if (--_counts[_successor->id] == 0)
+				{
+					_ready.push_back(_successor);
+				};
+			};
+		};
+		ASX_CHECK(_visited == this->nodes_.size());
+
+		this->prepared_ = true;
+	};
+
+	void task_graph::execute(node* _node)
+	{
+		while (_node)
+		{
+			_node->start_time = clock_type::now();
+			try
+			{
+				_node->fn();
+			}
+			catch (...)
+			{
+				const auto lck = std::unique_lock(this->error_mtx_);
+				if (!this->error_)
+				{
+					this->error_ = std::current_exception();
+				};
+			};
+			_node->end_time = clock_type::now();
+
+			// Keep one ready successor to run here, saves a trip through the pool
+			node* _next = nullptr;
+			for (auto& _successor : _node->successors)
+			{
+				if (_successor->pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+				{
+					if (!_next)
+					{
+						_next = _successor;
+					}
+					else
+					{
+						this->pool_->submit(*_successor);
+					};
+				};
+			};
+
+			if (this->remaining_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+			{
+				// The graph may be destroyed as soon as done_ reads 2
+				this->end_time_ = _node->end_time;
+				this->done_.store(1, std::memory_order_release);
+				futex_wake_all(this->done_);
+				this->done_.store(2, std::memory_order_release);
+				return;
+			};
+			_node = _next;
+		};
+	};
+
+	void task_graph::run(thread_pool& _pool)
+	{
+		ASX_CHECK(this->done_.load(std::memory_order_acquire) == 2);
+		if (!this->prepared_)
+		{
+			this->prepare();
+		};
+		if (this->nodes_.empty())
+		{
+			return;
+		};
+
+		for (auto& _node : this->nodes_)
+		{
+			_node->pending.store(static_cast<uint32_t>(_node->predecessors.size()), std::memory_order_relaxed);
+		};
+		this->pool_ = &_pool;
+		this->error_ = nullptr;
+		this->remaining_.store(this->nodes_.size(), std::memory_order_relaxed);
+		this->done_.store(0, std::memory_order_relaxed);
+		this->start_time_ = clock_type::now();
+
+		// Published by the release in submit, the first root runs here
+		for (size_t n = 1; n < this->roots_.size(); ++n)
+		{
+			_pool.submit(*this->roots_[n]);
+		};
+		this->execute(this->roots_.front());
+
+		// Help with pool work while waiting, a worker that blocked here could deadlock a small pool
+		const bool _isWorker = _pool.is_worker_thread();
+		while (true)
+		{
+			const auto _state = this->done_.load(std::memory_order_acquire);
+			if (_state == 2)
+			{
+				break;
+			}
+			else if (_state == 1 || _pool.try_run_one())
+			{
+				cpu_relax();
+			}
+			else if (_isWorker)
+			{
+				futex_wait_for(this->done_, 0, std::chrono::microseconds(50));
+			}
+			else
+			{
+				futex_wait(this->done_, 0);
+			};
+		};
+
+		if (this->error_)
+		{
+			std::rethrow_exception(this->error_);
+		};
+	};
+
+	task_graph::clock_type::duration task_graph::node_time(node_id _node) const
+	{
+		ASX_CHECK(_node < this->nodes_.size());
+		return this->nodes_[_node]->end_time - this->nodes_[_node]->start_time;
+	};
+
+	std::vector<task_graph::node_id> task_graph::critical_path() const
+	{
+		auto _path = std::vector<node_id>();
+		if (this->nodes_.empty() || this->end_time_ == clock_type::time_point{})
+		{
+			return _path;
+		};
+
+		const node* _node = nullptr;
+		for (auto& v : this->nodes_)
+		{
+			if (!_node || v->end_time > _node->end_time)
+			{
+				_node = v.get();
+			};
+		};
+
+		while (_node)
+		{
+			_path.push_back(_node->id);
+			const node* _gate = nullptr;
+			for (auto& v : _node->predecessors)
+			{
+				if (!_gate || v->end_time > _gate->end_time)
+				{
+					_gate = v;
+				};
+			};
+			_node = _gate;
+		};
+		return std::vector<node_id>(_path.rbegin(), _path.rend());
+	};
+
+	ASXSingleTimeProfiler::Result task_graph::profile() const
+	{
+		using duration_type = ASXSingleTimeProfiler::Duration;
+
+		auto _result = ASXSingleTimeProfiler::Result{};
+		_result.laps.reserve(this->nodes_.size());
+		for (auto& v : this->nodes_)
+		{
+			_result.laps.push_back({ std::chrono::duration_cast<duration_type>(v->end_time - v->start_time), v->name });
+		};
+		_result.total = std::chrono::duration_cast<duration_type>(this->total_time());
+		return _result;
+	};
+
+	void task_graph::print_critical_path() const
+	{
+		using duration_type = ASXSingleTimeProfiler::Duration;
+
+		auto _result = ASXSingleTimeProfiler::Result{};
+		for (auto& _id : this->critical_path())
+		{
+			const auto& _node = *this->nodes_[_id];
+			_result.laps.push_back({ std::chrono::duration_cast<duration_type>(_node.end_time - _node.start_time), _node.name });
+		};
+		_result.total = std::chrono::duration_cast<duration_type>(this->total_time());
+		ASXSingleTimeProfiler::print(_result);
+	};
+
+	task_graph::task_graph() = default;
+	task_graph::~task_graph() = default;
+};
@@ -0,0 +1,314 @@
+#include <asx/thread_pool.hpp>
+
+#include <asx/sync.hpp>
+#include <asx/assert.hpp>
+
+#include <algorithm>
+
+namespace asx
+{
+	/**
+	 * @brief Bounded Chase-Lev deque, the owner pushes and pops at the bottom and thieves take from the top.
+	*/
+	class work_stealing_deque
+	{
+	public:
+
+		constexpr static int64_t capacity = 4096;
+
+		/**
+		 * @brief Pushes a task. OWNER ONLY.
+		 * @return False if the deque is full.
+		*/
+		bool push(thread_pool_task* _task) noexcept
+		{
+			const auto _bottom = this->bottom_.load(std::memory_order_relaxed);
+			const auto _top = this->top_.load(std::memory_order_acquire);
+			if (_bottom - _top >= capacity)
+			{
+				return false;
+			};
+			this->buffer_[_bottom & (capacity - 1)].store(_task, std::memory_order_relaxed);
+			this->bottom_.store(_bottom + 1, std::memory_order_release);
+			return true;
+		};
+
+		/**
+		 * @brief Pops the most recently pushed task. OWNER ONLY.
+		*/
+		thread_pool_task* pop() noexcept
+		{
+			const auto _bottom = this->bottom_.load(std::memory_order_relaxed) - 1;
+			this->bottom_.store(_bottom, std::memory_order_seq_cst);
+			auto _top = this->top_.load(std::memory_order_seq_cst);
+			if (_top > _bottom)
+			{
+				this->bottom_.store(_bottom + 1, std::memory_order_relaxed);
+				return nullptr;
+			};
+
+			auto _task = this->buffer_[_bottom & (capacity - 1)].load(std::memory_order_relaxed);
+			if (_top == _bottom)
+			{
+				// Last task, race thieves for it
+				if (!this->top_.compare_exchange_strong(_top, _top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+				{
+					_task = nullptr;
+				};
+				this->bottom_.store(_bottom + 1, std::memory_order_relaxed);
+			};
+			return _task;
+		};
+
+		/**
+		 * @brief Takes the least recently pushed task.
+		 * @return The task, or null if empty or another thread won the race for it.
+		*/
+		thread_pool_task* steal() noexcept
+		{
+			auto _top = this->top_.load(std::memory_order_seq_cst);
+			const auto _bottom = this->bottom_.load(std::memory_order_seq_cst);
+			if (_top >= _bottom)
+			{
+				return nullptr;
+			};
+
+			const auto _task = this->buffer_[_top & (capacity - 1)].load(std::memory_order_relaxed);
+			if (!this->top_.compare_exchange_strong(_top, _top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+			{
+				return nullptr;
+			};
+			return _task;
+		};
+
+		bool empty() const noexcept
+		{
+			return this->bottom_.load(std::memory_order_acquire) <= this->top_.load(std::memory_order_acquire);
+		};
+
+	private:
+		alignas(64) std::atomic<int64_t> top_{ 0 };
+		alignas(64) std::atomic<int64_t> bottom_{ 0 };
+		std::unique_ptr<std::atomic<thread_pool_task*>[]> buffer_ = std::make_unique<std::atomic<thread_pool_task*>[]>(capacity);
+	};
+
+	struct alignas(64) thread_pool::worker
+	{
+		work_stealing_deque deque;
+
+		/**
+		 * @brief State of the xorshift generator picking steal victims, only touched by the owner.
+		*/
+		uint64_t rng = 0;
+	};
+
+	/**
+	 * @brief The pool and worker the calling thread belongs to, if any.
+	*/
+	thread_local thread_pool* this_thread_pool = nullptr;
+	thread_local size_t this_thread_worker = 0;
+};
+
+namespace asx
+{
+	void thread_pool::submit(thread_pool_task& _task)
+	{
+		if (this_thread_pool != this || !this->workers_[this_thread_worker].deque.push(&_task))
+		{
+			this->push_injected(_task);
+		};
+		this->notify();
+	};
+
+	bool thread_pool::try_run_one()
+	{
+		const auto _self = (this_thread_pool == this) ? &this->workers_[this_thread_worker] : nullptr;
+		if (const auto _task = this->find_task(_self); _task)
+		{
+			_task->run();
+			return true;
+		};
+		return false;
+	};
+
+	bool thread_pool::is_worker_thread() const noexcept
+	{
+		return this_thread_pool == this;
+	};
+
+	void thread_pool::push_injected(thread_pool_task& _task)
+	{
+		const auto lck = std::unique_lock(this->inject_mtx_);
+		_task.next_ = nullptr;
+		if (this->inject_tail_)
+		{
+			this->inject_tail_->next_ = &_task;
+		}
+		else
+		{
+			this->inject_head_ = &_task;
+		};
+		this->inject_tail_ = &_task;
+		this->has_injected_.store(true, std::memory_order_release);
+	};
+
+	thread_pool_task* thread_pool::pop_injected()
+	{
+		if (!this->has_injected_.load(std::memory_order_acquire))
+		{
+			return nullptr;
+		};
+
+		const auto lck = std::unique_lock(this->inject_mtx_);
+		const auto _task = this->inject_head_;
+		if (_task)
+		{
+			this->inject_head_ = _task->next_;
+			if (!this->inject_head_)
+			{
+				this->inject_tail_ = nullptr;
+				this->has_injected_.store(false, std::memory_order_relaxed);
+			};
+		};
+		return _task;
+	};
+
+	thread_pool_task* thread_pool::steal(worker* _self)
+	{
+		// Start at a random victim so thieves spread out
+		size_t _start = 0;
+		if (_self)
+		{
+			_self->rng ^= _self->rng << 13;
+			_self->rng ^= _self->rng >> 7;
+			_self->rng ^= _self->rng << 17;
+			_start = static_cast<size_t>(_self->rng % this->worker_count_);
+		};
+
+		for (size_t n = 0; n != this->worker_count_; ++n)
+		{
+			auto& _victim = this->workers_[(_start + n) % this->worker_count_];
+			if (&_victim == _self)
+			{
+				continue;
+			};
+			if (const auto _task = _victim.deque.steal(); _task)
+			{
+				return _task;
+			};
+		};
+		return nullptr;
+	};
+
+	thread_pool_task* thread_pool::find_task(worker* _self)
+	{
+		if (_self)
+		{
+			if (const auto _task = _self->deque.pop(); _task)
+			{
+				return _task;
+			};
+		};
+		if (const auto _task = this->pop_injected(); _task)
+		{
+			return _task;
+		};
+		return this->steal(_self);
+	};
+
+	bool thread_pool::has_queued() const noexcept
+	{
+		if (this->has_injected_.load(std::memory_order_seq_cst))
+		{
+			return true;
+		};
+		for (size_t n = 0; n != this->worker_count_; ++n)
+		{
+			if (!this->workers_[n].deque.empty())
+			{
+				return true;
+			};
+		};
+		return false;
+	};
+
+	void thread_pool::notify()
+	{
+		// Either a worker about to sleep sees the new task or we see it as a sleeper
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (this->sleepers_.load(std::memory_order_relaxed) != 0)
+		{
+			this->wake_epoch_.fetch_add(1, std::memory_order_release);
+			futex_wake_one(this->wake_epoch_);
+		};
+	};
+
+	void thread_pool::worker_main(size_t _index)
+	{
+		this_thread_pool = this;
+		this_thread_worker = _index;
+
+		auto& _self = this->workers_[_index];
+		while (true)
+		{
+			if (const auto _task = this->find_task(&_self); _task)
+			{
+				_task->run();
+				continue;
+			};
+
+			// Spin a little, new work often shows up right away
+			bool _found = false;
+			for (uint32_t n = 0; n != SYNC_SPIN_COUNT_DEFAULT && !_found; ++n)
+			{
+				cpu_relax();
+				_found = this->has_queued();
+			};
+			if (_found)
+			{
+				continue;
+			};
+
+			const auto _epoch = this->wake_epoch_.load(std::memory_order_acquire);
+			this->sleepers_.fetch_add(1, std::memory_order_seq_cst);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			if (this->has_queued())
+			{
+				this->sleepers_.fetch_sub(1, std::memory_order_relaxed);
+				continue;
+			};
+			if (this->stop_.load(std::memory_order_acquire))
+			{
+				this->sleepers_.fetch_sub(1, std::memory_order_relaxed);
+				break;
+			};
+			futex_wait(this->wake_epoch_, _epoch);
+			this->sleepers_.fetch_sub(1, std::memory_order_relaxed);
+		};
+
+		this_thread_pool = nullptr;
+	};
+
+	thread_pool::thread_pool(size_t _threads) :
+		worker_count_((_threads != 0) ? _threads : std::max<size_t>(std::thread::hardware_concurrency(), 1)),
+		workers_(std::make_unique<worker[]>(worker_count_))
+	{
+		this->threads_.reserve(this->worker_count_);
+		for (size_t n = 0; n != this->worker_count_; ++n)
+		{
+			this->workers_[n].rng = 0x9E3779B97F4A7C15ULL * (n + 1);
+			this->threads_.emplace_back(&thread_pool::worker_main, this, n);
+		};
+	};
+
+	thread_pool::~thread_pool()
+	{
+		this->stop_.store(true, std::memory_order_seq_cst);
+		this->wake_epoch_.fetch_add(1, std::memory_order_release);
+		futex_wake_all(this->wake_epoch_);
+		for (auto& _thread : this->threads_)
+		{
+			_thread.join();
+		};
+	};
+};
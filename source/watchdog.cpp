@@ -0,0 +1,198 @@
+#include <asx/watchdog.hpp>
+
+#include <asx/assert.hpp>
+#include <asx/logging.hpp>
+
+#include <utility>
+#include <algorithm>
+
+namespace asx
+{
+	struct watchdog::entry
+	{
+		std::string name;
+		std::chrono::milliseconds deadline;
+		os_thread_id thread;
+
+		std::atomic<uint64_t> heartbeat{ 0 };
+
+		/**
+		 * @brief Heartbeat seen at the last check and when it last changed, only used by the monitor.
+		*/
+		uint64_t last_heartbeat = 0;
+		std::chrono::steady_clock::time_point last_change{};
+
+		/**
+		 * @brief Set once the current stall has been reported, only used by the monitor.
+		*/
+		bool stalled = false;
+	};
+
+	/**
+	 * @brief Stall or recovery found by a check, reported once the monitor has released the lock.
+	*/
+	struct watchdog::event
+	{
+		std::string name;
+		os_thread_id thread;
+		std::chrono::milliseconds duration;
+		bool recovered;
+	};
+
+	watchdog::handle::handle(handle&& other) noexcept :
+		watchdog_(std::exchange(other.watchdog_, nullptr)),
+		entry_(std::exchange(other.entry_, nullptr)),
+		heartbeat_(std::exchange(other.heartbeat_, nullptr))
+	{};
+
+	watchdog::handle& watchdog::handle::operator=(handle&& other) noexcept
+	{
+		if (this != &other)
+		{
+			if (this->watchdog_)
+			{
+				this->watchdog_->unwatch(this->entry_);
+			};
+			this->watchdog_ = std::exchange(other.watchdog_, nullptr);
+			this->entry_ = std::exchange(other.entry_, nullptr);
+			this->heartbeat_ = std::exchange(other.heartbeat_, nullptr);
+		};
+		return *this;
+	};
+
+	watchdog::handle::~handle()
+	{
+		if (this->watchdog_)
+		{
+			this->watchdog_->unwatch(this->entry_);
+		};
+	};
+
+	watchdog::handle watchdog::watch(std::string _name, std::chrono::milliseconds _deadline)
+	{
+		auto _entry = std::make_unique<entry>();
+		_entry->name = std::move(_name);
+		_entry->deadline = _deadline;
+		_entry->thread = asx::get_os_thread_id();
+		_entry->last_change = std::chrono::steady_clock::now();
+
+		const auto lck = std::unique_lock(this->mtx_);
+		auto& _added = *this->entries_.emplace_back(std::move(_entry));
+		return handle(this, &_added, &_added.heartbeat);
+	};
+
+	void watchdog::unwatch(entry* _entry)
+	{
+		const auto lck = std::unique_lock(this->mtx_);
+		const auto it = std::find_if(this->entries_.begin(), this->entries_.end(), [_entry](const std::unique_ptr<entry>& v)
+		{
+			return v.get() == _entry;
+		});
+		if (it != this->entries_.end())
+		{
+			*it = std::move(this->entries_.back());
+			this->entries_.pop_back();
+		};
+	};
+
+	void watchdog::check(entry& _entry, std::chrono::steady_clock::time_point _now, std::vector<event>& _outEvents)
+	{
+		namespace ch = std::chrono;
+
+		const auto _heartbeat = _entry.heartbeat.load(std::memory_order_relaxed);
+		const bool _idle = (_heartbeat & 1) != 0;
+		if (_heartbeat != _entry.last_heartbeat || _idle)
+		{
+			if (_entry.stalled && _heartbeat != _entry.last_heartbeat)
+			{
+				_outEvents.push_back(event{ _entry.name, _entry.thread,
+					ch::duration_cast<ch::milliseconds>(_now - _entry.last_change), true });
+			};
+			_entry.last_heartbeat = _heartbeat;
+			_entry.last_change = _now;
+			_entry.stalled = false;
+			return;
+		};
+
+		if (_entry.stalled || _now - _entry.last_change < _entry.deadline)
+		{
+			return;
+		};
+
+		// Report the stall once
+		_entry.stalled = true;
+		this->stalls_.add();
+		_outEvents.push_back(event{ _entry.name, _entry.thread,
+			ch::duration_cast<ch::milliseconds>(_now - _entry.last_change), false });
+	};
+
+	void watchdog::report(const event& _event)
+	{
+		if (_event.recovered)
+		{
+			ASX_LOG_WARN("Thread \"{}\" recovered after stalling for about {} ms", _event.name, _event.duration.count());
+			return;
+		};
+
+		// The thread may have unregistered (or even exited) since the check, the capture then comes
+		// back empty or with the stack of whatever it is doing now
+		auto _trace = StackTrace(STACK_TRACE_MAX_FRAMES_DEFAULT);
+		_trace.resize(asx::get_thread_stack_trace(_event.thread, std::span<SourceLocation>(_trace.begin(), _trace.max_size())));
+		asx::log_error(StackTraceView(_trace), "Thread \"{}\" (tid {}) stalled, no heartbeat for {} ms",
+			_event.name, _event.thread, _event.duration.count());
+	};
+
+	void watchdog::monitor()
+	{
+		auto _events = std::vector<event>();
+		auto lck = std::unique_lock(this->mtx_);
+		while (!this->stop_)
+		{
+			this->cv_.wait_for(lck, this->interval_);
+			if (this->stop_)
+			{
+				break;
+			};
+
+			const auto _now = std::chrono::steady_clock::now();
+			for (auto& v : this->entries_)
+			{
+				this->check(*v, _now, _events);
+			};
+			if (_events.empty())
+			{
+				continue;
+			};
+
+			// Capturing a stack can take up to its timeout, threads may register and unregister meanwhile
+			lck.unlock();
+			for (auto& v : _events)
+			{
+				this->report(v);
+			};
+			_events.clear();
+			lck.lock();
+		};
+	};
+
+	watchdog::watchdog(const std::string& _name, std::chrono::milliseconds _interval) :
+		interval_(_interval),
+		stalls_("watchdog." + _name + ".stalls")
+	{
+		this->thread_ = std::thread([this]()
+		{
+			this->monitor();
+		});
+	};
+
+	watchdog::~watchdog()
+	{
+		{
+			const auto lck = std::unique_lock(this->mtx_);
+			ASX_CHECK(this->entries_.empty());
+			this->stop_ = true;
+		};
+		this->cv_.notify_all();
+		this->thread_.join();
+	};
+};
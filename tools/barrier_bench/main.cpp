@@ -0,0 +1,214 @@
+/**
+ * @file
+ * @brief Measures the round-trip time of `asx::barrier` (see `asx/sync.hpp`) against `std::barrier`.
+ *
+ * For each thread count every thread loops on arrive and wait. The time per round is the time for
+ * all of them to pass the barrier once. Each round's completion function checks that every thread
+ * arrived exactly once, and the exit code is non-zero if a check failed.
+*/
+
+#include <asx/sync.hpp>
+#include <asx/argparse.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+#include <barrier>
+#include <utility>
+#include <optional>
+#include <string_view>
+
+namespace
+{
+	namespace ch = std::chrono;
+
+	struct Options
+	{
+		size_t min_threads = 2;
+		size_t max_threads = 128;
+		size_t rounds = 20'000;
+		size_t fan_in = 4;
+	};
+
+	/**
+	 * @brief Parses the command line arguments.
+	 * @return Parsed options, or nullopt if the program should exit.
+	*/
+	std::optional<Options> parse_options(int _nargs, const char* const* _vargs, int& _outExitCode)
+	{
+		auto _parser = asx::ArgumentParser("asx_barrier_bench",
+			"Measures the round-trip time of asx::barrier against std::barrier.\n"
+			"Thread counts double from --min-threads up to --max-threads.");
+		_parser.add_argument("min-threads", "Smallest number of threads, defaults to 2").add_name("--min-threads");
+		_parser.add_argument("max-threads", "Largest number of threads, defaults to 128").add_name("--max-threads");
+		_parser.add_argument("rounds", "Number of rounds per thread count, defaults to 20000").add_name("-n").add_name("--rounds");
+		_parser.add_argument("fan-in", "Fan-in of the asx::barrier tree, defaults to 4").add_name("--fan-in");
+
+		const auto _result = _parser.parse_args_no_execute_filename(std::vector<std::string_view>(_vargs + 1, _vargs + _nargs));
+		_outExitCode = _result.error() ? 2 : 0;
+		if (_result.error())
+		{
+			std::fprintf(stderr, "asx_barrier_bench: %s\n", _result.message().c_str());
+			return std::nullopt;
+		}
+		else if (_result.should_exit())
+		{
+			std::fputs(_result.message().c_str(), stdout);
+			return std::nullopt;
+		};
+
+		auto _options = Options{};
+		for (auto [_label, _target] : { std::pair{ "min-threads", &_options.min_threads }, std::pair{ "max-threads", &_options.max_threads },
+			std::pair{ "rounds", &_options.rounds }, std::pair{ "fan-in", &_options.fan_in } })
+		{
+			const auto _argument = _result.get(_label);
+			if (!_argument)
+			{
+				continue;
+			};
+
+			const auto _value = _argument->to_number<size_t>();
+			if (!_value || *_value == 0)
+			{
+				std::fprintf(stderr, "asx_barrier_bench: invalid value \"%s\" for \"%s\"\n", _argument->get<std::string>().c_str(), _label);
+				_outExitCode = 2;
+				return std::nullopt;
+			};
+			*_target = *_value;
+		};
+
+		if (_options.min_threads > _options.max_threads || _options.fan_in < 2)
+		{
+			std::fprintf(stderr, "asx_barrier_bench: invalid thread range or fan-in, see --help\n");
+			_outExitCode = 2;
+			return std::nullopt;
+		};
+		return _options;
+	};
+
+
+
+	/**
+	 * @brief Counts arrivals, checked against the participant count by each round's completion.
+	*/
+	struct RoundCheck
+	{
+		std::atomic<size_t> arrivals{ 0 };
+		std::atomic<size_t> rounds{ 0 };
+		std::atomic<size_t> failures{ 0 };
+		size_t participants = 0;
+
+		void complete() noexcept
+		{
+			const auto _round = this->rounds.fetch_add(1, std::memory_order_relaxed) + 1;
+			if (this->arrivals.load(std::memory_order_relaxed) != _round * this->participants)
+			{
+				this->failures.fetch_add(1, std::memory_order_relaxed);
+			};
+		};
+	};
+
+	/**
+	 * @brief Runs every thread through the rounds.
+	 * @param _arriveAndWait Invoked as `_arriveAndWait(id)` once per thread per round.
+	 * @return Mean time per round in microseconds.
+	*/
+	template <typename FnT>
+	double time_rounds(size_t _threadCount, size_t _rounds, RoundCheck& _check, FnT&& _arriveAndWait)
+	{
+		auto _ready = std::atomic<size_t>(0);
+		const auto _work = [&](size_t _id)
+		{
+			// Start everyone together so thread creation isn't measured
+			_ready.fetch_add(1);
+			while (_ready.load() != _threadCount)
+			{
+				std::this_thread::yield();
+			};
+			for (size_t n = 0; n != _rounds; ++n)
+			{
+				_check.arrivals.fetch_add(1, std::memory_order_relaxed);
+				_arriveAndWait(_id);
+			};
+		};
+
+		auto _threads = std::vector<std::thread>();
+		for (size_t n = 1; n < _threadCount; ++n)
+		{
+			_threads.emplace_back(_work, n);
+		};
+
+		const auto _startTime = ch::steady_clock::now();
+		_work(0);
+		const auto _elapsed = ch::steady_clock::now() - _startTime;
+		for (auto& _thread : _threads)
+		{
+			_thread.join();
+		};
+		return ch::duration<double, std::micro>(_elapsed).count() / static_cast<double>(_rounds);
+	};
+
+	bool check_rounds(const RoundCheck& _check, size_t _rounds, const char* _name, size_t _threadCount)
+	{
+		const auto _passed = _check.failures.load() == 0 && _check.rounds.load() == _rounds;
+		if (!_passed)
+		{
+			std::printf("  [FAIL] %s with %zu threads: %zu of %zu rounds completed, %zu with missing arrivals\n",
+				_name, _threadCount, _check.rounds.load(), _rounds, _check.failures.load());
+		};
+		return _passed;
+	};
+
+	bool run(size_t _threadCount, const Options& _options)
+	{
+		auto _asxCheck = RoundCheck{};
+		_asxCheck.participants = _threadCount;
+		auto _asxBarrier = asx::barrier(_threadCount, [&] { _asxCheck.complete(); }, _options.fan_in);
+		const auto _asxTime = time_rounds(_threadCount, _options.rounds, _asxCheck, [&](size_t _id)
+		{
+			_asxBarrier.arrive_and_wait(_id);
+		});
+
+		auto _stdCheck = RoundCheck{};
+		_stdCheck.participants = _threadCount;
+		const auto _stdCompletion = [&]() noexcept { _stdCheck.complete(); };
+		auto _stdBarrier = std::barrier(static_cast<std::ptrdiff_t>(_threadCount), _stdCompletion);
+		const auto _stdTime = time_rounds(_threadCount, _options.rounds, _stdCheck, [&](size_t)
+		{
+			_stdBarrier.arrive_and_wait();
+		});
+
+		std::printf("%8zu %14.2f %14.2f %8.2fx\n", _threadCount, _asxTime, _stdTime, _stdTime / _asxTime);
+
+		bool _passed = true;
+		_passed &= check_rounds(_asxCheck, _options.rounds, "asx::barrier", _threadCount);
+		_passed &= check_rounds(_stdCheck, _options.rounds, "std::barrier", _threadCount);
+		return _passed;
+	};
+};
+
+int main(int _nargs, const char* _vargs[])
+{
+	int _exitCode = 0;
+	const auto _options = parse_options(_nargs, _vargs, _exitCode);
+	if (!_options)
+	{
+		return _exitCode;
+	};
+
+	std::printf("%zu hardware threads, %zu rounds, fan-in %zu\n",
+		static_cast<size_t>(std::thread::hardware_concurrency()), _options->rounds, _options->fan_in);
+	std::printf("%8s %14s %14s %9s\n", "threads", "asx (us/rnd)", "std (us/rnd)", "speedup");
+
+	bool _passed = true;
+	for (auto _threads = _options->min_threads; _threads <= _options->max_threads; _threads *= 2)
+	{
+		_passed &= run(_threads, *_options);
+	};
+
+	std::fflush(stdout);
+	return _passed ? 0 : 1;
+};
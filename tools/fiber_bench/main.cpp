@@ -0,0 +1,276 @@
+/**
+ * @file
+ * @brief Benchmarks and checks for `asx/fiber.hpp`.
+ *
+ * Times the resume and yield round trip of a bare fiber, checks that an exception thrown on a fiber
+ * is rethrown by the resume that finishes it, and runs scheduled fibers against each other on a
+ * `fiber_mutex` and a `message_queue` read with `fiber_wait_next()`. The exit code is non-zero if
+ * any check failed.
+*/
+
+#include <asx/fiber.hpp>
+#include <asx/argparse.hpp>
+#include <asx/thread_pool.hpp>
+#include <asx/message_queue.hpp>
+
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <utility>
+#include <optional>
+#include <stdexcept>
+#include <string_view>
+
+namespace
+{
+	namespace ch = std::chrono;
+
+	struct Options
+	{
+		size_t threads = std::max<size_t>(std::thread::hardware_concurrency(), 2);
+		size_t round_trips = 1'000'000;
+		size_t fibers = 64;
+		size_t locks = 2'000;
+		size_t messages = 100'000;
+	};
+
+	/**
+	 * @brief Parses the command line arguments.
+	 * @return Parsed options, or nullopt if the program should exit.
+	*/
+	std::optional<Options> parse_options(int _nargs, const char* const* _vargs, int& _outExitCode)
+	{
+		auto _parser = asx::ArgumentParser("asx_fiber_bench",
+			"Benchmarks fiber switching, fiber_mutex and fiber_wait_next, checking each along the way.");
+		_parser.add_argument("threads", "Number of scheduler threads, defaults to the hardware concurrency").add_name("-j").add_name("--threads");
+		_parser.add_argument("round-trips", "Number of resume and yield round trips to time, defaults to 1000000").add_name("-n").add_name("--round-trips");
+		_parser.add_argument("fibers", "Number of fibers contending on the mutex, defaults to 64").add_name("--fibers");
+		_parser.add_argument("locks", "Number of times each fiber locks the mutex, defaults to 2000").add_name("--locks");
+		_parser.add_argument("messages", "Number of messages sent through the queue, defaults to 100000").add_name("--messages");
+
+		const auto _result = _parser.parse_args_no_execute_filename(std::vector<std::string_view>(_vargs + 1, _vargs + _nargs));
+		_outExitCode = _result.error() ? 2 : 0;
+		if (_result.error())
+		{
+			std::fprintf(stderr, "asx_fiber_bench: %s\n", _result.message().c_str());
+			return std::nullopt;
+		}
+		else if (_result.should_exit())
+		{
+			std::fputs(_result.message().c_str(), stdout);
+			return std::nullopt;
+		};
+
+		auto _options = Options{};
+		for (auto [_label, _target] : { std::pair{ "threads", &_options.threads }, std::pair{ "round-trips", &_options.round_trips },
+			std::pair{ "fibers", &_options.fibers }, std::pair{ "locks", &_options.locks }, std::pair{ "messages", &_options.messages } })
+		{
+			const auto _argument = _result.get(_label);
+			if (!_argument)
+			{
+				continue;
+			};
+
+			const auto _value = _argument->to_number<size_t>();
+			if (!_value || *_value == 0)
+			{
+				std::fprintf(stderr, "asx_fiber_bench: invalid value \"%s\" for \"%s\"\n", _argument->get<std::string>().c_str(), _label);
+				_outExitCode = 2;
+				return std::nullopt;
+			};
+			*_target = *_value;
+		};
+		return _options;
+	};
+
+
+
+	bool check(bool _passed, const char* _what)
+	{
+		std::printf("  [%s] %s\n", _passed ? "PASS" : "FAIL", _what);
+		return _passed;
+	};
+
+	double nanoseconds_per(ch::steady_clock::duration _elapsed, size_t _count)
+	{
+		return ch::duration<double, std::nano>(_elapsed).count() / static_cast<double>(_count);
+	};
+
+	/**
+	 * @brief Times resuming a fiber that immediately yields back.
+	*/
+	bool run_round_trip(const Options& _options)
+	{
+		size_t _count = 0;
+		auto _fiber = asx::fiber([&]
+		{
+			for (size_t n = 0; n != _options.round_trips; ++n)
+			{
+				++_count;
+				asx::fiber::yield();
+			};
+		});
+
+		const auto _startTime = ch::steady_clock::now();
+		for (size_t n = 0; n != _options.round_trips; ++n)
+		{
+			_fiber.resume();
+		};
+		const auto _elapsed = ch::steady_clock::now() - _startTime;
+
+		// One more resume lets the function return
+		const auto _resumable = _fiber.resume();
+		std::printf("round trip: %.1f ns per resume and yield\n", nanoseconds_per(_elapsed, _options.round_trips));
+
+		bool _passed = true;
+		_passed &= check(_count == _options.round_trips, "fiber ran once per resume");
+		_passed &= check(!_resumable && _fiber.done(), "fiber finished after its last resume");
+		return _passed;
+	};
+
+	/**
+	 * @brief Checks an exception thrown on a fiber comes out of the resume that finishes it.
+	*/
+	bool run_exception()
+	{
+		auto _fiber = asx::fiber([]
+		{
+			asx::fiber::yield();
+			throw std::runtime_error("thrown on a fiber");
+		});
+
+		const auto _resumable = _fiber.resume();
+		bool _rethrown = false;
+		try
+		{
+			_fiber.resume();
+		}
+		catch (const std::runtime_error& _exc)
+		{
+			_rethrown = std::string_view(_exc.what()) == "thrown on a fiber";
+		};
+
+		bool _passed = true;
+		_passed &= check(_resumable, "fiber yielded before throwing");
+		_passed &= check(_rethrown && _fiber.done(), "exception was rethrown by resume");
+		return _passed;
+	};
+
+	/**
+	 * @brief Runs fibers and one plain thread against the same fiber_mutex.
+	*/
+	bool run_mutex(const Options& _options)
+	{
+		auto _pool = asx::thread_pool(_options.threads);
+		auto _mutex = asx::fiber_mutex();
+		size_t _counter = 0;
+
+		// Yielding while holding the lock makes the other fibers park on it
+		const auto _work = [&]
+		{
+			for (size_t n = 0; n != _options.locks; ++n)
+			{
+				const auto lck = std::unique_lock(_mutex);
+				const auto _value = _counter;
+				if (n % 8 == 0)
+				{
+					asx::fiber_scheduler::yield();
+				};
+				_counter = _value + 1;
+			};
+		};
+
+		const auto _startTime = ch::steady_clock::now();
+		{
+			auto _scheduler = asx::fiber_scheduler(_pool);
+			for (size_t n = 0; n != _options.fibers; ++n)
+			{
+				_scheduler.spawn(_work);
+			};
+
+			// Threads that aren't on a fiber block on a futex instead
+			auto _thread = std::thread(_work);
+			_scheduler.wait_idle();
+			_thread.join();
+		};
+		const auto _elapsed = ch::steady_clock::now() - _startTime;
+
+		const auto _expected = (_options.fibers + 1) * _options.locks;
+		std::printf("fiber_mutex: %zu fibers and 1 thread, %.1f ns per lock\n", _options.fibers, nanoseconds_per(_elapsed, _expected));
+		return check(_counter == _expected, "no increment was lost under the fiber_mutex");
+	};
+
+	/**
+	 * @brief Sends messages to a fiber and to a plain thread reading with fiber_wait_next().
+	*/
+	bool run_queue(const Options& _options)
+	{
+		auto _pool = asx::thread_pool(_options.threads);
+
+		// Reads every message, counting any that arrive out of order
+		const auto _read = [&](asx::message_queue<size_t>& _queue, size_t& _outOfOrder)
+		{
+			for (size_t n = 0; n != _options.messages; ++n)
+			{
+				_outOfOrder += asx::fiber_wait_next(_queue) != n;
+			};
+		};
+		const auto _send = [&](asx::message_queue<size_t>& _queue)
+		{
+			for (size_t n = 0; n != _options.messages; ++n)
+			{
+				_queue.push(n);
+			};
+		};
+
+		auto _fiberQueue = asx::message_queue<size_t>();
+		size_t _fiberOutOfOrder = 0;
+		const auto _startTime = ch::steady_clock::now();
+		{
+			auto _scheduler = asx::fiber_scheduler(_pool);
+			_scheduler.spawn([&] { _read(_fiberQueue, _fiberOutOfOrder); });
+			_send(_fiberQueue);
+			_scheduler.wait_idle();
+		};
+		const auto _elapsed = ch::steady_clock::now() - _startTime;
+
+		auto _threadQueue = asx::message_queue<size_t>();
+		size_t _threadOutOfOrder = 0;
+		{
+			auto _thread = std::thread([&] { _read(_threadQueue, _threadOutOfOrder); });
+			_send(_threadQueue);
+			_thread.join();
+		};
+
+		std::printf("fiber_wait_next: %.1f ns per message to a fiber\n", nanoseconds_per(_elapsed, _options.messages));
+
+		bool _passed = true;
+		_passed &= check(_fiberOutOfOrder == 0 && _fiberQueue.empty(), "fiber received every message in order");
+		_passed &= check(_threadOutOfOrder == 0 && _threadQueue.empty(), "thread received every message in order");
+		return _passed;
+	};
+};
+
+int main(int _nargs, const char* _vargs[])
+{
+	int _exitCode = 0;
+	const auto _options = parse_options(_nargs, _vargs, _exitCode);
+	if (!_options)
+	{
+		return _exitCode;
+	};
+
+	bool _passed = true;
+	_passed &= run_round_trip(*_options);
+	_passed &= run_exception();
+	_passed &= run_mutex(*_options);
+	_passed &= run_queue(*_options);
+
+	std::fflush(stdout);
+	return _passed ? 0 : 1;
+};
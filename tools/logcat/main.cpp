@@ -0,0 +1,369 @@
+/**
+ * @file
+ * @brief Decodes binary log files (see `asx/binlog.hpp`) into text or JSON.
+ *
+ * The side index written alongside log files (see `asx/log_index.hpp`) is used to
+ * map only the part of a file within the requested time range.
+ *
+ * Segments are decoded (and decompressed) in parallel and written out in file order. Records are
+ * filtered by level and time range before their arguments are touched, so skipped
+ * records are never formatted.
+*/
+
+#include <asx/binlog.hpp>
+#include <asx/logging.hpp>
+#include <asx/argparse.hpp>
+#include <asx/encoding.hpp>
+#include <asx/log_index.hpp>
+#include <asx/mapped_file.hpp>
+#include <asx/fmt/chrono.hpp>
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+#include <optional>
+#include <algorithm>
+#include <string_view>
+
+namespace
+{
+	namespace binlog = asx::binlog;
+
+	enum class OutputFormat
+	{
+		text,
+		json,
+	};
+
+	struct Options
+	{
+		std::vector<std::string> files;
+		OutputFormat format = OutputFormat::text;
+		uint8_t max_level = static_cast<uint8_t>(asx::LogLevel::info);
+		uint64_t time_begin = 0;
+		uint64_t time_end = UINT64_MAX;
+		size_t threads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+	};
+
+	std::optional<uint8_t> parse_level(std::string_view _name)
+	{
+		for (uint8_t n = 1; n != static_cast<uint8_t>(asx::LogLevel::all); ++n)
+		{
+			if (binlog::level_name(n) == _name)
+			{
+				return n;
+			};
+		};
+		return std::nullopt;
+	};
+
+	std::optional<uint64_t> parse_seconds(const asx::ArgumentParser::ParsedValue& _value)
+	{
+		const auto _seconds = _value.to_number<double>();
+		if (!_seconds || *_seconds < 0)
+		{
+			return std::nullopt;
+		};
+		return static_cast<uint64_t>(*_seconds * 1'000'000'000.0);
+	};
+
+	/**
+	 * @brief Parses the command line arguments.
+	 * @return Parsed options, or nullopt if the program should exit.
+	*/
+	std::optional<Options> parse_options(int _nargs, const char* const* _vargs, int& _outExitCode)
+	{
+		auto _parser = asx::ArgumentParser("asx_logcat",
+			"Decodes binary log files written by asx::set_binary_log_file().\n"
+			"Text log files are passed through, use --since/--until to cut a time window out of them.");
+		_parser.add_argument("files", "Log files to decode").set_nargs(255, true);
+		_parser.add_argument("format", "Output format, \"text\" (default) or \"json\"").add_name("-f").add_name("--format");
+		_parser.add_argument("level", "Most verbose level to output: fatal, error, warn or info (default)").add_name("-l").add_name("--level");
+		_parser.add_argument("since", "Skip records before this time, in seconds since the unix epoch").add_name("--since");
+		_parser.add_argument("until", "Skip records after this time, in seconds since the unix epoch").add_name("--until");
+		_parser.add_argument("threads", "Number of decoding threads, defaults to the hardware concurrency").add_name("-j").add_name("--threads");
+
+		const auto _result = _parser.parse_args_no_execute_filename(std::vector<std::string_view>(_vargs + 1, _vargs + _nargs));
+		_outExitCode = 0;
+
+		const auto _fail = [&](std::string_view _message) -> std::optional<Options>
+		{
+			std::fprintf(stderr, "asx_logcat: %.*s\n", static_cast<int>(_message.size()), _message.data());
+			_outExitCode = 2;
+			return std::nullopt;
+		};
+
+		if (_result.error())
+		{
+			return _fail(_result.message());
+		}
+		else if (_result.should_exit())
+		{
+			std::fputs(_result.message().c_str(), stdout);
+			return std::nullopt;
+		};
+
+		auto _options = Options{};
+		for (auto& _file : _result.get("files"))
+		{
+			_options.files.push_back(_file.get<std::string>());
+		};
+
+		if (const auto _format = _result.get("format"))
+		{
+			const auto& _value = _format->get<std::string>();
+			if (_value == "text") { _options.format = OutputFormat::text; }
+			else if (_value == "json") { _options.format = OutputFormat::json; }
+			else { return _fail(asx::format("unknown output format \"{}\"", _value)); };
+		};
+		if (const auto _level = _result.get("level"))
+		{
+			const auto _value = parse_level(_level->get<std::string>());
+			if (!_value) { return _fail(asx::format("unknown level \"{}\"", _level->get<std::string>())); };
+			_options.max_level = *_value;
+		};
+		if (const auto _since = _result.get("since"))
+		{
+			const auto _time = parse_seconds(*_since);
+			if (!_time) { return _fail(asx::format("invalid time \"{}\"", _since->get<std::string>())); };
+			_options.time_begin = *_time;
+		};
+		if (const auto _until = _result.get("until"))
+		{
+			const auto _time = parse_seconds(*_until);
+			if (!_time) { return _fail(asx::format("invalid time \"{}\"", _until->get<std::string>())); };
+			_options.time_end = *_time;
+		};
+		if (const auto _threads = _result.get("threads"))
+		{
+			const auto _value = _threads->to_number<size_t>();
+			if (!_value || *_value == 0) { return _fail(asx::format("invalid thread count \"{}\"", _threads->get<std::string>())); };
+			_options.threads = *_value;
+		};
+		return _options;
+	};
+
+
+
+	void append_json_string(std::string& _out, std::string_view _str)
+	{
+		_out.push_back('"');
+		asx::json_escape_to(_out, _str);
+		_out.push_back('"');
+	};
+
+	std::string timestamp_to_string(uint64_t _timestamp)
+	{
+		namespace ch = std::chrono;
+		const auto _time = asx::utc_time(ch::duration_cast<asx::utc_time::duration>(ch::nanoseconds(_timestamp)));
+		const auto _millis = (_timestamp / 1'000'000) % 1000;
+		return asx::format("{}.{:03}", asx::utc_timestamp_to_string(_time), _millis);
+	};
+
+	/**
+	 * @brief Decodes the records of a segment that pass the filters.
+	 * @param _bytes Bytes of a segment already checked by `binlog::check_segment`.
+	 * @param _options Filtering and output options.
+	 * @param _out String to append the decoded output to.
+	*/
+	void decode_segment(std::span<const std::byte> _bytes, const Options& _options, std::string& _out)
+	{
+		// Compressed record blocks are decompressed into a buffer reused by each decoding thread
+		thread_local std::vector<std::byte> _buffer{};
+
+		auto _segment = binlog::segment_view{};
+		if (!binlog::segment_view::parse_checked(_bytes, _segment, &_buffer))
+		{
+			return;
+		};
+
+		auto _message = std::string();
+		auto _record = binlog::record_view{};
+		for (size_t _offset = 0; _segment.next_record(_offset, _record);)
+		{
+			// Filter using only the record header
+			if (_record.level > _options.max_level ||
+				_record.timestamp < _options.time_begin ||
+				_record.timestamp > _options.time_end)
+			{
+				continue;
+			};
+
+			_message.clear();
+			if (!binlog::format_record(_segment, _record, _message))
+			{
+				_message = "<malformed record>";
+			};
+
+			const auto _entry = _segment.find_entry(_record.site_id);
+			const auto _hasSite = _entry && _entry->kind == binlog::entry_kind::callsite;
+
+			if (_options.format == OutputFormat::json)
+			{
+				_out.append(asx::format("{{\"timestamp\":{},\"level\":\"{}\",\"message\":",
+					_record.timestamp, binlog::level_name(_record.level)));
+				append_json_string(_out, _message);
+				if (_hasSite)
+				{
+					_out.append(",\"file\":");
+					append_json_string(_out, _entry->file);
+					_out.append(",\"function\":");
+					append_json_string(_out, _entry->function);
+					_out.append(asx::format(",\"line\":{}", _entry->line));
+				};
+				_out.append("}\n");
+			}
+			else
+			{
+				_out.append(asx::format("{} [{}] {}", timestamp_to_string(_record.timestamp), binlog::level_name(_record.level), _message));
+				if (_hasSite)
+				{
+					_out.append(asx::format(" ({} line {})", _entry->file, _entry->line));
+				};
+				_out.push_back('\n');
+			};
+		};
+	};
+
+	/**
+	 * @brief Finds and checks the segments in a mapped file, without decoding them.
+	 *
+	 * Every segment is checked before its size is trusted to skip it, so a damaged header can't skip
+	 * over intact segments. Invalid data is reported and skipped up to the next segment magic, so a
+	 * damaged file is decoded as far as possible.
+	 *
+	 * @return Spans viewing each intact segment whose time range overlaps the filter.
+	*/
+	std::vector<std::span<const std::byte>> find_segments(std::span<const std::byte> _bytes, const Options& _options, std::string_view _path)
+	{
+		auto _segments = std::vector<std::span<const std::byte>>();
+
+		size_t _offset = 0;
+		while (_offset < _bytes.size())
+		{
+			auto _header = binlog::segment_header{};
+			const auto _remaining = _bytes.size() - _offset;
+			if (_remaining < sizeof(_header))
+			{
+				std::fprintf(stderr, "asx_logcat: %.*s: truncated segment header at offset %zu\n",
+					static_cast<int>(_path.size()), _path.data(), _offset);
+				break;
+			};
+
+			size_t _size = 0;
+			if (!binlog::check_segment(_bytes.subspan(_offset), &_size))
+			{
+				const auto _next = binlog::find_segment_magic(_bytes, _offset + 1);
+				std::fprintf(stderr, "asx_logcat: %.*s: skipped %zu bytes of invalid or truncated data at offset %zu\n",
+					static_cast<int>(_path.size()), _path.data(), _next - _offset, _offset);
+				_offset = _next;
+				continue;
+			};
+
+			// Skip whole segments outside of the time range
+			std::memcpy(&_header, _bytes.data() + _offset, sizeof(_header));
+			if (_header.time_end >= _options.time_begin && _header.time_begin <= _options.time_end)
+			{
+				_segments.push_back(_bytes.subspan(_offset, _size));
+			};
+			_offset += _size;
+		};
+
+		return _segments;
+	};
+
+	/**
+	 * @brief Checks if mapped bytes begin with a binary log segment.
+	*/
+	bool is_binary_log(std::span<const std::byte> _bytes)
+	{
+		return _bytes.size() >= binlog::SEGMENT_MAGIC.size() &&
+			std::memcmp(_bytes.data(), binlog::SEGMENT_MAGIC.data(), binlog::SEGMENT_MAGIC.size()) == 0;
+	};
+
+	/**
+	 * @brief Decodes the segments of a file in parallel, writing the output in file order.
+	 *
+	 * The file's side index (if any) is used to skip to the part of the file within the time range.
+	 * Text logs are written out verbatim, so a time range can be used to cut a window out of them.
+	*/
+	bool decode_file(const std::string& _path, const Options& _options)
+	{
+		const auto _file = asx::map_log_time_range(_path.c_str(), _options.time_begin, _options.time_end);
+		if (!_file)
+		{
+			// Empty files and ranges map nothing but aren't an error
+			return asx::mapped_file::file_size(_path.c_str()) != asx::mapped_file::npos;
+		};
+
+		if (!is_binary_log(_file.data()))
+		{
+			std::fwrite(_file.data().data(), 1, _file.size(), stdout);
+			return true;
+		};
+
+		const auto _segments = find_segments(_file.data(), _options, _path);
+
+		// Decode in batches to bound the amount of buffered output
+		const auto _batchSize = _options.threads * 4;
+		auto _outputs = std::vector<std::string>(_batchSize);
+
+		for (size_t _batchBegin = 0; _batchBegin < _segments.size(); _batchBegin += _batchSize)
+		{
+			const auto _batchCount = std::min(_batchSize, _segments.size() - _batchBegin);
+			auto _next = std::atomic<size_t>{ 0 };
+
+			const auto _work = [&]()
+			{
+				for (auto n = _next.fetch_add(1); n < _batchCount; n = _next.fetch_add(1))
+				{
+					_outputs[n].clear();
+					decode_segment(_segments[_batchBegin + n], _options, _outputs[n]);
+				};
+			};
+
+			auto _threads = std::vector<std::thread>();
+			const auto _threadCount = std::min(_options.threads, _batchCount);
+			for (size_t n = 1; n < _threadCount; ++n)
+			{
+				_threads.emplace_back(_work);
+			};
+			_work();
+			for (auto& _thread : _threads)
+			{
+				_thread.join();
+			};
+
+			for (size_t n = 0; n != _batchCount; ++n)
+			{
+				std::fwrite(_outputs[n].data(), 1, _outputs[n].size(), stdout);
+			};
+		};
+
+		return true;
+	};
+};
+
+int main(int _nargs, const char* _vargs[])
+{
+	int _exitCode = 0;
+	const auto _options = parse_options(_nargs, _vargs, _exitCode);
+	if (!_options)
+	{
+		return _exitCode;
+	};
+
+	for (auto& _path : _options->files)
+	{
+		if (!decode_file(_path, *_options))
+		{
+			_exitCode = 1;
+		};
+	};
+
+	std::fflush(stdout);
+	return _exitCode;
+};
@@ -0,0 +1,414 @@
+/**
+ * @file
+ * @brief Contention tests and reclamation benchmarks for `asx/hazard_pointer.hpp` and `asx/epoch.hpp`.
+ *
+ * Readers hammer a small set of shared slots while writers keep swapping new nodes into them and
+ * retiring the old ones. Retired nodes are poisoned instead of freed until the run ends, so a reader
+ * that gets to a node after it was reclaimed is caught instead of reading freed memory.
+ *
+ * Each run reports the read and retire throughput, the latency from retiring a node to its deleter
+ * running and the peak number of retired nodes not yet reclaimed. The exit code is non-zero if any
+ * check failed.
+*/
+
+#include <asx/epoch.hpp>
+#include <asx/argparse.hpp>
+#include <asx/hazard_pointer.hpp>
+
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <string>
+#include <vector>
+#include <utility>
+#include <optional>
+#include <algorithm>
+#include <string_view>
+
+namespace
+{
+	namespace ch = std::chrono;
+
+	/**
+	 * @brief Number of shared slots readers and writers contend on.
+	*/
+	constexpr size_t SLOT_COUNT = 4;
+
+	constexpr uint32_t NODE_ALIVE = 0xA11CE;
+	constexpr uint32_t NODE_DEAD = 0xDEAD;
+
+	struct Options
+	{
+		size_t readers = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+		size_t writers = 2;
+		size_t ops = 200'000;
+	};
+
+	/**
+	 * @brief Parses the command line arguments.
+	 * @return Parsed options, or nullopt if the program should exit.
+	*/
+	std::optional<Options> parse_options(int _nargs, const char* const* _vargs, int& _outExitCode)
+	{
+		auto _parser = asx::ArgumentParser("asx_reclaim_bench",
+			"Runs contention tests and reclamation benchmarks of asx::hazard_domain and asx::epoch_domain.");
+		_parser.add_argument("readers", "Number of reader threads, defaults to the hardware concurrency").add_name("-r").add_name("--readers");
+		_parser.add_argument("writers", "Number of writer threads, defaults to 2").add_name("-w").add_name("--writers");
+		_parser.add_argument("ops", "Number of nodes each writer retires, defaults to 200000").add_name("-n").add_name("--ops");
+
+		const auto _result = _parser.parse_args_no_execute_filename(std::vector<std::string_view>(_vargs + 1, _vargs + _nargs));
+		_outExitCode = _result.error() ? 2 : 0;
+		if (_result.error())
+		{
+			std::fprintf(stderr, "asx_reclaim_bench: %s\n", _result.message().c_str());
+			return std::nullopt;
+		}
+		else if (_result.should_exit())
+		{
+			std::fputs(_result.message().c_str(), stdout);
+			return std::nullopt;
+		};
+
+		auto _options = Options{};
+		for (auto [_label, _target] : { std::pair{ "readers", &_options.readers }, std::pair{ "writers", &_options.writers }, std::pair{ "ops", &_options.ops } })
+		{
+			const auto _argument = _result.get(_label);
+			if (!_argument)
+			{
+				continue;
+			};
+
+			const auto _value = _argument->to_number<size_t>();
+			if (!_value || *_value == 0)
+			{
+				std::fprintf(stderr, "asx_reclaim_bench: invalid value \"%s\" for \"%s\"\n", _argument->get<std::string>().c_str(), _label);
+				_outExitCode = 2;
+				return std::nullopt;
+			};
+			*_target = *_value;
+		};
+		return _options;
+	};
+
+
+
+	struct Node
+	{
+		std::atomic<uint32_t> magic{ NODE_ALIVE };
+		ch::steady_clock::time_point retired_at{};
+		ch::nanoseconds reclaim_latency{};
+	};
+
+	/**
+	 * @brief Bookkeeping shared with the deleter, which can't carry any state of its own.
+	*/
+	struct Tracker
+	{
+		std::atomic<size_t> retired{ 0 };
+		std::atomic<size_t> reclaimed{ 0 };
+		std::atomic<size_t> peak_outstanding{ 0 };
+
+		std::mutex graveyard_mtx;
+		std::vector<Node*> graveyard;
+
+		/**
+		 * @brief Records the number of retired nodes waiting to be reclaimed.
+		*/
+		void sample_outstanding() noexcept
+		{
+			const auto _reclaimed = this->reclaimed.load(std::memory_order_relaxed);
+			const auto _outstanding = this->retired.load(std::memory_order_relaxed) - _reclaimed;
+			auto _peak = this->peak_outstanding.load(std::memory_order_relaxed);
+			while (_outstanding > _peak && !this->peak_outstanding.compare_exchange_weak(_peak, _outstanding, std::memory_order_relaxed))
+			{};
+		};
+
+		void reset()
+		{
+			for (auto _node : this->graveyard)
+			{
+				delete _node;
+			};
+			this->graveyard.clear();
+			this->retired = 0;
+			this->reclaimed = 0;
+			this->peak_outstanding = 0;
+		};
+	};
+
+	Tracker tracker_{};
+
+	/**
+	 * @brief Deleter given to the domains, poisons the node and keeps it around until the run ends.
+	*/
+	void bury_node(void* _ptr)
+	{
+		const auto _node = static_cast<Node*>(_ptr);
+		_node->reclaim_latency = ch::steady_clock::now() - _node->retired_at;
+		_node->magic.store(NODE_DEAD, std::memory_order_relaxed);
+		tracker_.reclaimed.fetch_add(1, std::memory_order_relaxed);
+
+		const auto lck = std::unique_lock(tracker_.graveyard_mtx);
+		tracker_.graveyard.push_back(_node);
+	};
+
+	struct HazardScheme
+	{
+		static constexpr auto name = "hazard_pointer";
+
+		struct Reader
+		{
+			Node* read(const std::atomic<Node*>& _slot) noexcept
+			{
+				return this->hp.protect(_slot);
+			};
+			void done() noexcept
+			{
+				this->hp.reset_protection();
+			};
+
+			asx::hazard_pointer hp;
+		};
+
+		Reader make_reader()
+		{
+			return Reader{ asx::hazard_pointer(this->domain) };
+		};
+		void retire(Node* _node)
+		{
+			this->domain.retire(_node, &bury_node);
+		};
+		void reclaim_all()
+		{
+			this->domain.reclaim();
+		};
+
+		/**
+		 * @brief Each writer holds back at most one scan threshold plus one node per slot.
+		*/
+		std::optional<size_t> memory_bound(const Options& _options) const
+		{
+			const auto _slots = this->domain.slot_count();
+			return _options.writers * (asx::HAZARD_SCAN_THRESHOLD_MIN + 3 * _slots + 1);
+		};
+
+		asx::hazard_domain domain{};
+	};
+
+	struct EpochScheme
+	{
+		static constexpr auto name = "epoch";
+
+		struct Reader
+		{
+			Node* read(const std::atomic<Node*>& _slot)
+			{
+				this->guard.emplace(this->domain->pin());
+				return _slot.load(std::memory_order_acquire);
+			};
+			void done() noexcept
+			{
+				this->guard.reset();
+			};
+
+			asx::epoch_domain* domain;
+			std::optional<asx::epoch_guard> guard{};
+		};
+
+		Reader make_reader()
+		{
+			return Reader{ &this->domain };
+		};
+		void retire(Node* _node)
+		{
+			this->domain.retire(_node, &bury_node);
+		};
+		void reclaim_all()
+		{
+			this->domain.synchronize();
+		};
+
+		/**
+		 * @brief Epochs have no fixed bound, a slow reader holds back every writer.
+		*/
+		std::optional<size_t> memory_bound(const Options&) const
+		{
+			return std::nullopt;
+		};
+
+		asx::epoch_domain domain{};
+	};
+
+	bool check(bool _passed, const char* _scheme, const char* _what)
+	{
+		std::printf("  [%s] %s: %s\n", _passed ? "PASS" : "FAIL", _scheme, _what);
+		return _passed;
+	};
+
+	/**
+	 * @brief Checks a retired node survives while a reader protects it and is reclaimed once released.
+	*/
+	template <typename Scheme>
+	bool run_stalled_reader()
+	{
+		auto _scheme = Scheme{};
+		auto _slot = std::atomic<Node*>(new Node{});
+		bool _passed = true;
+		{
+			auto _reader = _scheme.make_reader();
+			const auto _node = _reader.read(_slot);
+
+			_node->retired_at = ch::steady_clock::now();
+			_scheme.retire(_slot.exchange(new Node{}));
+			for (int n = 0; n != 8; ++n)
+			{
+				_scheme.domain.reclaim();
+			};
+			_passed &= check(_node->magic.load() == NODE_ALIVE, Scheme::name, "protected node survives reclamation");
+
+			_reader.done();
+			_scheme.reclaim_all();
+			_passed &= check(_node->magic.load() == NODE_DEAD, Scheme::name, "released node is reclaimed");
+		};
+
+		delete _slot.load();
+		tracker_.reset();
+		return _passed;
+	};
+
+	/**
+	 * @brief Runs readers and writers against shared slots, checking no reader sees a reclaimed node.
+	*/
+	template <typename Scheme>
+	bool run_contention(const Options& _options)
+	{
+		auto _scheme = Scheme{};
+		auto _slots = std::vector<std::atomic<Node*>>(SLOT_COUNT);
+		for (auto& _slot : _slots)
+		{
+			_slot.store(new Node{});
+		};
+
+		auto _writersLeft = std::atomic<size_t>(_options.writers);
+		auto _reads = std::atomic<size_t>(0);
+		auto _violations = std::atomic<size_t>(0);
+
+		const auto _readWork = [&](size_t _index)
+		{
+			auto _reader = _scheme.make_reader();
+			size_t _count = 0;
+			size_t _bad = 0;
+			while (_writersLeft.load(std::memory_order_relaxed) != 0)
+			{
+				const auto _node = _reader.read(_slots[(_index + _count) % SLOT_COUNT]);
+				if (_node->magic.load(std::memory_order_relaxed) != NODE_ALIVE)
+				{
+					++_bad;
+				};
+				_reader.done();
+				++_count;
+			};
+			_reads.fetch_add(_count, std::memory_order_relaxed);
+			_violations.fetch_add(_bad, std::memory_order_relaxed);
+		};
+
+		const auto _writeWork = [&](size_t _index)
+		{
+			for (size_t n = 0; n != _options.ops; ++n)
+			{
+				const auto _old = _slots[(_index + n) % SLOT_COUNT].exchange(new Node{}, std::memory_order_acq_rel);
+				_old->retired_at = ch::steady_clock::now();
+				tracker_.retired.fetch_add(1, std::memory_order_relaxed);
+				_scheme.retire(_old);
+
+				if (n % 64 == 0)
+				{
+					tracker_.sample_outstanding();
+				};
+			};
+			_writersLeft.fetch_sub(1, std::memory_order_relaxed);
+		};
+
+		const auto _startTime = ch::steady_clock::now();
+		auto _threads = std::vector<std::thread>();
+		for (size_t n = 0; n != _options.readers; ++n)
+		{
+			_threads.emplace_back(_readWork, n);
+		};
+		for (size_t n = 0; n != _options.writers; ++n)
+		{
+			_threads.emplace_back(_writeWork, n);
+		};
+		for (auto& _thread : _threads)
+		{
+			_thread.join();
+		};
+		const auto _elapsed = ch::duration<double>(ch::steady_clock::now() - _startTime).count();
+
+		// Every thread has exited, so whatever they left behind must now be reclaimable
+		for (auto& _slot : _slots)
+		{
+			const auto _node = _slot.exchange(nullptr);
+			_node->retired_at = ch::steady_clock::now();
+			tracker_.retired.fetch_add(1, std::memory_order_relaxed);
+			_scheme.retire(_node);
+		};
+		_scheme.reclaim_all();
+
+		auto _latencies = std::vector<ch::nanoseconds>();
+		_latencies.reserve(tracker_.graveyard.size());
+		for (auto _node : tracker_.graveyard)
+		{
+			_latencies.push_back(_node->reclaim_latency);
+		};
+		std::sort(_latencies.begin(), _latencies.end());
+
+		const auto _percentile = [&](double _p) -> double
+		{
+			if (_latencies.empty()) { return 0.0; };
+			const auto _at = std::min(static_cast<size_t>(_p * _latencies.size()), _latencies.size() - 1);
+			return ch::duration<double, std::micro>(_latencies[_at]).count();
+		};
+
+		const auto _retired = tracker_.retired.load();
+		const auto _peak = tracker_.peak_outstanding.load();
+		std::printf("%s: %zu readers, %zu writers, %.3f s\n", Scheme::name, _options.readers, _options.writers, _elapsed);
+		std::printf("  reads:    %.2f M/s\n", static_cast<double>(_reads.load()) / _elapsed / 1e6);
+		std::printf("  retires:  %.2f M/s\n", static_cast<double>(_retired) / _elapsed / 1e6);
+		std::printf("  reclaim latency: p50 %.1f us, p99 %.1f us, max %.1f us\n",
+			_percentile(0.50), _percentile(0.99), _percentile(1.0));
+		std::printf("  peak unreclaimed: %zu nodes (%zu bytes)\n", _peak, _peak * sizeof(Node));
+
+		bool _passed = true;
+		_passed &= check(_violations.load() == 0, Scheme::name, "no reader saw a reclaimed node");
+		_passed &= check(tracker_.reclaimed.load() == _retired, Scheme::name, "every retired node was reclaimed");
+		if (const auto _bound = _scheme.memory_bound(_options); _bound)
+		{
+			_passed &= check(_peak <= *_bound, Scheme::name, "unreclaimed nodes stay within the scan bound");
+		};
+
+		tracker_.reset();
+		return _passed;
+	};
+};
+
+int main(int _nargs, const char* _vargs[])
+{
+	int _exitCode = 0;
+	const auto _options = parse_options(_nargs, _vargs, _exitCode);
+	if (!_options)
+	{
+		return _exitCode;
+	};
+
+	bool _passed = true;
+	_passed &= run_stalled_reader<HazardScheme>();
+	_passed &= run_stalled_reader<EpochScheme>();
+	_passed &= run_contention<HazardScheme>(*_options);
+	_passed &= run_contention<EpochScheme>(*_options);
+
+	std::fflush(stdout);
+	return _passed ? 0 : 1;
+};
@@ -0,0 +1,294 @@
+/**
+ * @file
+ * @brief Measures `asx::concurrent_skiplist_map` (see `asx/concurrent_skiplist_map.hpp`) against an
+ * `asx::exclusive<std::map>` under a mixed workload.
+ *
+ * Each thread runs a random mix of lookups, inserts, erases and range scans over a shared key space
+ * that starts half full. Thread counts double from 1 up to the maximum. After each skip list run its
+ * contents are checked to be in order and to match its size, the exit code is non-zero if not.
+*/
+
+#include <asx/argparse.hpp>
+#include <asx/exclusive.hpp>
+#include <asx/concurrent_skiplist_map.hpp>
+
+#include <map>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+#include <utility>
+#include <optional>
+#include <string_view>
+
+namespace
+{
+	namespace ch = std::chrono;
+
+	struct Options
+	{
+		size_t threads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+		size_t ops = 200'000;
+		size_t keys = 100'000;
+		size_t write_pct = 10;
+		size_t scan_pct = 5;
+		size_t scan_length = 64;
+	};
+
+	/**
+	 * @brief Parses the command line arguments.
+	 * @return Parsed options, or nullopt if the program should exit.
+	*/
+	std::optional<Options> parse_options(int _nargs, const char* const* _vargs, int& _outExitCode)
+	{
+		auto _parser = asx::ArgumentParser("asx_skiplist_bench",
+			"Measures asx::concurrent_skiplist_map against asx::exclusive<std::map> under a mixed workload.\n"
+			"Thread counts double from 1 up to --threads.");
+		_parser.add_argument("threads", "Largest number of threads, defaults to the hardware concurrency").add_name("-j").add_name("--threads");
+		_parser.add_argument("ops", "Number of operations per thread, defaults to 200000").add_name("-n").add_name("--ops");
+		_parser.add_argument("keys", "Size of the key space, defaults to 100000").add_name("-k").add_name("--keys");
+		_parser.add_argument("write-pct", "Percent of operations that insert or erase, defaults to 10").add_name("--write-pct");
+		_parser.add_argument("scan-pct", "Percent of operations that scan a range, defaults to 5").add_name("--scan-pct");
+		_parser.add_argument("scan-length", "Number of keys each scan covers, defaults to 64").add_name("--scan-length");
+
+		const auto _result = _parser.parse_args_no_execute_filename(std::vector<std::string_view>(_vargs + 1, _vargs + _nargs));
+		_outExitCode = _result.error() ? 2 : 0;
+		if (_result.error())
+		{
+			std::fprintf(stderr, "asx_skiplist_bench: %s\n", _result.message().c_str());
+			return std::nullopt;
+		}
+		else if (_result.should_exit())
+		{
+			std::fputs(_result.message().c_str(), stdout);
+			return std::nullopt;
+		};
+
+		auto _options = Options{};
+		for (auto [_label, _target] : { std::pair{ "threads", &_options.threads }, std::pair{ "ops", &_options.ops },
+			std::pair{ "keys", &_options.keys }, std::pair{ "write-pct", &_options.write_pct },
+			std::pair{ "scan-pct", &_options.scan_pct }, std::pair{ "scan-length", &_options.scan_length } })
+		{
+			const auto _argument = _result.get(_label);
+			if (!_argument)
+			{
+				continue;
+			};
+
+			const auto _value = _argument->to_number<size_t>();
+			if (!_value)
+			{
+				std::fprintf(stderr, "asx_skiplist_bench: invalid value \"%s\" for \"%s\"\n", _argument->get<std::string>().c_str(), _label);
+				_outExitCode = 2;
+				return std::nullopt;
+			};
+			*_target = *_value;
+		};
+
+		if (_options.threads == 0 || _options.keys == 0 || _options.write_pct + _options.scan_pct > 100)
+		{
+			std::fprintf(stderr, "asx_skiplist_bench: invalid thread count, key count or operation mix, see --help\n");
+			_outExitCode = 2;
+			return std::nullopt;
+		};
+		return _options;
+	};
+
+
+
+	/**
+	 * @brief Small per-thread generator, the benchmark shouldn't measure its random numbers.
+	*/
+	struct XorShift
+	{
+		uint64_t state;
+
+		uint64_t operator()() noexcept
+		{
+			this->state ^= this->state << 13;
+			this->state ^= this->state >> 7;
+			this->state ^= this->state << 17;
+			return this->state;
+		};
+	};
+
+	struct SkiplistTarget
+	{
+		static constexpr auto name = "concurrent_skiplist_map";
+
+		bool find(uint64_t _key) const
+		{
+			return this->map.find(_key).has_value();
+		};
+		void insert(uint64_t _key)
+		{
+			this->map.insert(_key, _key);
+		};
+		void erase(uint64_t _key)
+		{
+			this->map.erase(_key);
+		};
+		size_t scan(uint64_t _first, uint64_t _last) const
+		{
+			size_t _count = 0;
+			this->map.for_each_range(_first, _last, [&](const uint64_t&, const uint64_t&) { ++_count; });
+			return _count;
+		};
+
+		/**
+		 * @brief Checks the elements are in order and match the size.
+		*/
+		bool check() const
+		{
+			size_t _count = 0;
+			bool _ordered = true;
+			auto _previous = std::optional<uint64_t>();
+			this->map.for_each([&](const uint64_t& _key, const uint64_t& _value)
+			{
+				_ordered &= (!_previous || *_previous < _key) && _key == _value;
+				_previous = _key;
+				++_count;
+			});
+			return _ordered && _count == this->map.size();
+		};
+
+		asx::concurrent_skiplist_map<uint64_t, uint64_t> map{};
+	};
+
+	struct ExclusiveMapTarget
+	{
+		static constexpr auto name = "exclusive<std::map>";
+
+		bool find(uint64_t _key) const
+		{
+			const auto _map = this->map.get();
+			return _map->find(_key) != _map->end();
+		};
+		void insert(uint64_t _key)
+		{
+			this->map.get()->emplace(_key, _key);
+		};
+		void erase(uint64_t _key)
+		{
+			this->map.get()->erase(_key);
+		};
+		size_t scan(uint64_t _first, uint64_t _last) const
+		{
+			size_t _count = 0;
+			const auto _map = this->map.get();
+			for (auto it = _map->lower_bound(_first); it != _map->end() && it->first < _last; ++it)
+			{
+				++_count;
+			};
+			return _count;
+		};
+		bool check() const
+		{
+			return true;
+		};
+
+		asx::exclusive<std::map<uint64_t, uint64_t>> map{};
+	};
+
+	/**
+	 * @brief Runs the workload on a fresh container.
+	 * @return Millions of operations per second over all threads, or nullopt if the check failed.
+	*/
+	template <typename TargetT>
+	std::optional<double> run(size_t _threadCount, const Options& _options)
+	{
+		auto _target = TargetT{};
+		for (uint64_t n = 0; n < _options.keys; n += 2)
+		{
+			_target.insert(n);
+		};
+
+		auto _ready = std::atomic<size_t>(0);
+		auto _sink = std::atomic<size_t>(0);
+		const auto _work = [&](size_t _id)
+		{
+			auto _random = XorShift{ 0x9E3779B97F4A7C15ull * (_id + 1) };
+			size_t _seen = 0;
+
+			// Start everyone together so thread creation isn't measured
+			_ready.fetch_add(1);
+			while (_ready.load() != _threadCount)
+			{
+				std::this_thread::yield();
+			};
+
+			for (size_t n = 0; n != _options.ops; ++n)
+			{
+				const auto _roll = _random() % 100;
+				const auto _key = _random() % _options.keys;
+				if (_roll < _options.write_pct)
+				{
+					if (_roll % 2 == 0) { _target.insert(_key); }
+					else { _target.erase(_key); };
+				}
+				else if (_roll < _options.write_pct + _options.scan_pct)
+				{
+					_seen += _target.scan(_key, _key + _options.scan_length);
+				}
+				else
+				{
+					_seen += _target.find(_key);
+				};
+			};
+			_sink.fetch_add(_seen, std::memory_order_relaxed);
+		};
+
+		auto _threads = std::vector<std::thread>();
+		for (size_t n = 1; n < _threadCount; ++n)
+		{
+			_threads.emplace_back(_work, n);
+		};
+
+		const auto _startTime = ch::steady_clock::now();
+		_work(0);
+		for (auto& _thread : _threads)
+		{
+			_thread.join();
+		};
+		const auto _elapsed = ch::duration<double>(ch::steady_clock::now() - _startTime).count();
+
+		if (!_target.check())
+		{
+			std::printf("  [FAIL] %s with %zu threads: elements out of order or size mismatch\n", TargetT::name, _threadCount);
+			return std::nullopt;
+		};
+		return static_cast<double>(_threadCount * _options.ops) / _elapsed / 1e6;
+	};
+};
+
+int main(int _nargs, const char* _vargs[])
+{
+	int _exitCode = 0;
+	const auto _options = parse_options(_nargs, _vargs, _exitCode);
+	if (!_options)
+	{
+		return _exitCode;
+	};
+
+	std::printf("%zu keys, %zu ops per thread, %zu%% writes, %zu%% scans of %zu keys\n", _options->keys,
+		_options->ops, _options->write_pct, _options->scan_pct, _options->scan_length);
+	std::printf("%8s %16s %16s %9s\n", "threads", "skiplist (M/s)", "exclusive (M/s)", "speedup");
+
+	bool _passed = true;
+	for (size_t _threads = 1; _threads <= _options->threads; _threads *= 2)
+	{
+		const auto _skiplist = run<SkiplistTarget>(_threads, *_options);
+		const auto _exclusive = run<ExclusiveMapTarget>(_threads, *_options);
+		if (!_skiplist || !_exclusive)
+		{
+			_passed = false;
+			continue;
+		};
+		std::printf("%8zu %16.2f %16.2f %8.2fx\n", _threads, *_skiplist, *_exclusive, *_skiplist / *_exclusive);
+	};
+
+	std::fflush(stdout);
+	return _passed ? 0 : 1;
+};